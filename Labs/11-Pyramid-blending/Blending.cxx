@@ -0,0 +1,210 @@
+/**
+********************************************************************************
+*
+*   @file       Blending.cxx
+*
+*   @brief      Blend two images (an orange and an apple) using their
+*               Laplacian pyramids.
+*
+*   @date       31/03/2021
+*
+*   @author     Franck Vidal
+*
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+// Headers
+//******************************************************************************
+#include <cstdlib>   // Header for atoi
+#include <exception> // Header for catching exceptions
+#include <iostream>  // Header to display text in the console
+#include <string>    // Header for std::string
+#include <opencv2/opencv.hpp> // Main OpenCV header
+
+#include "MultiBandBlender.h"
+#include "Pyramid.h"
+
+
+//******************************************************************************
+// Namespaces
+//******************************************************************************
+using namespace std;
+using namespace cv;
+
+
+//******************************************************************************
+// Function declarations
+//******************************************************************************
+Mat loadImage(const string& aFilename);
+Mat padToPowerOfTwo(const Mat& anImage);
+
+
+//-----------------------------
+int main(int argc, char** argv)
+//-----------------------------
+{
+    try
+    {
+        // Wrong number of arguments
+        if (argc > 2)
+        {
+            // Create an error message
+            std::string error_message;
+            error_message  = "usage: ";
+            error_message += argv[0];
+            error_message += " [number_of_levels]";
+
+            // Throw an error
+            throw error_message;
+        }
+
+        // Load the images
+        Mat orange = padToPowerOfTwo(loadImage("orange.jpg"));
+        Mat apple = padToPowerOfTwo(loadImage("apple.jpg"));
+
+        if (orange.size() != apple.size())
+        {
+            throw "The images do not have the same size.";
+        }
+
+        // Display both images
+        namedWindow("Orange", WINDOW_GUI_EXPANDED);
+        namedWindow("Apple", WINDOW_GUI_EXPANDED);
+        imshow("Orange", orange);
+        imshow("Apple", apple);
+
+        // The number of levels in the pyramids
+        size_t number_of_levels = 6;
+        if (argc == 2)
+        {
+            int levels = atoi(argv[1]);
+            if (levels < 1) throw "The number of levels must be at least 1.";
+            number_of_levels = levels;
+        }
+
+        // The Gaussian pyramids
+        Pyramid orange_pyramid(orange, number_of_levels);
+        Pyramid apple_pyramid(apple, number_of_levels);
+
+        Mat orange_gaussian_display = displayPyramid(orange_pyramid.getGaussianPyramid());
+        Mat apple_gaussian_display = displayPyramid(apple_pyramid.getGaussianPyramid());
+        imshow("Gaussian pyramid of the orange", orange_gaussian_display);
+        imshow("Gaussian pyramid of the apple", apple_gaussian_display);
+        imwrite("orange_gaussian_pyramid.png", orange_gaussian_display);
+        imwrite("apple_gaussian_pyramid.png", apple_gaussian_display);
+
+        // The Laplacian pyramids
+        vector<Mat> orange_laplacian_pyramid = orange_pyramid.getLaplacianPyramid();
+        vector<Mat> apple_laplacian_pyramid = apple_pyramid.getLaplacianPyramid();
+
+        Mat orange_laplacian_display = displayPyramid(orange_laplacian_pyramid);
+        Mat apple_laplacian_display = displayPyramid(apple_laplacian_pyramid);
+        imshow("Laplacian pyramid of the orange", orange_laplacian_display);
+        imshow("Laplacian pyramid of the apple", apple_laplacian_display);
+        imwrite("orange_laplacian_pyramid.png", orange_laplacian_display);
+        imwrite("apple_laplacian_pyramid.png", apple_laplacian_display);
+
+        // Swap the two halves of each level
+        vector<Mat> oranapple_pyramid = combineHalves(orange_laplacian_pyramid, apple_laplacian_pyramid);
+        vector<Mat> apporange_pyramid = combineHalves(apple_laplacian_pyramid, orange_laplacian_pyramid);
+
+        // Reconstruct the images
+        Mat oranapple;
+        Mat apporange;
+        reconstruct(oranapple_pyramid, 0).convertTo(oranapple, CV_8U);
+        reconstruct(apporange_pyramid, 0).convertTo(apporange, CV_8U);
+
+        // Display and save them
+        imshow("Oranapple", oranapple);
+        imshow("Apporange", apporange);
+        imwrite("oranapple-synthesis.png", oranapple);
+        imwrite("apporange-synthesis.png", apporange);
+
+        // The same with the blending engine and a mask per image
+        Mat orange_mask(orange.size(), CV_8U, Scalar(0));
+        orange_mask.colRange(0, orange.cols / 2).setTo(255);
+
+        MultiBandBlender blender(number_of_levels);
+        blender.addImage(orange, orange_mask);
+        blender.addImage(apple, 255 - orange_mask);
+
+        Mat blended;
+        blender.blend().convertTo(blended, CV_8U);
+        imshow("Oranapple (masks)", blended);
+        imwrite("oranapple-masks.png", blended);
+
+        waitKey(0);
+    }
+    // An error occured
+    catch (const std::exception& error)
+    {
+        // Display an error message in the console
+        cerr << error.what() << endl;
+    }
+    catch (const std::string& error)
+    {
+        // Display an error message in the console
+        cerr << error << endl;
+    }
+    catch (const char* error)
+    {
+        // Display an error message in the console
+        cerr << error << endl;
+    }
+
+#ifdef WIN32
+#ifdef _DEBUG
+    system("pause");
+#endif
+#endif
+
+    // Exit the program
+    return 0;
+}
+
+
+//------------------------------------
+Mat loadImage(const string& aFilename)
+//------------------------------------
+{
+    // Load the image in colour
+    Mat image = imread(aFilename, IMREAD_COLOR);
+
+    // Check if the image is loaded
+    if (image.empty())
+    {
+        throw string("Could not open or find the image ") + aFilename;
+    }
+
+    return image;
+}
+
+
+//-------------------------------------
+Mat padToPowerOfTwo(const Mat& anImage)
+//-------------------------------------
+{
+    // The image size is already a power of two
+    if (isPowerOfTwo(anImage.cols) && isPowerOfTwo(anImage.rows))
+    {
+        return anImage;
+    }
+
+    // The next powers of two
+    int width = 1;
+    int height = 1;
+    while (width < anImage.cols) width *= 2;
+    while (height < anImage.rows) height *= 2;
+
+    // Pad the image on the right and at the bottom
+    Mat padded_image;
+    copyMakeBorder(anImage, padded_image,
+                   0, height - anImage.rows,
+                   0, width - anImage.cols,
+                   BORDER_REFLECT_101);
+
+    return padded_image;
+}
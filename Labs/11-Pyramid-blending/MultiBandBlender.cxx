@@ -0,0 +1,213 @@
+/**
+********************************************************************************
+*
+*   @file       MultiBandBlender.cxx
+*
+*   @brief      Blend any number of images with arbitrary masks, band by band
+*               (Laplacian pyramids), e.g. the seams of a panorama.
+*
+*   @date       31/03/2021
+*
+*   @author     Franck Vidal
+*
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+// Headers
+//******************************************************************************
+#include <sstream>   // Header for std::stringstream
+#include <stdexcept> // Header for std::invalid_argument
+
+#include "MultiBandBlender.h"
+#include "Pyramid.h"
+
+
+//******************************************************************************
+// Namespaces
+//******************************************************************************
+using namespace std;
+using namespace cv;
+
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+/// Throw an exception with a nice error message
+//------------------------------------------------------------------------------
+template<typename ExceptionT>
+void throwError(const char* aFunction, int aLine, const char* aMessage)
+{
+    // Format a nice error message
+    std::stringstream error_message;
+    error_message << "ERROR:" << std::endl;
+    error_message << "\tin File:" << __FILE__ << std::endl;
+    error_message << "\tin Function:" << aFunction << std::endl;
+    error_message << "\tat Line:" << aLine << std::endl;
+    error_message << "\tMESSAGE: " << aMessage << std::endl;
+
+    // Throw an exception
+    throw ExceptionT(error_message.str());
+}
+
+
+//------------------------------------------------------------------------------
+/// Add the weighted band of an image to a level of the result, row by row on
+/// all the cores:
+///     aResult += aMask / aWeights * (aGaussian - anExpanded)
+/// anExpanded is empty for the coarsest level (the band is the Gaussian level).
+//------------------------------------------------------------------------------
+void addBand(const Mat& aGaussian, const Mat& anExpanded,
+             const Mat& aMask, const Mat& aWeights, Mat& aResult)
+{
+    const int channels = aResult.channels();
+    const int width = aResult.cols;
+
+    parallel_for_(Range(0, aResult.rows), [&](const Range& aRange)
+    {
+        for (int y = aRange.start; y < aRange.end; ++y)
+        {
+            const float* p_gaussian = aGaussian.ptr<float>(y);
+            const float* p_expanded = anExpanded.empty() ? 0 : anExpanded.ptr<float>(y);
+            const float* p_mask = aMask.ptr<float>(y);
+            const float* p_weights = aWeights.ptr<float>(y);
+            float* p_result = aResult.ptr<float>(y);
+
+            for (int x = 0; x < width; ++x)
+            {
+                // Nothing to blend
+                if (p_weights[x] <= 0.0f || p_mask[x] == 0.0f) continue;
+
+                const float weight = p_mask[x] / p_weights[x];
+                for (int c = 0; c < channels; ++c)
+                {
+                    const int i = x * channels + c;
+                    const float band = p_expanded ? p_gaussian[i] - p_expanded[i] : p_gaussian[i];
+                    p_result[i] += weight * band;
+                }
+            }
+        }
+    });
+}
+
+} // namespace
+
+
+//---------------------------------------------------------
+MultiBandBlender::MultiBandBlender(size_t aNumberOfLevels):
+//---------------------------------------------------------
+    m_number_of_levels(aNumberOfLevels)
+//---------------------------------------------------------
+{
+    if (!aNumberOfLevels)
+    {
+        throwError<invalid_argument>(__FUNCTION__, __LINE__, "The pyramids need at least one level.");
+    }
+}
+
+
+//---------------------------------------------------------------------------
+void MultiBandBlender::addImage(const cv::Mat& anImage, const cv::Mat& aMask)
+//---------------------------------------------------------------------------
+{
+    if (anImage.empty() || anImage.size() != aMask.size() || aMask.channels() != 1)
+    {
+        throwError<invalid_argument>(__FUNCTION__, __LINE__, "The mask must have one channel and the size of the image.");
+    }
+
+    if (!m_images.empty() &&
+        (anImage.size() != m_images[0].size() || anImage.channels() != m_images[0].channels()))
+    {
+        throwError<invalid_argument>(__FUNCTION__, __LINE__, "All the images must have the same size and number of channels.");
+    }
+
+    // The weights in floats (255 is 1 for bytes)
+    Mat mask;
+    aMask.convertTo(mask, CV_32F, aMask.depth() == CV_8U ? 1.0 / 255.0 : 1.0);
+
+    m_images.push_back(anImage);
+    m_masks.push_back(mask);
+}
+
+
+//------------------------------------------------
+size_t MultiBandBlender::getNumberOfImages() const
+//------------------------------------------------
+{
+    return m_images.size();
+}
+
+
+//-------------------------------------
+cv::Mat MultiBandBlender::blend() const
+//-------------------------------------
+{
+    if (m_images.empty())
+    {
+        throwError<invalid_argument>(__FUNCTION__, __LINE__, "There is no image to blend.");
+    }
+
+    const size_t number_of_images = m_images.size();
+
+    // The Gaussian pyramids of the images and of the masks, all in parallel
+    vector<Pyramid> pyramids(2 * number_of_images);
+    parallel_for_(Range(0, int(pyramids.size())), [&](const Range& aRange)
+    {
+        for (int i = aRange.start; i < aRange.end; ++i)
+        {
+            const Mat& image = i < int(number_of_images) ? m_images[i] : m_masks[i - number_of_images];
+            pyramids[i].create(image, m_number_of_levels);
+        }
+    });
+
+    const Pyramid* p_image_pyramids = &pyramids[0];
+    const Pyramid* p_mask_pyramids = &pyramids[number_of_images];
+
+    // Collapse from the coarsest level
+    Mat result;
+    Mat expanded_image;
+    Mat weights;
+    for (int level = int(m_number_of_levels) - 1; level >= 0; --level)
+    {
+        // The sum of the weights at this level
+        weights = p_mask_pyramids[0].getGaussianLevel(level).clone();
+        for (size_t i = 1; i < number_of_images; ++i)
+        {
+            weights += p_mask_pyramids[i].getGaussianLevel(level);
+        }
+
+        // Start from the expansion of the coarser result
+        const Mat& first_level = p_image_pyramids[0].getGaussianLevel(level);
+        if (result.empty())
+        {
+            result = Mat::zeros(first_level.size(), first_level.type());
+        }
+        else
+        {
+            Mat expanded_result;
+            pyrUp(result, expanded_result, first_level.size());
+            result = expanded_result;
+        }
+
+        // Add the weighted bands of the images
+        for (size_t i = 0; i < number_of_images; ++i)
+        {
+            if (level + 1 < int(m_number_of_levels))
+            {
+                pyrUp(p_image_pyramids[i].getGaussianLevel(level + 1), expanded_image, first_level.size());
+            }
+            else
+            {
+                expanded_image.release();
+            }
+
+            addBand(p_image_pyramids[i].getGaussianLevel(level), expanded_image,
+                    p_mask_pyramids[i].getGaussianLevel(level), weights, result);
+        }
+    }
+
+    return result;
+}
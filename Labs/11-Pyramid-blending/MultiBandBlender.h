@@ -0,0 +1,94 @@
+#ifndef __MultiBandBlender_h
+#define __MultiBandBlender_h
+
+/**
+********************************************************************************
+*
+*   @file       MultiBandBlender.h
+*
+*   @brief      Blend any number of images with arbitrary masks, band by band
+*               (Laplacian pyramids), e.g. the seams of a panorama.
+*
+*   @date       31/03/2021
+*
+*   @author     Franck Vidal
+*
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+// Headers
+//******************************************************************************
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+
+//------------------------------------------------------------------------------
+/// Multi-band blending of N images of the same size (Burt and Adelson). Each
+/// level of the result is the average of the Laplacian levels of the images,
+/// weighted by the Gaussian pyramids of their masks:
+///     B_l = sum_i G_l(M_i) L_l(I_i) / sum_i G_l(M_i)
+/// and the result is collapsed from the coarsest level:
+///     R_l = pyrUp(R_l+1) + B_l
+///
+/// The blend and the collapse are fused: the weighted Laplacian level of each
+/// image is computed on the fly and added to the expansion of the coarser
+/// result, row by row on all the cores. No Laplacian pyramid, of the images or
+/// of the result, is ever stored: only the Gaussian pyramids of the images and
+/// of the masks (built in parallel), and the current level of the result.
+//------------------------------------------------------------------------------
+class MultiBandBlender
+{
+public:
+    //--------------------------------------------------------------------------
+    /// Constructor
+    /**
+    * @param aNumberOfLevels: the number of levels of the pyramids
+    */
+    //--------------------------------------------------------------------------
+    explicit MultiBandBlender(size_t aNumberOfLevels = 6);
+
+
+    //--------------------------------------------------------------------------
+    /// Add an image to blend
+    /**
+    * @param anImage: the image (any number of channels, the same for all the
+    * images)
+    * @param aMask: the weights of its pixels, of the same size, one channel:
+    * floats, or bytes (255 is a weight of 1)
+    */
+    //--------------------------------------------------------------------------
+    void addImage(const cv::Mat& anImage, const cv::Mat& aMask);
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the number of images
+    /**
+    * @return the number of images
+    */
+    //--------------------------------------------------------------------------
+    size_t getNumberOfImages() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Blend the images. At a level where all the masks of a pixel are 0, the
+    /// pixel receives no band and keeps the expansion of the coarser result:
+    /// the holes are filled with the low frequencies of their neighbourhood,
+    /// and are 0 only if they are larger than the coarsest level can reach.
+    /**
+    * @return the result, in floats (CV_32FC(n))
+    */
+    //--------------------------------------------------------------------------
+    cv::Mat blend() const;
+
+
+private:
+    size_t m_number_of_levels;      //< The number of levels of the pyramids
+    std::vector<cv::Mat> m_images;  //< The images
+    std::vector<cv::Mat> m_masks;   //< The masks, in floats
+};
+
+
+#endif // __MultiBandBlender_h
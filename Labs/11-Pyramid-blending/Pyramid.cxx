@@ -0,0 +1,478 @@
+/**
+********************************************************************************
+*
+*   @file       Pyramid.cxx
+*
+*   @brief      Gaussian and Laplacian pyramids: construction, display and
+*               reconstruction.
+*
+*   @date       31/03/2021
+*
+*   @author     Franck Vidal
+*
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+// Headers
+//******************************************************************************
+#include <algorithm> // Header for std::max
+#include <sstream>   // Header for std::stringstream
+#include <stdexcept> // Header for std::out_of_range, std::invalid_argument
+
+#include "Pyramid.h"
+
+
+//******************************************************************************
+// Namespaces
+//******************************************************************************
+using namespace std;
+using namespace cv;
+
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+/// Reflect an index at the border (cv::BORDER_REFLECT_101: ... 2 1 | 0 1 2 ...)
+//------------------------------------------------------------------------------
+int reflect101(int anIndex, int aSize)
+{
+    if (aSize == 1) return 0;
+
+    while (anIndex < 0 || anIndex >= aSize)
+    {
+        if (anIndex < 0) anIndex = -anIndex;
+        if (anIndex >= aSize) anIndex = 2 * aSize - 2 - anIndex;
+    }
+
+    return anIndex;
+}
+
+
+//------------------------------------------------------------------------------
+/// Blur a row with the 1D binomial kernel [1 4 6 4 1] and keep one pixel out
+/// of two (the weights are normalised in the vertical pass)
+//------------------------------------------------------------------------------
+void blurAndDecimateRow(const float* anInput, int anInputWidth, int aNumberOfChannels,
+                        float* anOutput, int anOutputWidth)
+{
+    const int n = aNumberOfChannels;
+
+    for (int x = 0; x < anOutputWidth; ++x)
+    {
+        const int centre = 2 * x;
+
+        // Inside the row
+        if (centre >= 2 && centre + 2 < anInputWidth)
+        {
+            const float* p_input = anInput + (centre - 2) * n;
+            for (int c = 0; c < n; ++c)
+            {
+                anOutput[x * n + c] = p_input[c] + p_input[4 * n + c] +
+                    4.0f * (p_input[n + c] + p_input[3 * n + c]) +
+                    6.0f * p_input[2 * n + c];
+            }
+        }
+        // The border is reflected
+        else
+        {
+            const int x0 = reflect101(centre - 2, anInputWidth) * n;
+            const int x1 = reflect101(centre - 1, anInputWidth) * n;
+            const int x2 = reflect101(centre,     anInputWidth) * n;
+            const int x3 = reflect101(centre + 1, anInputWidth) * n;
+            const int x4 = reflect101(centre + 2, anInputWidth) * n;
+            for (int c = 0; c < n; ++c)
+            {
+                anOutput[x * n + c] = anInput[x0 + c] + anInput[x4 + c] +
+                    4.0f * (anInput[x1 + c] + anInput[x3 + c]) +
+                    6.0f * anInput[x2 + c];
+            }
+        }
+    }
+}
+
+
+//------------------------------------------------------------------------------
+/// Throw an exception with a nice error message
+//------------------------------------------------------------------------------
+template<typename ExceptionT>
+void throwError(const char* aFunction, int aLine, const char* aMessage)
+{
+    // Format a nice error message
+    std::stringstream error_message;
+    error_message << "ERROR:" << std::endl;
+    error_message << "\tin File:" << __FILE__ << std::endl;
+    error_message << "\tin Function:" << aFunction << std::endl;
+    error_message << "\tat Line:" << aLine << std::endl;
+    error_message << "\tMESSAGE: " << aMessage << std::endl;
+
+    // Throw an exception
+    throw ExceptionT(error_message.str());
+}
+
+} // namespace
+
+
+//-----------------
+Pyramid::Pyramid():
+//-----------------
+    m_type(CV_32FC1)
+//-----------------
+{}
+
+
+//---------------------------------------------------------------
+Pyramid::Pyramid(const cv::Mat& anImage, size_t aNumberOfLevels):
+//---------------------------------------------------------------
+    m_type(CV_32FC1)
+//---------------------------------------------------------------
+{
+    create(anImage, aNumberOfLevels);
+}
+
+
+//------------------------------------------------------------------
+void Pyramid::create(const cv::Mat& anImage, size_t aNumberOfLevels)
+//------------------------------------------------------------------
+{
+    if (anImage.empty() || !aNumberOfLevels)
+    {
+        throwError<invalid_argument>(__FUNCTION__, __LINE__, "The image or the pyramid is empty.");
+    }
+
+    // The size of the levels
+    m_type = CV_MAKETYPE(CV_32F, anImage.channels());
+    m_sizes.assign(1, anImage.size());
+    while (m_sizes.size() < aNumberOfLevels)
+    {
+        const Size& previous = m_sizes.back();
+        m_sizes.push_back(Size((previous.width + 1) / 2, (previous.height + 1) / 2));
+    }
+
+    // All the levels in a single buffer
+    allocateLevels(m_gaussian_buffer, m_gaussian_levels);
+
+    // Level 0: the image in floats, written in the buffer
+    anImage.convertTo(m_gaussian_levels[0], CV_32F);
+
+    // Each level from the previous one
+    for (size_t i = 1; i < m_sizes.size(); ++i)
+    {
+        blurAndDecimate(m_gaussian_levels[i - 1], m_gaussian_levels[i]);
+    }
+
+    // The Laplacian levels are out of date
+    m_laplacian_levels.clear();
+    m_laplacian_ready.assign(m_sizes.size(), false);
+}
+
+
+//---------------------------------------
+size_t Pyramid::getNumberOfLevels() const
+//---------------------------------------
+{
+    return m_sizes.size();
+}
+
+
+//-----------------------------------------------------------
+const cv::Mat& Pyramid::getGaussianLevel(size_t aLevel) const
+//-----------------------------------------------------------
+{
+    if (aLevel >= m_gaussian_levels.size())
+    {
+        throwError<out_of_range>(__FUNCTION__, __LINE__, "Invalid level.");
+    }
+
+    return m_gaussian_levels[aLevel];
+}
+
+
+//------------------------------------------------------------
+const cv::Mat& Pyramid::getLaplacianLevel(size_t aLevel) const
+//------------------------------------------------------------
+{
+    if (aLevel >= m_gaussian_levels.size())
+    {
+        throwError<out_of_range>(__FUNCTION__, __LINE__, "Invalid level.");
+    }
+
+    if (!m_laplacian_ready[aLevel])
+    {
+        // The buffer is allocated the first time a level is needed
+        if (m_laplacian_levels.empty())
+        {
+            allocateLevels(m_laplacian_buffer, m_laplacian_levels);
+        }
+
+        // The last level is the last Gaussian level
+        if (aLevel + 1 == m_sizes.size())
+        {
+            m_gaussian_levels[aLevel].copyTo(m_laplacian_levels[aLevel]);
+        }
+        // The difference between the level and the expansion of the next one
+        else
+        {
+            Mat expanded;
+            pyrUp(m_gaussian_levels[aLevel + 1], expanded, m_sizes[aLevel]);
+            subtract(m_gaussian_levels[aLevel], expanded, m_laplacian_levels[aLevel]);
+        }
+
+        m_laplacian_ready[aLevel] = true;
+    }
+
+    return m_laplacian_levels[aLevel];
+}
+
+
+//------------------------------------------------------
+std::vector<cv::Mat> Pyramid::getGaussianPyramid() const
+//------------------------------------------------------
+{
+    return m_gaussian_levels;
+}
+
+
+//-------------------------------------------------------
+std::vector<cv::Mat> Pyramid::getLaplacianPyramid() const
+//-------------------------------------------------------
+{
+    vector<Mat> laplacian_pyramid;
+    for (size_t i = 0; i < m_sizes.size(); ++i)
+    {
+        laplacian_pyramid.push_back(getLaplacianLevel(i));
+    }
+
+    return laplacian_pyramid;
+}
+
+
+//---------------------------------------------------------------------------------
+void Pyramid::allocateLevels(cv::Mat& aBuffer, std::vector<cv::Mat>& aLevels) const
+//---------------------------------------------------------------------------------
+{
+    // Level 0 on top, and the other levels side by side below it (as in
+    // displayPyramid): a 2D buffer, so that no dimension exceeds the size of
+    // the image (a single row of all the pixels would overflow an int)
+    int width = m_sizes[0].width;
+    int height = m_sizes[0].height;
+    if (m_sizes.size() > 1)
+    {
+        int strip_width = 0;
+        for (size_t i = 1; i < m_sizes.size(); ++i)
+        {
+            strip_width += m_sizes[i].width;
+        }
+
+        width = max(width, strip_width);
+        height += m_sizes[1].height;
+    }
+
+    // Reuse the buffer if possible
+    aBuffer.create(height, width, m_type);
+
+    // Each level is a region of the buffer: it shares the buffer and its
+    // reference counter
+    aLevels.resize(m_sizes.size());
+    aLevels[0] = aBuffer(Rect(Point(0, 0), m_sizes[0]));
+    int x = 0;
+    for (size_t i = 1; i < m_sizes.size(); ++i)
+    {
+        aLevels[i] = aBuffer(Rect(Point(x, m_sizes[0].height), m_sizes[i]));
+        x += m_sizes[i].width;
+    }
+}
+
+
+//-------------------------------------------------------------
+void blurAndDecimate(const cv::Mat& anInput, cv::Mat& anOutput)
+//-------------------------------------------------------------
+{
+    CV_Assert(anInput.depth() == CV_32F);
+
+    const int channels = anInput.channels();
+    const int input_width = anInput.cols;
+    const int input_height = anInput.rows;
+    const int output_width = (input_width + 1) / 2;
+    const int output_height = (input_height + 1) / 2;
+
+    // No reallocation if the output is a level of a pyramid
+    anOutput.create(output_height, output_width, anInput.type());
+
+    // A ring of 5 rows, blurred horizontally and decimated. Each row of the
+    // input is only blurred once, and only at the columns that are kept.
+    const int row_size = output_width * channels;
+    vector<float> rows(5 * row_size);
+    int ring_rows[5] = {-1, -1, -1, -1, -1};
+
+    // The binomial kernel, twice: 1 / (16 x 16)
+    const float normalisation = 1.0f / 256.0f;
+
+    for (int y = 0; y < output_height; ++y)
+    {
+        // The input rows 2y - 2 to 2y + 2 (reflected at the border)
+        const float* p_rows[5];
+        for (int k = 0; k < 5; ++k)
+        {
+            int input_row = reflect101(2 * y - 2 + k, input_height);
+            int slot = input_row % 5;
+            if (ring_rows[slot] != input_row)
+            {
+                blurAndDecimateRow(anInput.ptr<float>(input_row), input_width, channels,
+                                   &rows[slot * row_size], output_width);
+                ring_rows[slot] = input_row;
+            }
+            p_rows[k] = &rows[slot * row_size];
+        }
+
+        // The vertical pass
+        float* p_output = anOutput.ptr<float>(y);
+        for (int i = 0; i < row_size; ++i)
+        {
+            p_output[i] = normalisation * (p_rows[0][i] + p_rows[4][i] +
+                4.0f * (p_rows[1][i] + p_rows[3][i]) +
+                6.0f * p_rows[2][i]);
+        }
+    }
+}
+
+
+//----------------------
+bool isPowerOfTwo(int i)
+//----------------------
+{
+    return i > 0 && (i & (i - 1)) == 0;
+}
+
+
+//----------------------------------------------------------------
+void createGaussianPyramid(const cv::Mat& anOriginalImage,
+                           std::vector<cv::Mat>& aGaussianPyramid,
+                           size_t aNumberOfLevels)
+//----------------------------------------------------------------
+{
+    aGaussianPyramid = Pyramid(anOriginalImage, aNumberOfLevels).getGaussianPyramid();
+}
+
+
+//----------------------------------------------------------
+cv::Mat displayPyramid(const std::vector<cv::Mat>& aPyramid)
+//----------------------------------------------------------
+{
+    if (aPyramid.empty()) return Mat();
+
+    // The first level on the left, the other ones stacked on the right
+    int width = aPyramid[0].cols;
+    int height = aPyramid[0].rows;
+    if (aPyramid.size() > 1)
+    {
+        width += aPyramid[1].cols;
+
+        int column_height = 0;
+        for (size_t i = 1; i < aPyramid.size(); ++i)
+        {
+            column_height += aPyramid[i].rows;
+        }
+        height = max(height, column_height);
+    }
+
+    Mat display(height, width, CV_8UC(aPyramid[0].channels()), Scalar::all(0));
+
+    int x = 0;
+    int y = 0;
+    for (size_t i = 0; i < aPyramid.size(); ++i)
+    {
+        // Stretch the pixels to [0, 255] (the Laplacian levels are signed)
+        Mat level;
+        normalize(aPyramid[i], level, 0, 255, NORM_MINMAX, CV_8U);
+        level.copyTo(display(Rect(x, y, level.cols, level.rows)));
+
+        if (i == 0)
+        {
+            x = level.cols;
+        }
+        else
+        {
+            y += level.rows;
+        }
+    }
+
+    return display;
+}
+
+
+//-----------------------------------------------------------------------
+void createLaplacianPyramid(const std::vector<cv::Mat>& aGaussianPyramid,
+                            std::vector<cv::Mat>& aLaplacianPyramid)
+//-----------------------------------------------------------------------
+{
+    aLaplacianPyramid.resize(aGaussianPyramid.size());
+    for (size_t i = 0; i < aGaussianPyramid.size(); ++i)
+    {
+        // The last level is the last Gaussian level
+        if (i + 1 == aGaussianPyramid.size())
+        {
+            aLaplacianPyramid[i] = aGaussianPyramid[i].clone();
+        }
+        // The difference between the level and the expansion of the next one
+        else
+        {
+            Mat expanded;
+            pyrUp(aGaussianPyramid[i + 1], expanded, aGaussianPyramid[i].size());
+            subtract(aGaussianPyramid[i], expanded, aLaplacianPyramid[i]);
+        }
+    }
+}
+
+
+//---------------------------------------------------------------------------
+std::vector<cv::Mat> combineHalves(const std::vector<cv::Mat>& aLeftPyramid,
+                                   const std::vector<cv::Mat>& aRightPyramid)
+//---------------------------------------------------------------------------
+{
+    if (aLeftPyramid.size() != aRightPyramid.size())
+    {
+        throwError<invalid_argument>(__FUNCTION__, __LINE__, "The pyramids do not have the same number of levels.");
+    }
+
+    vector<Mat> combined_pyramid;
+    for (size_t i = 0; i < aLeftPyramid.size(); ++i)
+    {
+        if (aLeftPyramid[i].size() != aRightPyramid[i].size())
+        {
+            throwError<invalid_argument>(__FUNCTION__, __LINE__, "The levels do not have the same size.");
+        }
+
+        Mat level = aRightPyramid[i].clone();
+        int half_width = level.cols / 2;
+        aLeftPyramid[i](Rect(0, 0, half_width, level.rows)).copyTo(level(Rect(0, 0, half_width, level.rows)));
+        combined_pyramid.push_back(level);
+    }
+
+    return combined_pyramid;
+}
+
+
+//----------------------------------------------------------------------------
+cv::Mat reconstruct(const std::vector<cv::Mat>& aLaplacianPyramid, int aLevel)
+//----------------------------------------------------------------------------
+{
+    if (aLevel < 0 || aLevel >= int(aLaplacianPyramid.size()))
+    {
+        throwError<out_of_range>(__FUNCTION__, __LINE__, "Invalid level.");
+    }
+
+    // From the coarsest level: expand, then add the details
+    Mat image = aLaplacianPyramid.back().clone();
+    for (int i = int(aLaplacianPyramid.size()) - 2; i >= aLevel; --i)
+    {
+        Mat expanded;
+        pyrUp(image, expanded, aLaplacianPyramid[i].size());
+        add(expanded, aLaplacianPyramid[i], image);
+    }
+
+    return image;
+}
@@ -0,0 +1,224 @@
+#ifndef __Pyramid_h
+#define __Pyramid_h
+
+/**
+********************************************************************************
+*
+*   @file       Pyramid.h
+*
+*   @brief      Gaussian and Laplacian pyramids: construction, display and
+*               reconstruction.
+*
+*   @date       31/03/2021
+*
+*   @author     Franck Vidal
+*
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+// Headers
+//******************************************************************************
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+
+//------------------------------------------------------------------------------
+/// Gaussian and Laplacian pyramids of an image (any number of channels). The
+/// pixels are stored in floats (the Laplacian levels are signed).
+///
+/// All the Gaussian levels are stored in a single allocation, level 0 on top
+/// and the smaller levels side by side below it (1.5 times the size of the
+/// image): each level is a cv::Mat region that shares it. A level is built
+/// from the previous one by a fused blur-and-decimate pass: the 5x5 binomial
+/// kernel of cv::pyrDown is applied as two 1D passes, and only at the pixels
+/// that are kept (one row and one column out of two). The Laplacian levels are only computed when they are
+/// needed, in a second single allocation.
+//------------------------------------------------------------------------------
+class Pyramid
+{
+public:
+    //--------------------------------------------------------------------------
+    /// Default constructor: an empty pyramid
+    //--------------------------------------------------------------------------
+    Pyramid();
+
+
+    //--------------------------------------------------------------------------
+    /// Constructor: build the Gaussian pyramid of an image
+    /**
+    * @param anImage: the image (level 0)
+    * @param aNumberOfLevels: the number of levels, including the image
+    */
+    //--------------------------------------------------------------------------
+    Pyramid(const cv::Mat& anImage, size_t aNumberOfLevels);
+
+
+    //--------------------------------------------------------------------------
+    /// Build the Gaussian pyramid of an image. The memory is reused if the
+    /// pyramid has the same size.
+    /**
+    * @param anImage: the image (level 0)
+    * @param aNumberOfLevels: the number of levels, including the image
+    */
+    //--------------------------------------------------------------------------
+    void create(const cv::Mat& anImage, size_t aNumberOfLevels);
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the number of levels
+    /**
+    * @return the number of levels
+    */
+    //--------------------------------------------------------------------------
+    size_t getNumberOfLevels() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on a level of the Gaussian pyramid
+    /**
+    * @param aLevel: the level (0 is the image)
+    * @return the level (it shares the memory of the pyramid)
+    */
+    //--------------------------------------------------------------------------
+    const cv::Mat& getGaussianLevel(size_t aLevel) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on a level of the Laplacian pyramid: the difference between the
+    /// Gaussian level and the expansion of the next one (cv::pyrUp). The last
+    /// level is the last Gaussian level. The level is computed the first time
+    /// it is needed.
+    /**
+    * @param aLevel: the level
+    * @return the level (it shares the memory of the pyramid)
+    */
+    //--------------------------------------------------------------------------
+    const cv::Mat& getLaplacianLevel(size_t aLevel) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the Gaussian pyramid
+    /**
+    * @return the levels
+    */
+    //--------------------------------------------------------------------------
+    std::vector<cv::Mat> getGaussianPyramid() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the Laplacian pyramid (all its levels are computed)
+    /**
+    * @return the levels
+    */
+    //--------------------------------------------------------------------------
+    std::vector<cv::Mat> getLaplacianPyramid() const;
+
+
+private:
+    //--------------------------------------------------------------------------
+    /// Create the headers of the levels in a single 2D buffer: level 0 on top,
+    /// the other levels side by side below it
+    /**
+    * @param aBuffer: the buffer, allocated if needed
+    * @param aLevels: the levels
+    */
+    //--------------------------------------------------------------------------
+    void allocateLevels(cv::Mat& aBuffer, std::vector<cv::Mat>& aLevels) const;
+
+
+    std::vector<cv::Size> m_sizes;                      //< The size of each level
+    int m_type;                                         //< The type of the pixels (CV_32FC(n))
+
+    cv::Mat m_gaussian_buffer;                          //< The pixels of all the Gaussian levels
+    std::vector<cv::Mat> m_gaussian_levels;             //< The Gaussian levels, in m_gaussian_buffer
+
+    mutable cv::Mat m_laplacian_buffer;                 //< The pixels of all the Laplacian levels
+    mutable std::vector<cv::Mat> m_laplacian_levels;    //< The Laplacian levels, in m_laplacian_buffer
+    mutable std::vector<bool> m_laplacian_ready;        //< True if a Laplacian level is computed
+};
+
+
+//--------------------------------------------------------------------------
+/// Blur an image with the 5x5 binomial kernel of cv::pyrDown and keep one
+/// row and one column out of two, in a single pass: only the pixels that are
+/// kept are computed. The border is reflected (cv::BORDER_REFLECT_101).
+/**
+ * @param anInput:   the image (CV_32FC(n))
+ * @param anOutput:  the result, of size ((cols + 1) / 2, (rows + 1) / 2)
+ */
+//--------------------------------------------------------------------------
+void blurAndDecimate(const cv::Mat& anInput, cv::Mat& anOutput);
+
+
+//--------------------------------------------------------------------------
+/// Check if a number is a power of two.
+/**
+ * @param i: the number
+ * @return true if i is a power of two, false otherwise
+ */
+//--------------------------------------------------------------------------
+bool isPowerOfTwo(int i);
+
+
+//--------------------------------------------------------------------------
+/// Create a Gaussian pyramid.
+/**
+ * @param anOriginalImage:    the image to process
+ * @param aGaussianPyramid:   the Gaussian pyramid
+ * @param aNumberOfLevels:    the number of levels in the pyramid
+ */
+//--------------------------------------------------------------------------
+void createGaussianPyramid(const cv::Mat& anOriginalImage,
+                           std::vector<cv::Mat>& aGaussianPyramid,
+                           size_t aNumberOfLevels);
+
+
+//--------------------------------------------------------------------------
+/// Create an image to visualise a pyramid (Gaussian or Laplacian).
+/**
+ * @param aPyramid: the pyramid to visualise
+ * @return  the visualisation of the pyramid
+ */
+//--------------------------------------------------------------------------
+cv::Mat displayPyramid(const std::vector<cv::Mat>& aPyramid);
+
+
+//--------------------------------------------------------------------------
+/// Create a Laplacian pyramid from a Gaussian pyramid.
+/**
+ * @param aGaussianPyramid:   the Gaussian pyramid
+ * @param aLaplacianPyramid:  the corresponding Laplacian pyramid
+ */
+//--------------------------------------------------------------------------
+void createLaplacianPyramid(const std::vector<cv::Mat>& aGaussianPyramid,
+                            std::vector<cv::Mat>& aLaplacianPyramid);
+
+
+//--------------------------------------------------------------------------
+/// Combine the left half of the levels of a pyramid with the right half of
+/// the levels of another one.
+/**
+ * @param aLeftPyramid:   the pyramid of the left-hand side image
+ * @param aRightPyramid:  the pyramid of the right-hand side image
+ * @return the combined pyramid
+ */
+//--------------------------------------------------------------------------
+std::vector<cv::Mat> combineHalves(const std::vector<cv::Mat>& aLeftPyramid,
+                                   const std::vector<cv::Mat>& aRightPyramid);
+
+
+//--------------------------------------------------------------------------
+/// Reconstruct an image from the Laplacian pyramid at a given level.
+/**
+ * @param aLaplacianPyramid:    the Laplacian pyramid
+ * @param aLevel:    the level
+ * @return the corresponding reconstructed image
+ */
+//--------------------------------------------------------------------------
+cv::Mat reconstruct(const std::vector<cv::Mat>& aLaplacianPyramid, int aLevel);
+
+
+#endif // __Pyramid_h
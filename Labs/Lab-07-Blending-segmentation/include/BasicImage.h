@@ -0,0 +1,395 @@
+#ifndef __BasicImage_h
+#define __BasicImage_h
+
+#include <vector>
+#include <string>
+#include <cstddef>  // size_t
+#include <cstdint>  // uint8_t, uint16_t
+
+#include "Half.h"
+#include "PixelRow.h"
+#include "PixelBuffer.h"
+
+
+//------------------------------------------------------------------------------
+/// Convert pixels from a type to another, using several threads. The values
+/// are rounded to the nearest integer (ties to even) and saturated to the
+/// range of the output type, e.g. [0, 255] for uint8_t. NaN gives 0.
+/// Supported types: uint8_t, uint16_t, float and Half.
+/**
+* @param anInput: the input pixels
+* @param anOutput: the output pixels
+* @param aSize: the number of pixels
+*/
+//------------------------------------------------------------------------------
+template<typename InputT, typename OutputT>
+void convertPixels(const InputT* anInput, OutputT* anOutput, size_t aSize);
+
+
+//------------------------------------------------------------------------------
+/// Greyscale image with compact pixels (uint8_t, uint16_t or Half), e.g. to
+/// keep 8-bit images in 8 bits. The processing is done on float images
+/// (BasicImage<float>, i.e. Image, see Image.h): the conversions between pixel
+/// types are explicit and saturating.
+//------------------------------------------------------------------------------
+template<typename PixelT>
+class BasicImage
+{
+public:
+    typedef PixelT PixelType;
+
+
+    //--------------------------------------------------------------------------
+    /// Default constructor: Create an empty image
+    //--------------------------------------------------------------------------
+    BasicImage();
+
+
+    //--------------------------------------------------------------------------
+    /// Copy constructor: Copy an existing image
+    /**
+    * @param anImage: The image to copy
+    */
+    //--------------------------------------------------------------------------
+    BasicImage(const BasicImage& anImage) = default;
+
+
+    //--------------------------------------------------------------------------
+    /// Move constructor: Take the pixels of an image
+    /**
+    * @param anImage: The image to move. It is left empty.
+    */
+    //--------------------------------------------------------------------------
+    BasicImage(BasicImage&& anImage) noexcept;
+
+
+    //--------------------------------------------------------------------------
+    /// Constructor: Create an image from an array
+    /**
+    * @param anImage: The array of pixel values
+    * @param aWidth: The number of columns
+    * @param aHeight: The number of rows
+    */
+    //--------------------------------------------------------------------------
+    BasicImage(const PixelT* anImage, size_t aWidth, size_t aHeight);
+
+
+    //--------------------------------------------------------------------------
+    /// Constructor: Create an image from a vector
+    /**
+    * @param anImage: The vector of pixel values
+    * @param aWidth: The number of columns
+    * @param aHeight: The number of rows
+    */
+    //--------------------------------------------------------------------------
+    BasicImage(const std::vector<PixelT>& anImage, size_t aWidth, size_t aHeight);
+
+
+    //--------------------------------------------------------------------------
+    /// Constructor: Create an image of a given size, filled with a constant
+    /**
+    * @param aConstant: The value of all the pixels
+    * @param aWidth: The number of columns
+    * @param aHeight: The number of rows
+    */
+    //--------------------------------------------------------------------------
+    BasicImage(PixelT aConstant, size_t aWidth, size_t aHeight);
+
+
+    //--------------------------------------------------------------------------
+    /// Constructor: Load an image from a JPEG file
+    /**
+    * @param aFilename: The name of the file to load
+    */
+    //--------------------------------------------------------------------------
+    explicit BasicImage(const char* aFilename);
+
+
+    //--------------------------------------------------------------------------
+    /// Constructor: Load an image from a JPEG file
+    /**
+    * @param aFilename: The name of the file to load
+    */
+    //--------------------------------------------------------------------------
+    explicit BasicImage(const std::string& aFilename);
+
+
+    //--------------------------------------------------------------------------
+    /// Conversion from another pixel type (see convertPixels)
+    /**
+    * @param anImage: The image to convert
+    */
+    //--------------------------------------------------------------------------
+    template<typename OtherPixelT>
+    explicit BasicImage(const BasicImage<OtherPixelT>& anImage);
+
+
+    //--------------------------------------------------------------------------
+    /// Assignment operator
+    /**
+    * @param anImage: The image to copy
+    * @return the new image
+    */
+    //--------------------------------------------------------------------------
+    BasicImage& operator=(const BasicImage& anImage) = default;
+
+
+    //--------------------------------------------------------------------------
+    /// Move assignment operator
+    /**
+    * @param anImage: The image to move. It is left empty.
+    * @return the new image
+    */
+    //--------------------------------------------------------------------------
+    BasicImage& operator=(BasicImage&& anImage) noexcept;
+
+
+    //--------------------------------------------------------------------------
+    /// Load an image from a JPEG file, possibly at a reduced resolution. A RGB
+    /// image is converted to its relative luminance, rounded to the nearest
+    /// integer. The uncompressed files of ImageIO.h (raw, PGM, PFM or TIFF)
+    /// are loaded too, and their samples converted as by convertPixels.
+    /**
+    * @param aFilename: The name of the file to load
+    * @param aScaleHint: The scale of the image that is needed, e.g. 0.25 for
+    * a quarter of the width and of the height. A JPEG file is decoded at 1,
+    * 1/2, 1/4 or 1/8 of its size (the DCT coefficients of the other
+    * frequencies are skipped): the smallest of them that is not smaller than
+    * aScaleHint. The other files are always loaded at full resolution.
+    */
+    //--------------------------------------------------------------------------
+    void load(const char* aFilename, float aScaleHint = 1.0f);
+
+
+    //--------------------------------------------------------------------------
+    /// Load an image from a JPEG file, possibly at a reduced resolution
+    /**
+    * @param aFilename: The name of the file to load
+    * @param aScaleHint: The scale of the image that is needed (see above)
+    */
+    //--------------------------------------------------------------------------
+    void load(const std::string& aFilename, float aScaleHint = 1.0f);
+
+
+    //--------------------------------------------------------------------------
+    /// Save the image in a greyscale JPEG file. The pixels are saturated to
+    /// [0, 255].
+    /**
+    * @param aFilename: The name of the file to write
+    * @param aQuality: The quality, from 1 (smallest file) to 100 (best image)
+    * @param anOptimiseFlag: true to compute optimal Huffman tables (smaller
+    * file, slower encoding)
+    */
+    //--------------------------------------------------------------------------
+    void saveJPEG(const char* aFilename, int aQuality = 75, bool anOptimiseFlag = false) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Save the image in a greyscale JPEG file
+    /**
+    * @param aFilename: The name of the file to write
+    * @param aQuality: The quality, from 1 (smallest file) to 100 (best image)
+    * @param anOptimiseFlag: true to compute optimal Huffman tables
+    */
+    //--------------------------------------------------------------------------
+    void saveJPEG(const std::string& aFilename, int aQuality = 75, bool anOptimiseFlag = false) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Save the image in a file. The format is given by the extension of the
+    /// file: .jpg or .jpeg, .raw, .pgm (8- and 16-bit images), .pfm or .tif.
+    /**
+    * @param aFilename: The name of the file to write
+    */
+    //--------------------------------------------------------------------------
+    void save(const char* aFilename) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Save the image in a file (see above)
+    /**
+    * @param aFilename: The name of the file to write
+    */
+    //--------------------------------------------------------------------------
+    void save(const std::string& aFilename) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Median filter over a (2r + 1) x (2r + 1) window. The border is extended.
+    /// The 8-bit images use the constant-time filter of MedianFilter.h; the
+    /// other types use the exact filter of the float images (see Image.h).
+    /**
+    * @param aRadius: the radius r of the window (1 for 3x3)
+    * @return the new image
+    */
+    //--------------------------------------------------------------------------
+    BasicImage medianFilter(unsigned int aRadius = 1) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on a given pixel
+    /**
+    * @param col: coordinate of the pixel along the horizontal axis
+    * @param row: coordinate of the pixel along the vertical axis
+    * @return the corresponding pixel value
+    */
+    //--------------------------------------------------------------------------
+    const PixelT& operator()(size_t col, size_t row) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on a given pixel
+    /**
+    * @param col: coordinate of the pixel along the horizontal axis
+    * @param row: coordinate of the pixel along the vertical axis
+    * @return the corresponding pixel value
+    */
+    //--------------------------------------------------------------------------
+    PixelT& operator()(size_t col, size_t row);
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on a given pixel without any bounds check
+    /**
+    * @param col: coordinate of the pixel along the horizontal axis
+    * @param row: coordinate of the pixel along the vertical axis
+    * @return the corresponding pixel value
+    */
+    //--------------------------------------------------------------------------
+    const PixelT& atUnchecked(size_t col, size_t row) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on a row of pixels without any bounds check
+    /**
+    * @param row: coordinate of the row along the vertical axis
+    * @return the corresponding row
+    */
+    //--------------------------------------------------------------------------
+    PixelRow<const PixelT> getRow(size_t row) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on all the rows of pixels, e.g. to use in a range-based loop
+    /**
+    * @return the rows
+    */
+    //--------------------------------------------------------------------------
+    PixelRows<const PixelT> getRows() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the width of the image
+    /**
+    * @return the number of columns
+    */
+    //--------------------------------------------------------------------------
+    size_t getWidth() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the height of the image
+    /**
+    * @return the number of rows
+    */
+    //--------------------------------------------------------------------------
+    size_t getHeight() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the pixel data
+    /**
+    * @return the pixel data, or NULL if the image is empty
+    */
+    //--------------------------------------------------------------------------
+    const PixelT* getPixelPointer() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the pixel data
+    /**
+    * @return the pixel data, or NULL if the image is empty
+    */
+    //--------------------------------------------------------------------------
+    PixelT* getPixelPointer();
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the smallest pixel value
+    /**
+    * @return the smallest pixel value
+    */
+    //--------------------------------------------------------------------------
+    float getMinValue();
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the largest pixel value
+    /**
+    * @return the largest pixel value
+    */
+    //--------------------------------------------------------------------------
+    float getMaxValue();
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the average pixel value
+    /**
+    * @return the average pixel value
+    */
+    //--------------------------------------------------------------------------
+    float getAverageValue();
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the standard deviation of the pixel values
+    /**
+    * @return the standard deviation of the pixel values
+    */
+    //--------------------------------------------------------------------------
+    float getStandardDeviation();
+
+private:
+    //--------------------------------------------------------------------------
+    /// Throw an exception for a pixel that does not exist
+    /**
+    * @param col: coordinate of the pixel along the horizontal axis
+    * @param row: coordinate of the pixel along the vertical axis
+    */
+    //--------------------------------------------------------------------------
+    void throwOutOfRange(size_t col, size_t row) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Update the image statistics if needed. The pixels are converted to
+    /// floats by chunks, then processed as the ones of a float image.
+    //--------------------------------------------------------------------------
+    void updateStats();
+
+
+    PixelBuffer<PixelT> m_pixel_data; //< The pixel data in greyscale as a 1D array, aligned on PIXEL_ALIGNMENT bytes
+    size_t m_width; //< The number of columns
+    size_t m_height; //< The number of rows
+    float m_min_pixel_value; //< The smallest pixel value
+    float m_max_pixel_value; //< The largest pixel value
+    float m_average_pixel_value; //< The average pixel value
+    float m_stddev_pixel_value; //< The standard deviation of the pixel values
+
+    bool m_stats_up_to_date; //< True if the statistics are up-to-date, false otherwise
+};
+
+
+// The float images are specialised (see Image.h)
+template<> class BasicImage<float>;
+
+typedef BasicImage<uint8_t> ImageU8;    //< 8-bit images, e.g. from JPEG files
+typedef BasicImage<uint16_t> ImageU16;  //< 16-bit images
+typedef BasicImage<Half> ImageHalf;     //< Half-precision floating point images
+
+// The 8-bit images have their own median filter
+template<> ImageU8 ImageU8::medianFilter(unsigned int aRadius) const;
+
+
+#include "BasicImage.inl"
+
+#endif // __BasicImage_h
@@ -0,0 +1,119 @@
+//---------------------------------------------------------------------
+template<typename PixelT>
+template<typename OtherPixelT>
+BasicImage<PixelT>::BasicImage(const BasicImage<OtherPixelT>& anImage):
+//---------------------------------------------------------------------
+    m_pixel_data(anImage.getWidth() * anImage.getHeight()),
+    m_width(anImage.getWidth()),
+    m_height(anImage.getHeight()),
+    m_min_pixel_value(0),
+    m_max_pixel_value(0),
+    m_average_pixel_value(0),
+    m_stddev_pixel_value(0),
+    m_stats_up_to_date(false)
+//---------------------------------------------------------------------
+{
+    if (m_pixel_data.size())
+    {
+        convertPixels(anImage.getPixelPointer(), &m_pixel_data[0], m_pixel_data.size());
+    }
+}
+
+
+//-------------------------------------------------------------------------------
+template<typename PixelT>
+inline const PixelT& BasicImage<PixelT>::operator()(size_t col, size_t row) const
+//-------------------------------------------------------------------------------
+{
+    // Check if the coordinates are valid, if not throw an error
+    if (col >= m_width || row >= m_height)
+    {
+        throwOutOfRange(col, row);
+    }
+
+    return m_pixel_data[row * m_width + col];
+}
+
+
+//-------------------------------------------------------------------
+template<typename PixelT>
+inline PixelT& BasicImage<PixelT>::operator()(size_t col, size_t row)
+//-------------------------------------------------------------------
+{
+    // Check if the coordinates are valid, if not throw an error
+    if (col >= m_width || row >= m_height)
+    {
+        throwOutOfRange(col, row);
+    }
+
+    // To be on the safe side, turn the flag off
+    m_stats_up_to_date = false;
+
+    return m_pixel_data[row * m_width + col];
+}
+
+
+//--------------------------------------------------------------------------------
+template<typename PixelT>
+inline const PixelT& BasicImage<PixelT>::atUnchecked(size_t col, size_t row) const
+//--------------------------------------------------------------------------------
+{
+    return m_pixel_data[row * m_width + col];
+}
+
+
+//------------------------------------------------------------------------
+template<typename PixelT>
+inline PixelRow<const PixelT> BasicImage<PixelT>::getRow(size_t row) const
+//------------------------------------------------------------------------
+{
+    return PixelRow<const PixelT>(getPixelPointer() + row * m_width, m_width);
+}
+
+
+//----------------------------------------------------------------
+template<typename PixelT>
+inline PixelRows<const PixelT> BasicImage<PixelT>::getRows() const
+//----------------------------------------------------------------
+{
+    return PixelRows<const PixelT>(getPixelPointer(), m_width, m_height, m_width);
+}
+
+
+//------------------------------------------------
+template<typename PixelT>
+inline size_t BasicImage<PixelT>::getWidth() const
+//------------------------------------------------
+{
+    return m_width;
+}
+
+
+//-------------------------------------------------
+template<typename PixelT>
+inline size_t BasicImage<PixelT>::getHeight() const
+//-------------------------------------------------
+{
+    return m_height;
+}
+
+
+//--------------------------------------------------------------
+template<typename PixelT>
+inline const PixelT* BasicImage<PixelT>::getPixelPointer() const
+//--------------------------------------------------------------
+{
+    return m_pixel_data.size() ? &m_pixel_data[0] : 0;
+}
+
+
+//--------------------------------------------------
+template<typename PixelT>
+inline PixelT* BasicImage<PixelT>::getPixelPointer()
+//--------------------------------------------------
+{
+    // To be on the safe side, turn the flag off
+    m_stats_up_to_date = false;
+
+    return m_pixel_data.size() ? &m_pixel_data[0] : 0;
+}
@@ -0,0 +1,109 @@
+#ifndef __Convolution_h
+#define __Convolution_h
+
+#include <vector>
+#include <cstddef>  // size_t
+
+
+//------------------------------------------------------------------------------
+/// How to deal with the pixels outside of the image during a convolution
+//------------------------------------------------------------------------------
+enum BorderMode
+{
+    BORDER_EXTEND = 0, //< Use the closest pixel of the image
+    BORDER_ZERO,       //< The image is padded with zeros
+    BORDER_CROP        //< Skip the output pixels that need values beyond the edge
+};
+
+
+//------------------------------------------------------------------------------
+/// How to compute a convolution
+//------------------------------------------------------------------------------
+enum ConvolutionMethod
+{
+    CONVOLUTION_AUTO = 0,  //< Use the cost model (see selectConvolutionMethod)
+    CONVOLUTION_SPATIAL,   //< The sum over all the coefficients of the kernel
+    CONVOLUTION_SEPARABLE, //< Two 1D passes (spatial if the kernel is not separable)
+    CONVOLUTION_FFT        //< Products of spectra, by overlap-save tiles (for large kernels)
+};
+
+
+//------------------------------------------------------------------------------
+/// Size of the result of a convolution
+/**
+* @param aWidth: the number of columns of the input image
+* @param aHeight: the number of rows of the input image
+* @param aKernelWidth: the number of columns of the kernel
+* @param aKernelHeight: the number of rows of the kernel
+* @param aBorderMode: how to deal with the border
+* @param anOutputWidth: the number of columns of the output image
+* @param anOutputHeight: the number of rows of the output image
+*/
+//------------------------------------------------------------------------------
+void getConvolutionSize(size_t aWidth, size_t aHeight,
+                        size_t aKernelWidth, size_t aKernelHeight,
+                        BorderMode aBorderMode,
+                        size_t& anOutputWidth, size_t& anOutputHeight);
+
+
+//------------------------------------------------------------------------------
+/// Split a kernel into a column and a row vector if it is separable, i.e. if
+/// h(k, l) = aColumnKernel[l] * aRowKernel[k] for all its coefficients (rank 1)
+/**
+* @param aKernel: the coefficients of the kernel, row by row
+* @param aKernelWidth: the number of columns of the kernel
+* @param aKernelHeight: the number of rows of the kernel
+* @param aRowKernel: the horizontal 1D kernel (aKernelWidth coefficients)
+* @param aColumnKernel: the vertical 1D kernel (aKernelHeight coefficients)
+* @return true if the kernel is separable, false otherwise
+*/
+//------------------------------------------------------------------------------
+bool separateKernel(const float* aKernel, size_t aKernelWidth, size_t aKernelHeight,
+                    std::vector<float>& aRowKernel, std::vector<float>& aColumnKernel);
+
+
+//------------------------------------------------------------------------------
+/// Choose the fastest way to compute a convolution. The cost model compares
+/// the number of operations of the spatial convolution (W_h x H_h per pixel),
+/// of the separable one (W_h + H_h per pixel), and of the FFT-based one (the
+/// transforms of the overlap-save tiles, of the best size).
+/**
+* @param aWidth: the number of columns of the output image
+* @param aHeight: the number of rows of the output image
+* @param aKernelWidth: the number of columns of the kernel
+* @param aKernelHeight: the number of rows of the kernel
+* @param aSeparableFlag: true if the kernel is separable (see separateKernel)
+* @return the method (never CONVOLUTION_AUTO)
+*/
+//------------------------------------------------------------------------------
+ConvolutionMethod selectConvolutionMethod(size_t aWidth, size_t aHeight,
+                                          size_t aKernelWidth, size_t aKernelHeight,
+                                          bool aSeparableFlag);
+
+
+//------------------------------------------------------------------------------
+/// 2D convolution (Lab 8):
+/// f'(x,y) = sum_l sum_k f(x - W_h / 2 + k, y - H_h / 2 + l) * h(k,l)
+/// Separable kernels are applied as two 1D passes. The image is processed in
+/// strips of rows whose data stays in the cache, and the inner loops use the
+/// SIMD kernels (see PixelKernels.h). Large kernels are applied in the
+/// frequency domain.
+/**
+* @param anInput: the pixels of the input image
+* @param aWidth: the number of columns of the input image
+* @param aHeight: the number of rows of the input image
+* @param aKernel: the coefficients of the kernel, row by row
+* @param aKernelWidth: the number of columns of the kernel
+* @param aKernelHeight: the number of rows of the kernel
+* @param aBorderMode: how to deal with the border
+* @param anOutput: the pixels of the output image (see getConvolutionSize)
+* @param aMethod: how to compute the convolution (automatic by default)
+*/
+//------------------------------------------------------------------------------
+void convolve(const float* anInput, size_t aWidth, size_t aHeight,
+              const float* aKernel, size_t aKernelWidth, size_t aKernelHeight,
+              BorderMode aBorderMode, float* anOutput,
+              ConvolutionMethod aMethod = CONVOLUTION_AUTO);
+
+
+#endif // __Convolution_h
@@ -0,0 +1,138 @@
+#ifndef __FFT_h
+#define __FFT_h
+
+#include <vector>
+#include <complex>
+#include <cstddef>  // size_t
+
+
+//------------------------------------------------------------------------------
+/// Fast Fourier transform of a complex sequence (mixed radix 2, 3, 4 and 5).
+/// The plan (factors and twiddle factors) is computed by the constructor, and
+/// can then be used by several threads at the same time.
+//------------------------------------------------------------------------------
+class FFT
+{
+public:
+    typedef std::complex<double> Complex;
+
+
+    //--------------------------------------------------------------------------
+    /// Constructor
+    /**
+    * @param aSize: the number of samples, a product of powers of 2, 3 and 5
+    * (see getFastSize)
+    * @param anInverseFlag: true for the inverse transform, false otherwise
+    */
+    //--------------------------------------------------------------------------
+    FFT(size_t aSize, bool anInverseFlag = false);
+
+
+    //--------------------------------------------------------------------------
+    /// Compute the transform. The inverse transform is not normalised, i.e. the
+    /// output is multiplied by the number of samples.
+    /**
+    * @param anInput: the input samples
+    * @param anOutput: the output samples (must differ from anInput)
+    */
+    //--------------------------------------------------------------------------
+    void transform(const Complex* anInput, Complex* anOutput) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the number of samples
+    /**
+    * @return the number of samples
+    */
+    //--------------------------------------------------------------------------
+    size_t getSize() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Smallest size supported that is greater or equal to a given size
+    /**
+    * @param aMinimumSize: the number of samples needed
+    * @param anEvenFlag: true if the size must be even (see RealFFT)
+    * @return the size, a product of powers of 2, 3 and 5
+    */
+    //--------------------------------------------------------------------------
+    static size_t getFastSize(size_t aMinimumSize, bool anEvenFlag = false);
+
+private:
+    //--------------------------------------------------------------------------
+    /// Recursive decimation in time
+    /**
+    * @param anOutput: the output samples
+    * @param anInput: the first input sample
+    * @param anInputStride: the distance between two input samples
+    * @param aFactor: the index of the radix in m_factors
+    */
+    //--------------------------------------------------------------------------
+    void transform(Complex* anOutput, const Complex* anInput, size_t anInputStride, size_t aFactor) const;
+
+
+    size_t m_size;                  //< The number of samples
+    bool m_inverse;                 //< True for the inverse transform
+    std::vector<size_t> m_factors;  //< Pairs of radix (4, 2, 3 or 5) and length of the sub-transforms
+    std::vector<Complex> m_twiddle_factors; //< exp(-+2 pi i k / m_size)
+};
+
+
+//------------------------------------------------------------------------------
+/// Fast Fourier transform of a real sequence, computed as a complex transform
+/// of half the size. Only the first N / 2 + 1 coefficients of the spectrum
+/// are stored, the others are their complex conjugates.
+//------------------------------------------------------------------------------
+class RealFFT
+{
+public:
+    typedef FFT::Complex Complex;
+
+
+    //--------------------------------------------------------------------------
+    /// Constructor
+    /**
+    * @param aSize: the number of samples N, even (see FFT::getFastSize)
+    */
+    //--------------------------------------------------------------------------
+    explicit RealFFT(size_t aSize);
+
+
+    //--------------------------------------------------------------------------
+    /// Forward transform
+    /**
+    * @param anInput: the N real samples
+    * @param anOutput: the N / 2 + 1 first coefficients of the spectrum
+    */
+    //--------------------------------------------------------------------------
+    void forward(const double* anInput, Complex* anOutput) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Inverse transform, not normalised (the output is multiplied by N)
+    /**
+    * @param anInput: the N / 2 + 1 first coefficients of the spectrum. They are
+    * overwritten.
+    * @param anOutput: the N real samples
+    */
+    //--------------------------------------------------------------------------
+    void inverse(Complex* anInput, double* anOutput) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the number of samples
+    /**
+    * @return the number of samples
+    */
+    //--------------------------------------------------------------------------
+    size_t getSize() const;
+
+private:
+    size_t m_size;                  //< The number of samples
+    FFT m_forward;                  //< The complex transform of size N / 2
+    FFT m_inverse;                  //< The complex inverse transform of size N / 2
+    std::vector<Complex> m_twiddle_factors; //< exp(-2 pi i k / N)
+};
+
+
+#endif // __FFT_h
@@ -0,0 +1,144 @@
+#ifndef __Half_h
+#define __Half_h
+
+#include <cstdint>  // uint16_t, uint32_t
+#include <cstring>  // std::memcpy
+
+
+//------------------------------------------------------------------------------
+/// Half-precision floating point number (IEEE 754 binary16), used to store
+/// the pixels of a BasicImage<Half>. It is only a storage type: the
+/// computations are done in float, and the conversions are explicit.
+//------------------------------------------------------------------------------
+class Half
+{
+public:
+    //--------------------------------------------------------------------------
+    /// Default constructor: +0
+    //--------------------------------------------------------------------------
+    Half():
+        m_bits(0)
+    {}
+
+
+    //--------------------------------------------------------------------------
+    /// Conversion from a float, rounded to the nearest half (ties to even).
+    /// The finite values beyond the range are saturated to +/-65504, the
+    /// infinities and NaNs are kept.
+    /**
+    * @param aValue: the value to convert
+    */
+    //--------------------------------------------------------------------------
+    explicit Half(float aValue):
+        m_bits(fromFloat(aValue))
+    {}
+
+
+    //--------------------------------------------------------------------------
+    /// Conversion to a float (exact)
+    /**
+    * @return the value
+    */
+    //--------------------------------------------------------------------------
+    explicit operator float() const
+    {
+        return toFloat(m_bits);
+    }
+
+
+    //--------------------------------------------------------------------------
+    /// Create a half from its binary representation
+    /**
+    * @param aBits: the 16 bits of the number
+    * @return the half
+    */
+    //--------------------------------------------------------------------------
+    static Half fromBits(uint16_t aBits)
+    {
+        Half half;
+        half.m_bits = aBits;
+        return half;
+    }
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the binary representation
+    /**
+    * @return the 16 bits of the number
+    */
+    //--------------------------------------------------------------------------
+    uint16_t getBits() const
+    {
+        return m_bits;
+    }
+
+
+    bool operator==(const Half& aValue) const { return m_bits == aValue.m_bits; }
+    bool operator!=(const Half& aValue) const { return m_bits != aValue.m_bits; }
+
+private:
+    static uint16_t fromFloat(float aValue)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &aValue, 4);
+
+        uint16_t sign = uint16_t((bits >> 16) & 0x8000);
+        bits &= 0x7fffffff;
+
+        // Infinity or NaN (quiet)
+        if (bits >= 0x7f800000) return sign | (bits > 0x7f800000 ? 0x7e00 : 0x7c00);
+
+        // Saturation to the largest finite half (65504)
+        if (bits >= 0x477fe000) return sign | 0x7bff;
+
+        // Subnormal half, or zero: let the FPU round the mantissa by adding 0.5
+        if (bits < 0x38800000)
+        {
+            float value;
+            std::memcpy(&value, &bits, 4);
+            value += 0.5f;
+            std::memcpy(&bits, &value, 4);
+            return sign | uint16_t(bits - 0x3f000000);
+        }
+
+        // Normal half: rebias the exponent, round the mantissa to 10 bits
+        uint32_t odd_mantissa = (bits >> 13) & 1;
+        bits += 0xc8000fff + odd_mantissa;
+        return sign | uint16_t(bits >> 13);
+    }
+
+    static float toFloat(uint16_t aBits)
+    {
+        uint32_t sign = uint32_t(aBits & 0x8000) << 16;
+        uint32_t exponent = (aBits >> 10) & 0x1f;
+        uint32_t mantissa = aBits & 0x3ff;
+
+        uint32_t bits;
+
+        // Zero or subnormal: mantissa x 2^-24
+        if (!exponent)
+        {
+            float value = float(mantissa) * (1.0f / 16777216.0f);
+            std::memcpy(&bits, &value, 4);
+            bits |= sign;
+        }
+        // Infinity or NaN
+        else if (exponent == 31)
+        {
+            bits = sign | 0x7f800000 | (mantissa << 13);
+        }
+        else
+        {
+            bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+        }
+
+        float value;
+        std::memcpy(&value, &bits, 4);
+        return value;
+    }
+
+    uint16_t m_bits; //< Sign (1 bit), exponent (5 bits) and mantissa (10 bits)
+};
+
+
+#endif // __Half_h
@@ -5,18 +5,31 @@
 #include <string>
 #include <iostream>
 
-class Image;
+#include "BasicImage.h"
+#include "ImageExpression.h"
+#include "Convolution.h"
+#include "PixelRow.h"
+
+typedef BasicImage<float> Image;
 std::ostream& operator<<(std::ostream& anOutputStream, const Image& anImage);
-Image operator*(float aValue, const Image&);
-Image operator+(float aValue, const Image&);
 
-class Image
+//------------------------------------------------------------------------------
+/// Greyscale image with float pixels (Image), used for all the processing:
+/// pixel-wise expressions, convolutions, filters, etc. The images of other
+/// pixel types (see BasicImage.h) are converted explicitly, e.g.
+/// Image image(ImageU8("photo.jpg")).
+//------------------------------------------------------------------------------
+template<>
+class BasicImage<float>
 {
 public:
+    typedef float PixelType;
+
+
     //--------------------------------------------------------------------------
     /// Default constructor: Create an empty image
     //--------------------------------------------------------------------------
-    Image();
+    BasicImage();
 
 
     //--------------------------------------------------------------------------
@@ -25,7 +38,16 @@ public:
     * @param anImage: The image to copy
     */
     //--------------------------------------------------------------------------
-    Image(const Image& anImage);
+    BasicImage(const Image& anImage);
+
+
+    //--------------------------------------------------------------------------
+    /// Move constructor: Take over the pixel data of an existing image
+    /**
+    * @param anImage: The image to move. It is left empty.
+    */
+    //--------------------------------------------------------------------------
+    BasicImage(Image&& anImage) noexcept;
 
 
     //--------------------------------------------------------------------------
@@ -36,7 +58,7 @@ public:
     * @param aHeight: The image height
     */
     //--------------------------------------------------------------------------
-    Image(const float* anImage, size_t aWidth, size_t aHeight);
+    BasicImage(const float* anImage, size_t aWidth, size_t aHeight);
 
 
     //--------------------------------------------------------------------------
@@ -47,7 +69,7 @@ public:
     * @param aHeight: The image height
     */
     //--------------------------------------------------------------------------
-    Image(const std::vector<float>& anImage, size_t aWidth, size_t aHeight);
+    BasicImage(const std::vector<float>& anImage, size_t aWidth, size_t aHeight);
 
 
     //--------------------------------------------------------------------------
@@ -58,7 +80,7 @@ public:
     * @param aHeight: The image height
     */
     //--------------------------------------------------------------------------
-    Image(float aConstant, size_t aWidth, size_t aHeight);
+    BasicImage(float aConstant, size_t aWidth, size_t aHeight);
 
 
     //--------------------------------------------------------------------------
@@ -67,7 +89,7 @@ public:
     * @param aFilename: The name of the file to load
     */
     //--------------------------------------------------------------------------
-    Image(const char* aFilename);
+    BasicImage(const char* aFilename);
 
 
     //--------------------------------------------------------------------------
@@ -76,7 +98,28 @@ public:
     * @param aFilename: The name of the file to load
     */
     //--------------------------------------------------------------------------
-    Image(const std::string& aFilename);
+    BasicImage(const std::string& aFilename);
+
+
+    //--------------------------------------------------------------------------
+    /// Constructor: Evaluate a pixel-wise expression, e.g. alpha * img1 + beta.
+    /// The whole expression is computed in a single pass over the pixels.
+    /**
+    * @param anExpression: The expression to evaluate
+    */
+    //--------------------------------------------------------------------------
+    template<typename E>
+    BasicImage(const ImageExpression<E>& anExpression);
+
+
+    //--------------------------------------------------------------------------
+    /// Conversion from another pixel type (see convertPixels)
+    /**
+    * @param anImage: The image to convert
+    */
+    //--------------------------------------------------------------------------
+    template<typename PixelT>
+    explicit BasicImage(const BasicImage<PixelT>& anImage);
 
 
     //--------------------------------------------------------------------------
@@ -89,6 +132,28 @@ public:
     Image& operator=(const Image& anInputImage);
 
 
+    //--------------------------------------------------------------------------
+    /// Move assignment operator
+    /**
+    * @param anInputImage: The image to move. It is left empty.
+    * @return the new image
+    */
+    //--------------------------------------------------------------------------
+    Image& operator=(Image&& anInputImage) noexcept;
+
+
+    //--------------------------------------------------------------------------
+    /// Assignment operator: Evaluate a pixel-wise expression in a single pass.
+    /// The pixel data of the instance is reused if it has the right size.
+    /**
+    * @param anExpression: The expression to evaluate
+    * @return the new image
+    */
+    //--------------------------------------------------------------------------
+    template<typename E>
+    Image& operator=(const ImageExpression<E>& anExpression);
+
+
     //--------------------------------------------------------------------------
     /// Assignment operator
     /**
@@ -110,39 +175,73 @@ public:
 
 
     //--------------------------------------------------------------------------
-    /// Load a file from the disk
+    /// Load a file from the disk, possibly at a reduced resolution. The
+    /// format is found from the first bytes of the file: JPEG, or one of the
+    /// uncompressed formats of ImageIO.h (raw, PGM, PFM or TIFF).
     /**
     * @param aFilename: The name of the file to load
+    * @param aScaleHint: The scale of the image that is needed, e.g. 0.25 for
+    * a quarter of the width and of the height. A JPEG file is decoded at 1,
+    * 1/2, 1/4 or 1/8 of its size (the DCT coefficients of the other
+    * frequencies are skipped): the smallest of them that is not smaller than
+    * aScaleHint. The other files are always loaded at full resolution.
     */
     //--------------------------------------------------------------------------
-    void load(const char* aFilename);
+    void load(const char* aFilename, float aScaleHint = 1.0f);
 
 
     //--------------------------------------------------------------------------
-    /// Load a file from the disk
+    /// Load a file from the disk, possibly at a reduced resolution
     /**
     * @param aFilename: The name of the file to load
+    * @param aScaleHint: The scale of the image that is needed (see above)
     */
     //--------------------------------------------------------------------------
-    void load(const std::string& aFilename);
+    void load(const std::string& aFilename, float aScaleHint = 1.0f);
 
 
     //--------------------------------------------------------------------------
-    /// Save a JPEG file on the disk
+    /// Save a JPEG file on the disk. The file is greyscale, and the pixels are
+    /// rounded to the nearest integer and saturated to [0, 255].
     /**
     * @param aFilename: The name of the file to save
+    * @param aQuality: The quality, from 1 (smallest file) to 100 (best image)
+    * @param anOptimiseFlag: true to compute optimal Huffman tables (smaller
+    * file, slower encoding)
     */
     //--------------------------------------------------------------------------
-    void saveJPEG(const char* aFilename);
+    void saveJPEG(const char* aFilename, int aQuality = 75, bool anOptimiseFlag = false) const;
 
 
     //--------------------------------------------------------------------------
     /// Save a JPEG file on the disk
     /**
     * @param aFilename: The name of the file to save
+    * @param aQuality: The quality, from 1 (smallest file) to 100 (best image)
+    * @param anOptimiseFlag: true to compute optimal Huffman tables
     */
     //--------------------------------------------------------------------------
-    void saveJPEG(const std::string& aFilename);
+    void saveJPEG(const std::string& aFilename, int aQuality = 75, bool anOptimiseFlag = false) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Save the image in a file. The format is given by the extension of the
+    /// file: .jpg or .jpeg (lossy, 8 bits), .raw, .pfm or .tif (the floats
+    /// are stored without any loss).
+    /**
+    * @param aFilename: The name of the file to save
+    */
+    //--------------------------------------------------------------------------
+    void save(const char* aFilename) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Save the image in a file (see above)
+    /**
+    * @param aFilename: The name of the file to save
+    */
+    //--------------------------------------------------------------------------
+    void save(const std::string& aFilename) const;
 
 
     //--------------------------------------------------------------------------
@@ -167,6 +266,36 @@ public:
     float& operator()(size_t col, size_t row);
 
 
+    //--------------------------------------------------------------------------
+    /// Accessor on a given pixel without any bounds check
+    /**
+    * @param col: coordinate of the pixel along the horizontal axis
+    * @param row: coordinate of the pixel along the vertical axis
+    * @return the corresponding pixel value
+    */
+    //--------------------------------------------------------------------------
+    const float& atUnchecked(size_t col, size_t row) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on a row of pixels without any bounds check
+    /**
+    * @param row: coordinate of the row along the vertical axis
+    * @return the corresponding row
+    */
+    //--------------------------------------------------------------------------
+    PixelRow<const float> getRow(size_t row) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on all the rows of pixels, e.g. to use in a range-based loop
+    /**
+    * @return the rows
+    */
+    //--------------------------------------------------------------------------
+    PixelRows<const float> getRows() const;
+
+
     //--------------------------------------------------------------------------
     /// Accessor on the image width in number of pixels
     /**
@@ -204,87 +333,85 @@ public:
 
 
     //--------------------------------------------------------------------------
-    /// Add a constant value to all the pixels of an image
+    /// Add a constant value to all the pixels of an image.
+    /// This method actually change the pixel values of the instance.
     /**
     * @param aValue: the value to add
     * @return the new image
     */
     //--------------------------------------------------------------------------
-    Image operator+(float aValue) const;
+    Image& operator+=(float aValue);
     
     
     //--------------------------------------------------------------------------
-    /// Subtract a constant value to all the pixels of an image
+    /// Subtract a constant value to all the pixels of an image.
+    /// This method actually change the pixel values of the instance.
     /**
     * @param aValue: the value to subtract
     * @return the new image
     */
     //--------------------------------------------------------------------------
-    Image operator-(float aValue) const;
+    Image& operator-=(float aValue);
     
     
     //--------------------------------------------------------------------------
-    /// Multiply all the pixels of an image with a constant value
+    /// Multiply all the pixels of an image with a constant value.
+    /// This method actually change the pixel values of the instance.
     /**
     * @param aValue: the value to multiply
     * @return the new image
     */
     //--------------------------------------------------------------------------
-    Image operator*(float aValue) const;
+    Image& operator*=(float aValue);
     
     
     //--------------------------------------------------------------------------
-    /// Divide all the pixels of an image by a constant value
+    /// Divide all the pixels of an image by a constant value.
+    /// This method actually change the pixel values of the instance.
     /**
     * @param aValue: the divisor
     * @return the new image
     */
     //--------------------------------------------------------------------------
-    Image operator/(float aValue) const;
-
-
+    Image& operator/=(float aValue);
+    
+    
     //--------------------------------------------------------------------------
-    /// Add a constant value to all the pixels of an image.
-    /// This method actually change the pixel values of the instance.
+    /// Absolute value of all the pixels of an image.
     /**
-    * @param aValue: the value to add
     * @return the new image
     */
     //--------------------------------------------------------------------------
-    Image& operator+=(float aValue);
+    Image absoluteValue() const;
     
     
     //--------------------------------------------------------------------------
-    /// Subtract a constant value to all the pixels of an image.
-    /// This method actually change the pixel values of the instance.
+    /// Square of all the pixels of an image.
     /**
-    * @param aValue: the value to subtract
     * @return the new image
     */
     //--------------------------------------------------------------------------
-    Image& operator-=(float aValue);
+    Image square() const;
     
     
     //--------------------------------------------------------------------------
-    /// Multiply all the pixels of an image with a constant value.
-    /// This method actually change the pixel values of the instance.
+    /// Square root of all the pixels of an image.
     /**
-    * @param aValue: the value to multiply
     * @return the new image
     */
     //--------------------------------------------------------------------------
-    Image& operator*=(float aValue);
+    Image squareRoot() const;
     
     
     //--------------------------------------------------------------------------
-    /// Divide all the pixels of an image by a constant value.
-    /// This method actually change the pixel values of the instance.
+    /// Clamp all the pixels of an image in a given range.
     /**
-    * @param aValue: the divisor
+    * @param aLowerThreshold: the smallest pixel value allowed
+    * @param anUpperThreshold: the largest pixel value allowed
     * @return the new image
     */
     //--------------------------------------------------------------------------
-    Image& operator/=(float aValue);
+    Image clamp(float aLowerThreshold, float anUpperThreshold) const;
     
     
     //--------------------------------------------------------------------------
@@ -296,6 +423,106 @@ public:
     Image normalise();
     
     
+    //--------------------------------------------------------------------------
+    /// 2D convolution: f'(x,y) = sum_l sum_k f(x - W_h / 2 + k, y - H_h / 2 + l) * h(k,l).
+    /// Separable kernels (e.g. Gaussian, Sobel) are detected and applied as two
+    /// 1D passes, and large kernels are applied in the frequency domain.
+    /**
+    * @param aKernel: the kernel h
+    * @param aBorderMode: how to deal with the border (BORDER_EXTEND by default)
+    * @param aMethod: how to compute the convolution (chosen using a cost model
+    * by default)
+    * @return the new image (smaller than the input with BORDER_CROP)
+    */
+    //--------------------------------------------------------------------------
+    Image conv2d(const Image& aKernel,
+                 BorderMode aBorderMode = BORDER_EXTEND,
+                 ConvolutionMethod aMethod = CONVOLUTION_AUTO) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Gaussian filter (3x3 kernel).
+    /**
+    * @return the new image
+    */
+    //--------------------------------------------------------------------------
+    Image gaussianFilter() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Mean filter over a (2r + 1) x (2r + 1) window (3x3 by default). It uses
+    /// a summed-area table (see SummedAreaTable.h): its cost per pixel does not
+    /// depend on the radius. The border is extended.
+    /**
+    * @param aRadius: the radius r of the window
+    * @return the new image
+    */
+    //--------------------------------------------------------------------------
+    Image meanFilter(unsigned int aRadius = 1) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Average filter, i.e. mean filter.
+    /**
+    * @param aRadius: the radius r of the window
+    * @return the new image
+    */
+    //--------------------------------------------------------------------------
+    Image averageFilter(unsigned int aRadius = 1) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Box filter, i.e. mean filter.
+    /**
+    * @param aRadius: the radius r of the window
+    * @return the new image
+    */
+    //--------------------------------------------------------------------------
+    Image boxFilter(unsigned int aRadius = 1) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Laplacian filter (3x3 kernel).
+    /**
+    * @return the new image
+    */
+    //--------------------------------------------------------------------------
+    Image laplacianFilter() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Gradient magnitude using the Sobel operator: sqrt(G_x^2 + G_y^2).
+    /**
+    * @return the new image
+    */
+    //--------------------------------------------------------------------------
+    Image gradientMagnitude() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Median filter over a (2r + 1) x (2r + 1) window (see MedianFilter.h).
+    /// The border is extended. The result is exact: if all the pixels are
+    /// integers in [0, 255], the constant-time filter of the 8-bit images is
+    /// used, otherwise the median of each window is selected in O(r^2).
+    /**
+    * @param aRadius: the radius r of the window (1 for 3x3)
+    * @return the new image
+    */
+    //--------------------------------------------------------------------------
+    Image medianFilter(unsigned int aRadius = 1) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Sharpen the image: original + alpha * (original - 5x5 Gaussian blur).
+    /// The result is clamped to the dynamic range of the input.
+    /**
+    * @param alpha: the weight of the details
+    * @return the new image
+    */
+    //--------------------------------------------------------------------------
+    Image sharpen(double alpha);
+
+
     //--------------------------------------------------------------------------
     /// Accessor on the smallest pixel value
     /**
@@ -313,13 +540,59 @@ public:
     //--------------------------------------------------------------------------
     float getMaxValue();
 
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the average pixel value
+    /**
+    * @return the average pixel value
+    */
+    //--------------------------------------------------------------------------
+    float getAverageValue();
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the standard deviation of the pixel values
+    /**
+    * @return the standard deviation of the pixel values
+    */
+    //--------------------------------------------------------------------------
+    float getStandardDeviation();
+
 private:
     //--------------------------------------------------------------------------
-    /// Update the image statistics if needed
+    /// Throw an exception for a pixel that does not exist
+    /**
+    * @param col: coordinate of the pixel along the horizontal axis
+    * @param row: coordinate of the pixel along the vertical axis
+    */
+    //--------------------------------------------------------------------------
+    void throwOutOfRange(size_t col, size_t row) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Update the image statistics if needed. Min, max, mean and standard
+    /// deviation are computed in a single pass, using several threads for
+    /// large images.
     //--------------------------------------------------------------------------
     void updateStats();
+
+
+    //--------------------------------------------------------------------------
+    /// Evaluate a pixel-wise expression and store the result in the instance
+    /**
+    * @param anExpression: The expression to evaluate
+    */
+    //--------------------------------------------------------------------------
+    template<typename E>
+    void evaluate(const E& anExpression);
+
+    // Can take over the pixel data of a temporary image
+    friend class ImageTemporary;
+
+    // Can write the pixels and handle the statistics flag
+    friend class PixelWriter;
     
-    std::vector<float> m_pixel_data; //< The pixel data in greyscale as a 1D array (here STL vector)
+    PixelBuffer<float> m_pixel_data; //< The pixel data in greyscale as a 1D array, aligned on PIXEL_ALIGNMENT bytes
     size_t m_width; //< The number of columns
     size_t m_height; //< The number of rows
     float m_min_pixel_value; //< The smallest pixel value
@@ -330,4 +603,70 @@ private:
     bool m_stats_up_to_date; //< True if m_min_pixel_value, m_max_pixel_value, m_average_pixel_value and m_stddev_pixel_value are up-to-date, false otherwise
 };
 
+
+//------------------------------------------------------------------------------
+/// Write access to the pixels of an image without any bounds check, e.g. for
+/// filters. The statistics of the image are marked out-of-date when the writer
+/// is created and when it is destroyed, not at every pixel access.
+//------------------------------------------------------------------------------
+class PixelWriter
+{
+public:
+    //--------------------------------------------------------------------------
+    /// Constructor
+    /**
+    * @param anImage: The image to modify
+    */
+    //--------------------------------------------------------------------------
+    explicit PixelWriter(Image& anImage);
+
+
+    //--------------------------------------------------------------------------
+    /// Destructor
+    //--------------------------------------------------------------------------
+    ~PixelWriter();
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on a given pixel without any bounds check
+    /**
+    * @param col: coordinate of the pixel along the horizontal axis
+    * @param row: coordinate of the pixel along the vertical axis
+    * @return the corresponding pixel value
+    */
+    //--------------------------------------------------------------------------
+    float& atUnchecked(size_t col, size_t row) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on a row of pixels without any bounds check
+    /**
+    * @param row: coordinate of the row along the vertical axis
+    * @return the corresponding row
+    */
+    //--------------------------------------------------------------------------
+    PixelRow<float> getRow(size_t row) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on all the rows of pixels, e.g. to use in a range-based loop
+    /**
+    * @return the rows
+    */
+    //--------------------------------------------------------------------------
+    PixelRows<float> getRows() const;
+
+
+    PixelWriter(const PixelWriter&) = delete;
+    PixelWriter& operator=(const PixelWriter&) = delete;
+
+private:
+    Image& m_image;  //< The image to modify
+    float* m_p_data; //< Its pixel data
+    size_t m_width;  //< The number of columns
+};
+
+
+#include "Image.inl"
+
 #endif // __Image_h
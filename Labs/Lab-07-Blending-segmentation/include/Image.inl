@@ -0,0 +1,516 @@
+#include <type_traits>
+
+#include "PixelKernels.h"
+#include "ThreadPool.h"
+
+
+//------------------------------------------------------------------------------
+/// An image used in an expression. Only its pixel pointer is kept.
+//------------------------------------------------------------------------------
+class ImageReference: public ImageExpression<ImageReference>
+{
+public:
+    //--------------------------------------------------------------------------
+    /// Constructor
+    /**
+    * @param anImage: the image
+    */
+    //--------------------------------------------------------------------------
+    explicit ImageReference(const Image& anImage):
+        m_p_data(anImage.getPixelPointer()),
+        m_width(anImage.getWidth()),
+        m_height(anImage.getHeight())
+    {}
+
+    float operator[](size_t anIndex) const { return m_p_data[anIndex]; }
+    const float* getPixelPointer() const { return m_p_data; }
+    bool isScalar() const { return false; }
+    size_t getWidth() const { return m_width; }
+    size_t getHeight() const { return m_height; }
+    bool stealPixelData(PixelBuffer<float>&, size_t) const { return false; }
+
+private:
+    const float* m_p_data; //< The pixel data
+    size_t m_width;        //< The number of columns
+    size_t m_height;       //< The number of rows
+};
+
+
+//------------------------------------------------------------------------------
+/// A temporary image used in an expression, e.g. the result of a function.
+/// The expression owns it, and its pixel data can be reused for the result.
+//------------------------------------------------------------------------------
+class ImageTemporary: public ImageExpression<ImageTemporary>
+{
+public:
+    //--------------------------------------------------------------------------
+    /// Constructor
+    /**
+    * @param anImage: the temporary image
+    */
+    //--------------------------------------------------------------------------
+    explicit ImageTemporary(Image&& anImage):
+        m_image(std::move(anImage)),
+        m_p_data(static_cast<const Image&>(m_image).getPixelPointer())
+    {}
+
+    ImageTemporary(const ImageTemporary& anExpression):
+        m_image(anExpression.m_image),
+        m_p_data(static_cast<const Image&>(m_image).getPixelPointer())
+    {}
+
+    // Moving the image does not move its buffer, m_p_data remains valid
+    ImageTemporary(ImageTemporary&& anExpression):
+        m_image(std::move(anExpression.m_image)),
+        m_p_data(anExpression.m_p_data)
+    {}
+
+    float operator[](size_t anIndex) const { return m_p_data[anIndex]; }
+    const float* getPixelPointer() const { return m_p_data; }
+    bool isScalar() const { return false; }
+    size_t getWidth() const { return m_image.getWidth(); }
+    size_t getHeight() const { return m_image.getHeight(); }
+
+    bool stealPixelData(PixelBuffer<float>& aPixelData, size_t aNumberOfPixels) const
+    {
+        // The buffer does not have the right size or it was already taken
+        if (m_image.m_pixel_data.size() != aNumberOfPixels) return false;
+
+        // m_p_data still points to the same buffer, now owned by aPixelData.
+        // It is safe as the pixels are read before being written.
+        aPixelData = std::move(m_image.m_pixel_data);
+        return true;
+    }
+
+private:
+    mutable Image m_image; //< The temporary image
+    const float* m_p_data; //< The pixel data
+};
+
+
+//------------------------------------------------------------------------------
+/// Convert an operand of an arithmetic operator into an expression.
+/// Only numbers, images and expressions are valid operands.
+//------------------------------------------------------------------------------
+template<typename T, typename Enable = void>
+struct ImageOperand
+{
+    enum { is_valid = false, is_scalar = false };
+};
+
+// A number
+template<typename T>
+struct ImageOperand<T, typename std::enable_if<
+    std::is_arithmetic<typename std::decay<T>::type>::value>::type>
+{
+    enum { is_valid = true, is_scalar = true };
+    typedef ScalarExpression type;
+    static type make(T aValue) { return type(float(aValue)); }
+};
+
+// An existing image, the expression keeps a reference
+template<typename T>
+struct ImageOperand<T, typename std::enable_if<
+    std::is_same<typename std::decay<T>::type, Image>::value &&
+    !std::is_same<T, Image>::value>::type>
+{
+    enum { is_valid = true, is_scalar = false };
+    typedef ImageReference type;
+    static type make(const Image& anImage) { return type(anImage); }
+};
+
+// A temporary image, the expression owns it
+template<>
+struct ImageOperand<Image, void>
+{
+    enum { is_valid = true, is_scalar = false };
+    typedef ImageTemporary type;
+    static type make(Image&& anImage) { return type(std::move(anImage)); }
+};
+
+// Another expression, the expression owns a copy
+template<typename T>
+struct ImageOperand<T, typename std::enable_if<
+    std::is_base_of<ImageExpressionBase, typename std::decay<T>::type>::value>::type>
+{
+    enum { is_valid = true, is_scalar = false };
+    typedef typename std::decay<T>::type type;
+    static type make(T&& anExpression) { return type(std::forward<T>(anExpression)); }
+};
+
+
+//------------------------------------------------------------------------------
+/// Type of the expression created by an arithmetic operator. It is only
+/// defined if the operands are valid, and if at least one of them is not a
+/// number.
+//------------------------------------------------------------------------------
+template<bool IsValid, typename Operator, typename L, typename R>
+struct ImageOperatorResultImpl
+{};
+
+template<typename Operator, typename L, typename R>
+struct ImageOperatorResultImpl<true, Operator, L, R>
+{
+    typedef BinaryExpression<Operator,
+        typename ImageOperand<L>::type,
+        typename ImageOperand<R>::type> type;
+};
+
+template<typename Operator, typename L, typename R>
+struct ImageOperatorResult: ImageOperatorResultImpl<
+    ImageOperand<L>::is_valid && ImageOperand<R>::is_valid &&
+    !(ImageOperand<L>::is_scalar && ImageOperand<R>::is_scalar),
+    Operator, L, R>
+{};
+
+
+//-------------------------------------------------------------------
+template<typename L, typename R>
+typename ImageOperatorResult<ImageAddition, L, R>::type
+operator+(L&& aLeftOperand, R&& aRightOperand)
+//-------------------------------------------------------------------
+{
+    return typename ImageOperatorResult<ImageAddition, L, R>::type(
+        ImageOperand<L>::make(std::forward<L>(aLeftOperand)),
+        ImageOperand<R>::make(std::forward<R>(aRightOperand)));
+}
+
+
+//-------------------------------------------------------------------
+template<typename L, typename R>
+typename ImageOperatorResult<ImageSubtraction, L, R>::type
+operator-(L&& aLeftOperand, R&& aRightOperand)
+//-------------------------------------------------------------------
+{
+    return typename ImageOperatorResult<ImageSubtraction, L, R>::type(
+        ImageOperand<L>::make(std::forward<L>(aLeftOperand)),
+        ImageOperand<R>::make(std::forward<R>(aRightOperand)));
+}
+
+
+//-------------------------------------------------------------------
+template<typename L, typename R>
+typename ImageOperatorResult<ImageMultiplication, L, R>::type
+operator*(L&& aLeftOperand, R&& aRightOperand)
+//-------------------------------------------------------------------
+{
+    return typename ImageOperatorResult<ImageMultiplication, L, R>::type(
+        ImageOperand<L>::make(std::forward<L>(aLeftOperand)),
+        ImageOperand<R>::make(std::forward<R>(aRightOperand)));
+}
+
+
+//-------------------------------------------------------------------
+template<typename L, typename R>
+typename ImageOperatorResult<ImageDivision, L, R>::type
+operator/(L&& aLeftOperand, R&& aRightOperand)
+//-------------------------------------------------------------------
+{
+    return typename ImageOperatorResult<ImageDivision, L, R>::type(
+        ImageOperand<L>::make(std::forward<L>(aLeftOperand)),
+        ImageOperand<R>::make(std::forward<R>(aRightOperand)));
+}
+
+
+//-----------------------------------------------------------------
+inline const float& Image::operator()(size_t col, size_t row) const
+//-----------------------------------------------------------------
+{
+    // Check if the coordinates are valid, if not throw an error
+    if (col >= m_width || row >= m_height)
+    {
+        throwOutOfRange(col, row);
+    }
+
+    return m_pixel_data[row * m_width + col];
+}
+
+
+//-----------------------------------------------------
+inline float& Image::operator()(size_t col, size_t row)
+//-----------------------------------------------------
+{
+    // Check if the coordinates are valid, if not throw an error
+    if (col >= m_width || row >= m_height)
+    {
+        throwOutOfRange(col, row);
+    }
+
+    // To be on the safe side, turn the flag off
+    m_stats_up_to_date = false;
+
+    return m_pixel_data[row * m_width + col];
+}
+
+
+//------------------------------------------------------------------
+inline const float& Image::atUnchecked(size_t col, size_t row) const
+//------------------------------------------------------------------
+{
+    return m_pixel_data[row * m_width + col];
+}
+
+
+//----------------------------------------------------------
+inline PixelRow<const float> Image::getRow(size_t row) const
+//----------------------------------------------------------
+{
+    return PixelRow<const float>(getPixelPointer() + row * m_width, m_width);
+}
+
+
+//--------------------------------------------------
+inline PixelRows<const float> Image::getRows() const
+//--------------------------------------------------
+{
+    return PixelRows<const float>(getPixelPointer(), m_width, m_height, m_width);
+}
+
+
+//-----------------------------------
+inline size_t Image::getWidth() const
+//-----------------------------------
+{
+    return m_width;
+}
+
+
+//------------------------------------
+inline size_t Image::getHeight() const
+//------------------------------------
+{
+    return m_height;
+}
+
+
+//----------------------------------------------
+inline PixelWriter::PixelWriter(Image& anImage):
+//----------------------------------------------
+    m_image(anImage),
+    m_p_data(anImage.getPixelPointer()),
+    m_width(anImage.getWidth())
+//----------------------------------------------
+{
+    // getPixelPointer() has turned the statistics flag off
+}
+
+
+//--------------------------------
+inline PixelWriter::~PixelWriter()
+//--------------------------------
+{
+    // The statistics may have been computed while the pixels were modified
+    m_image.m_stats_up_to_date = false;
+}
+
+
+//------------------------------------------------------------------
+inline float& PixelWriter::atUnchecked(size_t col, size_t row) const
+//------------------------------------------------------------------
+{
+    return m_p_data[row * m_width + col];
+}
+
+
+//----------------------------------------------------------
+inline PixelRow<float> PixelWriter::getRow(size_t row) const
+//----------------------------------------------------------
+{
+    return PixelRow<float>(m_p_data + row * m_width, m_width);
+}
+
+
+//--------------------------------------------------
+inline PixelRows<float> PixelWriter::getRows() const
+//--------------------------------------------------
+{
+    return PixelRows<float>(m_p_data, m_width, m_image.getHeight(), m_width);
+}
+
+
+//------------------------------------------------------------------------------
+/// Select the SIMD kernel that matches a simple expression, i.e. a single
+/// operator applied to images and numbers
+//------------------------------------------------------------------------------
+template<typename Operator>
+struct PixelKernelSelector;
+
+template<>
+struct PixelKernelSelector<ImageAddition>
+{
+    static PixelKernels::ScalarKernel imageScalar(const PixelKernels& k) { return k.addScalar; }
+    static PixelKernels::ScalarKernel scalarImage(const PixelKernels& k) { return k.addScalar; }
+    static PixelKernels::BinaryKernel imageImage(const PixelKernels& k) { return k.add; }
+};
+
+template<>
+struct PixelKernelSelector<ImageSubtraction>
+{
+    static PixelKernels::ScalarKernel imageScalar(const PixelKernels& k) { return k.subtractScalar; }
+    static PixelKernels::ScalarKernel scalarImage(const PixelKernels& k) { return k.scalarSubtract; }
+    static PixelKernels::BinaryKernel imageImage(const PixelKernels& k) { return k.subtract; }
+};
+
+template<>
+struct PixelKernelSelector<ImageMultiplication>
+{
+    static PixelKernels::ScalarKernel imageScalar(const PixelKernels& k) { return k.multiplyScalar; }
+    static PixelKernels::ScalarKernel scalarImage(const PixelKernels& k) { return k.multiplyScalar; }
+    static PixelKernels::BinaryKernel imageImage(const PixelKernels& k) { return k.multiply; }
+};
+
+template<>
+struct PixelKernelSelector<ImageDivision>
+{
+    static PixelKernels::ScalarKernel imageScalar(const PixelKernels& k) { return k.divideScalar; }
+    static PixelKernels::ScalarKernel scalarImage(const PixelKernels& k) { return k.scalarDivide; }
+    static PixelKernels::BinaryKernel imageImage(const PixelKernels& k) { return k.divide; }
+};
+
+
+// True if E is an image in an expression
+template<typename E>
+struct IsImageOperand
+{
+    enum { value = std::is_same<E, ImageReference>::value ||
+        std::is_same<E, ImageTemporary>::value };
+};
+
+
+//---------------------------------------------------------------------------------------------
+// Any expression: generic loop, vectorised by the compiler if possible
+template<typename E>
+void evaluatePixels(const E& anExpression, float* anOutput, size_t aFirstPixel, size_t aSize)
+//---------------------------------------------------------------------------------------------
+{
+    for (size_t i = aFirstPixel; i < aFirstPixel + aSize; ++i)
+    {
+        anOutput[i] = anExpression[i];
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------------------------------
+// Image OP number
+template<typename Operator, typename L>
+typename std::enable_if<IsImageOperand<L>::value>::type
+evaluatePixels(const BinaryExpression<Operator, L, ScalarExpression>& anExpression, float* anOutput, size_t aFirstPixel, size_t aSize)
+//------------------------------------------------------------------------------------------------------------------------------------
+{
+    PixelKernelSelector<Operator>::imageScalar(getPixelKernels())(
+        anExpression.getLeftOperand().getPixelPointer() + aFirstPixel,
+        anExpression.getRightOperand().getValue(),
+        anOutput + aFirstPixel, aSize);
+}
+
+
+//------------------------------------------------------------------------------------------------------------------------------------
+// Number OP image
+template<typename Operator, typename R>
+typename std::enable_if<IsImageOperand<R>::value>::type
+evaluatePixels(const BinaryExpression<Operator, ScalarExpression, R>& anExpression, float* anOutput, size_t aFirstPixel, size_t aSize)
+//------------------------------------------------------------------------------------------------------------------------------------
+{
+    PixelKernelSelector<Operator>::scalarImage(getPixelKernels())(
+        anExpression.getRightOperand().getPixelPointer() + aFirstPixel,
+        anExpression.getLeftOperand().getValue(),
+        anOutput + aFirstPixel, aSize);
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------
+// Image OP image
+template<typename Operator, typename L, typename R>
+typename std::enable_if<IsImageOperand<L>::value && IsImageOperand<R>::value>::type
+evaluatePixels(const BinaryExpression<Operator, L, R>& anExpression, float* anOutput, size_t aFirstPixel, size_t aSize)
+//---------------------------------------------------------------------------------------------------------------------
+{
+    PixelKernelSelector<Operator>::imageImage(getPixelKernels())(
+        anExpression.getLeftOperand().getPixelPointer() + aFirstPixel,
+        anExpression.getRightOperand().getPixelPointer() + aFirstPixel,
+        anOutput + aFirstPixel, aSize);
+}
+
+
+//--------------------------------------------------------
+template<typename E>
+Image::BasicImage(const ImageExpression<E>& anExpression):
+//--------------------------------------------------------
+    m_width(0),
+    m_height(0),
+    m_min_pixel_value(0),
+    m_max_pixel_value(0),
+    m_average_pixel_value(0),
+    m_stddev_pixel_value(0),
+    m_stats_up_to_date(true)
+//--------------------------------------------------------
+{
+    evaluate(anExpression.getExpression());
+}
+
+
+//---------------------------------------------------
+template<typename PixelT>
+Image::BasicImage(const BasicImage<PixelT>& anImage):
+//---------------------------------------------------
+    m_pixel_data(anImage.getWidth() * anImage.getHeight()),
+    m_width(anImage.getWidth()),
+    m_height(anImage.getHeight()),
+    m_min_pixel_value(0),
+    m_max_pixel_value(0),
+    m_average_pixel_value(0),
+    m_stddev_pixel_value(0),
+    m_stats_up_to_date(false)
+//---------------------------------------------------
+{
+    if (m_pixel_data.size())
+    {
+        convertPixels(anImage.getPixelPointer(), &m_pixel_data[0], m_pixel_data.size());
+    }
+}
+
+
+//------------------------------------------------------------
+template<typename E>
+Image& Image::operator=(const ImageExpression<E>& anExpression)
+//------------------------------------------------------------
+{
+    evaluate(anExpression.getExpression());
+    return *this;
+}
+
+
+//------------------------------------------------------------
+template<typename E>
+void Image::evaluate(const E& anExpression)
+//------------------------------------------------------------
+{
+    size_t number_of_pixels = anExpression.getWidth() * anExpression.getHeight();
+
+    // The current buffer can't be used, reuse the one of a temporary if any.
+    // Note that the expression can't refer to the current buffer here, as
+    // all the images of an expression have the same size.
+    if (m_pixel_data.size() != number_of_pixels)
+    {
+        if (!anExpression.stealPixelData(m_pixel_data, number_of_pixels))
+        {
+            m_pixel_data.resize(number_of_pixels);
+        }
+    }
+
+    // Evaluate the expression in a single pass, by tiles run in parallel
+    if (number_of_pixels)
+    {
+        float* p_output = &m_pixel_data[0];
+        ThreadPool::getInstance().runOnTiles(number_of_pixels, [&](size_t aFirstPixel, size_t aNumberOfPixels)
+        {
+            evaluatePixels(anExpression, p_output, aFirstPixel, aNumberOfPixels);
+        });
+    }
+
+    m_width = anExpression.getWidth();
+    m_height = anExpression.getHeight();
+
+    // The statistics is not up-to-date
+    m_stats_up_to_date = false;
+}
@@ -0,0 +1,135 @@
+#ifndef __ImageBatchLoader_h
+#define __ImageBatchLoader_h
+
+#include <vector>
+#include <string>
+#include <cstddef>              // size_t
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>            // std::exception_ptr
+
+#include "Image.h"
+
+
+//------------------------------------------------------------------------------
+/// Loader of a list of image files (see Image::load). The files are decoded
+/// ahead of the caller by a set of threads, several at a time, while the caller
+/// processes the images that are already loaded: reading the disk, decoding
+/// and processing overlap. The images are handed out in the order of the list.
+/// The number of images loaded in advance is bounded, so is the memory.
+///
+/// The decoding threads are not the ones of the ThreadPool, which runs the
+/// operations of the caller.
+//------------------------------------------------------------------------------
+class ImageBatchLoader
+{
+public:
+    //--------------------------------------------------------------------------
+    /// Constructor: start loading the files
+    /**
+    * @param aFilenames: the names of the files, in the order of the images
+    * @param aNumberOfThreads: the number of files decoded at the same time, or
+    * 0 to use all the cores
+    * @param aQueueSize: the largest number of images loaded in advance (at
+    * least aNumberOfThreads), or 0 for twice the number of threads
+    * @param aScaleHint: the scale of the images that is needed (see
+    * Image::load)
+    */
+    //--------------------------------------------------------------------------
+    ImageBatchLoader(const std::vector<std::string>& aFilenames,
+                     size_t aNumberOfThreads = 0,
+                     size_t aQueueSize = 0,
+                     float aScaleHint = 1.0f);
+
+
+    //--------------------------------------------------------------------------
+    /// Destructor: stop the threads. The files that are being decoded are
+    /// finished first.
+    //--------------------------------------------------------------------------
+    ~ImageBatchLoader();
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the number of images
+    /**
+    * @return the number of files
+    */
+    //--------------------------------------------------------------------------
+    size_t getNumberOfImages() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the number of decoding threads
+    /**
+    * @return the number of threads
+    */
+    //--------------------------------------------------------------------------
+    size_t getNumberOfThreads() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the largest number of images loaded in advance
+    /**
+    * @return the size of the queue
+    */
+    //--------------------------------------------------------------------------
+    size_t getQueueSize() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Wait for the next image of the list. If the file could not be loaded,
+    /// the exception of Image::load is thrown instead, and the next call goes
+    /// on with the next file.
+    /**
+    * @param anImage: the image (its previous pixels are released)
+    * @param aFilename: the name of its file (optional)
+    * @return true if there was an image, false at the end of the list
+    */
+    //--------------------------------------------------------------------------
+    bool getNextImage(Image& anImage, std::string* aFilename = 0);
+
+
+    ImageBatchLoader(const ImageBatchLoader&) = delete;
+    ImageBatchLoader& operator=(const ImageBatchLoader&) = delete;
+
+private:
+    //--------------------------------------------------------------------------
+    /// An image of the queue
+    //--------------------------------------------------------------------------
+    struct Slot
+    {
+        Image m_image;                  //< The pixels
+        std::exception_ptr m_exception; //< The error of Image::load, if any
+        bool m_ready;                   //< True when the file is loaded
+    };
+
+
+    //--------------------------------------------------------------------------
+    /// Main loop of a decoding thread: load the next file of the list, as long
+    /// as there is room in the queue
+    //--------------------------------------------------------------------------
+    void workerLoop();
+
+
+    //--------------------------------------------------------------------------
+    /// Wake up the decoding threads and wait for the end of their current file
+    //--------------------------------------------------------------------------
+    void stopThreads();
+
+
+    std::vector<std::string> m_filenames;   //< The files to load
+    float m_scale_hint;                     //< The scale of the images
+    std::vector<Slot> m_slots;              //< The queue, m_slots[i % size] holds the image i
+    std::vector<std::thread> m_threads;     //< The decoding threads
+
+    std::mutex m_mutex;                     //< Protects the state below
+    std::condition_variable m_room;         //< Signals a free slot (or the end) to the threads
+    std::condition_variable m_loaded;       //< Signals a loaded image to the caller
+    size_t m_next_file;                     //< The next file to load
+    size_t m_next_image;                    //< The next image to hand out
+    bool m_stop;                            //< True to stop the threads
+};
+
+
+#endif // __ImageBatchLoader_h
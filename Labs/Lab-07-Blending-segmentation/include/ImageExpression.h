@@ -0,0 +1,170 @@
+#ifndef __ImageExpression_h
+#define __ImageExpression_h
+
+#include <vector>
+#include <cstddef>      // size_t
+#include <sstream>
+#include <stdexcept>    // std::invalid_argument
+#include <utility>      // std::move
+
+#include "PixelBuffer.h"
+
+
+//------------------------------------------------------------------------------
+/// Tag shared by all the pixel-wise expressions, used to recognise them as
+/// operands of the arithmetic operators
+//------------------------------------------------------------------------------
+class ImageExpressionBase {};
+
+
+//------------------------------------------------------------------------------
+/// Base class of a lazy pixel-wise expression (e.g. alpha * img1 + beta).
+/// Nothing is computed until the expression is assigned to an Image. The whole
+/// expression is then evaluated in a single pass over the pixels, without any
+/// intermediate image.
+/// Note that an expression only keeps a reference on the images that are not
+/// temporaries. Assign it to an Image, do not store it (e.g. using auto).
+//------------------------------------------------------------------------------
+template<typename E>
+class ImageExpression: public ImageExpressionBase
+{
+public:
+    //--------------------------------------------------------------------------
+    /// Accessor on the actual expression
+    /**
+    * @return the expression
+    */
+    //--------------------------------------------------------------------------
+    const E& getExpression() const
+    {
+        return static_cast<const E&>(*this);
+    }
+};
+
+
+//------------------------------------------------------------------------------
+/// A constant value used in an expression, e.g. 2 in (2 * img)
+//------------------------------------------------------------------------------
+class ScalarExpression: public ImageExpression<ScalarExpression>
+{
+public:
+    //--------------------------------------------------------------------------
+    /// Constructor
+    /**
+    * @param aValue: the constant value
+    */
+    //--------------------------------------------------------------------------
+    explicit ScalarExpression(float aValue):
+        m_value(aValue)
+    {}
+
+    float operator[](size_t) const { return m_value; }
+    float getValue() const { return m_value; }
+    bool isScalar() const { return true; }
+    size_t getWidth() const { return 0; }
+    size_t getHeight() const { return 0; }
+    bool stealPixelData(PixelBuffer<float>&, size_t) const { return false; }
+
+private:
+    float m_value; //< The constant value
+};
+
+
+//------------------------------------------------------------------------------
+/// The pixel-wise operators used in the expressions
+//------------------------------------------------------------------------------
+struct ImageAddition
+{
+    static float apply(float aLeft, float aRight) { return aLeft + aRight; }
+};
+
+struct ImageSubtraction
+{
+    static float apply(float aLeft, float aRight) { return aLeft - aRight; }
+};
+
+struct ImageMultiplication
+{
+    static float apply(float aLeft, float aRight) { return aLeft * aRight; }
+};
+
+struct ImageDivision
+{
+    static float apply(float aLeft, float aRight) { return aLeft / aRight; }
+};
+
+
+//------------------------------------------------------------------------------
+/// A binary operator applied to two expressions, e.g. img1 + img2
+//------------------------------------------------------------------------------
+template<typename Operator, typename L, typename R>
+class BinaryExpression: public ImageExpression<BinaryExpression<Operator, L, R> >
+{
+public:
+    //--------------------------------------------------------------------------
+    /// Constructor
+    /**
+    * @param aLeftOperand: the left hand side operand
+    * @param aRightOperand: the right hand side operand
+    */
+    //--------------------------------------------------------------------------
+    BinaryExpression(L&& aLeftOperand, R&& aRightOperand):
+        m_left(std::move(aLeftOperand)),
+        m_right(std::move(aRightOperand)),
+        m_width(m_left.isScalar() ? m_right.getWidth() : m_left.getWidth()),
+        m_height(m_left.isScalar() ? m_right.getHeight() : m_left.getHeight())
+    {
+        // Both operands are images, check their sizes
+        if (!m_left.isScalar() && !m_right.isScalar() &&
+            (m_left.getWidth() != m_right.getWidth() ||
+            m_left.getHeight() != m_right.getHeight()))
+        {
+            // Format a nice error message
+            std::stringstream error_message;
+            error_message << "ERROR:" << std::endl;
+            error_message << "\tin File:" << __FILE__ << std::endl;
+            error_message << "\tin Function:" << __FUNCTION__ << std::endl;
+            error_message << "\tat Line:" << __LINE__ << std::endl;
+            error_message << "\tMESSAGE: The images have different sizes: " <<
+                m_left.getWidth() << "x" << m_left.getHeight() << " and " <<
+                m_right.getWidth() << "x" << m_right.getHeight() << std::endl;
+
+            // Throw an exception
+            throw std::invalid_argument(error_message.str());
+        }
+    }
+
+    float operator[](size_t anIndex) const
+    {
+        return Operator::apply(m_left[anIndex], m_right[anIndex]);
+    }
+
+    const L& getLeftOperand() const { return m_left; }
+    const R& getRightOperand() const { return m_right; }
+    bool isScalar() const { return m_left.isScalar() && m_right.isScalar(); }
+    size_t getWidth() const { return m_width; }
+    size_t getHeight() const { return m_height; }
+
+    //--------------------------------------------------------------------------
+    /// Hand over the pixel data of a temporary image used in the expression,
+    /// so that the result can be computed in place.
+    /**
+    * @param aPixelData: the buffer that receives the pixel data
+    * @param aNumberOfPixels: the number of pixels required
+    * @return true if a buffer was found, false otherwise
+    */
+    //--------------------------------------------------------------------------
+    bool stealPixelData(PixelBuffer<float>& aPixelData, size_t aNumberOfPixels) const
+    {
+        return m_left.stealPixelData(aPixelData, aNumberOfPixels) ||
+            m_right.stealPixelData(aPixelData, aNumberOfPixels);
+    }
+
+private:
+    L m_left;        //< The left hand side operand
+    R m_right;       //< The right hand side operand
+    size_t m_width;  //< The number of columns
+    size_t m_height; //< The number of rows
+};
+
+#endif // __ImageExpression_h
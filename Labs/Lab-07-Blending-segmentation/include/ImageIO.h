@@ -0,0 +1,390 @@
+#ifndef __ImageIO_h
+#define __ImageIO_h
+
+#include <vector>
+#include <cstddef>  // size_t
+#include <cstdint>  // uint8_t, uint16_t
+#include <memory>   // std::unique_ptr
+
+#include "Half.h"
+
+
+//------------------------------------------------------------------------------
+/// A file mapped in memory, read-only. The pages are read by the system when
+/// they are accessed: nothing is copied.
+//------------------------------------------------------------------------------
+class MappedFile
+{
+public:
+    //--------------------------------------------------------------------------
+    /// Constructor: map a file
+    /**
+    * @param aFilename: the name of the file
+    */
+    //--------------------------------------------------------------------------
+    explicit MappedFile(const char* aFilename);
+
+
+    //--------------------------------------------------------------------------
+    /// Move constructor: take over the mapping of another file
+    /**
+    * @param aFile: the file (empty afterwards)
+    */
+    //--------------------------------------------------------------------------
+    MappedFile(MappedFile&& aFile) noexcept;
+
+
+    //--------------------------------------------------------------------------
+    /// Destructor: unmap the file
+    //--------------------------------------------------------------------------
+    ~MappedFile();
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the content of the file
+    /**
+    * @return the first byte of the file, or NULL if the file is empty
+    */
+    //--------------------------------------------------------------------------
+    const unsigned char* getData() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the size of the file
+    /**
+    * @return the number of bytes
+    */
+    //--------------------------------------------------------------------------
+    size_t getSize() const;
+
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+private:
+    const unsigned char* m_p_data; //< The mapped file
+    size_t m_size;                 //< The number of bytes
+};
+
+
+//------------------------------------------------------------------------------
+/// Decoder of a JPEG file (libjpeg), scanline by scanline. The file is mapped
+/// in memory and libjpeg reads it from there: the compressed data is never
+/// copied, and the caller decodes each row where it needs it, e.g. straight
+/// into the pixels of an image.
+//------------------------------------------------------------------------------
+class JPEGDecoder
+{
+public:
+    //--------------------------------------------------------------------------
+    /// Constructor: open a file and read its header
+    /**
+    * @param aFilename: the name of the file
+    * @param aScaleHint: the scale of the image that is needed. The image is
+    * decoded at 1, 1/2, 1/4 or 1/8 of its size, the smallest of them that is
+    * not smaller than aScaleHint. libjpeg then skips the DCT coefficients of
+    * the frequencies that are not needed, i.e. most of the work.
+    */
+    //--------------------------------------------------------------------------
+    explicit JPEGDecoder(const char* aFilename, float aScaleHint = 1.0f);
+
+
+    //--------------------------------------------------------------------------
+    /// Constructor: read the header of a file that is already mapped
+    /**
+    * @param aFile: the mapped file (taken over by the decoder)
+    * @param aFilename: the name of the file (for the error messages)
+    * @param aScaleHint: the scale of the image that is needed (see above)
+    */
+    //--------------------------------------------------------------------------
+    JPEGDecoder(MappedFile&& aFile, const char* aFilename, float aScaleHint = 1.0f);
+
+
+    //--------------------------------------------------------------------------
+    /// Destructor: release the decoder and the file
+    //--------------------------------------------------------------------------
+    ~JPEGDecoder();
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the width of the image
+    /**
+    * @return the number of columns
+    */
+    //--------------------------------------------------------------------------
+    size_t getWidth() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the height of the image
+    /**
+    * @return the number of rows
+    */
+    //--------------------------------------------------------------------------
+    size_t getHeight() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the number of components
+    /**
+    * @return 1 for a greyscale image, 3 for a RGB image
+    */
+    //--------------------------------------------------------------------------
+    size_t getNumberOfComponents() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Decode the next row of the image
+    /**
+    * @param aRow: the getWidth() x getNumberOfComponents() samples of the row
+    * (the components of a pixel are interleaved)
+    */
+    //--------------------------------------------------------------------------
+    void readScanline(unsigned char* aRow);
+
+
+    JPEGDecoder(const JPEGDecoder&) = delete;
+    JPEGDecoder& operator=(const JPEGDecoder&) = delete;
+
+private:
+    struct State;
+    std::unique_ptr<State> m_p_state; //< The file and the libjpeg objects
+};
+
+
+//------------------------------------------------------------------------------
+/// Compute the relative luminance of a row of RGB pixels (ITU-R BT.709)
+/**
+* @param anRGBRow: the samples of the row (the components are interleaved)
+* @param anOutput: the luminance of the pixels
+* @param aWidth: the number of pixels
+*/
+//------------------------------------------------------------------------------
+void computeLuminance(const unsigned char* anRGBRow, float* anOutput, size_t aWidth);
+
+
+//------------------------------------------------------------------------------
+/// Encode a greyscale image in a JPEG file (libjpeg). The file has a single
+/// component: a third of the work and of the size of a RGB file.
+/**
+* @param aFilename: the name of the file
+* @param aPixels: the pixels of the image, row by row
+* @param aWidth: the number of columns of the image
+* @param aHeight: the number of rows of the image
+* @param aQuality: the quality, from 1 (smallest file) to 100 (best image)
+* @param anOptimiseFlag: true to compute optimal Huffman tables (a second
+* pass on the image for a smaller file), false to use the standard tables
+*/
+//------------------------------------------------------------------------------
+void writeJPEG(const char* aFilename, const unsigned char* aPixels,
+               size_t aWidth, size_t aHeight,
+               int aQuality = 75, bool anOptimiseFlag = false);
+
+
+
+//------------------------------------------------------------------------------
+/// The file formats of the images
+//------------------------------------------------------------------------------
+enum ImageFileFormat
+{
+    FORMAT_JPEG,    //< Lossy, 8 bits (libjpeg)
+    FORMAT_RAW,     //< The pixels as they are in memory, after a 32-byte header
+    FORMAT_PGM,     //< Binary portable graymap (P5), 8 or 16 bits
+    FORMAT_PFM,     //< Greyscale portable floatmap (Pf), 32-bit floats
+    FORMAT_TIFF     //< Uncompressed TIFF, 8 or 16 bits, or floats (tiles of 256x256 pixels when written)
+};
+
+
+//------------------------------------------------------------------------------
+/// The types of the samples stored in the uncompressed files
+//------------------------------------------------------------------------------
+enum SampleType
+{
+    SAMPLE_UINT8,
+    SAMPLE_UINT16,
+    SAMPLE_HALF,
+    SAMPLE_FLOAT
+};
+
+
+//------------------------------------------------------------------------------
+/// Accessor on the sample type of a pixel type
+/**
+* @return the sample type
+*/
+//------------------------------------------------------------------------------
+template<typename PixelT> SampleType getSampleType();
+template<> inline SampleType getSampleType<uint8_t>() { return SAMPLE_UINT8; }
+template<> inline SampleType getSampleType<uint16_t>() { return SAMPLE_UINT16; }
+template<> inline SampleType getSampleType<Half>() { return SAMPLE_HALF; }
+template<> inline SampleType getSampleType<float>() { return SAMPLE_FLOAT; }
+
+
+//------------------------------------------------------------------------------
+/// The size of the header of the raw files: the samples follow it, row by row
+/// and little-endian
+//------------------------------------------------------------------------------
+const size_t RAW_HEADER_SIZE = 32;
+
+
+//------------------------------------------------------------------------------
+/// Write the header of a raw file, e.g. in a file mapped in memory
+/**
+* @param aHeader: the RAW_HEADER_SIZE bytes of the header
+* @param aSampleType: the type of the samples
+* @param aWidth: the number of columns of the image
+* @param aHeight: the number of rows of the image
+*/
+//------------------------------------------------------------------------------
+void writeRawHeader(unsigned char* aHeader, SampleType aSampleType, size_t aWidth, size_t aHeight);
+
+
+//------------------------------------------------------------------------------
+/// Find the format of an image file from its extension (.jpg or .jpeg, .raw,
+/// .pgm, .pfm, .tif or .tiff, case insensitive), e.g. to save an image
+/**
+* @param aFilename: the name of the file
+* @return the format
+*/
+//------------------------------------------------------------------------------
+ImageFileFormat getFileFormat(const char* aFilename);
+
+
+//------------------------------------------------------------------------------
+/// Find the format of an existing image file from its first bytes
+/**
+* @param aFilename: the name of the file
+* @return the format
+*/
+//------------------------------------------------------------------------------
+ImageFileFormat readFileFormat(const char* aFilename);
+
+
+//------------------------------------------------------------------------------
+/// Find the format of a mapped image file from its first bytes
+/**
+* @param aFile: the mapped file
+* @param aFilename: the name of the file (for the error messages)
+* @return the format
+*/
+//------------------------------------------------------------------------------
+ImageFileFormat readFileFormat(const MappedFile& aFile, const char* aFilename);
+
+
+//------------------------------------------------------------------------------
+/// Reader of an uncompressed image file (raw, PGM, PFM or TIFF). The file is
+/// mapped in memory, and the rows are copied from there with a single pass,
+/// i.e. a memcpy when the file has the byte order of the machine.
+//------------------------------------------------------------------------------
+class ImageFileReader
+{
+public:
+    //--------------------------------------------------------------------------
+    /// Constructor: map a file and read its header
+    /**
+    * @param aFilename: the name of the file
+    */
+    //--------------------------------------------------------------------------
+    explicit ImageFileReader(const char* aFilename);
+
+
+    //--------------------------------------------------------------------------
+    /// Constructor: read the header of a file that is already mapped
+    /**
+    * @param aFile: the mapped file (taken over by the reader)
+    * @param aFilename: the name of the file (for the error messages)
+    */
+    //--------------------------------------------------------------------------
+    ImageFileReader(MappedFile&& aFile, const char* aFilename);
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the width of the image
+    /**
+    * @return the number of columns
+    */
+    //--------------------------------------------------------------------------
+    size_t getWidth() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the height of the image
+    /**
+    * @return the number of rows
+    */
+    //--------------------------------------------------------------------------
+    size_t getHeight() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the type of the samples stored in the file
+    /**
+    * @return the sample type
+    */
+    //--------------------------------------------------------------------------
+    SampleType getSampleType() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Read rows of samples, in the byte order of the machine
+    /**
+    * @param aFirstRow: the first row to read
+    * @param aNumberOfRows: the number of rows
+    * @param aSamples: the samples of the rows (getSampleType())
+    */
+    //--------------------------------------------------------------------------
+    void readRows(size_t aFirstRow, size_t aNumberOfRows, void* aSamples) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Read all the pixels, converted to another type if needed (see
+    /// convertPixels)
+    /**
+    * @param aPixels: the getWidth() x getHeight() pixels
+    */
+    //--------------------------------------------------------------------------
+    template<typename PixelT>
+    void readPixels(PixelT* aPixels) const;
+
+
+    ImageFileReader(const ImageFileReader&) = delete;
+    ImageFileReader& operator=(const ImageFileReader&) = delete;
+
+private:
+    void readRawHeader();
+    void readPortableHeader();
+    void readTIFFHeader();
+
+    MappedFile m_file;              //< The content of the file
+    size_t m_width;                 //< The number of columns
+    size_t m_height;                //< The number of rows
+    SampleType m_sample_type;       //< The type of the samples
+    size_t m_sample_size;           //< The size of a sample in bytes
+    bool m_swap_bytes;              //< True if the byte order is not the one of the machine
+    bool m_bottom_up;               //< True if the rows are stored from the bottom (PFM)
+    size_t m_block_width;           //< The number of columns of a block (the width for strips)
+    size_t m_block_height;          //< The number of rows of a block (tile or strip)
+    std::vector<size_t> m_blocks;   //< The offsets of the blocks (tiles or strips) in the file
+};
+
+
+//------------------------------------------------------------------------------
+/// Write an image in an uncompressed file (raw, PGM, PFM or TIFF) with large
+/// buffered writes. The samples are converted if the format needs it, without
+/// any loss: to floats for PFM files, and from halves to floats for TIFF
+/// files. PGM files only store 8- and 16-bit samples.
+/**
+* @param aFilename: the name of the file
+* @param aFormat: the format of the file (not FORMAT_JPEG)
+* @param aSampleType: the type of the pixels
+* @param aPixels: the pixels of the image, row by row
+* @param aWidth: the number of columns of the image
+* @param aHeight: the number of rows of the image
+*/
+//------------------------------------------------------------------------------
+void writeImageFile(const char* aFilename, ImageFileFormat aFormat,
+                    SampleType aSampleType, const void* aPixels,
+                    size_t aWidth, size_t aHeight);
+
+
+#endif // __ImageIO_h
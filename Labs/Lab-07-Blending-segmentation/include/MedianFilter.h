@@ -0,0 +1,61 @@
+#ifndef __MedianFilter_h
+#define __MedianFilter_h
+
+#include <cstddef>  // size_t
+#include <cstdint>  // uint8_t
+
+
+//------------------------------------------------------------------------------
+/// The largest radius of the median filter (the counts of the histograms of
+/// the columns are stored in 16 bits)
+//------------------------------------------------------------------------------
+const unsigned int MAX_MEDIAN_RADIUS = 32767;
+
+
+//------------------------------------------------------------------------------
+/// Median filter of an 8-bit image, over a (2r + 1) x (2r + 1) window. The
+/// pixels outside of the image are the closest pixels of the image (like
+/// BORDER_EXTEND). The strips of rows are filtered in parallel.
+///
+/// For r = 1 and r = 2 (3x3 and 5x5), the median of each window is selected by
+/// a sorting network reduced to the comparisons that lead to the median. It is
+/// applied to whole blocks of pixels at once (min/max of rows of bytes, i.e.
+/// SIMD instructions).
+///
+/// For larger windows, the constant-time algorithm of Perreault and Hebert
+/// (2007) is used: a histogram of the 2r + 1 pixels of each column is updated
+/// when moving down (one pixel in, one pixel out), and the histogram of the
+/// window is updated when moving right (one column in, one column out). The
+/// histograms have two levels (16 coarse bins of 16 fine bins), and the fine
+/// bins of the window are only updated for the coarse bin of the median. The
+/// cost per pixel does not depend on the radius.
+/**
+* @param anInput: the pixels of the input image
+* @param aWidth: the number of columns
+* @param aHeight: the number of rows
+* @param aRadius: the radius r of the window (0 copies the image)
+* @param anOutput: the pixels of the output image (same size, not anInput)
+*/
+//------------------------------------------------------------------------------
+void medianFilter(const uint8_t* anInput, size_t aWidth, size_t aHeight,
+                  unsigned int aRadius, uint8_t* anOutput);
+
+
+//------------------------------------------------------------------------------
+/// Exact median filter of a float image, over a (2r + 1) x (2r + 1) window,
+/// with the border extended. The median of each window is selected among its
+/// values (std::nth_element): the cost per pixel is O(r^2). The rows are
+/// filtered in parallel.
+/**
+* @param anInput: the pixels of the input image
+* @param aWidth: the number of columns
+* @param aHeight: the number of rows
+* @param aRadius: the radius r of the window (0 copies the image)
+* @param anOutput: the pixels of the output image (same size, not anInput)
+*/
+//------------------------------------------------------------------------------
+void medianFilter(const float* anInput, size_t aWidth, size_t aHeight,
+                  unsigned int aRadius, float* anOutput);
+
+
+#endif // __MedianFilter_h
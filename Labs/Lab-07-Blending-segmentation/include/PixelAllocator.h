@@ -0,0 +1,194 @@
+#ifndef __PixelAllocator_h
+#define __PixelAllocator_h
+
+#include <vector>
+#include <map>
+#include <cstddef>  // size_t
+#include <memory>   // std::shared_ptr
+#include <mutex>
+
+
+// The alignment of the pixel buffers in bytes (a cache line, an AVX-512 vector)
+const size_t PIXEL_ALIGNMENT = 64;
+
+
+//------------------------------------------------------------------------------
+/// Allocator of the pixel buffers (see PixelBuffer.h). The blocks are aligned
+/// on PIXEL_ALIGNMENT bytes. The allocators are shared by the buffers they
+/// allocated, they can be used from several threads.
+//------------------------------------------------------------------------------
+class PixelAllocator
+{
+public:
+    //--------------------------------------------------------------------------
+    /// Destructor
+    //--------------------------------------------------------------------------
+    virtual ~PixelAllocator();
+
+
+    //--------------------------------------------------------------------------
+    /// Allocate a block of memory. It throws std::bad_alloc on failure.
+    /**
+    * @param aSize: the size of the block in bytes (not 0)
+    * @return the block, aligned on PIXEL_ALIGNMENT bytes
+    */
+    //--------------------------------------------------------------------------
+    virtual void* allocate(size_t aSize) = 0;
+
+
+    //--------------------------------------------------------------------------
+    /// Release a block allocated by this allocator
+    /**
+    * @param aBlock: the block
+    * @param aSize: the size that was passed to allocate()
+    */
+    //--------------------------------------------------------------------------
+    virtual void deallocate(void* aBlock, size_t aSize) = 0;
+};
+
+
+//------------------------------------------------------------------------------
+/// Allocator that goes straight to the heap
+//------------------------------------------------------------------------------
+class AlignedAllocator: public PixelAllocator
+{
+public:
+    virtual void* allocate(size_t aSize);
+    virtual void deallocate(void* aBlock, size_t aSize);
+};
+
+
+//------------------------------------------------------------------------------
+/// Allocator that recycles the released blocks. The sizes are rounded up to
+/// size classes (four per power of two, i.e. less than 25% of waste), and a
+/// released block is kept in the free list of its class, up to a maximum
+/// amount of cached memory. A chain of filters on same-sized images then
+/// allocates its temporaries once.
+/// It is the default allocator. A pool can also be used as the arena of a
+/// pipeline (see ScopedPixelAllocator): its memory is released with it.
+//------------------------------------------------------------------------------
+class BufferPool: public PixelAllocator
+{
+public:
+    //--------------------------------------------------------------------------
+    /// Constructor
+    /**
+    * @param aMaximumCachedSize: the maximum size of the released blocks that
+    * are kept, in bytes
+    */
+    //--------------------------------------------------------------------------
+    explicit BufferPool(size_t aMaximumCachedSize = 256 << 20);
+
+
+    //--------------------------------------------------------------------------
+    /// Destructor: release the cached blocks
+    //--------------------------------------------------------------------------
+    virtual ~BufferPool();
+
+
+    virtual void* allocate(size_t aSize);
+    virtual void deallocate(void* aBlock, size_t aSize);
+
+
+    //--------------------------------------------------------------------------
+    /// Release the cached blocks to the heap
+    //--------------------------------------------------------------------------
+    void release();
+
+
+    //--------------------------------------------------------------------------
+    /// Set the maximum size of the released blocks that are kept
+    /**
+    * @param aSize: the size in bytes
+    */
+    //--------------------------------------------------------------------------
+    void setMaximumCachedSize(size_t aSize);
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the size of the released blocks that are kept
+    /**
+    * @return the size in bytes
+    */
+    //--------------------------------------------------------------------------
+    size_t getCachedSize() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Round a size up to its size class
+    /**
+    * @param aSize: the size in bytes
+    * @return the size of the blocks of the class in bytes
+    */
+    //--------------------------------------------------------------------------
+    static size_t getSizeClass(size_t aSize);
+
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+private:
+    mutable std::mutex m_mutex;                         //< Protect the free lists
+    std::map<size_t, std::vector<void*> > m_free_lists; //< The released blocks of each size class
+    size_t m_cached_size;                               //< The size of the released blocks
+    size_t m_maximum_cached_size;                       //< The maximum size of the released blocks
+};
+
+
+//------------------------------------------------------------------------------
+/// Accessor on the allocator of the new pixel buffers in the current thread:
+/// the one of the innermost ScopedPixelAllocator if any, the default one
+/// otherwise. The tasks of the thread pool use the allocator of the thread
+/// that submitted the job. No lock is taken: each thread keeps a copy of the
+/// default allocator, updated when the default allocator changes.
+/**
+* @return the allocator
+*/
+//------------------------------------------------------------------------------
+const std::shared_ptr<PixelAllocator>& getPixelAllocator();
+
+
+//------------------------------------------------------------------------------
+/// Set the default allocator of the pixel buffers (a BufferPool at start-up).
+/// The existing buffers keep their allocator.
+/**
+* @param anAllocator: the allocator
+*/
+//------------------------------------------------------------------------------
+void setDefaultPixelAllocator(const std::shared_ptr<PixelAllocator>& anAllocator);
+
+
+//------------------------------------------------------------------------------
+/// Use an allocator for the pixel buffers created by the current thread in a
+/// scope, e.g. the arena of a pipeline:
+///     ScopedPixelAllocator arena(std::make_shared<BufferPool>());
+/// The buffers keep a reference to their allocator, they can outlive the scope.
+//------------------------------------------------------------------------------
+class ScopedPixelAllocator
+{
+public:
+    //--------------------------------------------------------------------------
+    /// Constructor: make an allocator current
+    /**
+    * @param anAllocator: the allocator
+    */
+    //--------------------------------------------------------------------------
+    explicit ScopedPixelAllocator(const std::shared_ptr<PixelAllocator>& anAllocator);
+
+
+    //--------------------------------------------------------------------------
+    /// Destructor: restore the previous allocator
+    //--------------------------------------------------------------------------
+    ~ScopedPixelAllocator();
+
+
+    ScopedPixelAllocator(const ScopedPixelAllocator&) = delete;
+    ScopedPixelAllocator& operator=(const ScopedPixelAllocator&) = delete;
+
+private:
+    std::shared_ptr<PixelAllocator> m_allocator;                   //< The current allocator
+    const std::shared_ptr<PixelAllocator>* m_p_previous_allocator; //< The allocator of the previous scope, if any
+};
+
+
+#endif // __PixelAllocator_h
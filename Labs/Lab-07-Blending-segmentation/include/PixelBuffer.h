@@ -0,0 +1,147 @@
+#ifndef __PixelBuffer_h
+#define __PixelBuffer_h
+
+#include <cstddef>      // size_t
+#include <memory>       // std::shared_ptr
+#include <type_traits>  // std::is_trivially_copyable
+
+#include "PixelAllocator.h"
+
+
+//------------------------------------------------------------------------------
+/// Storage of the pixels of an image: an array aligned on PIXEL_ALIGNMENT
+/// bytes, allocated by the current PixelAllocator (see PixelAllocator.h), e.g.
+/// recycled by the default BufferPool. It looks like a std::vector, but the
+/// new pixels are not initialised, as they are written by the operations.
+/// T must be trivially copyable (float, uint8_t, uint16_t, Half).
+//------------------------------------------------------------------------------
+template<typename T>
+class PixelBuffer
+{
+    static_assert(std::is_trivially_copyable<T>::value, "The pixels must be trivially copyable");
+
+public:
+    //--------------------------------------------------------------------------
+    /// Default constructor: Create an empty buffer
+    //--------------------------------------------------------------------------
+    PixelBuffer();
+
+
+    //--------------------------------------------------------------------------
+    /// Constructor: Create a buffer of a given size (not initialised)
+    /**
+    * @param aSize: the number of pixels
+    */
+    //--------------------------------------------------------------------------
+    explicit PixelBuffer(size_t aSize);
+
+
+    //--------------------------------------------------------------------------
+    /// Constructor: Create a buffer filled with a constant
+    /**
+    * @param aSize: the number of pixels
+    * @param aValue: the value of all the pixels
+    */
+    //--------------------------------------------------------------------------
+    PixelBuffer(size_t aSize, const T& aValue);
+
+
+    //--------------------------------------------------------------------------
+    /// Constructor: Copy an array
+    /**
+    * @param aFirst: the first pixel
+    * @param aLast: the end of the array
+    */
+    //--------------------------------------------------------------------------
+    PixelBuffer(const T* aFirst, const T* aLast);
+
+
+    //--------------------------------------------------------------------------
+    /// Copy constructor: the new buffer comes from the current allocator
+    /**
+    * @param aBuffer: the buffer to copy
+    */
+    //--------------------------------------------------------------------------
+    PixelBuffer(const PixelBuffer& aBuffer);
+
+
+    //--------------------------------------------------------------------------
+    /// Move constructor
+    /**
+    * @param aBuffer: the buffer to move. It is left empty.
+    */
+    //--------------------------------------------------------------------------
+    PixelBuffer(PixelBuffer&& aBuffer) noexcept;
+
+
+    //--------------------------------------------------------------------------
+    /// Destructor: give the memory back to its allocator
+    //--------------------------------------------------------------------------
+    ~PixelBuffer();
+
+
+    //--------------------------------------------------------------------------
+    /// Assignment operator. The memory is reused if the sizes are the same.
+    /**
+    * @param aBuffer: the buffer to copy
+    * @return the buffer
+    */
+    //--------------------------------------------------------------------------
+    PixelBuffer& operator=(const PixelBuffer& aBuffer);
+
+
+    //--------------------------------------------------------------------------
+    /// Move assignment operator
+    /**
+    * @param aBuffer: the buffer to move. It is left empty.
+    * @return the buffer
+    */
+    //--------------------------------------------------------------------------
+    PixelBuffer& operator=(PixelBuffer&& aBuffer) noexcept;
+
+
+    //--------------------------------------------------------------------------
+    /// Change the number of pixels. The existing pixels are kept, the new ones
+    /// are not initialised.
+    /**
+    * @param aSize: the number of pixels
+    */
+    //--------------------------------------------------------------------------
+    void resize(size_t aSize);
+
+
+    //--------------------------------------------------------------------------
+    /// Release the pixels
+    //--------------------------------------------------------------------------
+    void clear();
+
+
+    //--------------------------------------------------------------------------
+    /// Exchange the pixels of two buffers
+    /**
+    * @param aBuffer: the other buffer
+    */
+    //--------------------------------------------------------------------------
+    void swap(PixelBuffer& aBuffer) noexcept;
+
+
+    T& operator[](size_t anIndex) { return m_p_data[anIndex]; }
+    const T& operator[](size_t anIndex) const { return m_p_data[anIndex]; }
+    T* data() { return m_p_data; }
+    const T* data() const { return m_p_data; }
+    size_t size() const { return m_size; }
+    bool empty() const { return !m_size; }
+
+private:
+    void allocate(size_t aSize);
+    void deallocate();
+
+    T* m_p_data;                                 //< The pixels, or NULL if empty
+    size_t m_size;                               //< The number of pixels
+    std::shared_ptr<PixelAllocator> m_allocator; //< The allocator of m_p_data
+};
+
+
+#include "PixelBuffer.inl"
+
+#endif // __PixelBuffer_h
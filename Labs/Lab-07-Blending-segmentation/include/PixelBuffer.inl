@@ -0,0 +1,185 @@
+#include <algorithm>    // std::fill_n, std::swap
+#include <cstring>      // std::memcpy
+
+
+//----------------------------
+template<typename T>
+PixelBuffer<T>::PixelBuffer():
+//----------------------------
+    m_p_data(0),
+    m_size(0)
+//----------------------------
+{}
+
+
+//----------------------------------------
+template<typename T>
+PixelBuffer<T>::PixelBuffer(size_t aSize):
+//----------------------------------------
+    m_p_data(0),
+    m_size(0)
+//----------------------------------------
+{
+    allocate(aSize);
+}
+
+
+//---------------------------------------------------------
+template<typename T>
+PixelBuffer<T>::PixelBuffer(size_t aSize, const T& aValue):
+//---------------------------------------------------------
+    m_p_data(0),
+    m_size(0)
+//---------------------------------------------------------
+{
+    allocate(aSize);
+    std::fill_n(m_p_data, m_size, aValue);
+}
+
+
+//-----------------------------------------------------------
+template<typename T>
+PixelBuffer<T>::PixelBuffer(const T* aFirst, const T* aLast):
+//-----------------------------------------------------------
+    m_p_data(0),
+    m_size(0)
+//-----------------------------------------------------------
+{
+    allocate(aLast - aFirst);
+    if (m_size) std::memcpy(m_p_data, aFirst, m_size * sizeof(T));
+}
+
+
+//------------------------------------------------------
+template<typename T>
+PixelBuffer<T>::PixelBuffer(const PixelBuffer& aBuffer):
+//------------------------------------------------------
+    m_p_data(0),
+    m_size(0)
+//------------------------------------------------------
+{
+    allocate(aBuffer.m_size);
+    if (m_size) std::memcpy(m_p_data, aBuffer.m_p_data, m_size * sizeof(T));
+}
+
+
+//----------------------------------------------------------
+template<typename T>
+PixelBuffer<T>::PixelBuffer(PixelBuffer&& aBuffer) noexcept:
+//----------------------------------------------------------
+    m_p_data(aBuffer.m_p_data),
+    m_size(aBuffer.m_size),
+    m_allocator(std::move(aBuffer.m_allocator))
+//----------------------------------------------------------
+{
+    aBuffer.m_p_data = 0;
+    aBuffer.m_size = 0;
+}
+
+
+//----------------------------
+template<typename T>
+PixelBuffer<T>::~PixelBuffer()
+//----------------------------
+{
+    deallocate();
+}
+
+
+//-------------------------------------------------------------------
+template<typename T>
+PixelBuffer<T>& PixelBuffer<T>::operator=(const PixelBuffer& aBuffer)
+//-------------------------------------------------------------------
+{
+    if (this != &aBuffer)
+    {
+        // Reuse the memory if possible
+        if (m_size != aBuffer.m_size)
+        {
+            deallocate();
+            allocate(aBuffer.m_size);
+        }
+
+        if (m_size) std::memcpy(m_p_data, aBuffer.m_p_data, m_size * sizeof(T));
+    }
+
+    return *this;
+}
+
+
+//-----------------------------------------------------------------------
+template<typename T>
+PixelBuffer<T>& PixelBuffer<T>::operator=(PixelBuffer&& aBuffer) noexcept
+//-----------------------------------------------------------------------
+{
+    if (this != &aBuffer)
+    {
+        deallocate();
+        swap(aBuffer);
+    }
+
+    return *this;
+}
+
+
+//---------------------------------------
+template<typename T>
+void PixelBuffer<T>::resize(size_t aSize)
+//---------------------------------------
+{
+    if (aSize != m_size)
+    {
+        PixelBuffer buffer(aSize);
+        size_t size = std::min(aSize, m_size);
+        if (size) std::memcpy(buffer.m_p_data, m_p_data, size * sizeof(T));
+        swap(buffer);
+    }
+}
+
+
+//--------------------------
+template<typename T>
+void PixelBuffer<T>::clear()
+//--------------------------
+{
+    deallocate();
+}
+
+
+//------------------------------------------------------
+template<typename T>
+void PixelBuffer<T>::swap(PixelBuffer& aBuffer) noexcept
+//------------------------------------------------------
+{
+    std::swap(m_p_data, aBuffer.m_p_data);
+    std::swap(m_size, aBuffer.m_size);
+    m_allocator.swap(aBuffer.m_allocator);
+}
+
+
+//-----------------------------------------
+template<typename T>
+void PixelBuffer<T>::allocate(size_t aSize)
+//-----------------------------------------
+{
+    if (aSize)
+    {
+        m_allocator = getPixelAllocator();
+        m_p_data = static_cast<T*>(m_allocator->allocate(aSize * sizeof(T)));
+        m_size = aSize;
+    }
+}
+
+
+//-------------------------------
+template<typename T>
+void PixelBuffer<T>::deallocate()
+//-------------------------------
+{
+    if (m_p_data)
+    {
+        m_allocator->deallocate(m_p_data, m_size * sizeof(T));
+        m_p_data = 0;
+        m_size = 0;
+    }
+}
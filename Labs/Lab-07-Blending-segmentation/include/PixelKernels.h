@@ -0,0 +1,122 @@
+#ifndef __PixelKernels_h
+#define __PixelKernels_h
+
+#include <cstddef>  // size_t
+#include <cstdint>  // uint8_t, uint16_t
+
+
+//------------------------------------------------------------------------------
+/// Instruction sets that can be used by the point operators
+//------------------------------------------------------------------------------
+enum SIMDLevel
+{
+    SIMD_SCALAR = 0, //< Plain C++ loops
+    SIMD_SSE2,       //< 4 floats at a time
+    SIMD_AVX2,       //< 8 floats at a time
+    SIMD_AVX512      //< 16 floats at a time
+};
+
+
+//------------------------------------------------------------------------------
+/// Statistics of a set of pixels. The mean and the sum of the squared
+/// deviations from the mean are kept in double precision so that partial
+/// results (e.g. of several threads) can be merged without loss of accuracy.
+//------------------------------------------------------------------------------
+struct PixelStatistics
+{
+    size_t count;           //< The number of pixels
+    float min;              //< The smallest pixel value
+    float max;              //< The largest pixel value
+    double mean;            //< The average pixel value
+    double sum_of_squares;  //< The sum of the squared deviations from the mean
+};
+
+
+//------------------------------------------------------------------------------
+/// Merge the statistics of two sets of pixels (Chan et al.'s formula)
+/**
+* @param aStatistics: the statistics of the first set, updated with the result
+* @param anOtherSet: the statistics of the second set
+*/
+//------------------------------------------------------------------------------
+void mergeStatistics(PixelStatistics& aStatistics, const PixelStatistics& anOtherSet);
+
+
+//------------------------------------------------------------------------------
+/// Table of the pixel-wise kernels for a given instruction set.
+/// All the kernels process aSize pixels, and anOutput may be equal to one of
+/// the inputs (the computations are then done in place).
+//------------------------------------------------------------------------------
+struct PixelKernels
+{
+    typedef void (*ScalarKernel)(const float* anInput, float aValue, float* anOutput, size_t aSize);
+    typedef void (*BinaryKernel)(const float* aLeft, const float* aRight, float* anOutput, size_t aSize);
+    typedef void (*UnaryKernel)(const float* anInput, float* anOutput, size_t aSize);
+    typedef void (*ClampKernel)(const float* anInput, float aLowerThreshold, float anUpperThreshold, float* anOutput, size_t aSize);
+    typedef PixelStatistics (*StatisticsKernel)(const float* anInput, size_t aSize);
+    typedef void (*FromUInt8Kernel)(const uint8_t* anInput, float* anOutput, size_t aSize);
+    typedef void (*FromUInt16Kernel)(const uint16_t* anInput, float* anOutput, size_t aSize);
+    typedef void (*ToUInt8Kernel)(const float* anInput, uint8_t* anOutput, size_t aSize);
+    typedef void (*ToUInt16Kernel)(const float* anInput, uint16_t* anOutput, size_t aSize);
+
+    const char* name;            //< Name of the instruction set
+    SIMDLevel level;             //< The instruction set
+
+    ScalarKernel addScalar;      //< anInput + aValue
+    ScalarKernel subtractScalar; //< anInput - aValue
+    ScalarKernel multiplyScalar; //< anInput * aValue
+    ScalarKernel divideScalar;   //< anInput / aValue
+    ScalarKernel scalarSubtract; //< aValue - anInput
+    ScalarKernel scalarDivide;   //< aValue / anInput
+    ScalarKernel multiplyAdd;    //< anOutput + anInput * aValue (e.g. for convolutions)
+
+    BinaryKernel add;            //< aLeft + aRight
+    BinaryKernel subtract;       //< aLeft - aRight
+    BinaryKernel multiply;       //< aLeft * aRight
+    BinaryKernel divide;         //< aLeft / aRight
+
+    UnaryKernel absoluteValue;   //< |anInput|
+    UnaryKernel square;          //< anInput * anInput
+    UnaryKernel squareRoot;      //< sqrt(anInput)
+
+    ClampKernel clamp;           //< min(max(anInput, aLowerThreshold), anUpperThreshold)
+
+    StatisticsKernel statistics; //< min, max, mean and sum of squared deviations in one pass
+
+    FromUInt8Kernel convertFromUInt8;   //< float(anInput)
+    FromUInt16Kernel convertFromUInt16; //< float(anInput)
+    ToUInt8Kernel convertToUInt8;       //< anInput rounded to the nearest integer (ties to even), saturated to [0, 255]
+    ToUInt16Kernel convertToUInt16;     //< anInput rounded to the nearest integer (ties to even), saturated to [0, 65535]
+};
+
+
+//------------------------------------------------------------------------------
+/// Accessor on the fastest instruction set supported by the CPU (and built in
+/// the executable). CPUID is only queried once.
+/**
+* @return the instruction set
+*/
+//------------------------------------------------------------------------------
+SIMDLevel getSupportedSIMDLevel();
+
+
+//------------------------------------------------------------------------------
+/// Accessor on the kernels of the fastest instruction set supported
+/**
+* @return the kernels
+*/
+//------------------------------------------------------------------------------
+const PixelKernels& getPixelKernels();
+
+
+//------------------------------------------------------------------------------
+/// Accessor on the kernels of a given instruction set
+/**
+* @param aLevel: the instruction set
+* @return the kernels, or NULL if the instruction set is not supported
+*/
+//------------------------------------------------------------------------------
+const PixelKernels* getPixelKernels(SIMDLevel aLevel);
+
+
+#endif // __PixelKernels_h
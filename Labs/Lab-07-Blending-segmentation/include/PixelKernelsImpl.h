@@ -0,0 +1,406 @@
+#ifndef __PixelKernelsImpl_h
+#define __PixelKernelsImpl_h
+
+// Generic implementation of the pixel-wise kernels. This header is private:
+// it is included by the source file of each instruction set, which provides
+// the traits of its vector type (load, store, add, etc.). The loads and
+// stores of uint8_t and uint16_t pixels convert them from and to floats (the
+// stores round to the nearest integer, ties to even).
+//
+// Everything is in an unnamed namespace on purpose. Each source file is built
+// with different compiler flags (e.g. -mavx2), and the linker must never
+// merge the instances of two instruction sets.
+
+#include "PixelKernels.h"
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+/// The operators, applied on a vector type V (with V = float for the scalar
+/// tails of the loops)
+//------------------------------------------------------------------------------
+template<typename V> struct AddOperator
+{
+    static typename V::type apply(typename V::type a, typename V::type b) { return V::add(a, b); }
+};
+
+template<typename V> struct SubtractOperator
+{
+    static typename V::type apply(typename V::type a, typename V::type b) { return V::subtract(a, b); }
+};
+
+template<typename V> struct MultiplyOperator
+{
+    static typename V::type apply(typename V::type a, typename V::type b) { return V::multiply(a, b); }
+};
+
+template<typename V> struct DivideOperator
+{
+    static typename V::type apply(typename V::type a, typename V::type b) { return V::divide(a, b); }
+};
+
+template<typename V> struct AbsoluteValueOperator
+{
+    static typename V::type apply(typename V::type a) { return V::absoluteValue(a); }
+};
+
+template<typename V> struct SquareOperator
+{
+    static typename V::type apply(typename V::type a) { return V::multiply(a, a); }
+};
+
+template<typename V> struct SquareRootOperator
+{
+    static typename V::type apply(typename V::type a) { return V::squareRoot(a); }
+};
+
+
+//------------------------------------------------------------------------------
+/// anInput OP aValue, or aValue OP anInput if Swap is true
+//------------------------------------------------------------------------------
+template<typename V, typename T, template<typename> class Operator, bool Swap>
+void scalarKernel(const float* anInput, float aValue, float* anOutput, size_t aSize)
+{
+    size_t i = 0;
+
+    // Vector loop
+    typename V::type value = V::set(aValue);
+    for (; i + V::width <= aSize; i += V::width)
+    {
+        typename V::type pixels = V::load(anInput + i);
+        V::store(anOutput + i, Swap ?
+            Operator<V>::apply(value, pixels) :
+            Operator<V>::apply(pixels, value));
+    }
+
+    // Remaining pixels
+    typename T::type tail_value = T::set(aValue);
+    for (; i < aSize; ++i)
+    {
+        typename T::type pixel = T::load(anInput + i);
+        T::store(anOutput + i, Swap ?
+            Operator<T>::apply(tail_value, pixel) :
+            Operator<T>::apply(pixel, tail_value));
+    }
+}
+
+
+//------------------------------------------------------------------------------
+/// anOutput += anInput * aValue. A multiplication followed by an addition
+/// rather than a FMA, so that all the instruction sets give the same results.
+//------------------------------------------------------------------------------
+template<typename V, typename T>
+void multiplyAddKernel(const float* anInput, float aValue, float* anOutput, size_t aSize)
+{
+    size_t i = 0;
+
+    typename V::type value = V::set(aValue);
+    for (; i + V::width <= aSize; i += V::width)
+    {
+        V::store(anOutput + i, V::add(V::load(anOutput + i), V::multiply(V::load(anInput + i), value)));
+    }
+
+    typename T::type tail_value = T::set(aValue);
+    for (; i < aSize; ++i)
+    {
+        T::store(anOutput + i, T::add(T::load(anOutput + i), T::multiply(T::load(anInput + i), tail_value)));
+    }
+}
+
+
+//------------------------------------------------------------------------------
+/// aLeft OP aRight
+//------------------------------------------------------------------------------
+template<typename V, typename T, template<typename> class Operator>
+void binaryKernel(const float* aLeft, const float* aRight, float* anOutput, size_t aSize)
+{
+    size_t i = 0;
+
+    for (; i + V::width <= aSize; i += V::width)
+    {
+        V::store(anOutput + i, Operator<V>::apply(V::load(aLeft + i), V::load(aRight + i)));
+    }
+
+    for (; i < aSize; ++i)
+    {
+        T::store(anOutput + i, Operator<T>::apply(T::load(aLeft + i), T::load(aRight + i)));
+    }
+}
+
+
+//------------------------------------------------------------------------------
+/// OP(anInput)
+//------------------------------------------------------------------------------
+template<typename V, typename T, template<typename> class Operator>
+void unaryKernel(const float* anInput, float* anOutput, size_t aSize)
+{
+    size_t i = 0;
+
+    for (; i + V::width <= aSize; i += V::width)
+    {
+        V::store(anOutput + i, Operator<V>::apply(V::load(anInput + i)));
+    }
+
+    for (; i < aSize; ++i)
+    {
+        T::store(anOutput + i, Operator<T>::apply(T::load(anInput + i)));
+    }
+}
+
+
+//------------------------------------------------------------------------------
+/// min(max(anInput, aLowerThreshold), anUpperThreshold)
+//------------------------------------------------------------------------------
+template<typename V, typename T>
+void clampKernel(const float* anInput, float aLowerThreshold, float anUpperThreshold, float* anOutput, size_t aSize)
+{
+    size_t i = 0;
+
+    typename V::type lower = V::set(aLowerThreshold);
+    typename V::type upper = V::set(anUpperThreshold);
+    for (; i + V::width <= aSize; i += V::width)
+    {
+        V::store(anOutput + i, V::minimum(V::maximum(V::load(anInput + i), lower), upper));
+    }
+
+    typename T::type tail_lower = T::set(aLowerThreshold);
+    typename T::type tail_upper = T::set(anUpperThreshold);
+    for (; i < aSize; ++i)
+    {
+        T::store(anOutput + i, T::minimum(T::maximum(T::load(anInput + i), tail_lower), tail_upper));
+    }
+}
+
+
+//------------------------------------------------------------------------------
+/// Statistics of the pixels. The data is processed in small blocks that stay
+/// in the L1 cache: the first pass over a block gives its min, max and mean,
+/// the second pass its sum of squared deviations (corrected two-pass
+/// algorithm). The blocks are then merged in double precision. The memory is
+/// read only once, and the result is as accurate as a two-pass algorithm.
+//------------------------------------------------------------------------------
+template<typename V, typename T>
+PixelStatistics statisticsKernel(const float* anInput, size_t aSize)
+{
+    const size_t block_size = 512;
+
+    PixelStatistics statistics = {0, 0, 0, 0, 0};
+
+    for (size_t block = 0; block < aSize; block += block_size)
+    {
+        const float* p_block = anInput + block;
+        size_t size = aSize - block < block_size ? aSize - block : block_size;
+        size_t i = 0;
+        float lanes[V::width];
+
+        // Min, max and sum
+        float min_value = p_block[0];
+        float max_value = p_block[0];
+        float sum = 0;
+        if (size >= size_t(V::width))
+        {
+            typename V::type v_min = V::load(p_block);
+            typename V::type v_max = v_min;
+            typename V::type v_sum = V::set(0);
+            for (; i + V::width <= size; i += V::width)
+            {
+                typename V::type pixels = V::load(p_block + i);
+                v_min = V::minimum(v_min, pixels);
+                v_max = V::maximum(v_max, pixels);
+                v_sum = V::add(v_sum, pixels);
+            }
+
+            V::store(lanes, v_min);
+            for (int j = 0; j < V::width; ++j) if (lanes[j] < min_value) min_value = lanes[j];
+            V::store(lanes, v_max);
+            for (int j = 0; j < V::width; ++j) if (lanes[j] > max_value) max_value = lanes[j];
+            V::store(lanes, v_sum);
+            for (int j = 0; j < V::width; ++j) sum += lanes[j];
+        }
+        for (; i < size; ++i)
+        {
+            if (p_block[i] < min_value) min_value = p_block[i];
+            if (p_block[i] > max_value) max_value = p_block[i];
+            sum += p_block[i];
+        }
+
+        // Sum of the deviations and of the squared deviations
+        float mean = sum / size;
+        float deviations = 0;
+        float squared_deviations = 0;
+        i = 0;
+        if (size >= size_t(V::width))
+        {
+            typename V::type v_mean = V::set(mean);
+            typename V::type v_deviations = V::set(0);
+            typename V::type v_squared_deviations = V::set(0);
+            for (; i + V::width <= size; i += V::width)
+            {
+                typename V::type deviation = V::subtract(V::load(p_block + i), v_mean);
+                v_deviations = V::add(v_deviations, deviation);
+                v_squared_deviations = V::add(v_squared_deviations, V::multiply(deviation, deviation));
+            }
+
+            V::store(lanes, v_deviations);
+            for (int j = 0; j < V::width; ++j) deviations += lanes[j];
+            V::store(lanes, v_squared_deviations);
+            for (int j = 0; j < V::width; ++j) squared_deviations += lanes[j];
+        }
+        for (; i < size; ++i)
+        {
+            float deviation = p_block[i] - mean;
+            deviations += deviation;
+            squared_deviations += deviation * deviation;
+        }
+
+        // The deviations do not exactly sum to zero because of rounding
+        // errors in the mean: correct the block statistics accordingly
+        PixelStatistics block_statistics;
+        block_statistics.count = size;
+        block_statistics.min = min_value;
+        block_statistics.max = max_value;
+        block_statistics.mean = double(mean) + double(deviations) / size;
+        block_statistics.sum_of_squares = double(squared_deviations) -
+            double(deviations) * double(deviations) / size;
+
+        mergeStatistics(statistics, block_statistics);
+    }
+
+    return statistics;
+}
+
+
+//------------------------------------------------------------------------------
+/// Conversion of integer pixels to floats
+//------------------------------------------------------------------------------
+template<typename V, typename T, typename PixelT>
+void convertToFloatKernel(const PixelT* anInput, float* anOutput, size_t aSize)
+{
+    size_t i = 0;
+
+    for (; i + V::width <= aSize; i += V::width)
+    {
+        V::store(anOutput + i, V::load(anInput + i));
+    }
+
+    for (; i < aSize; ++i)
+    {
+        T::store(anOutput + i, T::load(anInput + i));
+    }
+}
+
+
+//------------------------------------------------------------------------------
+/// Conversion of floats to integer pixels: the values are saturated to
+/// [0, MaxValue] first (NaN gives 0), then rounded by the store
+//------------------------------------------------------------------------------
+template<typename V, typename T, typename PixelT, int MaxValue>
+void convertFromFloatKernel(const float* anInput, PixelT* anOutput, size_t aSize)
+{
+    size_t i = 0;
+
+    typename V::type lower = V::set(0.0f);
+    typename V::type upper = V::set(float(MaxValue));
+    for (; i + V::width <= aSize; i += V::width)
+    {
+        V::store(anOutput + i, V::minimum(V::maximum(V::load(anInput + i), lower), upper));
+    }
+
+    typename T::type tail_lower = T::set(0.0f);
+    typename T::type tail_upper = T::set(float(MaxValue));
+    for (; i < aSize; ++i)
+    {
+        T::store(anOutput + i, T::minimum(T::maximum(T::load(anInput + i), tail_lower), tail_upper));
+    }
+}
+
+
+//------------------------------------------------------------------------------
+/// Fill the table of kernels using the vector type V, and the type T for the
+/// pixels that remain at the end of the vector loops
+//------------------------------------------------------------------------------
+template<typename V, typename T>
+PixelKernels createPixelKernels(const char* aName, SIMDLevel aLevel)
+{
+    PixelKernels kernels;
+
+    kernels.name = aName;
+    kernels.level = aLevel;
+
+    kernels.addScalar      = &scalarKernel<V, T, AddOperator,      false>;
+    kernels.subtractScalar = &scalarKernel<V, T, SubtractOperator, false>;
+    kernels.multiplyScalar = &scalarKernel<V, T, MultiplyOperator, false>;
+    kernels.divideScalar   = &scalarKernel<V, T, DivideOperator,   false>;
+    kernels.scalarSubtract = &scalarKernel<V, T, SubtractOperator, true>;
+    kernels.scalarDivide   = &scalarKernel<V, T, DivideOperator,   true>;
+    kernels.multiplyAdd    = &multiplyAddKernel<V, T>;
+
+    kernels.add      = &binaryKernel<V, T, AddOperator>;
+    kernels.subtract = &binaryKernel<V, T, SubtractOperator>;
+    kernels.multiply = &binaryKernel<V, T, MultiplyOperator>;
+    kernels.divide   = &binaryKernel<V, T, DivideOperator>;
+
+    kernels.absoluteValue = &unaryKernel<V, T, AbsoluteValueOperator>;
+    kernels.square        = &unaryKernel<V, T, SquareOperator>;
+    kernels.squareRoot    = &unaryKernel<V, T, SquareRootOperator>;
+
+    kernels.clamp = &clampKernel<V, T>;
+
+    kernels.statistics = &statisticsKernel<V, T>;
+
+    kernels.convertFromUInt8  = &convertToFloatKernel<V, T, uint8_t>;
+    kernels.convertFromUInt16 = &convertToFloatKernel<V, T, uint16_t>;
+    kernels.convertToUInt8    = &convertFromFloatKernel<V, T, uint8_t, 255>;
+    kernels.convertToUInt16   = &convertFromFloatKernel<V, T, uint16_t, 65535>;
+
+    return kernels;
+}
+
+} // namespace
+
+
+#ifdef HAS_X86_KERNELS
+#include <emmintrin.h>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+/// A single float in a SSE register, used for the tails of the loops of the
+/// x86 kernels. It does not rely on <cmath> or <algorithm>, whose inline
+/// functions could be shared with files built without SIMD flags.
+//------------------------------------------------------------------------------
+struct SSEScalarTraits
+{
+    typedef __m128 type;
+    enum { width = 1 };
+
+    static type load(const float* p) { return _mm_load_ss(p); }
+    static void store(float* p, type a) { _mm_store_ss(p, a); }
+    static type set(float a) { return _mm_set_ss(a); }
+    static type add(type a, type b) { return _mm_add_ss(a, b); }
+    static type subtract(type a, type b) { return _mm_sub_ss(a, b); }
+    static type multiply(type a, type b) { return _mm_mul_ss(a, b); }
+    static type divide(type a, type b) { return _mm_div_ss(a, b); }
+    static type minimum(type a, type b) { return _mm_min_ss(a, b); }
+    static type maximum(type a, type b) { return _mm_max_ss(a, b); }
+    static type absoluteValue(type a) { return _mm_andnot_ps(_mm_set_ss(-0.0f), a); }
+    static type squareRoot(type a) { return _mm_sqrt_ss(a); }
+
+    static type load(const uint8_t* p) { return _mm_set_ss(float(*p)); }
+    static type load(const uint16_t* p) { return _mm_set_ss(float(*p)); }
+    static void store(uint8_t* p, type a) { *p = uint8_t(_mm_cvtss_si32(a)); }
+    static void store(uint16_t* p, type a) { *p = uint16_t(_mm_cvtss_si32(a)); }
+};
+
+} // namespace
+
+// The x86 kernels, each of them defined in its own source file
+PixelKernels createSSE2PixelKernels();
+PixelKernels createAVX2PixelKernels();
+PixelKernels createAVX512PixelKernels();
+
+#endif // HAS_X86_KERNELS
+
+#endif // __PixelKernelsImpl_h
@@ -0,0 +1,93 @@
+#ifndef __PixelRow_h
+#define __PixelRow_h
+
+#include <cstddef>  // size_t, ptrdiff_t
+#include <iterator> // std::forward_iterator_tag
+
+
+//------------------------------------------------------------------------------
+/// A row of pixels (no bounds check). T is float or const float.
+//------------------------------------------------------------------------------
+template<typename T>
+class PixelRow
+{
+public:
+    typedef T* iterator;
+
+    PixelRow(T* aFirstPixel, size_t aWidth):
+        m_p_data(aFirstPixel),
+        m_width(aWidth)
+    {}
+
+    T& operator[](size_t col) const { return m_p_data[col]; }
+    T* data() const { return m_p_data; }
+    size_t size() const { return m_width; }
+    iterator begin() const { return m_p_data; }
+    iterator end() const { return m_p_data + m_width; }
+
+private:
+    T* m_p_data;    //< The first pixel of the row
+    size_t m_width; //< The number of pixels in the row
+};
+
+
+//------------------------------------------------------------------------------
+/// Iterator on the rows of an image
+//------------------------------------------------------------------------------
+template<typename T>
+class PixelRowIterator
+{
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef PixelRow<T> value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const PixelRow<T>* pointer;
+    typedef PixelRow<T> reference;
+
+    PixelRowIterator(T* aFirstPixel, size_t aWidth, size_t aStride):
+        m_p_data(aFirstPixel),
+        m_width(aWidth),
+        m_stride(aStride)
+    {}
+
+    PixelRow<T> operator*() const { return PixelRow<T>(m_p_data, m_width); }
+    PixelRowIterator& operator++() { m_p_data += m_stride; return *this; }
+    PixelRowIterator operator++(int) { PixelRowIterator temp(*this); ++*this; return temp; }
+    bool operator==(const PixelRowIterator& anIterator) const { return m_p_data == anIterator.m_p_data; }
+    bool operator!=(const PixelRowIterator& anIterator) const { return m_p_data != anIterator.m_p_data; }
+
+private:
+    T* m_p_data;     //< The first pixel of the current row
+    size_t m_width;  //< The number of pixels in a row
+    size_t m_stride; //< The distance between two rows in number of pixels
+};
+
+
+//------------------------------------------------------------------------------
+/// All the rows of an image, e.g. for (PixelRow<float> row: writer.getRows())
+//------------------------------------------------------------------------------
+template<typename T>
+class PixelRows
+{
+public:
+    typedef PixelRowIterator<T> iterator;
+
+    PixelRows(T* aFirstPixel, size_t aWidth, size_t aHeight, size_t aStride):
+        m_p_data(aFirstPixel),
+        m_width(aWidth),
+        m_height(aHeight),
+        m_stride(aStride)
+    {}
+
+    iterator begin() const { return iterator(m_p_data, m_width, m_stride); }
+    iterator end() const { return iterator(m_p_data + m_height * m_stride, m_width, m_stride); }
+    size_t size() const { return m_height; }
+
+private:
+    T* m_p_data;     //< The first pixel of the image
+    size_t m_width;  //< The number of columns
+    size_t m_height; //< The number of rows
+    size_t m_stride; //< The distance between two rows in number of pixels
+};
+
+#endif // __PixelRow_h
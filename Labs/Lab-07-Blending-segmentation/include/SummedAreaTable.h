@@ -0,0 +1,172 @@
+#ifndef __SummedAreaTable_h
+#define __SummedAreaTable_h
+
+#include <cstddef>      // size_t, ptrdiff_t
+
+#include "Image.h"
+#include "Convolution.h"
+#include "PixelBuffer.h"
+
+
+//------------------------------------------------------------------------------
+/// Summed-area table (integral image) of an Image: the sum of the pixels of
+/// any rectangle costs four look-ups, whatever its size. The sums are stored
+/// in double precision, so that the differences of large sums keep the
+/// precision of the pixels. The sums of the squared pixels can be stored too,
+/// for local variances.
+///
+/// Box filters (local means) and local variances of any radius then cost O(1)
+/// per pixel, and the same table can be reused for several radii, e.g. for
+/// local mean and variance thresholding.
+//------------------------------------------------------------------------------
+class SummedAreaTable
+{
+public:
+    //--------------------------------------------------------------------------
+    /// Default constructor: an empty table
+    //--------------------------------------------------------------------------
+    SummedAreaTable();
+
+
+    //--------------------------------------------------------------------------
+    /// Constructor: compute the table of an image
+    /**
+    * @param anImage: the image
+    * @param aSquaresFlag: true to compute the sums of the squared pixels too
+    * (needed by getSumOfSquares and localVariance)
+    */
+    //--------------------------------------------------------------------------
+    explicit SummedAreaTable(const Image& anImage, bool aSquaresFlag = false);
+
+
+    //--------------------------------------------------------------------------
+    /// Compute the table of an image, using several threads (the rows, then
+    /// the columns)
+    /**
+    * @param anImage: the image
+    * @param aSquaresFlag: true to compute the sums of the squared pixels too
+    */
+    //--------------------------------------------------------------------------
+    void create(const Image& anImage, bool aSquaresFlag = false);
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the width of the image
+    /**
+    * @return the number of columns
+    */
+    //--------------------------------------------------------------------------
+    size_t getWidth() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the height of the image
+    /**
+    * @return the number of rows
+    */
+    //--------------------------------------------------------------------------
+    size_t getHeight() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the sum of the pixels of a rectangle
+    /**
+    * @param aCol: the first column (it can be outside of the image)
+    * @param aRow: the first row (it can be outside of the image)
+    * @param aWidth: the number of columns
+    * @param aHeight: the number of rows
+    * @param aBorderMode: the value of the pixels outside of the image: the
+    * closest pixel (BORDER_EXTEND) or zero (BORDER_ZERO). With BORDER_CROP,
+    * the rectangle must be inside the image.
+    * @return the sum
+    */
+    //--------------------------------------------------------------------------
+    double getSum(ptrdiff_t aCol, ptrdiff_t aRow,
+                  size_t aWidth, size_t aHeight,
+                  BorderMode aBorderMode = BORDER_EXTEND) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the sum of the squared pixels of a rectangle (the table must
+    /// have been created with aSquaresFlag)
+    /**
+    * @param aCol: the first column (it can be outside of the image)
+    * @param aRow: the first row (it can be outside of the image)
+    * @param aWidth: the number of columns
+    * @param aHeight: the number of rows
+    * @param aBorderMode: the value of the pixels outside of the image (see
+    * getSum)
+    * @return the sum
+    */
+    //--------------------------------------------------------------------------
+    double getSumOfSquares(ptrdiff_t aCol, ptrdiff_t aRow,
+                           size_t aWidth, size_t aHeight,
+                           BorderMode aBorderMode = BORDER_EXTEND) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Box filter: the mean of the (2r + 1) x (2r + 1) window of each pixel,
+    /// in O(1) per pixel. With BORDER_EXTEND, the result is the same as the
+    /// convolution with the normalised box kernel (see Image::conv2d).
+    /**
+    * @param aRadius: the radius r of the window
+    * @param aBorderMode: how to deal with the border
+    * @return the local means (smaller than the image with BORDER_CROP)
+    */
+    //--------------------------------------------------------------------------
+    Image boxFilter(unsigned int aRadius, BorderMode aBorderMode = BORDER_EXTEND) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Local variance: E[f^2] - E[f]^2 over the (2r + 1) x (2r + 1) window of
+    /// each pixel, in O(1) per pixel (the table must have been created with
+    /// aSquaresFlag)
+    /**
+    * @param aRadius: the radius r of the window
+    * @param aBorderMode: how to deal with the border
+    * @return the local variances (smaller than the image with BORDER_CROP)
+    */
+    //--------------------------------------------------------------------------
+    Image localVariance(unsigned int aRadius, BorderMode aBorderMode = BORDER_EXTEND) const;
+
+
+private:
+    //--------------------------------------------------------------------------
+    /// The sum of a rectangle of a table, clipped by the image or not
+    /**
+    * @param aTable: the table (m_sums or m_squares)
+    * @param aCol: the first column
+    * @param aRow: the first row
+    * @param aWidth: the number of columns
+    * @param aHeight: the number of rows
+    * @param aBorderMode: how to deal with the border
+    * @return the sum
+    */
+    //--------------------------------------------------------------------------
+    double getSum(const PixelBuffer<double>& aTable,
+                  ptrdiff_t aCol, ptrdiff_t aRow,
+                  size_t aWidth, size_t aHeight,
+                  BorderMode aBorderMode) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Compute the means of the windows of all the pixels, and optionally the
+    /// variances, in parallel
+    /**
+    * @param aRadius: the radius of the windows
+    * @param aBorderMode: how to deal with the border
+    * @param aVarianceFlag: true for the variances, false for the means
+    * @return the image
+    */
+    //--------------------------------------------------------------------------
+    Image filter(unsigned int aRadius, BorderMode aBorderMode, bool aVarianceFlag) const;
+
+
+    size_t m_width;                 //< The number of columns of the image
+    size_t m_height;                //< The number of rows of the image
+    PixelBuffer<double> m_sums;     //< The sums of the pixels above and on the left, (w + 1) x (h + 1)
+    PixelBuffer<double> m_squares;  //< The sums of the squared pixels, or empty
+};
+
+
+#endif // __SummedAreaTable_h
@@ -0,0 +1,211 @@
+#ifndef __ThreadPool_h
+#define __ThreadPool_h
+
+#include <vector>
+#include <cstddef>              // size_t
+#include <functional>           // std::function
+#include <memory>               // std::unique_ptr
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>            // std::exception_ptr
+
+#include "PixelAllocator.h"
+
+
+//------------------------------------------------------------------------------
+/// Pool of threads used by the Image methods (point operators, convolutions,
+/// statistics). A job is a set of independent tasks, e.g. the row tiles of an
+/// image. Each thread owns a range of tasks, and the threads that run out of
+/// work steal half of the remaining tasks of another thread.
+/// The tasks never depend on the number of threads, and each task writes its
+/// own part of the output: the results are the same whatever the number of
+/// threads.
+//------------------------------------------------------------------------------
+class ThreadPool
+{
+public:
+    typedef std::function<void(size_t)> Task;
+    typedef std::function<void(size_t, size_t)> TileTask;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the pool shared by all the images
+    /**
+    * @return the pool
+    */
+    //--------------------------------------------------------------------------
+    static ThreadPool& getInstance();
+
+
+    //--------------------------------------------------------------------------
+    /// Destructor: stop the threads
+    //--------------------------------------------------------------------------
+    ~ThreadPool();
+
+
+    //--------------------------------------------------------------------------
+    /// Set the number of threads, including the thread that submits the jobs.
+    /// It waits for the job in progress, if any. It cannot be called from a
+    /// task (std::logic_error).
+    /**
+    * @param aNumberOfThreads: the number of threads, or 0 to use all the cores
+    */
+    //--------------------------------------------------------------------------
+    void setNumberOfThreads(size_t aNumberOfThreads);
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the number of threads
+    /**
+    * @return the number of threads, including the thread that submits the jobs
+    */
+    //--------------------------------------------------------------------------
+    size_t getNumberOfThreads() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Set the size of the tiles, i.e. the number of pixels processed by a task.
+    /// The default (32K pixels, 128 KB) fits in the L2 cache.
+    /**
+    * @param aNumberOfPixels: the number of pixels of a tile, or 0 for the default
+    */
+    //--------------------------------------------------------------------------
+    void setTileSize(size_t aNumberOfPixels);
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the size of the tiles
+    /**
+    * @return the number of pixels of a tile
+    */
+    //--------------------------------------------------------------------------
+    size_t getTileSize() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Run aTask(0), aTask(1), ..., aTask(aNumberOfTasks - 1) using all the
+    /// threads, and wait for them. The tasks are run by the calling thread
+    /// only if the pool has one thread, or if run is called from a task.
+    /// If a task throws an exception, the first one is thrown again here once
+    /// all the tasks are done. The tasks allocate their pixel buffers from the
+    /// allocator of the calling thread (see ScopedPixelAllocator).
+    /**
+    * @param aNumberOfTasks: the number of tasks
+    * @param aTask: the task
+    */
+    //--------------------------------------------------------------------------
+    void run(size_t aNumberOfTasks, const Task& aTask);
+
+
+    //--------------------------------------------------------------------------
+    /// Split a set of pixels in tiles of getTileSize() pixels, and run
+    /// aTask(first pixel, number of pixels) on each of them
+    /**
+    * @param aNumberOfPixels: the number of pixels
+    * @param aTask: the task
+    */
+    //--------------------------------------------------------------------------
+    void runOnTiles(size_t aNumberOfPixels, const TileTask& aTask);
+
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+private:
+    //--------------------------------------------------------------------------
+    /// The tasks of a thread, from m_first_task to m_last_task (excluded)
+    //--------------------------------------------------------------------------
+    struct TaskQueue
+    {
+        std::mutex m_mutex;
+        size_t m_first_task;
+        size_t m_last_task;
+    };
+
+
+    //--------------------------------------------------------------------------
+    /// Default constructor: Use all the cores
+    //--------------------------------------------------------------------------
+    ThreadPool();
+
+
+    //--------------------------------------------------------------------------
+    /// Start the worker threads (one less than aNumberOfThreads)
+    /**
+    * @param aNumberOfThreads: the number of threads, including the caller
+    */
+    //--------------------------------------------------------------------------
+    void startThreads(size_t aNumberOfThreads);
+
+
+    //--------------------------------------------------------------------------
+    /// Stop and join the worker threads
+    //--------------------------------------------------------------------------
+    void stopThreads();
+
+
+    //--------------------------------------------------------------------------
+    /// Main loop of a worker thread
+    /**
+    * @param aThreadID: the index of the thread (from 1, 0 is the caller)
+    */
+    //--------------------------------------------------------------------------
+    void workerLoop(size_t aThreadID);
+
+
+    //--------------------------------------------------------------------------
+    /// Run the tasks of a thread, then steal the ones of the other threads
+    /// until there is nothing left
+    /**
+    * @param aThreadID: the index of the thread
+    */
+    //--------------------------------------------------------------------------
+    void runTasks(size_t aThreadID);
+
+
+    //--------------------------------------------------------------------------
+    /// Take the next task of a thread
+    /**
+    * @param aThreadID: the index of the thread
+    * @param aTask: the task
+    * @return true if there was a task, false otherwise
+    */
+    //--------------------------------------------------------------------------
+    bool popTask(size_t aThreadID, size_t& aTask);
+
+
+    //--------------------------------------------------------------------------
+    /// Steal the second half of the tasks of another thread. The first stolen
+    /// task is returned, the others go in the queue of the thread.
+    /**
+    * @param aThreadID: the index of the thread that steals
+    * @param aTask: the task
+    * @return true if a task was stolen, false if there is no task left
+    */
+    //--------------------------------------------------------------------------
+    bool stealTasks(size_t aThreadID, size_t& aTask);
+
+
+    std::vector<std::thread> m_threads;                 //< The worker threads
+    std::vector<std::unique_ptr<TaskQueue> > m_queues;  //< The tasks of each thread (0 is the caller)
+
+    std::mutex m_job_mutex;             //< Only one job at a time, protects m_threads and m_queues
+    std::mutex m_mutex;                 //< Protects the state below
+    std::condition_variable m_start;    //< Signals a new job (or the end) to the workers
+    std::condition_variable m_done;     //< Signals the end of the job to the caller
+    const Task* m_p_task;               //< The task of the current job
+    std::shared_ptr<PixelAllocator> m_allocator; //< The pixel allocator of the caller of the current job
+    size_t m_job_id;                    //< Incremented for every job
+    size_t m_busy_workers;              //< The number of workers that are running tasks
+    bool m_stop;                        //< True to stop the workers
+    std::exception_ptr m_exception;     //< The first exception thrown by a task
+    std::atomic<size_t> m_remaining_tasks; //< The number of tasks that are not done
+
+    std::atomic<size_t> m_number_of_threads;   //< The number of queues, read without m_job_mutex
+    std::atomic<size_t> m_tile_size;           //< The number of pixels of a tile
+};
+
+
+#endif // __ThreadPool_h
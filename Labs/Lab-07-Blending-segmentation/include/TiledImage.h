@@ -0,0 +1,197 @@
+#ifndef __TiledImage_h
+#define __TiledImage_h
+
+#include <cstddef>      // size_t, ptrdiff_t
+#include <functional>   // std::function
+
+#include "Image.h"
+#include "Convolution.h"
+
+
+//------------------------------------------------------------------------------
+/// Greyscale image stored in a raw file of floats (see ImageIO.h), too large
+/// to fit in memory, e.g. a stitched panorama or a microscopy slide. The file
+/// is mapped in memory: the system reads the pages when they are accessed and
+/// writes them back when they are modified.
+///
+/// The operations stream over the image by square tiles. Each tile is read
+/// with a border (the halo) into an Image, processed with the Image API (point
+/// operators, conv2d, filters...), then written to the output without its
+/// halo. The pages of the tiles that are done are released: the memory used is
+/// a band of tiles, whatever the size of the image.
+//------------------------------------------------------------------------------
+class TiledImage
+{
+public:
+    typedef std::function<Image(const Image&)> TileOperation;
+
+
+    //--------------------------------------------------------------------------
+    /// Constructor: create a new file, filled with zeros
+    /**
+    * @param aFilename: the name of the file (raw, see ImageIO.h)
+    * @param aWidth: the number of columns
+    * @param aHeight: the number of rows
+    * @param aTileSize: the number of columns and of rows of the tiles
+    */
+    //--------------------------------------------------------------------------
+    TiledImage(const char* aFilename, size_t aWidth, size_t aHeight, size_t aTileSize = 512);
+
+
+    //--------------------------------------------------------------------------
+    /// Constructor: open an existing raw file of floats, to read and write it
+    /**
+    * @param aFilename: the name of the file
+    * @param aTileSize: the number of columns and of rows of the tiles
+    */
+    //--------------------------------------------------------------------------
+    explicit TiledImage(const char* aFilename, size_t aTileSize = 512);
+
+
+    //--------------------------------------------------------------------------
+    /// Destructor: unmap the file (the modified pages are written by the
+    /// system)
+    //--------------------------------------------------------------------------
+    ~TiledImage();
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the width of the image
+    /**
+    * @return the number of columns
+    */
+    //--------------------------------------------------------------------------
+    size_t getWidth() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the height of the image
+    /**
+    * @return the number of rows
+    */
+    //--------------------------------------------------------------------------
+    size_t getHeight() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the size of the tiles
+    /**
+    * @return the number of columns and of rows of a tile
+    */
+    //--------------------------------------------------------------------------
+    size_t getTileSize() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Copy a region of the image in memory. The region may go beyond the
+    /// edges of the image.
+    /**
+    * @param aColumn: the first column of the region (may be negative)
+    * @param aRow: the first row of the region (may be negative)
+    * @param aWidth: the number of columns of the region
+    * @param aHeight: the number of rows of the region
+    * @param aBorderMode: the pixels outside of the image: the closest pixel
+    * (BORDER_EXTEND) or zero (BORDER_ZERO). With BORDER_CROP, the region must
+    * be inside the image.
+    * @return the pixels of the region
+    */
+    //--------------------------------------------------------------------------
+    Image readRegion(ptrdiff_t aColumn, ptrdiff_t aRow,
+                     size_t aWidth, size_t aHeight,
+                     BorderMode aBorderMode = BORDER_EXTEND) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Copy an image in a region of the image
+    /**
+    * @param anImage: the pixels (the region must be inside the image)
+    * @param aColumn: the first column of the region
+    * @param aRow: the first row of the region
+    */
+    //--------------------------------------------------------------------------
+    void writeRegion(const Image& anImage, size_t aColumn, size_t aRow);
+
+
+    //--------------------------------------------------------------------------
+    /// Apply an operation to all the tiles, e.g.
+    /// [](const Image& aTile) { return aTile.gaussianFilter() * 2.0f; }
+    /// The result is the same as the operation on the whole image if each
+    /// output pixel only depends on the input pixels that are less than aHalo
+    /// pixels away (aHalo = 0 for point operators), and the operation extends
+    /// the border of the image (BORDER_EXTEND).
+    /**
+    * @param anOutput: the result (same size). It may be this image if aHalo
+    * is 0.
+    * @param anOperation: the operation, which returns an image of the size of
+    * its input
+    * @param aHalo: the number of pixels around the tiles that are needed
+    */
+    //--------------------------------------------------------------------------
+    void transform(TiledImage& anOutput, const TileOperation& anOperation, size_t aHalo = 0) const;
+
+
+    //--------------------------------------------------------------------------
+    /// 2D convolution, tile by tile (see Image::conv2d). The halo of the tiles
+    /// is given by the size of the kernel.
+    /**
+    * @param anOutput: the result (see getConvolutionSize), not this image
+    * @param aKernel: the kernel h
+    * @param aBorderMode: how to deal with the border (BORDER_EXTEND by default)
+    * @param aMethod: how to compute the convolution of the tiles
+    */
+    //--------------------------------------------------------------------------
+    void conv2d(TiledImage& anOutput,
+                const Image& aKernel,
+                BorderMode aBorderMode = BORDER_EXTEND,
+                ConvolutionMethod aMethod = CONVOLUTION_AUTO) const;
+
+
+    TiledImage(const TiledImage&) = delete;
+    TiledImage& operator=(const TiledImage&) = delete;
+
+private:
+    //--------------------------------------------------------------------------
+    /// Map a file in memory, to read and write it
+    /**
+    * @param aFilename: the name of the file
+    * @param aSize: the size of a new file, or 0 to open an existing file
+    */
+    //--------------------------------------------------------------------------
+    void map(const char* aFilename, size_t aSize);
+
+
+    //--------------------------------------------------------------------------
+    /// Release the memory of a set of rows. The modified pages are scheduled to
+    /// be written, and the pages stay in the file.
+    /**
+    * @param aFirstRow: the first row
+    * @param aNumberOfRows: the number of rows
+    */
+    //--------------------------------------------------------------------------
+    void releaseRows(size_t aFirstRow, size_t aNumberOfRows) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Process the image by tiles, band by band
+    /**
+    * @param anOutput: the output image
+    * @param aProcessTile: computes the output tile at (column, row, width, height)
+    * @param aHalo: the number of input rows above and below a band that are
+    * used
+    */
+    //--------------------------------------------------------------------------
+    void processTiles(TiledImage& anOutput,
+                      const std::function<Image(size_t, size_t, size_t, size_t)>& aProcessTile,
+                      size_t aHalo) const;
+
+
+    unsigned char* m_p_data;    //< The mapped file
+    size_t m_size;              //< The number of bytes of the file
+    float* m_p_pixels;          //< The pixels, after the header
+    size_t m_width;             //< The number of columns
+    size_t m_height;            //< The number of rows
+    size_t m_tile_size;         //< The number of columns and of rows of the tiles
+};
+
+
+#endif // __TiledImage_h
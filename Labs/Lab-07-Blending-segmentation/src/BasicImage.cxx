@@ -0,0 +1,542 @@
+#include <sstream>
+#include <stdexcept>      // std::out_of_range
+#include <cmath>
+#include <utility>        // std::move
+#include <algorithm>      // std::min, std::copy
+
+#include "Image.h"
+#include "ImageIO.h"
+#include "MedianFilter.h"
+#include "PixelKernels.h"
+#include "ThreadPool.h"
+
+
+namespace
+{
+
+// The number of pixels converted to floats at a time, when there is no
+// direct conversion between two pixel types
+const size_t conversion_buffer_size = 256;
+
+
+//------------------------------------------------------------------------------
+/// Conversions of a tile of pixels. The conversions from and to integers use
+/// the SIMD kernels, the ones from and to Half are plain C++.
+//------------------------------------------------------------------------------
+void convertTile(const uint8_t* anInput, float* anOutput, size_t aSize)
+{
+    getPixelKernels().convertFromUInt8(anInput, anOutput, aSize);
+}
+
+void convertTile(const uint16_t* anInput, float* anOutput, size_t aSize)
+{
+    getPixelKernels().convertFromUInt16(anInput, anOutput, aSize);
+}
+
+void convertTile(const float* anInput, uint8_t* anOutput, size_t aSize)
+{
+    getPixelKernels().convertToUInt8(anInput, anOutput, aSize);
+}
+
+void convertTile(const float* anInput, uint16_t* anOutput, size_t aSize)
+{
+    getPixelKernels().convertToUInt16(anInput, anOutput, aSize);
+}
+
+void convertTile(const Half* anInput, float* anOutput, size_t aSize)
+{
+    for (size_t i = 0; i < aSize; ++i) anOutput[i] = float(anInput[i]);
+}
+
+void convertTile(const float* anInput, Half* anOutput, size_t aSize)
+{
+    for (size_t i = 0; i < aSize; ++i) anOutput[i] = Half(anInput[i]);
+}
+
+// Same type
+template<typename PixelT>
+void convertTile(const PixelT* anInput, PixelT* anOutput, size_t aSize)
+{
+    std::copy(anInput, anInput + aSize, anOutput);
+}
+
+// Any other pair of types: through a small buffer of floats
+template<typename InputT, typename OutputT>
+void convertTile(const InputT* anInput, OutputT* anOutput, size_t aSize)
+{
+    float buffer[conversion_buffer_size];
+    for (size_t i = 0; i < aSize; i += conversion_buffer_size)
+    {
+        size_t size = std::min(conversion_buffer_size, aSize - i);
+        convertTile(anInput + i, buffer, size);
+        convertTile(buffer, anOutput + i, size);
+    }
+}
+
+
+//------------------------------------------------------------------------------
+/// Decode a row of a greyscale JPEG file into a row of an image. The rows of
+/// an 8-bit image are decoded in place, the others are converted.
+//------------------------------------------------------------------------------
+void readGreyRow(JPEGDecoder& aDecoder, unsigned char*, uint8_t* aRow, size_t)
+{
+    aDecoder.readScanline(aRow);
+}
+
+template<typename PixelT>
+void readGreyRow(JPEGDecoder& aDecoder, unsigned char* aScanline, PixelT* aRow, size_t aWidth)
+{
+    aDecoder.readScanline(aScanline);
+    convertTile(aScanline, aRow, aWidth);
+}
+
+} // namespace
+
+
+//------------------------------------------------------------------------
+template<typename InputT, typename OutputT>
+void convertPixels(const InputT* anInput, OutputT* anOutput, size_t aSize)
+//------------------------------------------------------------------------
+{
+    ThreadPool::getInstance().runOnTiles(aSize, [&](size_t aFirstPixel, size_t aNumberOfPixels)
+    {
+        convertTile(anInput + aFirstPixel, anOutput + aFirstPixel, aNumberOfPixels);
+    });
+}
+
+
+//-------------------------------
+template<typename PixelT>
+BasicImage<PixelT>::BasicImage():
+//-------------------------------
+    m_width(0),
+    m_height(0),
+    m_min_pixel_value(0),
+    m_max_pixel_value(0),
+    m_average_pixel_value(0),
+    m_stddev_pixel_value(0),
+    m_stats_up_to_date(true)
+//-------------------------------
+{}
+
+
+//------------------------------------------------------------
+template<typename PixelT>
+BasicImage<PixelT>::BasicImage(BasicImage&& anImage) noexcept:
+//------------------------------------------------------------
+    m_pixel_data(std::move(anImage.m_pixel_data)),
+    m_width(anImage.m_width),
+    m_height(anImage.m_height),
+    m_min_pixel_value(anImage.m_min_pixel_value),
+    m_max_pixel_value(anImage.m_max_pixel_value),
+    m_average_pixel_value(anImage.m_average_pixel_value),
+    m_stddev_pixel_value(anImage.m_stddev_pixel_value),
+    m_stats_up_to_date(anImage.m_stats_up_to_date)
+//------------------------------------------------------------
+{
+    // Leave the input image empty (but valid)
+    anImage.m_pixel_data.clear();
+    anImage.m_width = 0;
+    anImage.m_height = 0;
+    anImage.m_min_pixel_value = 0;
+    anImage.m_max_pixel_value = 0;
+    anImage.m_average_pixel_value = 0;
+    anImage.m_stddev_pixel_value = 0;
+    anImage.m_stats_up_to_date = true;
+}
+
+
+//-----------------------------------------------------------------------------------
+template<typename PixelT>
+BasicImage<PixelT>::BasicImage(const PixelT* anImage, size_t aWidth, size_t aHeight):
+//-----------------------------------------------------------------------------------
+    m_pixel_data(anImage, anImage + aWidth * aHeight),
+    m_width(aWidth),
+    m_height(aHeight),
+    m_min_pixel_value(0),
+    m_max_pixel_value(0),
+    m_average_pixel_value(0),
+    m_stddev_pixel_value(0),
+    m_stats_up_to_date(false)
+//-----------------------------------------------------------------------------------
+{}
+
+
+//------------------------------------------------------------------------------------------------
+template<typename PixelT>
+BasicImage<PixelT>::BasicImage(const std::vector<PixelT>& anImage, size_t aWidth, size_t aHeight):
+//------------------------------------------------------------------------------------------------
+    m_pixel_data(anImage.data(), anImage.data() + anImage.size()),
+    m_width(aWidth),
+    m_height(aHeight),
+    m_min_pixel_value(0),
+    m_max_pixel_value(0),
+    m_average_pixel_value(0),
+    m_stddev_pixel_value(0),
+    m_stats_up_to_date(false)
+//------------------------------------------------------------------------------------------------
+{}
+
+
+//------------------------------------------------------------------------------
+template<typename PixelT>
+BasicImage<PixelT>::BasicImage(PixelT aConstant, size_t aWidth, size_t aHeight):
+//------------------------------------------------------------------------------
+    m_pixel_data(aWidth * aHeight, aConstant),
+    m_width(aWidth),
+    m_height(aHeight),
+    m_min_pixel_value(static_cast<float>(aConstant)),
+    m_max_pixel_value(static_cast<float>(aConstant)),
+    m_average_pixel_value(static_cast<float>(aConstant)),
+    m_stddev_pixel_value(0),
+    m_stats_up_to_date(true)
+//------------------------------------------------------------------------------
+{}
+
+
+//----------------------------------------------------
+template<typename PixelT>
+BasicImage<PixelT>::BasicImage(const char* aFilename):
+//----------------------------------------------------
+    m_width(0),
+    m_height(0),
+    m_min_pixel_value(0),
+    m_max_pixel_value(0),
+    m_average_pixel_value(0),
+    m_stddev_pixel_value(0),
+    m_stats_up_to_date(true)
+//----------------------------------------------------
+{
+    load(aFilename);
+}
+
+
+//-----------------------------------------------------------
+template<typename PixelT>
+BasicImage<PixelT>::BasicImage(const std::string& aFilename):
+//-----------------------------------------------------------
+    m_width(0),
+    m_height(0),
+    m_min_pixel_value(0),
+    m_max_pixel_value(0),
+    m_average_pixel_value(0),
+    m_stddev_pixel_value(0),
+    m_stats_up_to_date(true)
+//-----------------------------------------------------------
+{
+    load(aFilename);
+}
+
+
+//------------------------------------------------------------------------------
+template<typename PixelT>
+BasicImage<PixelT>& BasicImage<PixelT>::operator=(BasicImage&& anImage) noexcept
+//------------------------------------------------------------------------------
+{
+    if (this != &anImage)
+    {
+        m_pixel_data = std::move(anImage.m_pixel_data);
+        m_width = anImage.m_width;
+        m_height = anImage.m_height;
+        m_min_pixel_value = anImage.m_min_pixel_value;
+        m_max_pixel_value = anImage.m_max_pixel_value;
+        m_average_pixel_value = anImage.m_average_pixel_value;
+        m_stddev_pixel_value = anImage.m_stddev_pixel_value;
+        m_stats_up_to_date = anImage.m_stats_up_to_date;
+
+        // Leave the input image empty (but valid)
+        anImage.m_pixel_data.clear();
+        anImage.m_width = 0;
+        anImage.m_height = 0;
+        anImage.m_min_pixel_value = 0;
+        anImage.m_max_pixel_value = 0;
+        anImage.m_average_pixel_value = 0;
+        anImage.m_stddev_pixel_value = 0;
+        anImage.m_stats_up_to_date = true;
+    }
+
+    return *this;
+}
+
+
+//--------------------------------------------------------------------
+template<typename PixelT>
+void BasicImage<PixelT>::load(const char* aFilename, float aScaleHint)
+//--------------------------------------------------------------------
+{
+    // The file is mapped once: its format is read from its first bytes
+    MappedFile file(aFilename);
+
+    // Uncompressed file: read the whole image at once
+    if (readFileFormat(file, aFilename) != FORMAT_JPEG)
+    {
+        ImageFileReader reader(std::move(file), aFilename);
+        PixelBuffer<PixelT> pixel_data(reader.getWidth() * reader.getHeight());
+        reader.readPixels(pixel_data.data());
+
+        // The image is only changed once the file has been read
+        m_pixel_data.swap(pixel_data);
+        m_width = reader.getWidth();
+        m_height = reader.getHeight();
+        m_stats_up_to_date = false;
+        return;
+    }
+
+    // JPEG file: read its header from the mapped file. The pixels are
+    // decoded in a new buffer: the image is unchanged if the decoder throws.
+    JPEGDecoder decoder(std::move(file), aFilename, aScaleHint);
+    size_t width = decoder.getWidth();
+    size_t height = decoder.getHeight();
+    PixelBuffer<PixelT> pixel_data(width * height);
+
+    // Decode the rows one by one, and convert them straight into the image:
+    // only a row is stored in float
+    std::vector<unsigned char> scanline(width * decoder.getNumberOfComponents());
+    std::vector<float> luminance(width);
+    for (size_t row = 0; row < height; ++row)
+    {
+        PixelT* p_row = &pixel_data[row * width];
+
+        // Compute the relative luminance from RGB data
+        if (decoder.getNumberOfComponents() == 3)
+        {
+            decoder.readScanline(&scanline[0]);
+            computeLuminance(&scanline[0], &luminance[0], width);
+            convertTile(&luminance[0], p_row, width);
+        }
+        // Use the data
+        else
+        {
+            readGreyRow(decoder, &scanline[0], p_row, width);
+        }
+    }
+
+    // Replace the pixels (they are not copied)
+    m_pixel_data.swap(pixel_data);
+    m_width = width;
+    m_height = height;
+
+    // The statistics is not up-to-date
+    m_stats_up_to_date = false;
+}
+
+
+//---------------------------------------------------------------------------
+template<typename PixelT>
+void BasicImage<PixelT>::load(const std::string& aFilename, float aScaleHint)
+//---------------------------------------------------------------------------
+{
+    load(aFilename.c_str(), aScaleHint);
+}
+
+
+//-----------------------------------------------------------------------------------------------
+template<typename PixelT>
+void BasicImage<PixelT>::saveJPEG(const char* aFilename, int aQuality, bool anOptimiseFlag) const
+//-----------------------------------------------------------------------------------------------
+{
+    // Convert the data to 8 bits (nothing to do for 8-bit images)
+    std::vector<uint8_t> grey_image(m_pixel_data.size());
+    if (m_pixel_data.size())
+    {
+        convertPixels(&m_pixel_data[0], &grey_image[0], m_pixel_data.size());
+    }
+
+    writeJPEG(aFilename, grey_image.data(), m_width, m_height, aQuality, anOptimiseFlag);
+}
+
+
+//------------------------------------------------------------------------------------------------------
+template<typename PixelT>
+void BasicImage<PixelT>::saveJPEG(const std::string& aFilename, int aQuality, bool anOptimiseFlag) const
+//------------------------------------------------------------------------------------------------------
+{
+    saveJPEG(aFilename.c_str(), aQuality, anOptimiseFlag);
+}
+
+
+//--------------------------------------------------------
+template<typename PixelT>
+void BasicImage<PixelT>::save(const char* aFilename) const
+//--------------------------------------------------------
+{
+    ImageFileFormat format = getFileFormat(aFilename);
+    if (format == FORMAT_JPEG)
+    {
+        saveJPEG(aFilename);
+    }
+    else
+    {
+        writeImageFile(aFilename, format, getSampleType<PixelT>(), m_pixel_data.data(), m_width, m_height);
+    }
+}
+
+
+//---------------------------------------------------------------
+template<typename PixelT>
+void BasicImage<PixelT>::save(const std::string& aFilename) const
+//---------------------------------------------------------------
+{
+    save(aFilename.c_str());
+}
+
+
+//------------------------------------------------------------------------
+template<typename PixelT>
+BasicImage<PixelT> BasicImage<PixelT>::medianFilter(unsigned int aRadius) const
+//------------------------------------------------------------------------
+{
+    // The median is one of the pixels: it is converted back without loss
+    return BasicImage(Image(*this).medianFilter(aRadius));
+}
+
+
+//------------------------------------------------------------
+template<>
+ImageU8 ImageU8::medianFilter(unsigned int aRadius) const
+//------------------------------------------------------------
+{
+    ImageU8 output;
+    output.m_width = m_width;
+    output.m_height = m_height;
+    output.m_pixel_data.resize(m_pixel_data.size());
+    output.m_stats_up_to_date = !output.m_pixel_data.size();
+
+    if (m_pixel_data.size())
+    {
+        ::medianFilter(m_pixel_data.data(), m_width, m_height, aRadius, output.m_pixel_data.data());
+    }
+
+    return output;
+}
+
+
+//-------------------------------------
+template<typename PixelT>
+float BasicImage<PixelT>::getMinValue()
+//-------------------------------------
+{
+    if (!m_stats_up_to_date) updateStats();
+
+    return m_min_pixel_value;
+}
+
+
+//-------------------------------------
+template<typename PixelT>
+float BasicImage<PixelT>::getMaxValue()
+//-------------------------------------
+{
+    if (!m_stats_up_to_date) updateStats();
+
+    return m_max_pixel_value;
+}
+
+
+//-----------------------------------------
+template<typename PixelT>
+float BasicImage<PixelT>::getAverageValue()
+//-----------------------------------------
+{
+    if (!m_stats_up_to_date) updateStats();
+
+    return m_average_pixel_value;
+}
+
+
+//----------------------------------------------
+template<typename PixelT>
+float BasicImage<PixelT>::getStandardDeviation()
+//----------------------------------------------
+{
+    if (!m_stats_up_to_date) updateStats();
+
+    return m_stddev_pixel_value;
+}
+
+
+//--------------------------------------------------------------------
+template<typename PixelT>
+void BasicImage<PixelT>::throwOutOfRange(size_t col, size_t row) const
+//--------------------------------------------------------------------
+{
+    // Format a nice error message
+    std::stringstream error_message;
+    error_message << "ERROR:" << std::endl;
+    error_message << "\tin File:" << __FILE__ << std::endl;
+    error_message << "\tin Function:" << __FUNCTION__ << std::endl;
+    error_message << "\tat Line:" << __LINE__ << std::endl;
+    error_message << "\tMESSAGE: Pixel(" << col << ", " << row << ") does not exist. The image size is: " << m_width << "x" << m_height << std::endl;
+
+    // Throw an exception
+    throw std::out_of_range(error_message.str());
+}
+
+
+//------------------------------------
+template<typename PixelT>
+void BasicImage<PixelT>::updateStats()
+//------------------------------------
+{
+    // Need to udate the stats
+    if (!m_stats_up_to_date && m_pixel_data.size())
+    {
+        const PixelKernels& kernels = getPixelKernels();
+        const PixelT* p_data = &m_pixel_data[0];
+        size_t number_of_pixels = m_pixel_data.size();
+
+        // Same chunks as the float images: the statistics of an image and of
+        // its conversion to float are the same
+        const size_t chunk_size = 1 << 16;
+        size_t number_of_chunks = (number_of_pixels + chunk_size - 1) / chunk_size;
+        std::vector<PixelStatistics> chunk_statistics(number_of_chunks);
+
+        // The chunks are converted and processed in parallel
+        ThreadPool::getInstance().run(number_of_chunks, [&](size_t i)
+        {
+            size_t offset = i * chunk_size;
+            size_t size = std::min(chunk_size, number_of_pixels - offset);
+
+            std::vector<float> pixels(size);
+            convertTile(p_data + offset, &pixels[0], size);
+            chunk_statistics[i] = kernels.statistics(&pixels[0], size);
+        });
+
+        // Merge the statistics of all the chunks
+        PixelStatistics statistics = chunk_statistics[0];
+        for (size_t i = 1; i < number_of_chunks; ++i)
+        {
+            mergeStatistics(statistics, chunk_statistics[i]);
+        }
+
+        m_min_pixel_value = statistics.min;
+        m_max_pixel_value = statistics.max;
+        m_average_pixel_value = statistics.mean;
+        m_stddev_pixel_value = std::sqrt(statistics.sum_of_squares / statistics.count);
+
+        m_stats_up_to_date = true;
+    }
+}
+
+
+// The pixel types supported
+template class BasicImage<uint8_t>;
+template class BasicImage<uint16_t>;
+template class BasicImage<Half>;
+
+template void convertPixels(const uint8_t*,  uint8_t*,  size_t);
+template void convertPixels(const uint8_t*,  uint16_t*, size_t);
+template void convertPixels(const uint8_t*,  float*,    size_t);
+template void convertPixels(const uint8_t*,  Half*,     size_t);
+template void convertPixels(const uint16_t*, uint8_t*,  size_t);
+template void convertPixels(const uint16_t*, uint16_t*, size_t);
+template void convertPixels(const uint16_t*, float*,    size_t);
+template void convertPixels(const uint16_t*, Half*,     size_t);
+template void convertPixels(const float*,    uint8_t*,  size_t);
+template void convertPixels(const float*,    uint16_t*, size_t);
+template void convertPixels(const float*,    float*,    size_t);
+template void convertPixels(const float*,    Half*,     size_t);
+template void convertPixels(const Half*,     uint8_t*,  size_t);
+template void convertPixels(const Half*,     uint16_t*, size_t);
+template void convertPixels(const Half*,     float*,    size_t);
+template void convertPixels(const Half*,     Half*,     size_t);
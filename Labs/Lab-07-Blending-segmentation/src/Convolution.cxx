@@ -0,0 +1,661 @@
+#include <cmath>
+#include <vector>
+#include <algorithm>      // std::fill, std::copy, std::max, std::min
+
+#include "Convolution.h"
+#include "FFT.h"
+#include "ThreadPool.h"
+#include "PixelKernels.h"
+#include "PixelBuffer.h"
+
+
+namespace
+{
+
+typedef FFT::Complex Complex;
+
+// Relative tolerance used to decide if a kernel is separable
+const double separable_tolerance = 1.0e-6;
+
+// The largest size of the FFT tiles (the tiles of the whole image are used
+// if it is smaller)
+const size_t max_fft_tile_size = 1024;
+
+// The cost model, roughly in nanoseconds. A multiply-add of the spatial
+// convolution costs multiply_add_cost / (number of floats in a SIMD register).
+// The FFT-based convolution costs fft_cost per pixel of a tile and per log2 of
+// the number of pixels of a tile, plus fft_tile_cost per pixel of a tile
+// (copies and product of the spectra).
+const double multiply_add_cost = 1.0;
+const double fft_cost = 2.0;
+const double fft_tile_cost = 4.0;
+
+// The number of tile sizes remembered by each thread (see getFFTTileSize)
+const size_t fft_tile_size_cache_size = 16;
+
+
+//------------------------------------------------------------------------------
+/// a * b, without the NaN and infinity checks of std::complex
+//------------------------------------------------------------------------------
+inline Complex multiply(const Complex& a, const Complex& b)
+{
+    return Complex(a.real() * b.real() - a.imag() * b.imag(),
+                   a.real() * b.imag() + a.imag() * b.real());
+}
+
+
+//------------------------------------------------------------------------------
+/// Copy a row of the input image in a buffer, with the pixels required on the
+/// left and on the right of the row to apply the kernel
+//------------------------------------------------------------------------------
+void padRow(const float* anInputRow, size_t aWidth,
+            size_t aLeftBorder, size_t aRightBorder,
+            BorderMode aBorderMode, float* anOutputRow)
+{
+    float left_value  = aBorderMode == BORDER_EXTEND ? anInputRow[0] : 0.0f;
+    float right_value = aBorderMode == BORDER_EXTEND ? anInputRow[aWidth - 1] : 0.0f;
+
+    std::fill(anOutputRow, anOutputRow + aLeftBorder, left_value);
+    std::copy(anInputRow, anInputRow + aWidth, anOutputRow + aLeftBorder);
+    std::fill(anOutputRow + aLeftBorder + aWidth,
+              anOutputRow + aLeftBorder + aWidth + aRightBorder,
+              right_value);
+}
+
+
+//------------------------------------------------------------------------------
+/// Spatial convolution, by strips of rows. The kernel is applied as two 1D
+/// passes if it is separable: W_h + H_h operations per pixel instead of
+/// W_h x H_h.
+//------------------------------------------------------------------------------
+void convolveSpatial(const float* anInput, size_t aWidth, size_t aHeight,
+                     const float* aKernel, size_t aKernelWidth, size_t aKernelHeight,
+                     BorderMode aBorderMode, float* anOutput,
+                     size_t anOutputWidth, size_t anOutputHeight,
+                     bool aSeparableFlag,
+                     const std::vector<float>& aRowKernel,
+                     const std::vector<float>& aColumnKernel)
+{
+    // Number of pixels needed around the image. When the border is cropped,
+    // the rows of the input image are used as they are.
+    bool crop = aBorderMode == BORDER_CROP;
+    size_t left_border = crop ? 0 : aKernelWidth / 2;
+    size_t right_border = crop ? 0 : aKernelWidth - 1 - left_border;
+    size_t top_border = crop ? 0 : aKernelHeight / 2;
+    size_t padded_width = aWidth + left_border + right_border;
+
+    // The output rows are computed by strips. The input rows of a strip
+    // (padded, or filtered horizontally if the kernel is separable) are
+    // buffered once, and reused by the H_h output rows that need them.
+    // The size of the buffer is the size of the tiles of the thread pool.
+    size_t buffered_rows = std::max(aKernelHeight + 7, ThreadPool::getInstance().getTileSize() / padded_width);
+    size_t strip_height = buffered_rows - aKernelHeight + 1;
+    size_t number_of_strips = (anOutputHeight + strip_height - 1) / strip_height;
+
+    std::vector<float> zero_row(aBorderMode == BORDER_ZERO ? padded_width : 0, 0.0f);
+
+    const PixelKernels& kernels = getPixelKernels();
+
+    // The strips are independent: they are computed in parallel
+    ThreadPool::getInstance().run(number_of_strips, [&](size_t aStrip)
+    {
+        size_t first_row = aStrip * strip_height;
+        size_t last_row = std::min(first_row + strip_height, anOutputHeight);
+
+        // The buffers are written before being read: they come from the
+        // pixel allocator, e.g. recycled from the previous strips
+        PixelBuffer<float> buffer(buffered_rows * padded_width);
+        PixelBuffer<float> padded_row(aSeparableFlag && !crop ? padded_width : 0);
+        std::vector<const float*> rows(buffered_rows);
+
+        // Prepare the input rows of the strip
+        for (size_t i = 0; i < last_row - first_row + aKernelHeight - 1; ++i)
+        {
+            long long input_row = (long long)(first_row + i) - (long long)(top_border);
+
+            // The row is outside of the image
+            if (input_row < 0 || input_row >= (long long)(aHeight))
+            {
+                if (aBorderMode == BORDER_ZERO)
+                {
+                    rows[i] = &zero_row[0];
+                    continue;
+                }
+
+                input_row = input_row < 0 ? 0 : aHeight - 1;
+            }
+
+            const float* p_row = anInput + input_row * aWidth;
+            if (!crop)
+            {
+                float* p_padded_row = aSeparableFlag ? &padded_row[0] : &buffer[i * padded_width];
+                padRow(p_row, aWidth, left_border, right_border, aBorderMode, p_padded_row);
+                p_row = p_padded_row;
+            }
+
+            // Horizontal pass
+            if (aSeparableFlag)
+            {
+                float* p_filtered_row = &buffer[i * padded_width];
+                std::fill(p_filtered_row, p_filtered_row + anOutputWidth, 0.0f);
+
+                for (size_t k = 0; k < aKernelWidth; ++k)
+                {
+                    if (aRowKernel[k] != 0.0f)
+                    {
+                        kernels.multiplyAdd(p_row + k, aRowKernel[k], p_filtered_row, anOutputWidth);
+                    }
+                }
+
+                p_row = p_filtered_row;
+            }
+
+            rows[i] = p_row;
+        }
+
+        // Compute the output rows of the strip
+        for (size_t row = first_row; row < last_row; ++row)
+        {
+            float* p_output_row = anOutput + row * anOutputWidth;
+            std::fill(p_output_row, p_output_row + anOutputWidth, 0.0f);
+
+            for (size_t l = 0; l < aKernelHeight; ++l)
+            {
+                const float* p_row = rows[row - first_row + l];
+
+                // Vertical pass
+                if (aSeparableFlag)
+                {
+                    if (aColumnKernel[l] != 0.0f)
+                    {
+                        kernels.multiplyAdd(p_row, aColumnKernel[l], p_output_row, anOutputWidth);
+                    }
+                }
+                // All the coefficients of the row of the kernel
+                else
+                {
+                    for (size_t k = 0; k < aKernelWidth; ++k)
+                    {
+                        float coefficient = aKernel[l * aKernelWidth + k];
+                        if (coefficient != 0.0f)
+                        {
+                            kernels.multiplyAdd(p_row + k, coefficient, p_output_row, anOutputWidth);
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+
+//------------------------------------------------------------------------------
+/// 2D Fourier transform of the real tiles of the FFT-based convolution. The
+/// rows are transformed first (real FFT), then the columns of their spectra.
+/// The transforms are const: the tiles can be transformed in parallel.
+//------------------------------------------------------------------------------
+class TileTransform
+{
+public:
+    TileTransform(size_t aWidth, size_t aHeight):
+        m_width(aWidth),
+        m_height(aHeight),
+        m_spectrum_width(aWidth / 2 + 1),
+        m_row_transform(aWidth),
+        m_column_transform(aHeight, false),
+        m_column_inverse(aHeight, true)
+    {}
+
+    size_t getSpectrumSize() const { return m_spectrum_width * m_height; }
+
+    // aSpectrum = FFT(aTile)
+    void forward(const double* aTile, Complex* aSpectrum) const
+    {
+        for (size_t row = 0; row < m_height; ++row)
+        {
+            m_row_transform.forward(aTile + row * m_width, aSpectrum + row * m_spectrum_width);
+        }
+
+        transformColumns(m_column_transform, aSpectrum);
+    }
+
+    // aTile = m_width x m_height x FFT^-1(aSpectrum), for the rows from
+    // aFirstRow to aLastRow (excluded). aSpectrum is overwritten.
+    void inverse(Complex* aSpectrum, double* aTile, size_t aFirstRow, size_t aLastRow) const
+    {
+        transformColumns(m_column_inverse, aSpectrum);
+
+        for (size_t row = aFirstRow; row < aLastRow; ++row)
+        {
+            m_row_transform.inverse(aSpectrum + row * m_spectrum_width, aTile + row * m_width);
+        }
+    }
+
+private:
+    void transformColumns(const FFT& aTransform, Complex* aSpectrum) const
+    {
+        std::vector<Complex> column(m_height);
+        std::vector<Complex> transformed_column(m_height);
+
+        for (size_t col = 0; col < m_spectrum_width; ++col)
+        {
+            for (size_t row = 0; row < m_height; ++row)
+            {
+                column[row] = aSpectrum[row * m_spectrum_width + col];
+            }
+
+            aTransform.transform(&column[0], &transformed_column[0]);
+
+            for (size_t row = 0; row < m_height; ++row)
+            {
+                aSpectrum[row * m_spectrum_width + col] = transformed_column[row];
+            }
+        }
+    }
+
+    size_t m_width;                 //< The number of columns of a tile
+    size_t m_height;                //< The number of rows of a tile
+    size_t m_spectrum_width;        //< The number of columns of the spectrum
+    RealFFT m_row_transform;        //< The transform of the rows
+    FFT m_column_transform;         //< The transform of the columns
+    FFT m_column_inverse;           //< The inverse transform of the columns
+};
+
+
+//------------------------------------------------------------------------------
+/// Cost of the FFT-based convolution with given tile sizes. Each tile gives
+/// (tile width - W_h + 1) x (tile height - H_h + 1) pixels of the output.
+//------------------------------------------------------------------------------
+double getFFTCost(size_t anOutputWidth, size_t anOutputHeight,
+                  size_t aKernelWidth, size_t aKernelHeight,
+                  size_t aTileWidth, size_t aTileHeight)
+{
+    size_t valid_width = aTileWidth - aKernelWidth + 1;
+    size_t valid_height = aTileHeight - aKernelHeight + 1;
+    double number_of_tiles = double((anOutputWidth + valid_width - 1) / valid_width) *
+        double((anOutputHeight + valid_height - 1) / valid_height);
+
+    double tile_size = double(aTileWidth) * double(aTileHeight);
+    return number_of_tiles * tile_size *
+        (fft_cost * std::log(tile_size) / std::log(2.0) + fft_tile_cost);
+}
+
+
+//------------------------------------------------------------------------------
+/// Search the tile size that minimises the cost of the FFT-based convolution,
+/// among all the fast sizes
+//------------------------------------------------------------------------------
+double searchFFTTileSize(size_t anOutputWidth, size_t anOutputHeight,
+                         size_t aKernelWidth, size_t aKernelHeight,
+                         size_t& aTileWidth, size_t& aTileHeight)
+{
+    // The candidate sizes along each axis, from the smallest tile to the
+    // whole image (if it is not too large)
+    std::vector<size_t> candidates[2];
+    size_t output_sizes[2] = {anOutputWidth, anOutputHeight};
+    size_t kernel_sizes[2] = {aKernelWidth, aKernelHeight};
+
+    for (size_t axis = 0; axis < 2; ++axis)
+    {
+        size_t largest_size = FFT::getFastSize(output_sizes[axis] + kernel_sizes[axis] - 1, true);
+        largest_size = std::min(largest_size, std::max(max_fft_tile_size, 2 * kernel_sizes[axis]));
+
+        for (size_t size = FFT::getFastSize(kernel_sizes[axis], true);
+             size <= largest_size;
+             size = FFT::getFastSize(size + 1, true))
+        {
+            candidates[axis].push_back(size);
+        }
+
+        // The kernel is larger than the limit
+        if (candidates[axis].empty())
+        {
+            candidates[axis].push_back(FFT::getFastSize(kernel_sizes[axis], true));
+        }
+    }
+
+    double best_cost = -1;
+    for (size_t i = 0; i < candidates[0].size(); ++i)
+    {
+        for (size_t j = 0; j < candidates[1].size(); ++j)
+        {
+            double cost = getFFTCost(anOutputWidth, anOutputHeight,
+                aKernelWidth, aKernelHeight,
+                candidates[0][i], candidates[1][j]);
+
+            if (best_cost < 0 || cost < best_cost)
+            {
+                best_cost = cost;
+                aTileWidth = candidates[0][i];
+                aTileHeight = candidates[1][j];
+            }
+        }
+    }
+
+    return best_cost;
+}
+
+
+//------------------------------------------------------------------------------
+/// A tile size found by searchFFTTileSize
+//------------------------------------------------------------------------------
+struct FFTTileSize
+{
+    size_t m_output_width;          //< The number of columns of the output
+    size_t m_output_height;         //< The number of rows of the output
+    size_t m_kernel_width;          //< The number of columns of the kernel
+    size_t m_kernel_height;         //< The number of rows of the kernel
+    size_t m_tile_width;            //< The number of columns of the tiles
+    size_t m_tile_height;           //< The number of rows of the tiles
+    double m_cost;                  //< The cost of the convolution
+};
+
+// The last tile sizes found by each thread (a ring), without locks
+thread_local std::vector<FFTTileSize> fft_tile_sizes;
+thread_local size_t next_fft_tile_size = 0;
+
+
+//------------------------------------------------------------------------------
+/// Find the tile size that minimises the cost of the FFT-based convolution.
+/// The repeated convolutions (same sizes of image and kernel) reuse the result
+/// of the search.
+//------------------------------------------------------------------------------
+double getFFTTileSize(size_t anOutputWidth, size_t anOutputHeight,
+                      size_t aKernelWidth, size_t aKernelHeight,
+                      size_t& aTileWidth, size_t& aTileHeight)
+{
+    for (size_t i = 0; i < fft_tile_sizes.size(); ++i)
+    {
+        const FFTTileSize& size = fft_tile_sizes[i];
+        if (size.m_output_width == anOutputWidth && size.m_output_height == anOutputHeight &&
+            size.m_kernel_width == aKernelWidth && size.m_kernel_height == aKernelHeight)
+        {
+            aTileWidth = size.m_tile_width;
+            aTileHeight = size.m_tile_height;
+            return size.m_cost;
+        }
+    }
+
+    FFTTileSize size = {anOutputWidth, anOutputHeight, aKernelWidth, aKernelHeight, 0, 0, 0.0};
+    size.m_cost = searchFFTTileSize(anOutputWidth, anOutputHeight, aKernelWidth, aKernelHeight,
+                                    size.m_tile_width, size.m_tile_height);
+
+    // Replace the oldest size once the ring is full
+    if (fft_tile_sizes.size() < fft_tile_size_cache_size)
+    {
+        fft_tile_sizes.push_back(size);
+    }
+    else
+    {
+        fft_tile_sizes[next_fft_tile_size] = size;
+        next_fft_tile_size = (next_fft_tile_size + 1) % fft_tile_size_cache_size;
+    }
+
+    aTileWidth = size.m_tile_width;
+    aTileHeight = size.m_tile_height;
+    return size.m_cost;
+}
+
+
+//------------------------------------------------------------------------------
+/// FFT-based convolution (overlap-save). The image is split in tiles that
+/// overlap by W_h - 1 columns and H_h - 1 rows. The spectrum of each tile is
+/// multiplied by the spectrum of the kernel, and the pixels of the inverse
+/// transform that are not affected by the circular wrap-around are kept.
+//------------------------------------------------------------------------------
+void convolveFFT(const float* anInput, size_t aWidth, size_t aHeight,
+                 const float* aKernel, size_t aKernelWidth, size_t aKernelHeight,
+                 BorderMode aBorderMode, float* anOutput,
+                 size_t anOutputWidth, size_t anOutputHeight)
+{
+    size_t tile_width = 0;
+    size_t tile_height = 0;
+    getFFTTileSize(anOutputWidth, anOutputHeight, aKernelWidth, aKernelHeight, tile_width, tile_height);
+
+    bool crop = aBorderMode == BORDER_CROP;
+    long long left_border = crop ? 0 : aKernelWidth / 2;
+    long long top_border = crop ? 0 : aKernelHeight / 2;
+    size_t valid_width = tile_width - aKernelWidth + 1;
+    size_t valid_height = tile_height - aKernelHeight + 1;
+
+    TileTransform transform(tile_width, tile_height);
+    std::vector<double> kernel_tile(tile_width * tile_height, 0.0);
+    std::vector<Complex> kernel_spectrum(transform.getSpectrumSize());
+
+    // The spectrum of the kernel. It is flipped, as the formula of Lab 8 is a
+    // correlation, and the normalisation of the inverse transform is included.
+    double scale = 1.0 / (double(tile_width) * double(tile_height));
+    for (size_t l = 0; l < aKernelHeight; ++l)
+    {
+        for (size_t k = 0; k < aKernelWidth; ++k)
+        {
+            kernel_tile[(aKernelHeight - 1 - l) * tile_width + aKernelWidth - 1 - k] =
+                aKernel[l * aKernelWidth + k] * scale;
+        }
+    }
+    transform.forward(&kernel_tile[0], &kernel_spectrum[0]);
+
+    // The tiles are independent: they are computed in parallel
+    size_t number_of_tile_rows = (anOutputHeight + valid_height - 1) / valid_height;
+    size_t number_of_tile_cols = (anOutputWidth + valid_width - 1) / valid_width;
+
+    ThreadPool::getInstance().run(number_of_tile_rows * number_of_tile_cols, [&](size_t aTile)
+    {
+        size_t first_row = (aTile / number_of_tile_cols) * valid_height;
+        size_t first_col = (aTile % number_of_tile_cols) * valid_width;
+        size_t number_of_rows = std::min(valid_height, anOutputHeight - first_row);
+        size_t number_of_cols = std::min(valid_width, anOutputWidth - first_col);
+
+        std::vector<double> tile(tile_width * tile_height);
+        std::vector<Complex> spectrum(transform.getSpectrumSize());
+
+        // Copy the input pixels of the tile. The pixels outside of the
+        // image that are not used by the border mode are set to zero.
+        for (size_t i = 0; i < tile_height; ++i)
+        {
+            double* p_tile_row = &tile[i * tile_width];
+            long long input_row = (long long)(first_row + i) - top_border;
+
+            if (input_row < 0 || input_row >= (long long)(aHeight))
+            {
+                if (aBorderMode != BORDER_EXTEND)
+                {
+                    std::fill(p_tile_row, p_tile_row + tile_width, 0.0);
+                    continue;
+                }
+
+                input_row = input_row < 0 ? 0 : aHeight - 1;
+            }
+
+            const float* p_input_row = anInput + input_row * aWidth;
+            long long first_input_col = (long long)(first_col) - left_border;
+            for (size_t j = 0; j < tile_width; ++j)
+            {
+                long long input_col = first_input_col + j;
+
+                if (input_col >= 0 && input_col < (long long)(aWidth))
+                    p_tile_row[j] = p_input_row[input_col];
+                else if (aBorderMode == BORDER_EXTEND)
+                    p_tile_row[j] = p_input_row[input_col < 0 ? 0 : aWidth - 1];
+                else
+                    p_tile_row[j] = 0.0;
+            }
+        }
+
+        // Product of the spectra
+        transform.forward(&tile[0], &spectrum[0]);
+        for (size_t i = 0; i < spectrum.size(); ++i)
+        {
+            spectrum[i] = multiply(spectrum[i], kernel_spectrum[i]);
+        }
+
+        // Only the rows that are needed are transformed back
+        transform.inverse(&spectrum[0], &tile[0], aKernelHeight - 1, aKernelHeight - 1 + number_of_rows);
+
+        for (size_t row = 0; row < number_of_rows; ++row)
+        {
+            const double* p_tile_row = &tile[(row + aKernelHeight - 1) * tile_width + aKernelWidth - 1];
+            float* p_output_row = anOutput + (first_row + row) * anOutputWidth + first_col;
+            for (size_t col = 0; col < number_of_cols; ++col)
+            {
+                p_output_row[col] = float(p_tile_row[col]);
+            }
+        }
+    });
+}
+
+} // namespace
+
+
+//--------------------------------------------------------------------
+void getConvolutionSize(size_t aWidth, size_t aHeight,
+                        size_t aKernelWidth, size_t aKernelHeight,
+                        BorderMode aBorderMode,
+                        size_t& anOutputWidth, size_t& anOutputHeight)
+//--------------------------------------------------------------------
+{
+    if (aBorderMode == BORDER_CROP)
+    {
+        anOutputWidth  = aWidth  >= aKernelWidth  ? aWidth  - aKernelWidth  + 1 : 0;
+        anOutputHeight = aHeight >= aKernelHeight ? aHeight - aKernelHeight + 1 : 0;
+
+        // No pixel at all
+        if (!anOutputWidth || !anOutputHeight)
+        {
+            anOutputWidth = anOutputHeight = 0;
+        }
+    }
+    else
+    {
+        anOutputWidth  = aWidth;
+        anOutputHeight = aHeight;
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+bool separateKernel(const float* aKernel, size_t aKernelWidth, size_t aKernelHeight,
+                    std::vector<float>& aRowKernel, std::vector<float>& aColumnKernel)
+//------------------------------------------------------------------------------------
+{
+    // Find the largest coefficient (in absolute value)
+    size_t pivot = 0;
+    for (size_t i = 1; i < aKernelWidth * aKernelHeight; ++i)
+    {
+        if (std::fabs(aKernel[i]) > std::fabs(aKernel[pivot])) pivot = i;
+    }
+
+    // Null kernel
+    if (!aKernelWidth || !aKernelHeight || aKernel[pivot] == 0.0f) return false;
+
+    size_t pivot_col = pivot % aKernelWidth;
+    size_t pivot_row = pivot / aKernelWidth;
+
+    // The column of the pivot, and its row divided by the pivot
+    aColumnKernel.resize(aKernelHeight);
+    for (size_t l = 0; l < aKernelHeight; ++l)
+    {
+        aColumnKernel[l] = aKernel[l * aKernelWidth + pivot_col];
+    }
+
+    aRowKernel.resize(aKernelWidth);
+    for (size_t k = 0; k < aKernelWidth; ++k)
+    {
+        aRowKernel[k] = aKernel[pivot_row * aKernelWidth + k] / aKernel[pivot];
+    }
+
+    // Check that the outer product of the two vectors gives the kernel
+    double tolerance = separable_tolerance * std::fabs(aKernel[pivot]);
+    for (size_t l = 0; l < aKernelHeight; ++l)
+    {
+        for (size_t k = 0; k < aKernelWidth; ++k)
+        {
+            double product = double(aColumnKernel[l]) * double(aRowKernel[k]);
+            if (std::fabs(aKernel[l * aKernelWidth + k] - product) > tolerance)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+//----------------------------------------------------------------------------------
+ConvolutionMethod selectConvolutionMethod(size_t aWidth, size_t aHeight,
+                                          size_t aKernelWidth, size_t aKernelHeight,
+                                          bool aSeparableFlag)
+//----------------------------------------------------------------------------------
+{
+    double number_of_pixels = double(aWidth) * double(aHeight);
+
+    // Cost of a multiply-add of the spatial convolution
+    const int simd_widths[] = {1, 4, 8, 16};
+    double cost_per_operation = multiply_add_cost / simd_widths[getPixelKernels().level];
+
+    ConvolutionMethod method = CONVOLUTION_SPATIAL;
+    double cost = cost_per_operation * number_of_pixels * aKernelWidth * aKernelHeight;
+
+    double separable_cost = cost_per_operation * number_of_pixels * (aKernelWidth + aKernelHeight);
+    if (aSeparableFlag && separable_cost < cost)
+    {
+        method = CONVOLUTION_SEPARABLE;
+        cost = separable_cost;
+    }
+
+    size_t tile_width = 0;
+    size_t tile_height = 0;
+    if (number_of_pixels &&
+        getFFTTileSize(aWidth, aHeight, aKernelWidth, aKernelHeight, tile_width, tile_height) < cost)
+    {
+        method = CONVOLUTION_FFT;
+    }
+
+    return method;
+}
+
+
+//----------------------------------------------------------------------------
+void convolve(const float* anInput, size_t aWidth, size_t aHeight,
+              const float* aKernel, size_t aKernelWidth, size_t aKernelHeight,
+              BorderMode aBorderMode, float* anOutput,
+              ConvolutionMethod aMethod)
+//----------------------------------------------------------------------------
+{
+    size_t output_width;
+    size_t output_height;
+    getConvolutionSize(aWidth, aHeight, aKernelWidth, aKernelHeight, aBorderMode, output_width, output_height);
+
+    // Nothing to compute
+    if (!output_width || !output_height || !aKernelWidth || !aKernelHeight) return;
+
+    // Is the kernel separable? (not needed if the method is imposed)
+    std::vector<float> row_kernel;
+    std::vector<float> column_kernel;
+    bool separable = (aMethod == CONVOLUTION_AUTO || aMethod == CONVOLUTION_SEPARABLE) &&
+        aKernelWidth > 1 && aKernelHeight > 1 &&
+        separateKernel(aKernel, aKernelWidth, aKernelHeight, row_kernel, column_kernel);
+
+    ConvolutionMethod method = aMethod;
+    if (method == CONVOLUTION_AUTO)
+    {
+        method = selectConvolutionMethod(output_width, output_height, aKernelWidth, aKernelHeight, separable);
+    }
+
+    if (method == CONVOLUTION_FFT)
+    {
+        convolveFFT(anInput, aWidth, aHeight,
+            aKernel, aKernelWidth, aKernelHeight,
+            aBorderMode, anOutput,
+            output_width, output_height);
+    }
+    else
+    {
+        convolveSpatial(anInput, aWidth, aHeight,
+            aKernel, aKernelWidth, aKernelHeight,
+            aBorderMode, anOutput,
+            output_width, output_height,
+            separable && method == CONVOLUTION_SEPARABLE, row_kernel, column_kernel);
+    }
+}
@@ -0,0 +1,347 @@
+#include <cmath>
+#include <sstream>
+#include <stdexcept>      // std::invalid_argument
+
+#include "FFT.h"
+
+
+namespace
+{
+
+typedef FFT::Complex Complex;
+
+const double pi = 3.14159265358979323846;
+
+
+//------------------------------------------------------------------------------
+/// a * b, without the NaN and infinity checks of std::complex (much faster)
+//------------------------------------------------------------------------------
+inline Complex multiply(const Complex& a, const Complex& b)
+{
+    return Complex(a.real() * b.real() - a.imag() * b.imag(),
+                   a.real() * b.imag() + a.imag() * b.real());
+}
+
+
+//------------------------------------------------------------------------------
+/// Throw an exception for a size that is not supported
+//------------------------------------------------------------------------------
+void throwInvalidSize(const char* aFunction, size_t aSize, const char* aReason)
+{
+    // Format a nice error message
+    std::stringstream error_message;
+    error_message << "ERROR:" << std::endl;
+    error_message << "\tin File:" << __FILE__ << std::endl;
+    error_message << "\tin Function:" << aFunction << std::endl;
+    error_message << "\tat Line:" << __LINE__ << std::endl;
+    error_message << "\tMESSAGE: Invalid FFT size " << aSize << ": " << aReason << std::endl;
+
+    // Throw an exception
+    throw std::invalid_argument(error_message.str());
+}
+
+} // namespace
+
+
+//-----------------------------------------
+FFT::FFT(size_t aSize, bool anInverseFlag):
+//-----------------------------------------
+    m_size(aSize),
+    m_inverse(anInverseFlag),
+    m_twiddle_factors(aSize)
+//-----------------------------------------
+{
+    if (!aSize)
+    {
+        throwInvalidSize(__FUNCTION__, aSize, "there is no sample");
+    }
+
+    // Factorise the size, with radix-4 butterflies first
+    const size_t radices[] = {4, 2, 3, 5};
+    size_t length = aSize;
+    for (size_t i = 0; i < 4; ++i)
+    {
+        while (length % radices[i] == 0)
+        {
+            length /= radices[i];
+            m_factors.push_back(radices[i]);
+            m_factors.push_back(length);
+        }
+    }
+
+    if (length != 1)
+    {
+        throwInvalidSize(__FUNCTION__, aSize, "it must be a product of powers of 2, 3 and 5");
+    }
+
+    // The twiddle factors
+    double sign = m_inverse ? 1.0 : -1.0;
+    for (size_t k = 0; k < aSize; ++k)
+    {
+        double phase = sign * 2.0 * pi * k / aSize;
+        m_twiddle_factors[k] = Complex(std::cos(phase), std::sin(phase));
+    }
+}
+
+
+//------------------------------------------------------------------
+void FFT::transform(const Complex* anInput, Complex* anOutput) const
+//------------------------------------------------------------------
+{
+    if (m_size == 1)
+    {
+        anOutput[0] = anInput[0];
+    }
+    else
+    {
+        transform(anOutput, anInput, 1, 0);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------------
+void FFT::transform(Complex* anOutput, const Complex* anInput, size_t anInputStride, size_t aFactor) const
+//--------------------------------------------------------------------------------------------------------
+{
+    size_t radix = m_factors[2 * aFactor];
+    size_t length = m_factors[2 * aFactor + 1];
+
+    // The input stride is also the stride in the table of twiddle factors
+    size_t stride = anInputStride;
+
+    // Transform the decimated sequences
+    if (length == 1)
+    {
+        for (size_t q = 0; q < radix; ++q)
+        {
+            anOutput[q] = anInput[q * anInputStride];
+        }
+    }
+    else
+    {
+        for (size_t q = 0; q < radix; ++q)
+        {
+            transform(anOutput + q * length, anInput + q * anInputStride, anInputStride * radix, aFactor + 1);
+        }
+    }
+
+    // Combine them using the butterflies
+    const Complex* twiddle_factors = &m_twiddle_factors[0];
+    if (radix == 2)
+    {
+        for (size_t k = 0; k < length; ++k)
+        {
+            Complex t = multiply(anOutput[k + length], twiddle_factors[k * stride]);
+            anOutput[k + length] = anOutput[k] - t;
+            anOutput[k] += t;
+        }
+    }
+    else if (radix == 4)
+    {
+        for (size_t k = 0; k < length; ++k)
+        {
+            Complex s0 = multiply(anOutput[k + length],     twiddle_factors[k * stride]);
+            Complex s1 = multiply(anOutput[k + 2 * length], twiddle_factors[2 * k * stride]);
+            Complex s2 = multiply(anOutput[k + 3 * length], twiddle_factors[3 * k * stride]);
+
+            Complex s5 = anOutput[k] - s1;
+            anOutput[k] += s1;
+            Complex s3 = s0 + s2;
+            Complex s4 = s0 - s2;
+
+            anOutput[k + 2 * length] = anOutput[k] - s3;
+            anOutput[k] += s3;
+
+            // Multiplication of s4 by -i (forward) or i (inverse)
+            if (m_inverse)
+            {
+                anOutput[k + length]     = Complex(s5.real() - s4.imag(), s5.imag() + s4.real());
+                anOutput[k + 3 * length] = Complex(s5.real() + s4.imag(), s5.imag() - s4.real());
+            }
+            else
+            {
+                anOutput[k + length]     = Complex(s5.real() + s4.imag(), s5.imag() - s4.real());
+                anOutput[k + 3 * length] = Complex(s5.real() - s4.imag(), s5.imag() + s4.real());
+            }
+        }
+    }
+    else if (radix == 3)
+    {
+        // exp(-+2 pi i / 3)
+        double sine = twiddle_factors[stride * length].imag();
+
+        for (size_t k = 0; k < length; ++k)
+        {
+            Complex s1 = multiply(anOutput[k + length],     twiddle_factors[k * stride]);
+            Complex s2 = multiply(anOutput[k + 2 * length], twiddle_factors[2 * k * stride]);
+            Complex s3 = s1 + s2;
+            Complex s0 = (s1 - s2) * sine;
+
+            Complex a = anOutput[k] - s3 * 0.5;
+            anOutput[k] += s3;
+            anOutput[k + length]     = Complex(a.real() - s0.imag(), a.imag() + s0.real());
+            anOutput[k + 2 * length] = Complex(a.real() + s0.imag(), a.imag() - s0.real());
+        }
+    }
+    else
+    {
+        // exp(-+2 pi i / 5) and exp(-+4 pi i / 5)
+        Complex ya = twiddle_factors[stride * length];
+        Complex yb = twiddle_factors[2 * stride * length];
+
+        for (size_t k = 0; k < length; ++k)
+        {
+            Complex s0 = anOutput[k];
+            Complex s1 = multiply(anOutput[k + length],     twiddle_factors[k * stride]);
+            Complex s2 = multiply(anOutput[k + 2 * length], twiddle_factors[2 * k * stride]);
+            Complex s3 = multiply(anOutput[k + 3 * length], twiddle_factors[3 * k * stride]);
+            Complex s4 = multiply(anOutput[k + 4 * length], twiddle_factors[4 * k * stride]);
+
+            Complex s7 = s1 + s4;
+            Complex s10 = s1 - s4;
+            Complex s8 = s2 + s3;
+            Complex s9 = s2 - s3;
+
+            anOutput[k] = s0 + s7 + s8;
+
+            Complex s5 = s0 + s7 * ya.real() + s8 * yb.real();
+            Complex s6(s10.imag() * ya.imag() + s9.imag() * yb.imag(),
+                       -s10.real() * ya.imag() - s9.real() * yb.imag());
+            anOutput[k + length]     = s5 - s6;
+            anOutput[k + 4 * length] = s5 + s6;
+
+            Complex s11 = s0 + s7 * yb.real() + s8 * ya.real();
+            Complex s12(-s10.imag() * yb.imag() + s9.imag() * ya.imag(),
+                        s10.real() * yb.imag() - s9.real() * ya.imag());
+            anOutput[k + 2 * length] = s11 + s12;
+            anOutput[k + 3 * length] = s11 - s12;
+        }
+    }
+}
+
+
+//-------------------------
+size_t FFT::getSize() const
+//-------------------------
+{
+    return m_size;
+}
+
+
+//-----------------------------------------------------------
+size_t FFT::getFastSize(size_t aMinimumSize, bool anEvenFlag)
+//-----------------------------------------------------------
+{
+    size_t size = aMinimumSize > 1 ? aMinimumSize : 1;
+    if (anEvenFlag && size % 2) ++size;
+
+    while (true)
+    {
+        size_t length = size;
+        while (length % 2 == 0) length /= 2;
+        while (length % 3 == 0) length /= 3;
+        while (length % 5 == 0) length /= 5;
+
+        if (length == 1) return size;
+
+        size += anEvenFlag ? 2 : 1;
+    }
+}
+
+
+//-----------------------------
+RealFFT::RealFFT(size_t aSize):
+//-----------------------------
+    m_size(aSize),
+    m_forward(aSize > 1 ? aSize / 2 : 1, false),
+    m_inverse(aSize > 1 ? aSize / 2 : 1, true),
+    m_twiddle_factors(aSize / 2 + 1)
+//-----------------------------
+{
+    if (!aSize || aSize % 2)
+    {
+        throwInvalidSize(__FUNCTION__, aSize, "it must be even");
+    }
+
+    for (size_t k = 0; k <= aSize / 2; ++k)
+    {
+        double phase = -2.0 * pi * k / aSize;
+        m_twiddle_factors[k] = Complex(std::cos(phase), std::sin(phase));
+    }
+}
+
+
+//-------------------------------------------------------------------
+void RealFFT::forward(const double* anInput, Complex* anOutput) const
+//-------------------------------------------------------------------
+{
+    // The even and odd samples are the real and imaginary parts of a complex
+    // sequence z of size N / 2 (std::complex is an array of two doubles)
+    size_t half_size = m_size / 2;
+    m_forward.transform(reinterpret_cast<const Complex*>(anInput), anOutput);
+
+    // Spectra of the even (E) and odd (O) samples from Z:
+    // E[k] = (Z[k] + Z*[N/2-k]) / 2, O[k] = -i (Z[k] - Z*[N/2-k]) / 2,
+    // and X[k] = E[k] + exp(-2 pi i k / N) O[k]
+    Complex z0 = anOutput[0];
+    anOutput[0] = Complex(z0.real() + z0.imag(), 0.0);
+    anOutput[half_size] = Complex(z0.real() - z0.imag(), 0.0);
+
+    for (size_t k = 1; k <= half_size - k; ++k)
+    {
+        size_t j = half_size - k;
+        Complex z_k = anOutput[k];
+        Complex z_j = anOutput[j];
+
+        Complex even = 0.5 * (z_k + std::conj(z_j));
+        Complex odd = 0.5 * (z_k - std::conj(z_j));
+        odd = Complex(odd.imag(), -odd.real());
+        anOutput[k] = even + multiply(m_twiddle_factors[k], odd);
+
+        if (j != k)
+        {
+            even = 0.5 * (z_j + std::conj(z_k));
+            odd = 0.5 * (z_j - std::conj(z_k));
+            odd = Complex(odd.imag(), -odd.real());
+            anOutput[j] = even + multiply(m_twiddle_factors[j], odd);
+        }
+    }
+}
+
+
+//-------------------------------------------------------------
+void RealFFT::inverse(Complex* anInput, double* anOutput) const
+//-------------------------------------------------------------
+{
+    // Rebuild Z (times 2) from X: E[k] = X[k] + X*[N/2-k],
+    // O[k] = (X[k] - X*[N/2-k]) exp(2 pi i k / N), and Z[k] = E[k] + i O[k]
+    size_t half_size = m_size / 2;
+    for (size_t k = 0; k <= half_size - k; ++k)
+    {
+        size_t j = half_size - k;
+        Complex x_k = anInput[k];
+        Complex x_j = anInput[j];
+
+        Complex even = x_k + std::conj(x_j);
+        Complex odd = multiply(x_k - std::conj(x_j), std::conj(m_twiddle_factors[k]));
+        anInput[k] = even + Complex(-odd.imag(), odd.real());
+
+        if (j != k && j != half_size)
+        {
+            even = x_j + std::conj(x_k);
+            odd = multiply(x_j - std::conj(x_k), std::conj(m_twiddle_factors[j]));
+            anInput[j] = even + Complex(-odd.imag(), odd.real());
+        }
+    }
+
+    // The even and odd samples are the real and imaginary parts of the output
+    m_inverse.transform(anInput, reinterpret_cast<Complex*>(anOutput));
+}
+
+
+//-----------------------------
+size_t RealFFT::getSize() const
+//-----------------------------
+{
+    return m_size;
+}
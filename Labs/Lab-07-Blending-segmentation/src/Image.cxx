@@ -1,50 +1,47 @@
 #include <sstream>
-#include <stdexcept>      // std::out_of_range
+#include <stdexcept>      // std::out_of_range, std::invalid_argument
 #include <cmath>
-
-#ifdef HAS_LIBJPEG
-#include <jerror.h>
-#include <jpeglib.h>
-#endif
+#include <utility>        // std::move
+#include <algorithm>      // std::min
 
 #include "Image.h"
+#include "ImageIO.h"
+#include "MedianFilter.h"
+#include "SummedAreaTable.h"
+#include "PixelKernels.h"
+#include "ThreadPool.h"
 
 
-//------------------------------------------------------
-Image operator*(float aValue, const Image& anInputImage)
-//------------------------------------------------------
+namespace
 {
-    Image temp = anInputImage;
-    
-    float* p_data = temp.getPixelPointer();
-    size_t number_of_pixels = temp.getWidth() * temp.getHeight();
-    
-    for (size_t i = 0; i < number_of_pixels; ++i)
+
+//------------------------------------------------------------------------------
+/// Apply a scalar kernel to all the pixels, by tiles run in parallel
+//------------------------------------------------------------------------------
+void runScalarKernel(PixelKernels::ScalarKernel aKernel,
+                     const float* anInput, float aValue, float* anOutput, size_t aSize)
+{
+    ThreadPool::getInstance().runOnTiles(aSize, [&](size_t aFirstPixel, size_t aNumberOfPixels)
     {
-        *p_data++ *= aValue;
-    }
-    
-    return temp;
+        aKernel(anInput + aFirstPixel, aValue, anOutput + aFirstPixel, aNumberOfPixels);
+    });
 }
 
 
-//------------------------------------------------------
-Image operator+(float aValue, const Image& anInputImage)
-//------------------------------------------------------
+//------------------------------------------------------------------------------
+/// Apply a unary kernel to all the pixels, by tiles run in parallel
+//------------------------------------------------------------------------------
+void runUnaryKernel(PixelKernels::UnaryKernel aKernel,
+                    const float* anInput, float* anOutput, size_t aSize)
 {
-    Image temp = anInputImage;
-    
-    float* p_data = temp.getPixelPointer();
-    size_t number_of_pixels = temp.getWidth() * temp.getHeight();
-    
-    for (size_t i = 0; i < number_of_pixels; ++i)
+    ThreadPool::getInstance().runOnTiles(aSize, [&](size_t aFirstPixel, size_t aNumberOfPixels)
     {
-        *p_data++ += aValue;
-    }
-    
-    return temp;
+        aKernel(anInput + aFirstPixel, anOutput + aFirstPixel, aNumberOfPixels);
+    });
 }
 
+} // namespace
+
 
 //--------------------------------------------------------------------------
 std::ostream& operator<<(std::ostream& anOutputStream, const Image& anImage)
@@ -78,9 +75,9 @@ std::ostream& operator<<(std::ostream& anOutputStream, const Image& anImage)
 }
 
 
-//---------------------------
-Image::Image():
-//---------------------------
+//------------------
+Image::BasicImage():
+//------------------
     m_width(0),
     m_height(0),
     m_min_pixel_value(0),
@@ -88,13 +85,13 @@ Image::Image():
     m_average_pixel_value(0),
     m_stddev_pixel_value(0),
     m_stats_up_to_date(true)
-//---------------------------
+//------------------
 {}
 
 
-//-------------------------------------------------------
-Image::Image(const Image& anImage):
-//-------------------------------------------------------
+//--------------------------------------
+Image::BasicImage(const Image& anImage):
+//--------------------------------------
     m_pixel_data(anImage.m_pixel_data),
     m_width(anImage.m_width),
     m_height(anImage.m_height),
@@ -103,13 +100,38 @@ Image::Image(const Image& anImage):
     m_average_pixel_value(anImage.m_average_pixel_value),
     m_stddev_pixel_value(anImage.m_stddev_pixel_value),
     m_stats_up_to_date(anImage.m_stats_up_to_date)
-//-------------------------------------------------------
+//--------------------------------------
 {}
 
 
-//----------------------------------------------------------------
-Image::Image(const float* anImage, size_t aWidth, size_t aHeight):
-//----------------------------------------------------------------
+//------------------------------------------
+Image::BasicImage(Image&& anImage) noexcept:
+//------------------------------------------
+    m_pixel_data(std::move(anImage.m_pixel_data)),
+    m_width(anImage.m_width),
+    m_height(anImage.m_height),
+    m_min_pixel_value(anImage.m_min_pixel_value),
+    m_max_pixel_value(anImage.m_max_pixel_value),
+    m_average_pixel_value(anImage.m_average_pixel_value),
+    m_stddev_pixel_value(anImage.m_stddev_pixel_value),
+    m_stats_up_to_date(anImage.m_stats_up_to_date)
+//------------------------------------------
+{
+    // Leave the input image empty (but valid)
+    anImage.m_pixel_data.clear();
+    anImage.m_width = 0;
+    anImage.m_height = 0;
+    anImage.m_min_pixel_value = 0;
+    anImage.m_max_pixel_value = 0;
+    anImage.m_average_pixel_value = 0;
+    anImage.m_stddev_pixel_value = 0;
+    anImage.m_stats_up_to_date = true;
+}
+
+
+//---------------------------------------------------------------------
+Image::BasicImage(const float* anImage, size_t aWidth, size_t aHeight):
+//---------------------------------------------------------------------
     m_pixel_data(anImage, anImage + aWidth * aHeight),
     m_width(aWidth),
     m_height(aHeight),
@@ -118,14 +140,14 @@ Image::Image(const float* anImage, size_t aWidth, size_t aHeight):
     m_average_pixel_value(0),
     m_stddev_pixel_value(0),
     m_stats_up_to_date(false)
-//----------------------------------------------------------------
+//---------------------------------------------------------------------
 {}
 
 
-//-----------------------------------------------------------------------------
-Image::Image(const std::vector<float>& anImage, size_t aWidth, size_t aHeight):
-//-----------------------------------------------------------------------------
-    m_pixel_data(anImage),
+//----------------------------------------------------------------------------------
+Image::BasicImage(const std::vector<float>& anImage, size_t aWidth, size_t aHeight):
+//----------------------------------------------------------------------------------
+    m_pixel_data(anImage.data(), anImage.data() + anImage.size()),
     m_width(aWidth),
     m_height(aHeight),
     m_min_pixel_value(0),
@@ -133,13 +155,13 @@ Image::Image(const std::vector<float>& anImage, size_t aWidth, size_t aHeight):
     m_average_pixel_value(0),
     m_stddev_pixel_value(0),
     m_stats_up_to_date(false)
-//-----------------------------------------------------------------------------
+//----------------------------------------------------------------------------------
 {}
 
 
-//-----------------------------------------------------------
-Image::Image(float aConstant, size_t aWidth, size_t aHeight):
-//-----------------------------------------------------------
+//----------------------------------------------------------------
+Image::BasicImage(float aConstant, size_t aWidth, size_t aHeight):
+//----------------------------------------------------------------
     m_pixel_data(aWidth * aHeight, aConstant),
     m_width(aWidth),
     m_height(aHeight),
@@ -148,13 +170,13 @@ Image::Image(float aConstant, size_t aWidth, size_t aHeight):
     m_average_pixel_value(aConstant),
     m_stddev_pixel_value(0),
     m_stats_up_to_date(true)
-//-----------------------------------------------------------
+//----------------------------------------------------------------
 {}
 
 
-//----------------------------------
-Image::Image(const char* aFilename):
-//----------------------------------
+//---------------------------------------
+Image::BasicImage(const char* aFilename):
+//---------------------------------------
     m_width(0),
     m_height(0),
     m_min_pixel_value(0),
@@ -162,15 +184,15 @@ Image::Image(const char* aFilename):
     m_average_pixel_value(0),
     m_stddev_pixel_value(0),
     m_stats_up_to_date(true)
-//---------------------------
+//---------------------------------------
 {
     load(aFilename);
 }
 
 
-//-----------------------------------------
-Image::Image(const std::string& aFilename):
-//-----------------------------------------
+//----------------------------------------------
+Image::BasicImage(const std::string& aFilename):
+//----------------------------------------------
     m_width(0),
     m_height(0),
     m_min_pixel_value(0),
@@ -178,7 +200,7 @@ Image::Image(const std::string& aFilename):
     m_average_pixel_value(0),
     m_stddev_pixel_value(0),
     m_stats_up_to_date(true)
-//-----------------------------------------
+//----------------------------------------------
 {
     load(aFilename);
 }
@@ -201,6 +223,36 @@ Image& Image::operator=(const Image& anInputImage)
 }
 
 
+//----------------------------------------------------
+Image& Image::operator=(Image&& anInputImage) noexcept
+//----------------------------------------------------
+{
+    if (this != &anInputImage)
+    {
+        m_pixel_data = std::move(anInputImage.m_pixel_data);
+        m_width = anInputImage.m_width;
+        m_height = anInputImage.m_height;
+        m_min_pixel_value = anInputImage.m_min_pixel_value;
+        m_max_pixel_value = anInputImage.m_max_pixel_value;
+        m_average_pixel_value = anInputImage.m_average_pixel_value;
+        m_stddev_pixel_value = anInputImage.m_stddev_pixel_value;
+        m_stats_up_to_date = anInputImage.m_stats_up_to_date;
+
+        // Leave the input image empty (but valid)
+        anInputImage.m_pixel_data.clear();
+        anInputImage.m_width = 0;
+        anInputImage.m_height = 0;
+        anInputImage.m_min_pixel_value = 0;
+        anInputImage.m_max_pixel_value = 0;
+        anInputImage.m_average_pixel_value = 0;
+        anInputImage.m_stddev_pixel_value = 0;
+        anInputImage.m_stats_up_to_date = true;
+    }
+
+    return *this;
+}
+
+
 //--------------------------------------------
 Image& Image::operator=(const char* aFileName)
 //--------------------------------------------
@@ -219,273 +271,319 @@ Image& Image::operator=(const std::string& aFileName)
 }
 
 
-//-------------------------------------
-void Image::load(const char* aFilename)
-//-------------------------------------
+//-------------------------------------------------------
+void Image::load(const char* aFilename, float aScaleHint)
+//-------------------------------------------------------
 {
-#ifdef HAS_LIBJPEG
-    // Allocate and initialize a JPEG decompression object
-    struct jpeg_decompress_struct cinfo;
-    struct jpeg_error_mgr jerr;
-    cinfo.err = jpeg_std_error(&jerr);
-    jpeg_create_decompress(&cinfo);
+    // The file is mapped once: its format is read from its first bytes
+    MappedFile file(aFilename);
 
-    // Specify the source of the compressed data (eg, a file)
-    FILE* p_input_file(fopen(aFilename, "rb"));
-    if (!p_input_file)
+    // Uncompressed file: read the whole image at once
+    if (readFileFormat(file, aFilename) != FORMAT_JPEG)
     {
-        // Format a nice error message
-        std::stringstream error_message;
-        error_message << "ERROR:" << std::endl;
-        error_message << "\tin File:" << __FILE__ << std::endl;
-        error_message << "\tin Function:" << __FUNCTION__ << std::endl;
-        error_message << "\tat Line:" << __LINE__ << std::endl;
-        error_message << "\tMESSAGE: Can't open " << aFilename << std::endl;
-        throw std::runtime_error(error_message.str());
+        ImageFileReader reader(std::move(file), aFilename);
+        PixelBuffer<float> pixel_data(reader.getWidth() * reader.getHeight());
+        reader.readPixels(pixel_data.data());
+
+        // The image is only changed once the file has been read
+        m_pixel_data.swap(pixel_data);
+        m_width = reader.getWidth();
+        m_height = reader.getHeight();
+        m_stats_up_to_date = false;
+        return;
     }
-    jpeg_stdio_src(&cinfo, p_input_file);
 
-    // Call jpeg_read_header() to obtain image info
-    jpeg_read_header(&cinfo, TRUE);
+    // JPEG file: read its header from the mapped file. The pixels are
+    // decoded in a new buffer: the image is unchanged if the decoder throws.
+    JPEGDecoder decoder(std::move(file), aFilename, aScaleHint);
+    size_t width = decoder.getWidth();
+    size_t height = decoder.getHeight();
+    PixelBuffer<float> pixel_data(width * height);
 
-    // Set parameters for decompression
-    // Nothing to be done if the defaults are appropriate
+    // Decode the rows one by one, and convert them straight into the image
+    std::vector<unsigned char> scanline(width * decoder.getNumberOfComponents());
+    for (size_t row = 0; row < height; ++row)
+    {
+        decoder.readScanline(&scanline[0]);
 
-    // Start decompression
-    jpeg_start_decompress(&cinfo);
+        // Compute the relative luminance from RGB data
+        if (decoder.getNumberOfComponents() == 3)
+        {
+            computeLuminance(&scanline[0], &pixel_data[row * width], width);
+        }
+        // Copy the data
+        else
+        {
+            getPixelKernels().convertFromUInt8(&scanline[0], &pixel_data[row * width], width);
+        }
+    }
 
-    // Save the size of the image
-    m_width = cinfo.output_width;
-    m_height = cinfo.output_height;
-    m_pixel_data.resize(m_width * m_height);
+    // Replace the pixels (they are not copied)
+    m_pixel_data.swap(pixel_data);
+    m_width = width;
+    m_height = height;
 
-    // Decompress data
-    JSAMPROW row_pointer[1];        // pointer to a single row
-    int row_stride;                 // physical row width in buffer
+    // The statistics is not up-to-date
+    m_stats_up_to_date = false;
+}
 
-    if (cinfo.out_color_space == JCS_RGB)
-    {
-        row_stride = m_width * 3;   // JSAMPLEs per row in image_buffer
-    }
-    else if (cinfo.out_color_space == JCS_GRAYSCALE)
-    {
-        row_stride = m_width;   // JSAMPLEs per row in image_buffer
-    }
-    // Unknown colour space
-    else
-    {
-        // Format a nice error message
-        std::stringstream error_message;
-        error_message << "ERROR:" << std::endl;
-        error_message << "\tin File:" << __FILE__ << std::endl;
-        error_message << "\tin Function:" << __FUNCTION__ << std::endl;
-        error_message << "\tat Line:" << __LINE__ << std::endl;
-        error_message << "\tMESSAGE: Unknown colour space" << std::endl;
-        throw std::runtime_error(error_message.str());
-    }
 
-    // Create temporary buffer
-    unsigned char* p_rgb_image(new unsigned char[m_width * m_height * 3]);
+//--------------------------------------------------------------
+void Image::load(const std::string& aFilename, float aScaleHint)
+//--------------------------------------------------------------
+{
+    load(aFilename.c_str(), aScaleHint);
+}
 
-    // Decompress the data
-    while (cinfo.output_scanline < cinfo.output_height)
+
+//----------------------------------------------------------------------------------
+void Image::saveJPEG(const char* aFilename, int aQuality, bool anOptimiseFlag) const
+//----------------------------------------------------------------------------------
+{
+    // Convert the data to 8 bits: rounded and saturated by the vectorised
+    // kernel, on the thread pool
+    std::vector<unsigned char> grey_image(m_pixel_data.size());
+    if (m_pixel_data.size())
     {
-        row_pointer[0] = & p_rgb_image[cinfo.output_scanline * row_stride];
-        jpeg_read_scanlines(&cinfo, row_pointer, 1);
+        convertPixels(m_pixel_data.data(), grey_image.data(), m_pixel_data.size());
     }
 
-    // Finish decompression
-    jpeg_finish_decompress(&cinfo);
+    writeJPEG(aFilename, grey_image.data(), m_width, m_height, aQuality, anOptimiseFlag);
+}
 
-    // Release the JPEG decompression object
-    jpeg_destroy_decompress(&cinfo);
 
-    // Convert the data
-    if (cinfo.out_color_space == JCS_RGB)
-    {
-        double pixel_value;
+//-----------------------------------------------------------------------------------------
+void Image::saveJPEG(const std::string& aFilename, int aQuality, bool anOptimiseFlag) const
+//-----------------------------------------------------------------------------------------
+{
+    saveJPEG(aFilename.c_str(), aQuality, anOptimiseFlag);
+}
 
-        for (size_t i(0); i < m_width * m_height; ++i)
-        {
-            // Compute the relative luminance from RGB data
-            // using Photometric/digital ITU-R
-            pixel_value  = 0.2126 * p_rgb_image[i * 3    ];
-            pixel_value += 0.7152 * p_rgb_image[i * 3 + 1];
-            pixel_value += 0.0722 * p_rgb_image[i * 3 + 2];
 
-            m_pixel_data[i] = pixel_value;
-        }
+//-------------------------------------------
+void Image::save(const char* aFilename) const
+//-------------------------------------------
+{
+    ImageFileFormat format = getFileFormat(aFilename);
+    if (format == FORMAT_JPEG)
+    {
+        saveJPEG(aFilename);
     }
-    // Copy the data
-    else if (cinfo.out_color_space == JCS_GRAYSCALE)
+    else
     {
-        for (unsigned int i(0); i < m_width * m_height; ++i)
-        {
-            m_pixel_data[i] = p_rgb_image[i];
-        }
+        writeImageFile(aFilename, format, SAMPLE_FLOAT, m_pixel_data.data(), m_width, m_height);
     }
+}
 
-    // Release memory
-    delete [] p_rgb_image;
 
-    // The statistics is not up-to-date
-    m_stats_up_to_date = false;
-#else
+//--------------------------------------------------
+void Image::save(const std::string& aFilename) const
+//--------------------------------------------------
+{
+    save(aFilename.c_str());
+}
+
+
+//-------------------------------------------------------
+void Image::throwOutOfRange(size_t col, size_t row) const
+//-------------------------------------------------------
+{
     // Format a nice error message
     std::stringstream error_message;
     error_message << "ERROR:" << std::endl;
     error_message << "\tin File:" << __FILE__ << std::endl;
     error_message << "\tin Function:" << __FUNCTION__ << std::endl;
     error_message << "\tat Line:" << __LINE__ << std::endl;
-    error_message << "\tMESSAGE: LibJPEG not supported" << std::endl;
-    throw std::runtime_error(error_message.str());
-#endif
+    error_message << "\tMESSAGE: Pixel(" << col << ", " << row << ") does not exist. The image size is: " << m_width << "x" << m_height << std::endl;
+
+    // Throw an exception
+    throw std::out_of_range(error_message.str());
 }
 
 
-//--------------------------------------------
-void Image::load(const std::string& aFilename)
-//--------------------------------------------
+//-----------------------------------------
+const float* Image::getPixelPointer() const
+//-----------------------------------------
 {
-    load(aFilename.c_str());
+    // There are pixels
+    if (m_pixel_data.size() && m_width && m_height)
+        return &m_pixel_data[0];
+    // There is no pixel
+    else
+        return 0;
 }
 
+//-----------------------------
+float* Image::getPixelPointer()
+//-----------------------------
+{
+    // To be on the safe side, turn the flag off
+    m_stats_up_to_date = false;
 
-//-----------------------------------------
-void Image::saveJPEG(const char* aFilename)
-//-----------------------------------------
+    // There are pixels
+    if (m_pixel_data.size() && m_width && m_height)
+        return &m_pixel_data[0];
+    // There is no pixel
+    else
+        return 0;
+}
+
+
+//------------------------------------
+Image& Image::operator+=(float aValue)
+//------------------------------------
 {
-#ifdef HAS_LIBJPEG
-    // Allocate and initialize a JPEG compression object
-    struct jpeg_compress_struct cinfo;
-    struct jpeg_error_mgr jerr;
-    cinfo.err = jpeg_std_error(&jerr);
-    jpeg_create_compress(&cinfo);
+    if (m_pixel_data.size())
+    {
+        runScalarKernel(getPixelKernels().addScalar, &m_pixel_data[0], aValue, &m_pixel_data[0], m_pixel_data.size());
+    }
+
+    // The statistics is not up-to-date
+    m_stats_up_to_date = false;
+
+    return *this;
+}
+
 
-    // Specify the destination for the compressed data (eg, a file)
-    FILE* p_output_file(fopen(aFilename, "wb"));
-    if (!p_output_file)
+//------------------------------------
+Image& Image::operator-=(float aValue)
+//------------------------------------
+{
+    if (m_pixel_data.size())
     {
-        // Format a nice error message
-        std::stringstream error_message;
-        error_message << "ERROR:" << std::endl;
-        error_message << "\tin File:" << __FILE__ << std::endl;
-        error_message << "\tin Function:" << __FUNCTION__ << std::endl;
-        error_message << "\tat Line:" << __LINE__ << std::endl;
-        error_message << "\tMESSAGE: Can't open " << aFilename << std::endl;
-        throw std::runtime_error(error_message.str());
+        runScalarKernel(getPixelKernels().subtractScalar, &m_pixel_data[0], aValue, &m_pixel_data[0], m_pixel_data.size());
     }
-    jpeg_stdio_dest(&cinfo, p_output_file);
 
-    // Set parameters for compression, including image size & colorspace
-    cinfo.image_width  = m_width;   // image width in pixels
-    cinfo.image_height = m_height;  // image height in pixels
-    cinfo.input_components = 3;     // number of color components per pixel
-    cinfo.in_color_space = JCS_RGB; // colorspace of input image
-    jpeg_set_defaults(&cinfo);
+    // The statistics is not up-to-date
+    m_stats_up_to_date = false;
 
-    // Create temporary buffer
-    unsigned char* p_rgb_image(new unsigned char[m_width * m_height *3]);
+    return *this;
+}
 
-    // Convert the data
-    double input_pixel_value;
-    unsigned char output_pixel_value;
 
-    for (unsigned int i(0); i < m_width * m_height; ++i)
+//------------------------------------
+Image& Image::operator*=(float aValue)
+//------------------------------------
+{
+    if (m_pixel_data.size())
     {
-        input_pixel_value = m_pixel_data[i];
+        runScalarKernel(getPixelKernels().multiplyScalar, &m_pixel_data[0], aValue, &m_pixel_data[0], m_pixel_data.size());
+    }
 
-        if (input_pixel_value <= 0.0f)
-        {
-            output_pixel_value = 0;
-        }
-        else if (input_pixel_value >= 255.0f)
-        {
-            output_pixel_value = 255;
-        }
-        else
-        {
-            output_pixel_value = input_pixel_value;
-        }
+    // The statistics is not up-to-date
+    m_stats_up_to_date = false;
+
+    return *this;
+}
 
-        p_rgb_image[i * 3    ] = output_pixel_value;
-        p_rgb_image[i * 3 + 1] = output_pixel_value;
-        p_rgb_image[i * 3 + 2] = output_pixel_value;
+
+//------------------------------------
+Image& Image::operator/=(float aValue)
+//------------------------------------
+{
+    if (m_pixel_data.size())
+    {
+        runScalarKernel(getPixelKernels().divideScalar, &m_pixel_data[0], aValue, &m_pixel_data[0], m_pixel_data.size());
     }
 
+    // The statistics is not up-to-date
+    m_stats_up_to_date = false;
 
-    // Start compression
-    jpeg_start_compress(&cinfo, TRUE);
+    return *this;
+}
 
-    // Compress data
-    JSAMPROW row_pointer[1];        // pointer to a single row
-    int row_stride;                 // physical row width in buffer
 
-    row_stride = m_width * 3;   // JSAMPLEs per row in image_buffer
+//--------------------------------
+Image Image::absoluteValue() const
+//--------------------------------
+{
+    Image output;
+    output.m_pixel_data.resize(m_pixel_data.size());
+    output.m_width = m_width;
+    output.m_height = m_height;
+    output.m_stats_up_to_date = false;
 
-    while (cinfo.next_scanline < cinfo.image_height) {
-        row_pointer[0] = & p_rgb_image[cinfo.next_scanline * row_stride];
-        jpeg_write_scanlines(&cinfo, row_pointer, 1);
+    if (m_pixel_data.size())
+    {
+        runUnaryKernel(getPixelKernels().absoluteValue, &m_pixel_data[0], &output.m_pixel_data[0], m_pixel_data.size());
     }
 
-    // Finish compression
-    jpeg_finish_compress(&cinfo);
+    return output;
+}
 
-    // Release the JPEG compression object
-    jpeg_destroy_compress(&cinfo);
 
-    // Release memory
-    delete [] p_rgb_image;
-#else
-    // Format a nice error message
-    std::stringstream error_message;
-    error_message << "ERROR:" << std::endl;
-    error_message << "\tin File:" << __FILE__ << std::endl;
-    error_message << "\tin Function:" << __FUNCTION__ << std::endl;
-    error_message << "\tat Line:" << __LINE__ << std::endl;
-    error_message << "\tMESSAGE: LibJPEG not supported" << std::endl;
-    throw std::runtime_error(error_message.str());
-#endif
+//-------------------------
+Image Image::square() const
+//-------------------------
+{
+    Image output;
+    output.m_pixel_data.resize(m_pixel_data.size());
+    output.m_width = m_width;
+    output.m_height = m_height;
+    output.m_stats_up_to_date = false;
+
+    if (m_pixel_data.size())
+    {
+        runUnaryKernel(getPixelKernels().square, &m_pixel_data[0], &output.m_pixel_data[0], m_pixel_data.size());
+    }
+
+    return output;
 }
 
 
-//------------------------------------------------
-void Image::saveJPEG(const std::string& aFilename)
-//------------------------------------------------
+//-----------------------------
+Image Image::squareRoot() const
+//-----------------------------
 {
-    saveJPEG(aFilename.c_str());
+    Image output;
+    output.m_pixel_data.resize(m_pixel_data.size());
+    output.m_width = m_width;
+    output.m_height = m_height;
+    output.m_stats_up_to_date = false;
+
+    if (m_pixel_data.size())
+    {
+        runUnaryKernel(getPixelKernels().squareRoot, &m_pixel_data[0], &output.m_pixel_data[0], m_pixel_data.size());
+    }
+
+    return output;
 }
 
 
-//----------------------------------------------------------
-const float& Image::operator()(size_t col, size_t row) const
-//----------------------------------------------------------
+//---------------------------------------------------------------------
+Image Image::clamp(float aLowerThreshold, float anUpperThreshold) const
+//---------------------------------------------------------------------
 {
-    // Check if the coordinates are valid, if not throw an error
-    if (col < 0 || col >= m_width || row < 0 || row >= m_height)
+    Image output;
+    output.m_pixel_data.resize(m_pixel_data.size());
+    output.m_width = m_width;
+    output.m_height = m_height;
+    output.m_stats_up_to_date = false;
+
+    if (m_pixel_data.size())
     {
-        // Format a nice error message
-        std::stringstream error_message;
-        error_message << "ERROR:" << std::endl;
-        error_message << "\tin File:" << __FILE__ << std::endl;
-        error_message << "\tin Function:" << __FUNCTION__ << std::endl;
-        error_message << "\tat Line:" << __LINE__ << std::endl;
-        error_message << "\tMESSAGE: Pixel(" << col << ", " << row << ") does not exist. The image size is: " << m_width << "x" << m_height << std::endl;
+        PixelKernels::ClampKernel kernel = getPixelKernels().clamp;
+        const float* p_input = &m_pixel_data[0];
+        float* p_output = &output.m_pixel_data[0];
 
-        // Throw an exception
-        throw std::out_of_range(error_message.str());
+        ThreadPool::getInstance().runOnTiles(m_pixel_data.size(), [&](size_t aFirstPixel, size_t aNumberOfPixels)
+        {
+            kernel(p_input + aFirstPixel,
+                aLowerThreshold, anUpperThreshold,
+                p_output + aFirstPixel, aNumberOfPixels);
+        });
     }
 
-    return m_pixel_data[row * m_width + col];
+    return output;
 }
 
 
-//----------------------------------------------
-float& Image::operator()(size_t col, size_t row)
-//----------------------------------------------
+//------------------------------------------------------------------------------------------------
+Image Image::conv2d(const Image& aKernel, BorderMode aBorderMode, ConvolutionMethod aMethod) const
+//------------------------------------------------------------------------------------------------
 {
-    // Check if the coordinates are valid, if not throw an error
-    if (col < 0 || col >= m_width || row < 0 || row >= m_height)
+    // The kernel is empty
+    if (!aKernel.m_width || !aKernel.m_height)
     {
         // Format a nice error message
         std::stringstream error_message;
@@ -493,156 +591,177 @@ float& Image::operator()(size_t col, size_t row)
         error_message << "\tin File:" << __FILE__ << std::endl;
         error_message << "\tin Function:" << __FUNCTION__ << std::endl;
         error_message << "\tat Line:" << __LINE__ << std::endl;
-        error_message << "\tMESSAGE: Pixel(" << col << ", " << row << ") does not exist. The image size is: " << m_width << "x" << m_height << std::endl;
+        error_message << "\tMESSAGE: The convolution kernel is empty." << std::endl;
 
         // Throw an exception
-        throw std::out_of_range(error_message.str());
+        throw std::invalid_argument(error_message.str());
     }
 
-    // To be on the safe side, turn the flag off
-    m_stats_up_to_date = false;
-
-    return m_pixel_data[row * m_width + col];
-}
+    Image output;
+    getConvolutionSize(m_width, m_height, aKernel.m_width, aKernel.m_height, aBorderMode,
+        output.m_width, output.m_height);
+    output.m_pixel_data.resize(output.m_width * output.m_height);
+    output.m_stats_up_to_date = !output.m_pixel_data.size();
 
+    if (output.m_pixel_data.size())
+    {
+        convolve(&m_pixel_data[0], m_width, m_height,
+            &aKernel.m_pixel_data[0], aKernel.m_width, aKernel.m_height,
+            aBorderMode, &output.m_pixel_data[0], aMethod);
+    }
 
-//----------------------------
-size_t Image::getWidth() const
-//----------------------------
-{
-    return m_width;
+    return output;
 }
 
 
-//-----------------------------
-size_t Image::getHeight() const
-//-----------------------------
+//---------------------------------
+Image Image::gaussianFilter() const
+//---------------------------------
 {
-    return m_height;
-}
+    // Create the kernel
+    Image kernel(
+        {
+            1., 2., 1.,
+            2., 4., 2.,
+            1., 2., 1.
+        }, 3, 3);
 
+    // Normalise the kernel so that the sum of its coefficients is 1.
+    kernel /= 16.0;
 
-//-----------------------------------------
-const float* Image::getPixelPointer() const
-//-----------------------------------------
-{
-    // There are pixels
-    if (m_pixel_data.size() && m_width && m_height)
-        return &m_pixel_data[0];
-    // There is no pixel
-    else
-        return 0;
+    // Filter the image
+    return conv2d(kernel);
 }
 
-//-----------------------------
-float* Image::getPixelPointer()
-//-----------------------------
-{
-    // To be on the safe side, turn the flag off
-    m_stats_up_to_date = false;
 
-    // There are pixels
-    if (m_pixel_data.size() && m_width && m_height)
-        return &m_pixel_data[0];
-    // There is no pixel
-    else
-        return 0;
-}
-
-
-//----------------------------------------
-Image Image::operator+(float aValue) const
-//----------------------------------------
+//-------------------------------------------------
+Image Image::meanFilter(unsigned int aRadius) const
+//-------------------------------------------------
 {
-    Image temp = *this;
-    
-    for (size_t i = 0; i < m_width * m_height; ++i)
-    {
-        temp.m_pixel_data[i] += aValue;
-    }
-    
-    return temp;
+    // Sums of the windows in O(1) per pixel
+    return SummedAreaTable(*this).boxFilter(aRadius);
 }
 
 
-//----------------------------------------
-Image Image::operator-(float aValue) const
-//----------------------------------------
+//----------------------------------------------------
+Image Image::averageFilter(unsigned int aRadius) const
+//----------------------------------------------------
 {
-    Image temp = *this;
-    
-    for (size_t i = 0; i < m_width * m_height; ++i)
-    {
-        temp.m_pixel_data[i] -= aValue;
-    }
-    
-    return temp;
+    return meanFilter(aRadius);
 }
 
 
-//----------------------------------------
-Image Image::operator*(float aValue) const
-//----------------------------------------
+//------------------------------------------------
+Image Image::boxFilter(unsigned int aRadius) const
+//------------------------------------------------
 {
-    Image temp = *this;
-    
-    for (size_t i = 0; i < m_width * m_height; ++i)
-    {
-        temp.m_pixel_data[i] *= aValue;
-    }
-    
-    return temp;
+    return meanFilter(aRadius);
 }
 
 
-//----------------------------------------
-Image Image::operator/(float aValue) const
-//----------------------------------------
+//----------------------------------
+Image Image::laplacianFilter() const
+//----------------------------------
 {
-    Image temp = *this;
-    
-    for (size_t i = 0; i < m_width * m_height; ++i)
-    {
-        temp.m_pixel_data[i] /= aValue;
-    }
-    
-    return temp;
+    // Create the kernel
+    Image kernel(
+        {
+            1.,  1., 1.,
+            1., -8., 1.,
+            1.,  1., 1.
+        }, 3, 3);
+
+    // Filter the image
+    return conv2d(kernel);
 }
 
 
 //------------------------------------
-Image& Image::operator+=(float aValue)
+Image Image::gradientMagnitude() const
 //------------------------------------
 {
-    *this = *this + aValue;
-    return *this;
+    // The Sobel kernels
+    Image g_x(
+        {
+            1., 0., -1.,
+            2., 0., -2.,
+            1., 0., -1.
+        }, 3, 3);
+
+    Image g_y(
+        {
+             1.,  2.,  1.,
+             0.,  0.,  0.,
+            -1., -2., -1.
+        }, 3, 3);
+
+    // The vertical and horizontal derivatives
+    Image G_x = conv2d(g_x);
+    Image G_y = conv2d(g_y);
+
+    // sqrt(G_x^2 + G_y^2), the squares are computed in place
+    G_x = G_x * G_x + G_y * G_y;
+    return G_x.squareRoot();
 }
 
 
-//------------------------------------
-Image& Image::operator-=(float aValue)
-//------------------------------------
+//---------------------------------------------------
+Image Image::medianFilter(unsigned int aRadius) const
+//---------------------------------------------------
 {
-    *this = *this - aValue;
-    return *this;
-}
+    Image output;
+    output.m_width = m_width;
+    output.m_height = m_height;
+    output.m_pixel_data.resize(m_pixel_data.size());
+    output.m_stats_up_to_date = !output.m_pixel_data.size();
 
+    if (m_pixel_data.size())
+    {
+        // The 8-bit filter is exact for integers in [0, 255]: use it when the
+        // pixels can be converted without loss
+        const float* p_input = m_pixel_data.data();
+        bool is_8_bit = true;
+        for (size_t i = 0; i < m_pixel_data.size() && is_8_bit; ++i)
+        {
+            is_8_bit = p_input[i] >= 0.0f && p_input[i] <= 255.0f && p_input[i] == std::floor(p_input[i]);
+        }
 
-//------------------------------------
-Image& Image::operator*=(float aValue)
-//------------------------------------
-{
-    *this = *this * aValue;
-    return *this;
+        if (is_8_bit)
+        {
+            ImageU8 median = ImageU8(*this).medianFilter(aRadius);
+            convertPixels(median.getPixelPointer(), output.m_pixel_data.data(), m_pixel_data.size());
+        }
+        else
+        {
+            ::medianFilter(p_input, m_width, m_height, aRadius, output.m_pixel_data.data());
+        }
+    }
+
+    return output;
 }
 
 
-//------------------------------------
-Image& Image::operator/=(float aValue)
-//------------------------------------
+//--------------------------------
+Image Image::sharpen(double alpha)
+//--------------------------------
 {
-    *this = *this / aValue;
-    return *this;
+    // A 5x5 Gaussian kernel
+    Image gaussian_5x5_kernel(
+        {
+            1.,  4.,  7.,  4., 1.,
+            4., 16., 26., 16., 4.,
+            7., 26., 41., 26., 7.,
+            4., 16., 26., 16., 4.,
+            1.,  4.,  7.,  4., 1.
+        }, 5, 5);
+    gaussian_5x5_kernel /= 273.;
+
+    // Original + alpha * details, with details = original - blur
+    Image blur = conv2d(gaussian_5x5_kernel);
+    Image output = *this + float(alpha) * (*this - std::move(blur));
+
+    // Preserve the dynamic range
+    return output.clamp(getMinValue(), getMaxValue());
 }
 
 
@@ -676,35 +795,63 @@ float Image::getMaxValue()
 }
 
 
+//----------------------------
+float Image::getAverageValue()
+//----------------------------
+{
+    if (!m_stats_up_to_date) updateStats();
+    
+    return m_average_pixel_value;
+}
+
+
+//---------------------------------
+float Image::getStandardDeviation()
+//---------------------------------
+{
+    if (!m_stats_up_to_date) updateStats();
+    
+    return m_stddev_pixel_value;
+}
+
+
 //-----------------------
 void Image::updateStats()
 //-----------------------
 {
     // Need to udate the stats
-    if (!m_stats_up_to_date && m_width * m_height)
+    if (!m_stats_up_to_date && m_pixel_data.size())
     {
-        m_min_pixel_value = m_pixel_data[0];
-        m_max_pixel_value = m_pixel_data[0];
-        m_average_pixel_value = m_pixel_data[0];
-        
-        for (size_t i = 1; i < m_width * m_height; ++i)
+        const PixelKernels& kernels = getPixelKernels();
+        const float* p_data = &m_pixel_data[0];
+        size_t number_of_pixels = m_pixel_data.size();
+
+        // The image is split in fixed-size chunks (not the tiles of the thread
+        // pool), and their statistics are merged in order. The result does not
+        // depend on the number of threads, nor on the size of the tiles.
+        const size_t chunk_size = 1 << 16;
+        size_t number_of_chunks = (number_of_pixels + chunk_size - 1) / chunk_size;
+        std::vector<PixelStatistics> chunk_statistics(number_of_chunks);
+
+        // The chunks are processed in parallel
+        ThreadPool::getInstance().run(number_of_chunks, [&](size_t i)
         {
-            if (m_min_pixel_value > m_pixel_data[i]) m_min_pixel_value = m_pixel_data[i];
-            if (m_max_pixel_value < m_pixel_data[i]) m_max_pixel_value = m_pixel_data[i];
-            
-            m_average_pixel_value += m_pixel_data[i];
-        }
-        m_average_pixel_value /= m_width * m_height;
-        
-        m_stddev_pixel_value = 0;
-        for (size_t i = 0; i < m_width * m_height; ++i)
+            size_t offset = i * chunk_size;
+            chunk_statistics[i] = kernels.statistics(p_data + offset, std::min(chunk_size, number_of_pixels - offset));
+        });
+
+        // Merge the statistics of all the chunks
+        PixelStatistics statistics = chunk_statistics[0];
+        for (size_t i = 1; i < number_of_chunks; ++i)
         {
-            m_stddev_pixel_value += (m_pixel_data[i] - m_average_pixel_value) * (m_pixel_data[i] - m_average_pixel_value);
+            mergeStatistics(statistics, chunk_statistics[i]);
         }
-        m_stddev_pixel_value /= m_width * m_height;
-        m_stddev_pixel_value = sqrt(m_stddev_pixel_value);
-        
+
+        m_min_pixel_value = statistics.min;
+        m_max_pixel_value = statistics.max;
+        m_average_pixel_value = statistics.mean;
+        m_stddev_pixel_value = std::sqrt(statistics.sum_of_squares / statistics.count);
+
         m_stats_up_to_date = true;
     }
 }
-
@@ -0,0 +1,166 @@
+#include <utility>      // std::move
+#include <algorithm>    // std::max, std::min
+
+#include "ImageBatchLoader.h"
+
+
+//----------------------------------------------------------------------------
+ImageBatchLoader::ImageBatchLoader(const std::vector<std::string>& aFilenames,
+                                   size_t aNumberOfThreads,
+                                   size_t aQueueSize,
+                                   float aScaleHint):
+//----------------------------------------------------------------------------
+    m_filenames(aFilenames),
+    m_scale_hint(aScaleHint),
+    m_next_file(0),
+    m_next_image(0),
+    m_stop(false)
+//----------------------------------------------------------------------------
+{
+    size_t number_of_threads = aNumberOfThreads ? aNumberOfThreads : std::thread::hardware_concurrency();
+    number_of_threads = std::max(number_of_threads, size_t(1));
+
+    // No thread waits for a slot as long as there are files
+    number_of_threads = std::min(number_of_threads, std::max(m_filenames.size(), size_t(1)));
+
+    size_t queue_size = aQueueSize ? aQueueSize : 2 * number_of_threads;
+    m_slots.resize(std::max(queue_size, number_of_threads));
+    for (size_t i = 0; i < m_slots.size(); ++i)
+    {
+        m_slots[i].m_ready = false;
+    }
+
+    // If a thread cannot be created, stop the ones already started: the
+    // destructor is not called when the constructor throws
+    m_threads.reserve(number_of_threads);
+    try
+    {
+        for (size_t i = 0; i < number_of_threads; ++i)
+        {
+            m_threads.emplace_back(&ImageBatchLoader::workerLoop, this);
+        }
+    }
+    catch (...)
+    {
+        stopThreads();
+        throw;
+    }
+}
+
+
+//-----------------------------------
+ImageBatchLoader::~ImageBatchLoader()
+//-----------------------------------
+{
+    stopThreads();
+}
+
+
+//------------------------------------------------
+size_t ImageBatchLoader::getNumberOfImages() const
+//------------------------------------------------
+{
+    return m_filenames.size();
+}
+
+
+//-------------------------------------------------
+size_t ImageBatchLoader::getNumberOfThreads() const
+//-------------------------------------------------
+{
+    return m_threads.size();
+}
+
+
+//-------------------------------------------
+size_t ImageBatchLoader::getQueueSize() const
+//-------------------------------------------
+{
+    return m_slots.size();
+}
+
+
+//-------------------------------------------------------------------------
+bool ImageBatchLoader::getNextImage(Image& anImage, std::string* aFilename)
+//-------------------------------------------------------------------------
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_next_image == m_filenames.size()) return false;
+
+    // Wait for the image
+    size_t index = m_next_image;
+    Slot& slot = m_slots[index % m_slots.size()];
+    m_loaded.wait(lock, [&] { return slot.m_ready; });
+
+    // Take it, and free its slot
+    std::exception_ptr exception = slot.m_exception;
+    slot.m_exception = std::exception_ptr();
+    anImage = std::move(slot.m_image);
+    slot.m_ready = false;
+    ++m_next_image;
+    lock.unlock();
+    m_room.notify_all();
+
+    if (aFilename) *aFilename = m_filenames[index];
+    if (exception) std::rethrow_exception(exception);
+
+    return true;
+}
+
+
+//----------------------------------
+void ImageBatchLoader::stopThreads()
+//----------------------------------
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_room.notify_all();
+
+    for (size_t i = 0; i < m_threads.size(); ++i)
+    {
+        m_threads[i].join();
+    }
+    m_threads.clear();
+}
+
+
+//---------------------------------
+void ImageBatchLoader::workerLoop()
+//---------------------------------
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        // Wait for a file, and for room in the queue
+        m_room.wait(lock, [&]
+        {
+            return m_stop || m_next_file == m_filenames.size() ||
+                m_next_file < m_next_image + m_slots.size();
+        });
+
+        if (m_stop || m_next_file == m_filenames.size()) break;
+        size_t index = m_next_file++;
+        lock.unlock();
+
+        // Load the file (without the lock): nobody else uses the slot
+        Image image;
+        std::exception_ptr exception;
+        try
+        {
+            image.load(m_filenames[index], m_scale_hint);
+        }
+        catch (...)
+        {
+            exception = std::current_exception();
+        }
+
+        lock.lock();
+        Slot& slot = m_slots[index % m_slots.size()];
+        slot.m_image = std::move(image);
+        slot.m_exception = exception;
+        slot.m_ready = true;
+        m_loaded.notify_all();
+    }
+}
@@ -0,0 +1,1286 @@
+#include <sstream>
+#include <stdexcept>      // std::runtime_error
+#include <cstdio>
+#include <cstring>        // std::memcpy, std::memcmp
+#include <cctype>         // std::isspace, std::tolower
+#include <cstdlib>        // std::strtod, std::strtoull
+#include <cstdint>        // SIZE_MAX
+#include <csetjmp>        // setjmp, longjmp
+#include <string>
+#include <utility>        // std::move
+#include <algorithm>      // std::min, std::max, std::reverse
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>        // open
+#include <unistd.h>       // close
+#include <sys/mman.h>     // mmap, munmap
+#include <sys/stat.h>     // fstat
+#endif
+
+#ifdef HAS_LIBJPEG
+#include <jerror.h>
+#include <jpeglib.h>
+#endif
+
+#include "ImageIO.h"
+#include "BasicImage.h"   // convertPixels
+
+
+namespace
+{
+
+// The magic number of the raw files
+const char raw_magic_number[8] = {'I', 'C', 'P', 'I', 'M', 'A', 'G', 'E'};
+
+// The size of the tiles of the TIFF files that are written
+const size_t tiff_tile_size = 256;
+
+// The size of the buffer of the files that are written
+const size_t write_buffer_size = 1 << 20;
+
+// The number of pixels converted at a time when reading a file
+const size_t conversion_chunk_size = 1 << 16;
+
+//------------------------------------------------------------------------------
+/// Throw an exception for a file that can't be read or written
+//------------------------------------------------------------------------------
+void throwIOError(const char* aFunction, int aLine, const char* aMessage, const char* aFilename = 0)
+{
+    // Format a nice error message
+    std::stringstream error_message;
+    error_message << "ERROR:" << std::endl;
+    error_message << "\tin File:" << __FILE__ << std::endl;
+    error_message << "\tin Function:" << aFunction << std::endl;
+    error_message << "\tat Line:" << aLine << std::endl;
+    error_message << "\tMESSAGE: " << aMessage;
+    if (aFilename) error_message << " " << aFilename;
+    error_message << std::endl;
+
+    // Throw an exception
+    throw std::runtime_error(error_message.str());
+}
+
+
+//------------------------------------------------------------------------------
+/// True if the machine is little-endian
+//------------------------------------------------------------------------------
+bool isLittleEndian()
+{
+    uint16_t value = 1;
+    unsigned char first_byte;
+    std::memcpy(&first_byte, &value, 1);
+    return first_byte == 1;
+}
+
+
+//------------------------------------------------------------------------------
+/// Size of a sample in bytes
+//------------------------------------------------------------------------------
+size_t getSampleSize(SampleType aSampleType)
+{
+    return aSampleType == SAMPLE_UINT8 ? 1 : aSampleType == SAMPLE_FLOAT ? 4 : 2;
+}
+
+
+//------------------------------------------------------------------------------
+/// Read an unsigned integer of 1, 2, 4 or 8 bytes
+//------------------------------------------------------------------------------
+uint64_t readInteger(const unsigned char* aBytes, size_t aSize, bool aBigEndianFlag)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < aSize; ++i)
+    {
+        value |= uint64_t(aBytes[aBigEndianFlag ? aSize - 1 - i : i]) << (8 * i);
+    }
+    return value;
+}
+
+
+//------------------------------------------------------------------------------
+/// Append an unsigned integer of 1, 2, 4 or 8 bytes (little-endian)
+//------------------------------------------------------------------------------
+void writeInteger(std::vector<unsigned char>& aBytes, uint64_t aValue, size_t aSize)
+{
+    for (size_t i = 0; i < aSize; ++i)
+    {
+        aBytes.push_back((unsigned char)(aValue >> (8 * i)));
+    }
+}
+
+
+//------------------------------------------------------------------------------
+/// Copy samples, and reverse the order of their bytes if needed
+//------------------------------------------------------------------------------
+void copySamples(const unsigned char* anInput, unsigned char* anOutput,
+                 size_t aNumberOfSamples, size_t aSampleSize, bool aSwapFlag)
+{
+    if (!aSwapFlag || aSampleSize == 1)
+    {
+        std::memcpy(anOutput, anInput, aNumberOfSamples * aSampleSize);
+    }
+    else
+    {
+        for (size_t i = 0; i < aNumberOfSamples * aSampleSize; i += aSampleSize)
+        {
+            for (size_t j = 0; j < aSampleSize; ++j)
+            {
+                anOutput[i + j] = anInput[i + aSampleSize - 1 - j];
+            }
+        }
+    }
+}
+
+
+//------------------------------------------------------------------------------
+/// Convert samples of any type to pixels (see convertPixels)
+//------------------------------------------------------------------------------
+template<typename PixelT>
+void convertSamples(SampleType aSampleType, const void* anInput, PixelT* anOutput, size_t aSize)
+{
+    switch (aSampleType)
+    {
+    case SAMPLE_UINT8:
+        convertPixels(static_cast<const uint8_t*>(anInput), anOutput, aSize);
+        break;
+
+    case SAMPLE_UINT16:
+        convertPixels(static_cast<const uint16_t*>(anInput), anOutput, aSize);
+        break;
+
+    case SAMPLE_HALF:
+        convertPixels(static_cast<const Half*>(anInput), anOutput, aSize);
+        break;
+
+    case SAMPLE_FLOAT:
+        convertPixels(static_cast<const float*>(anInput), anOutput, aSize);
+        break;
+    }
+}
+
+
+//------------------------------------------------------------------------------
+/// Read the next token of the header of a PGM or PFM file, skipping the
+/// whitespaces and the comments
+//------------------------------------------------------------------------------
+std::string readToken(const unsigned char* aData, size_t aSize, size_t& aPosition)
+{
+    while (aPosition < aSize)
+    {
+        if (aData[aPosition] == '#')
+        {
+            while (aPosition < aSize && aData[aPosition] != '\n') ++aPosition;
+        }
+        else if (std::isspace(aData[aPosition]))
+        {
+            ++aPosition;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    std::string token;
+    while (aPosition < aSize && !std::isspace(aData[aPosition]) && token.size() < 32)
+    {
+        token += char(aData[aPosition++]);
+    }
+    return token;
+}
+
+
+//------------------------------------------------------------------------------
+/// Read a positive integer of the header of a PGM or PFM file
+//------------------------------------------------------------------------------
+size_t readSize(const unsigned char* aData, size_t aSize, size_t& aPosition, const char* aFunction, int aLine)
+{
+    std::string token = readToken(aData, aSize, aPosition);
+    if (token.empty() || token.find_first_not_of("0123456789") != std::string::npos)
+    {
+        throwIOError(aFunction, aLine, "Invalid header");
+    }
+    return size_t(std::strtoull(token.c_str(), 0, 10));
+}
+
+
+//------------------------------------------------------------------------------
+/// Find the format of an image file from its first bytes
+//------------------------------------------------------------------------------
+ImageFileFormat getFormatFromMagicNumber(const unsigned char* aData, size_t aSize, const char* aFilename,
+                                         const char* aFunction, int aLine)
+{
+    if (aSize >= 2 && aData[0] == 0xFF && aData[1] == 0xD8) return FORMAT_JPEG;
+    if (aSize >= 8 && !std::memcmp(aData, raw_magic_number, 8)) return FORMAT_RAW;
+    if (aSize >= 2 && aData[0] == 'P' && aData[1] == '5') return FORMAT_PGM;
+    if (aSize >= 2 && aData[0] == 'P' && aData[1] == 'f') return FORMAT_PFM;
+    if (aSize >= 4 && !std::memcmp(aData, "II*\0", 4)) return FORMAT_TIFF;
+    if (aSize >= 4 && !std::memcmp(aData, "MM\0*", 4)) return FORMAT_TIFF;
+
+    throwIOError(aFunction, aLine, "Unknown file format", aFilename);
+    return FORMAT_JPEG;
+}
+
+
+#ifdef HAS_LIBJPEG
+
+// The marker inserted if the data ends before the end of the image
+const JOCTET end_of_image[2] = {0xFF, JPEG_EOI};
+
+
+//------------------------------------------------------------------------------
+/// Error manager of libjpeg: the fatal errors jump back to the decoder or the
+/// encoder (the default manager calls exit()), which throws an exception
+//------------------------------------------------------------------------------
+struct ErrorManager
+{
+    jpeg_error_mgr m_manager;               //< The manager of libjpeg (first member)
+    std::jmp_buf m_jump_buffer;             //< Where to go back on error
+    char m_message[JMSG_LENGTH_MAX];        //< The message of the error
+};
+
+void exitOnError(j_common_ptr aDecompressor)
+{
+    ErrorManager* p_error_manager = reinterpret_cast<ErrorManager*>(aDecompressor->err);
+    (*aDecompressor->err->format_message)(aDecompressor, p_error_manager->m_message);
+    std::longjmp(p_error_manager->m_jump_buffer, 1);
+}
+
+
+//------------------------------------------------------------------------------
+/// Source manager of libjpeg that reads a buffer in memory, i.e. the mapped
+/// file: all the data is available from the start
+//------------------------------------------------------------------------------
+void initSource(j_decompress_ptr)
+{}
+
+boolean fillInputBuffer(j_decompress_ptr aDecompressor)
+{
+    // The file is truncated: end the image, as the stdio source does
+    WARNMS(aDecompressor, JWRN_JPEG_EOF);
+    aDecompressor->src->next_input_byte = end_of_image;
+    aDecompressor->src->bytes_in_buffer = 2;
+    return TRUE;
+}
+
+void skipInputData(j_decompress_ptr aDecompressor, long aNumberOfBytes)
+{
+    jpeg_source_mgr* p_source = aDecompressor->src;
+    if (aNumberOfBytes <= 0) return;
+
+    if (size_t(aNumberOfBytes) > p_source->bytes_in_buffer)
+    {
+        fillInputBuffer(aDecompressor);
+    }
+    else
+    {
+        p_source->next_input_byte += aNumberOfBytes;
+        p_source->bytes_in_buffer -= aNumberOfBytes;
+    }
+}
+
+void terminateSource(j_decompress_ptr)
+{}
+
+#endif // HAS_LIBJPEG
+
+} // namespace
+
+
+#ifdef HAS_LIBJPEG
+
+//------------------------------------------------------------------------------
+/// The file and the libjpeg objects of a decoder
+//------------------------------------------------------------------------------
+struct JPEGDecoder::State
+{
+    explicit State(MappedFile&& aFile):
+        m_file(std::move(aFile))
+    {
+        m_decompressor.err = jpeg_std_error(&m_error_manager.m_manager);
+        m_error_manager.m_manager.error_exit = exitOnError;
+        jpeg_create_decompress(&m_decompressor);
+
+        m_source.next_input_byte = m_file.getData();
+        m_source.bytes_in_buffer = m_file.getSize();
+        m_source.init_source = initSource;
+        m_source.fill_input_buffer = fillInputBuffer;
+        m_source.skip_input_data = skipInputData;
+        m_source.resync_to_restart = jpeg_resync_to_restart;
+        m_source.term_source = terminateSource;
+        m_decompressor.src = &m_source;
+    }
+
+    ~State()
+    {
+        jpeg_destroy_decompress(&m_decompressor);
+    }
+
+    MappedFile m_file;                            //< The compressed data
+    ErrorManager m_error_manager;                 //< The handling of the errors
+    jpeg_source_mgr m_source;                     //< The source of the compressed data
+    jpeg_decompress_struct m_decompressor;        //< The decompression object
+    size_t m_number_of_components;                //< 1 or 3
+};
+
+#else
+
+struct JPEGDecoder::State {};
+
+#endif // HAS_LIBJPEG
+
+
+//--------------------------------------------
+MappedFile::MappedFile(const char* aFilename):
+//--------------------------------------------
+    m_p_data(0),
+    m_size(0)
+//--------------------------------------------
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(aFilename, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throwIOError(__FUNCTION__, __LINE__, "Can't open", aFilename);
+    }
+
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+    m_size = size_t(size.QuadPart);
+
+    // The view keeps the mapping alive once the handles are closed
+    if (m_size)
+    {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping)
+        {
+            m_p_data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+#else
+    int file = open(aFilename, O_RDONLY);
+    if (file < 0)
+    {
+        throwIOError(__FUNCTION__, __LINE__, "Can't open", aFilename);
+    }
+
+    struct stat status;
+    if (fstat(file, &status) == 0) m_size = size_t(status.st_size);
+
+    // The mapping remains valid once the file is closed
+    if (m_size)
+    {
+        void* p_data = mmap(0, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (p_data != MAP_FAILED)
+        {
+            // The file is read from the start to the end
+            madvise(p_data, m_size, MADV_SEQUENTIAL);
+            m_p_data = static_cast<const unsigned char*>(p_data);
+        }
+    }
+    close(file);
+#endif
+
+    if (m_size && !m_p_data)
+    {
+        throwIOError(__FUNCTION__, __LINE__, "Can't map", aFilename);
+    }
+}
+
+
+//--------------------------------------------------
+MappedFile::MappedFile(MappedFile&& aFile) noexcept:
+//--------------------------------------------------
+    m_p_data(aFile.m_p_data),
+    m_size(aFile.m_size)
+//--------------------------------------------------
+{
+    aFile.m_p_data = 0;
+    aFile.m_size = 0;
+}
+
+
+//-----------------------
+MappedFile::~MappedFile()
+//-----------------------
+{
+    if (m_p_data)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(m_p_data);
+#else
+        munmap(const_cast<unsigned char*>(m_p_data), m_size);
+#endif
+    }
+}
+
+
+//----------------------------------------------
+const unsigned char* MappedFile::getData() const
+//----------------------------------------------
+{
+    return m_p_data;
+}
+
+
+//--------------------------------
+size_t MappedFile::getSize() const
+//--------------------------------
+{
+    return m_size;
+}
+
+
+//----------------------------------------------------------------
+JPEGDecoder::JPEGDecoder(const char* aFilename, float aScaleHint):
+//----------------------------------------------------------------
+    JPEGDecoder(MappedFile(aFilename), aFilename, aScaleHint)
+//----------------------------------------------------------------
+{}
+
+
+//-----------------------------------------------------------------------------------
+JPEGDecoder::JPEGDecoder(MappedFile&& aFile, const char* aFilename, float aScaleHint)
+//-----------------------------------------------------------------------------------
+{
+#ifdef HAS_LIBJPEG
+    m_p_state.reset(new State(std::move(aFile)));
+    jpeg_decompress_struct& decompressor = m_p_state->m_decompressor;
+
+    // The errors of libjpeg end up here
+    if (setjmp(m_p_state->m_error_manager.m_jump_buffer))
+    {
+        throwIOError(__FUNCTION__, __LINE__, m_p_state->m_error_manager.m_message, aFilename);
+    }
+
+    // Read the header
+    jpeg_read_header(&decompressor, TRUE);
+
+    // Decode at the smallest scale that is large enough
+    unsigned int scale_denominator = 1;
+    while (scale_denominator < 8 && 1.0f / (2 * scale_denominator) >= aScaleHint)
+    {
+        scale_denominator *= 2;
+    }
+    decompressor.scale_num = 1;
+    decompressor.scale_denom = scale_denominator;
+
+    // Start the decompression
+    jpeg_start_decompress(&decompressor);
+
+    if (decompressor.out_color_space == JCS_RGB)
+    {
+        m_p_state->m_number_of_components = 3;
+    }
+    else if (decompressor.out_color_space == JCS_GRAYSCALE)
+    {
+        m_p_state->m_number_of_components = 1;
+    }
+    // Unknown colour space
+    else
+    {
+        throwIOError(__FUNCTION__, __LINE__, "Unknown colour space in", aFilename);
+    }
+#else
+    throwIOError(__FUNCTION__, __LINE__, "LibJPEG not supported");
+#endif
+}
+
+
+//-------------------------
+JPEGDecoder::~JPEGDecoder()
+//-------------------------
+{}
+
+
+//----------------------------------
+size_t JPEGDecoder::getWidth() const
+//----------------------------------
+{
+#ifdef HAS_LIBJPEG
+    return m_p_state->m_decompressor.output_width;
+#else
+    return 0;
+#endif
+}
+
+
+//-----------------------------------
+size_t JPEGDecoder::getHeight() const
+//-----------------------------------
+{
+#ifdef HAS_LIBJPEG
+    return m_p_state->m_decompressor.output_height;
+#else
+    return 0;
+#endif
+}
+
+
+//-----------------------------------------------
+size_t JPEGDecoder::getNumberOfComponents() const
+//-----------------------------------------------
+{
+#ifdef HAS_LIBJPEG
+    return m_p_state->m_number_of_components;
+#else
+    return 0;
+#endif
+}
+
+
+//-------------------------------------------------
+void JPEGDecoder::readScanline(unsigned char* aRow)
+//-------------------------------------------------
+{
+#ifdef HAS_LIBJPEG
+    jpeg_decompress_struct& decompressor = m_p_state->m_decompressor;
+
+    if (decompressor.output_scanline >= decompressor.output_height)
+    {
+        throwIOError(__FUNCTION__, __LINE__, "No more rows to decode");
+    }
+
+    // The errors of libjpeg end up here
+    if (setjmp(m_p_state->m_error_manager.m_jump_buffer))
+    {
+        throwIOError(__FUNCTION__, __LINE__, m_p_state->m_error_manager.m_message);
+    }
+
+    JSAMPROW row_pointer = aRow;
+    jpeg_read_scanlines(&decompressor, &row_pointer, 1);
+
+    // Finish the decompression after the last row
+    if (decompressor.output_scanline == decompressor.output_height)
+    {
+        jpeg_finish_decompress(&decompressor);
+    }
+#endif
+}
+
+
+//----------------------------------------------------------------------------------
+void computeLuminance(const unsigned char* anRGBRow, float* anOutput, size_t aWidth)
+//----------------------------------------------------------------------------------
+{
+    for (size_t i = 0; i < aWidth; ++i)
+    {
+        // Compute the relative luminance from RGB data
+        // using Photometric/digital ITU-R
+        double pixel_value;
+        pixel_value  = 0.2126 * anRGBRow[i * 3    ];
+        pixel_value += 0.7152 * anRGBRow[i * 3 + 1];
+        pixel_value += 0.0722 * anRGBRow[i * 3 + 2];
+
+        anOutput[i] = pixel_value;
+    }
+}
+
+
+//-----------------------------------------------------------------
+void writeJPEG(const char* aFilename, const unsigned char* aPixels,
+               size_t aWidth, size_t aHeight,
+               int aQuality, bool anOptimiseFlag)
+//-----------------------------------------------------------------
+{
+#ifdef HAS_LIBJPEG
+    if (aQuality < 1 || aQuality > 100)
+    {
+        throwIOError(__FUNCTION__, __LINE__, "The quality must be between 1 and 100, cannot write", aFilename);
+    }
+
+    // Allocate and initialize a JPEG compression object
+    struct jpeg_compress_struct cinfo;
+    ErrorManager error_manager;
+    cinfo.err = jpeg_std_error(&error_manager.m_manager);
+    error_manager.m_manager.error_exit = exitOnError;
+    jpeg_create_compress(&cinfo);
+
+    // Specify the destination for the compressed data (eg, a file)
+    FILE* p_output_file(fopen(aFilename, "wb"));
+    if (!p_output_file)
+    {
+        jpeg_destroy_compress(&cinfo);
+        throwIOError(__FUNCTION__, __LINE__, "Can't open", aFilename);
+    }
+
+    // The errors of libjpeg end up here: the incomplete file is removed
+    if (setjmp(error_manager.m_jump_buffer))
+    {
+        jpeg_destroy_compress(&cinfo);
+        fclose(p_output_file);
+        std::remove(aFilename);
+        throwIOError(__FUNCTION__, __LINE__, error_manager.m_message, aFilename);
+    }
+    jpeg_stdio_dest(&cinfo, p_output_file);
+
+    // Set parameters for compression, including image size & colorspace
+    cinfo.image_width  = aWidth;    // image width in pixels
+    cinfo.image_height = aHeight;   // image height in pixels
+    cinfo.input_components = 1;           // number of color components per pixel
+    cinfo.in_color_space = JCS_GRAYSCALE; // colorspace of input image
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, aQuality, TRUE);
+    cinfo.optimize_coding = anOptimiseFlag ? TRUE : FALSE;
+
+    // Start compression
+    jpeg_start_compress(&cinfo, TRUE);
+
+    // Compress data, straight from the pixels, a group of rows at a time
+    const size_t rows_per_call = 16;
+    JSAMPROW row_pointers[rows_per_call];
+    while (cinfo.next_scanline < cinfo.image_height)
+    {
+        size_t rows = std::min(rows_per_call, size_t(cinfo.image_height - cinfo.next_scanline));
+        for (size_t i = 0; i < rows; ++i)
+        {
+            row_pointers[i] = const_cast<JSAMPROW>(aPixels + (cinfo.next_scanline + i) * aWidth);
+        }
+        jpeg_write_scanlines(&cinfo, row_pointers, JDIMENSION(rows));
+    }
+
+    // Finish compression
+    jpeg_finish_compress(&cinfo);
+
+    // Release the JPEG compression object
+    jpeg_destroy_compress(&cinfo);
+    fclose(p_output_file);
+#else
+    throwIOError(__FUNCTION__, __LINE__, "LibJPEG not supported");
+#endif
+}
+
+
+//------------------------------------------------------------------------------------------------
+void writeRawHeader(unsigned char* aHeader, SampleType aSampleType, size_t aWidth, size_t aHeight)
+//------------------------------------------------------------------------------------------------
+{
+    // Magic number, version, sample type, width and height, all little-endian
+    std::vector<unsigned char> header(raw_magic_number, raw_magic_number + 8);
+    writeInteger(header, 1, 4);
+    writeInteger(header, aSampleType, 4);
+    writeInteger(header, aWidth, 8);
+    writeInteger(header, aHeight, 8);
+
+    std::memcpy(aHeader, &header[0], RAW_HEADER_SIZE);
+}
+
+
+//--------------------------------------------------
+ImageFileFormat getFileFormat(const char* aFilename)
+//--------------------------------------------------
+{
+    std::string filename(aFilename);
+    std::string extension;
+    size_t dot = filename.find_last_of('.');
+    if (dot != std::string::npos)
+    {
+        for (size_t i = dot + 1; i < filename.size(); ++i)
+        {
+            extension += char(std::tolower((unsigned char)(filename[i])));
+        }
+    }
+
+    if (extension == "jpg" || extension == "jpeg") return FORMAT_JPEG;
+    if (extension == "raw") return FORMAT_RAW;
+    if (extension == "pgm") return FORMAT_PGM;
+    if (extension == "pfm") return FORMAT_PFM;
+    if (extension == "tif" || extension == "tiff") return FORMAT_TIFF;
+
+    throwIOError(__FUNCTION__, __LINE__, "Unknown file extension", aFilename);
+    return FORMAT_JPEG;
+}
+
+
+//---------------------------------------------------
+ImageFileFormat readFileFormat(const char* aFilename)
+//---------------------------------------------------
+{
+    // Read the magic number
+    unsigned char magic_number[8] = {0};
+    FILE* p_file = std::fopen(aFilename, "rb");
+    if (!p_file)
+    {
+        throwIOError(__FUNCTION__, __LINE__, "Can't open", aFilename);
+    }
+    size_t size = std::fread(magic_number, 1, 8, p_file);
+    std::fclose(p_file);
+
+    return getFormatFromMagicNumber(magic_number, size, aFilename, __FUNCTION__, __LINE__);
+}
+
+
+//----------------------------------------------------------------------------
+ImageFileFormat readFileFormat(const MappedFile& aFile, const char* aFilename)
+//----------------------------------------------------------------------------
+{
+    return getFormatFromMagicNumber(aFile.getData(), aFile.getSize(), aFilename, __FUNCTION__, __LINE__);
+}
+
+
+//------------------------------------------------------
+ImageFileReader::ImageFileReader(const char* aFilename):
+//------------------------------------------------------
+    ImageFileReader(MappedFile(aFilename), aFilename)
+//------------------------------------------------------
+{}
+
+
+//--------------------------------------------------------------------------
+ImageFileReader::ImageFileReader(MappedFile&& aFile, const char* aFilename):
+//--------------------------------------------------------------------------
+    m_file(std::move(aFile)),
+    m_width(0),
+    m_height(0),
+    m_sample_type(SAMPLE_UINT8),
+    m_sample_size(1),
+    m_swap_bytes(false),
+    m_bottom_up(false),
+    m_block_width(0),
+    m_block_height(0)
+//--------------------------------------------------------------------------
+{
+    switch (readFileFormat(m_file, aFilename))
+    {
+    case FORMAT_RAW:
+        readRawHeader();
+        break;
+
+    case FORMAT_PGM:
+    case FORMAT_PFM:
+        readPortableHeader();
+        break;
+
+    case FORMAT_TIFF:
+        readTIFFHeader();
+        break;
+
+    default:
+        throwIOError(__FUNCTION__, __LINE__, "Not an uncompressed image file", aFilename);
+    }
+
+    m_sample_size = getSampleSize(m_sample_type);
+
+    // The sizes in bytes of the image and of its blocks must fit in size_t,
+    // before any of them is computed
+    if ((m_width && m_height && m_width > SIZE_MAX / m_height / m_sample_size) ||
+        (m_block_width && m_block_height && m_block_width > SIZE_MAX / m_block_height / m_sample_size))
+    {
+        throwIOError(__FUNCTION__, __LINE__, "Image too large in", aFilename);
+    }
+
+    // Check that all the blocks are in the file
+    if (m_width && m_height)
+    {
+        size_t blocks_across = (m_width + m_block_width - 1) / m_block_width;
+        size_t blocks_down = (m_height + m_block_height - 1) / m_block_height;
+        if (m_blocks.size() < blocks_across * blocks_down)
+        {
+            throwIOError(__FUNCTION__, __LINE__, "Missing blocks in", aFilename);
+        }
+
+        for (size_t i = 0; i < blocks_across * blocks_down; ++i)
+        {
+            size_t rows = std::min(m_block_height, m_height - i / blocks_across * m_block_height);
+            size_t columns = std::min(m_block_width, m_width - i % blocks_across * m_block_width);
+            size_t end = m_blocks[i] + ((rows - 1) * m_block_width + columns) * m_sample_size;
+            if (m_blocks[i] > m_file.getSize() || end > m_file.getSize() || end < m_blocks[i])
+            {
+                throwIOError(__FUNCTION__, __LINE__, "Truncated file", aFilename);
+            }
+        }
+    }
+}
+
+
+//--------------------------------------
+size_t ImageFileReader::getWidth() const
+//--------------------------------------
+{
+    return m_width;
+}
+
+
+//---------------------------------------
+size_t ImageFileReader::getHeight() const
+//---------------------------------------
+{
+    return m_height;
+}
+
+
+//-----------------------------------------------
+SampleType ImageFileReader::getSampleType() const
+//-----------------------------------------------
+{
+    return m_sample_type;
+}
+
+
+//------------------------------------------------------------------------------------------
+void ImageFileReader::readRows(size_t aFirstRow, size_t aNumberOfRows, void* aSamples) const
+//------------------------------------------------------------------------------------------
+{
+    unsigned char* p_output = static_cast<unsigned char*>(aSamples);
+    size_t blocks_across = (m_width + m_block_width - 1) / m_block_width;
+
+    for (size_t row = aFirstRow; row < aFirstRow + aNumberOfRows; ++row)
+    {
+        size_t file_row = m_bottom_up ? m_height - 1 - row : row;
+        size_t block_row = file_row / m_block_height;
+        size_t row_in_block = file_row % m_block_height;
+
+        // The part of the row in each block
+        for (size_t i = 0; i < blocks_across; ++i)
+        {
+            size_t first_column = i * m_block_width;
+            size_t columns = std::min(m_block_width, m_width - first_column);
+            const unsigned char* p_input = m_file.getData() + m_blocks[block_row * blocks_across + i] +
+                row_in_block * m_block_width * m_sample_size;
+
+            copySamples(p_input, p_output + first_column * m_sample_size, columns, m_sample_size, m_swap_bytes);
+        }
+
+        p_output += m_width * m_sample_size;
+    }
+}
+
+
+//-----------------------------------------------------
+template<typename PixelT>
+void ImageFileReader::readPixels(PixelT* aPixels) const
+//-----------------------------------------------------
+{
+    if (!m_width || !m_height) return;
+
+    // Read the pixels in place
+    if (m_sample_type == ::getSampleType<PixelT>())
+    {
+        readRows(0, m_height, aPixels);
+    }
+    // Read and convert groups of rows
+    else
+    {
+        size_t rows_per_chunk = std::max(size_t(1), conversion_chunk_size / m_width);
+        std::vector<unsigned char> samples(rows_per_chunk * m_width * m_sample_size);
+        for (size_t row = 0; row < m_height; row += rows_per_chunk)
+        {
+            size_t rows = std::min(rows_per_chunk, m_height - row);
+            readRows(row, rows, &samples[0]);
+            convertSamples(m_sample_type, &samples[0], aPixels + row * m_width, rows * m_width);
+        }
+    }
+}
+
+
+//-----------------------------------
+void ImageFileReader::readRawHeader()
+//-----------------------------------
+{
+    const unsigned char* p_header = m_file.getData();
+    if (m_file.getSize() < RAW_HEADER_SIZE ||
+        readInteger(p_header + 8, 4, false) != 1 ||
+        readInteger(p_header + 12, 4, false) > SAMPLE_FLOAT)
+    {
+        throwIOError(__FUNCTION__, __LINE__, "Invalid raw header");
+    }
+
+    m_sample_type = SampleType(readInteger(p_header + 12, 4, false));
+    m_width = size_t(readInteger(p_header + 16, 8, false));
+    m_height = size_t(readInteger(p_header + 24, 8, false));
+
+    // The whole image is a single block, little-endian
+    m_swap_bytes = !isLittleEndian();
+    m_block_width = m_width;
+    m_block_height = std::max(m_height, size_t(1));
+    m_blocks.assign(1, RAW_HEADER_SIZE);
+}
+
+
+//----------------------------------------
+void ImageFileReader::readPortableHeader()
+//----------------------------------------
+{
+    const unsigned char* p_data = m_file.getData();
+    size_t size = m_file.getSize();
+    size_t position = 0;
+
+    std::string magic_number = readToken(p_data, size, position);
+    m_width = readSize(p_data, size, position, __FUNCTION__, __LINE__);
+    m_height = readSize(p_data, size, position, __FUNCTION__, __LINE__);
+
+    // PGM: the largest value gives the size of the samples (big-endian)
+    if (magic_number == "P5")
+    {
+        size_t maximum_value = readSize(p_data, size, position, __FUNCTION__, __LINE__);
+        if (!maximum_value || maximum_value > 65535)
+        {
+            throwIOError(__FUNCTION__, __LINE__, "Invalid maximum value in PGM header");
+        }
+
+        m_sample_type = maximum_value < 256 ? SAMPLE_UINT8 : SAMPLE_UINT16;
+        m_swap_bytes = isLittleEndian();
+    }
+    // PFM: the sign of the scale gives the byte order. The rows are stored
+    // from the bottom to the top.
+    else
+    {
+        std::string scale = readToken(p_data, size, position);
+        if (scale.empty())
+        {
+            throwIOError(__FUNCTION__, __LINE__, "Invalid PFM header");
+        }
+
+        m_sample_type = SAMPLE_FLOAT;
+        m_swap_bytes = (std::strtod(scale.c_str(), 0) < 0) != isLittleEndian();
+        m_bottom_up = true;
+    }
+
+    // A single whitespace before the samples
+    ++position;
+
+    m_block_width = m_width;
+    m_block_height = std::max(m_height, size_t(1));
+    m_blocks.assign(1, position);
+}
+
+
+//------------------------------------
+void ImageFileReader::readTIFFHeader()
+//------------------------------------
+{
+    const unsigned char* p_data = m_file.getData();
+    size_t size = m_file.getSize();
+    if (size < 8)
+    {
+        throwIOError(__FUNCTION__, __LINE__, "Invalid TIFF header");
+    }
+
+    bool big_endian = p_data[0] == 'M';
+
+    size_t directory = size_t(readInteger(p_data + 4, 4, big_endian));
+    if (directory + 2 > size)
+    {
+        throwIOError(__FUNCTION__, __LINE__, "Invalid TIFF header");
+    }
+
+    size_t number_of_entries = size_t(readInteger(p_data + directory, 2, big_endian));
+    if (directory + 2 + number_of_entries * 12 > size)
+    {
+        throwIOError(__FUNCTION__, __LINE__, "Invalid TIFF header");
+    }
+
+    // Read the tags of the first image
+    size_t bits_per_sample = 1;
+    size_t compression = 1;
+    size_t samples_per_pixel = 1;
+    size_t sample_format = 1;
+    size_t rows_per_strip = 0;
+    size_t tile_width = 0;
+    size_t tile_height = 0;
+    std::vector<size_t> offsets;
+
+    for (size_t i = 0; i < number_of_entries; ++i)
+    {
+        const unsigned char* p_entry = p_data + directory + 2 + i * 12;
+        size_t tag = size_t(readInteger(p_entry, 2, big_endian));
+        size_t type = size_t(readInteger(p_entry + 2, 2, big_endian));
+        size_t count = size_t(readInteger(p_entry + 4, 4, big_endian));
+
+        // Only the SHORT and LONG values are used
+        size_t value_size = type == 3 ? 2 : type == 4 ? 4 : 0;
+        if (!value_size || !count) continue;
+
+        // The values are in the entry if they fit in 4 bytes
+        const unsigned char* p_values = p_entry + 8;
+        if (count * value_size > 4)
+        {
+            size_t offset = size_t(readInteger(p_entry + 8, 4, big_endian));
+            if (count > size || offset + count * value_size > size)
+            {
+                throwIOError(__FUNCTION__, __LINE__, "Invalid TIFF tag");
+            }
+            p_values = p_data + offset;
+        }
+        size_t value = size_t(readInteger(p_values, value_size, big_endian));
+
+        switch (tag)
+        {
+        case 256: m_width = value; break;
+        case 257: m_height = value; break;
+        case 258: bits_per_sample = value; break;
+        case 259: compression = value; break;
+        case 277: samples_per_pixel = value; break;
+        case 278: rows_per_strip = value; break;
+        case 322: tile_width = value; break;
+        case 323: tile_height = value; break;
+        case 339: sample_format = value; break;
+
+        // Strip or tile offsets
+        case 273:
+        case 324:
+            offsets.resize(count);
+            for (size_t j = 0; j < count; ++j)
+            {
+                offsets[j] = size_t(readInteger(p_values + j * value_size, value_size, big_endian));
+            }
+            break;
+        }
+    }
+
+    if (compression != 1 || samples_per_pixel != 1)
+    {
+        throwIOError(__FUNCTION__, __LINE__, "Only uncompressed greyscale TIFF files are supported");
+    }
+
+    if (sample_format == 1 && bits_per_sample == 8) m_sample_type = SAMPLE_UINT8;
+    else if (sample_format == 1 && bits_per_sample == 16) m_sample_type = SAMPLE_UINT16;
+    else if (sample_format == 3 && bits_per_sample == 16) m_sample_type = SAMPLE_HALF;
+    else if (sample_format == 3 && bits_per_sample == 32) m_sample_type = SAMPLE_FLOAT;
+    else throwIOError(__FUNCTION__, __LINE__, "Unsupported TIFF sample format");
+
+    m_swap_bytes = big_endian == isLittleEndian();
+
+    // Tiles, or strips of rows
+    if (tile_width && tile_height)
+    {
+        m_block_width = tile_width;
+        m_block_height = tile_height;
+    }
+    else
+    {
+        m_block_width = std::max(m_width, size_t(1));
+        m_block_height = rows_per_strip && rows_per_strip < m_height ? rows_per_strip : std::max(m_height, size_t(1));
+    }
+    m_blocks = offsets;
+}
+
+
+//-----------------------------------------------------------------
+void writeImageFile(const char* aFilename, ImageFileFormat aFormat,
+                    SampleType aSampleType, const void* aPixels,
+                    size_t aWidth, size_t aHeight)
+//-----------------------------------------------------------------
+{
+    // The type of the samples in the file, and their byte order
+    SampleType file_sample_type = aSampleType;
+    bool swap_bytes = false;
+    switch (aFormat)
+    {
+    case FORMAT_RAW:
+        swap_bytes = !isLittleEndian();
+        break;
+
+    case FORMAT_PGM:
+        if (aSampleType != SAMPLE_UINT8 && aSampleType != SAMPLE_UINT16)
+        {
+            throwIOError(__FUNCTION__, __LINE__, "PGM files store 8- or 16-bit integers, convert the image first:", aFilename);
+        }
+        swap_bytes = isLittleEndian();
+        break;
+
+    case FORMAT_PFM:
+        file_sample_type = SAMPLE_FLOAT;
+        break;
+
+    case FORMAT_TIFF:
+        if (aSampleType == SAMPLE_HALF) file_sample_type = SAMPLE_FLOAT;
+        swap_bytes = !isLittleEndian();
+        break;
+
+    default:
+        throwIOError(__FUNCTION__, __LINE__, "Not an uncompressed image format:", aFilename);
+    }
+
+    size_t sample_size = getSampleSize(aSampleType);
+    size_t file_sample_size = getSampleSize(file_sample_type);
+    size_t row_size = aWidth * file_sample_size;
+
+    // The header
+    std::vector<unsigned char> header;
+    std::vector<size_t> row_order;  // The rows, in the order of the file
+
+    if (aFormat == FORMAT_RAW)
+    {
+        header.resize(RAW_HEADER_SIZE);
+        writeRawHeader(&header[0], aSampleType, aWidth, aHeight);
+    }
+    else if (aFormat == FORMAT_PGM || aFormat == FORMAT_PFM)
+    {
+        std::stringstream text;
+        if (aFormat == FORMAT_PGM)
+        {
+            text << "P5\n" << aWidth << " " << aHeight << "\n" << (aSampleType == SAMPLE_UINT8 ? 255 : 65535) << "\n";
+        }
+        else
+        {
+            text << "Pf\n" << aWidth << " " << aHeight << "\n" << (isLittleEndian() ? "-1.0" : "1.0") << "\n";
+        }
+        std::string header_text = text.str();
+        header.assign(header_text.begin(), header_text.end());
+    }
+    else
+    {
+        // Little-endian TIFF, tiled: the directory and the tile offsets come
+        // first, then the tiles
+        size_t tiles_across = (aWidth + tiff_tile_size - 1) / tiff_tile_size;
+        size_t tiles_down = (aHeight + tiff_tile_size - 1) / tiff_tile_size;
+        size_t number_of_tiles = tiles_across * tiles_down;
+        size_t tile_bytes = tiff_tile_size * tiff_tile_size * file_sample_size;
+
+        const size_t number_of_entries = 12;
+        size_t directory_size = 2 + number_of_entries * 12 + 4;
+        size_t arrays_offset = 8 + directory_size;
+        size_t arrays_size = number_of_tiles > 1 ? number_of_tiles * 8 : 0;
+        size_t data_offset = (arrays_offset + arrays_size + 15) / 16 * 16;
+
+        if (data_offset + number_of_tiles * tile_bytes > 0xFFFFFFFFu)
+        {
+            throwIOError(__FUNCTION__, __LINE__, "Image too large for a TIFF file:", aFilename);
+        }
+
+        header.push_back('I');
+        header.push_back('I');
+        writeInteger(header, 42, 2);
+        writeInteger(header, 8, 4);
+
+        // The entries: tag, type (3: SHORT, 4: LONG), count, value or offset
+        const size_t entries[number_of_entries][4] =
+        {
+            {256, 4, 1, aWidth},                                            // ImageWidth
+            {257, 4, 1, aHeight},                                           // ImageLength
+            {258, 3, 1, file_sample_size * 8},                              // BitsPerSample
+            {259, 3, 1, 1},                                                 // Compression: none
+            {262, 3, 1, 1},                                                 // PhotometricInterpretation: BlackIsZero
+            {277, 3, 1, 1},                                                 // SamplesPerPixel
+            {284, 3, 1, 1},                                                 // PlanarConfiguration: contiguous
+            {322, 4, 1, tiff_tile_size},                                    // TileWidth
+            {323, 4, 1, tiff_tile_size},                                    // TileLength
+            {324, 4, number_of_tiles, number_of_tiles > 1 ? arrays_offset : data_offset},                   // TileOffsets
+            {325, 4, number_of_tiles, number_of_tiles > 1 ? arrays_offset + number_of_tiles * 4 : tile_bytes}, // TileByteCounts
+            {339, 3, 1, size_t(file_sample_type == SAMPLE_FLOAT ? 3 : 1)}   // SampleFormat: float or unsigned
+        };
+
+        writeInteger(header, number_of_entries, 2);
+        for (size_t i = 0; i < number_of_entries; ++i)
+        {
+            writeInteger(header, entries[i][0], 2);
+            writeInteger(header, entries[i][1], 2);
+            writeInteger(header, entries[i][2], 4);
+            writeInteger(header, entries[i][3], entries[i][1] == 3 && entries[i][2] == 1 ? 2 : 4);
+            if (entries[i][1] == 3 && entries[i][2] == 1) writeInteger(header, 0, 2);
+        }
+        writeInteger(header, 0, 4); // No other image
+
+        if (number_of_tiles > 1)
+        {
+            for (size_t i = 0; i < number_of_tiles; ++i) writeInteger(header, data_offset + i * tile_bytes, 4);
+            for (size_t i = 0; i < number_of_tiles; ++i) writeInteger(header, tile_bytes, 4);
+        }
+        header.resize(data_offset, 0);
+    }
+
+    // Prepare a row in the format of the file, if it is not already
+    const unsigned char* p_pixels = static_cast<const unsigned char*>(aPixels);
+    std::vector<unsigned char> converted_row(row_size);
+    std::vector<float> float_row(file_sample_type != aSampleType ? aWidth : 0);
+    auto getFileRow = [&](size_t aRow) -> const unsigned char*
+    {
+        const unsigned char* p_row = p_pixels + aRow * aWidth * sample_size;
+        if (file_sample_type != aSampleType)
+        {
+            convertSamples(aSampleType, p_row, &float_row[0], aWidth);
+            p_row = reinterpret_cast<const unsigned char*>(&float_row[0]);
+        }
+        if (swap_bytes)
+        {
+            copySamples(p_row, &converted_row[0], aWidth, file_sample_size, true);
+            p_row = &converted_row[0];
+        }
+        return p_row;
+    };
+
+    // The bands of tiles of the TIFF files
+    bool is_tiled = aFormat == FORMAT_TIFF && aWidth && aHeight;
+    std::vector<unsigned char> band(is_tiled ? tiff_tile_size * row_size : 0);
+    std::vector<unsigned char> tile(is_tiled ? tiff_tile_size * tiff_tile_size * file_sample_size : 0);
+
+    // Open the file, with a large buffer. The buffers are allocated first:
+    // nothing throws until the file is closed.
+    std::vector<char> file_buffer(write_buffer_size);
+    FILE* p_file = std::fopen(aFilename, "wb");
+    if (!p_file)
+    {
+        throwIOError(__FUNCTION__, __LINE__, "Can't open", aFilename);
+    }
+    std::setvbuf(p_file, &file_buffer[0], _IOFBF, file_buffer.size());
+
+    if (header.size()) std::fwrite(&header[0], 1, header.size(), p_file);
+
+    if (aWidth && aHeight)
+    {
+        // Tiles of the TIFF files: the rows of a band of tiles are prepared,
+        // then the tiles are written one by one (zero-padded at the borders)
+        if (aFormat == FORMAT_TIFF)
+        {
+            size_t tiles_across = (aWidth + tiff_tile_size - 1) / tiff_tile_size;
+            size_t tile_row_size = tiff_tile_size * file_sample_size;
+
+            for (size_t first_row = 0; first_row < aHeight; first_row += tiff_tile_size)
+            {
+                size_t rows = std::min(tiff_tile_size, aHeight - first_row);
+                for (size_t i = 0; i < rows; ++i)
+                {
+                    std::memcpy(&band[i * row_size], getFileRow(first_row + i), row_size);
+                }
+
+                for (size_t j = 0; j < tiles_across; ++j)
+                {
+                    size_t first_column = j * tiff_tile_size;
+                    size_t columns = std::min(tiff_tile_size, aWidth - first_column);
+                    std::fill(tile.begin(), tile.end(), 0);
+                    for (size_t i = 0; i < rows; ++i)
+                    {
+                        std::memcpy(&tile[i * tile_row_size],
+                                    &band[i * row_size + first_column * file_sample_size],
+                                    columns * file_sample_size);
+                    }
+                    std::fwrite(&tile[0], 1, tile.size(), p_file);
+                }
+            }
+        }
+        // The whole image at once
+        else if (aFormat != FORMAT_PFM && file_sample_type == aSampleType && !swap_bytes)
+        {
+            std::fwrite(p_pixels, 1, aHeight * row_size, p_file);
+        }
+        // Row by row (from the bottom for the PFM files)
+        else
+        {
+            for (size_t i = 0; i < aHeight; ++i)
+            {
+                size_t row = aFormat == FORMAT_PFM ? aHeight - 1 - i : i;
+                std::fwrite(getFileRow(row), 1, row_size, p_file);
+            }
+        }
+    }
+
+    // The incomplete file is removed, as by writeJPEG
+    bool error = std::ferror(p_file) != 0;
+    if (std::fclose(p_file) || error)
+    {
+        std::remove(aFilename);
+        throwIOError(__FUNCTION__, __LINE__, "Can't write", aFilename);
+    }
+}
+
+
+// The pixel types of the images
+template void ImageFileReader::readPixels(uint8_t* aPixels) const;
+template void ImageFileReader::readPixels(uint16_t* aPixels) const;
+template void ImageFileReader::readPixels(Half* aPixels) const;
+template void ImageFileReader::readPixels(float* aPixels) const;
@@ -0,0 +1,400 @@
+#include <sstream>
+#include <cstring>        // std::memcpy
+#include <stdexcept>      // std::out_of_range
+#include <vector>
+#include <utility>        // std::pair
+#include <algorithm>      // std::min, std::max, std::copy, std::fill, std::reverse, std::nth_element
+
+#include "MedianFilter.h"
+#include "PixelBuffer.h"
+#include "ThreadPool.h"
+
+
+namespace
+{
+
+typedef std::pair<unsigned int, unsigned int> Comparator;
+
+// The number of columns filtered at once by the sorting networks: the values
+// of the windows of a block stay in the L1 cache (25 x 256 bytes for 5x5)
+const size_t network_block_width = 256;
+
+// The number of bytes compared at once (the size of a SSE register). The
+// lanes beyond the end of the block are computed too, and ignored.
+const size_t network_vector_width = 16;
+
+// The histograms: 16 coarse bins of 16 fine bins
+const size_t coarse_bins = 16;
+const size_t fine_bins = 256;
+
+
+//------------------------------------------------------------------------------
+/// The comparators of a sorting network that moves the median of n values to
+/// the index n / 2: Batcher's odd-even merge sort of the next power of two
+/// (the missing values act as +infinity: their comparators are dropped),
+/// without the comparators that do not lead to the index n / 2.
+//------------------------------------------------------------------------------
+std::vector<Comparator> createMedianNetwork(unsigned int n)
+{
+    unsigned int size = 1;
+    while (size < n) size <<= 1;
+
+    // Batcher's odd-even merge sort
+    std::vector<Comparator> network;
+    for (unsigned int p = 1; p < size; p <<= 1)
+    {
+        for (unsigned int k = p; k >= 1; k >>= 1)
+        {
+            for (unsigned int j = k % p; j + k < size; j += 2 * k)
+            {
+                for (unsigned int i = 0; i < std::min(k, size - j - k); ++i)
+                {
+                    if ((i + j) / (2 * p) == (i + j + k) / (2 * p) && i + j + k < n)
+                    {
+                        network.push_back(Comparator(i + j, i + j + k));
+                    }
+                }
+            }
+        }
+    }
+
+    // From the end: keep the comparators whose outputs are used later on
+    std::vector<bool> used(n, false);
+    used[n / 2] = true;
+
+    std::vector<Comparator> median_network;
+    for (std::vector<Comparator>::const_reverse_iterator it = network.rbegin(); it != network.rend(); ++it)
+    {
+        if (used[it->first] || used[it->second])
+        {
+            used[it->first] = used[it->second] = true;
+            median_network.push_back(*it);
+        }
+    }
+    std::reverse(median_network.begin(), median_network.end());
+
+    return median_network;
+}
+
+
+//------------------------------------------------------------------------------
+/// The index of the closest row or column of the image
+//------------------------------------------------------------------------------
+inline size_t clampIndex(ptrdiff_t anIndex, size_t aSize)
+{
+    return anIndex < 0 ? 0 : std::min(size_t(anIndex), aSize - 1);
+}
+
+
+//------------------------------------------------------------------------------
+/// Throw an exception if the radius of the median filter is too large
+//------------------------------------------------------------------------------
+void checkRadius(const char* aFunction, int aLine, unsigned int aRadius)
+{
+    if (aRadius > MAX_MEDIAN_RADIUS)
+    {
+        // Format a nice error message
+        std::stringstream error_message;
+        error_message << "ERROR:" << std::endl;
+        error_message << "\tin File:" << __FILE__ << std::endl;
+        error_message << "\tin Function:" << aFunction << std::endl;
+        error_message << "\tat Line:" << aLine << std::endl;
+        error_message << "\tMESSAGE: The radius of the median filter is too large (" <<
+            aRadius << " > " << MAX_MEDIAN_RADIUS << ")." << std::endl;
+
+        // Throw an exception
+        throw std::out_of_range(error_message.str());
+    }
+}
+
+
+//------------------------------------------------------------------------------
+/// Median filter for r = 1 and r = 2, using a sorting network. The comparators
+/// are applied to the values of the windows of a block of pixels at once: the
+/// k-th value of the windows of the block are stored in a row of bytes.
+//------------------------------------------------------------------------------
+void medianNetworkFilter(const uint8_t* anInput, size_t aWidth, size_t aHeight,
+                         unsigned int aRadius, uint8_t* anOutput)
+{
+    static const std::vector<Comparator> networks[] =
+    {
+        std::vector<Comparator>(),
+        createMedianNetwork(9),
+        createMedianNetwork(25)
+    };
+
+    const std::vector<Comparator>& network = networks[aRadius];
+    const size_t window = 2 * aRadius + 1;
+    const size_t number_of_values = window * window;
+    const size_t padded_width = aWidth + 2 * aRadius;
+
+    // The strips of rows are independent: they are computed in parallel
+    size_t strip_height = std::max<size_t>(1, ThreadPool::getInstance().getTileSize() / padded_width);
+    size_t number_of_strips = (aHeight + strip_height - 1) / strip_height;
+
+    ThreadPool::getInstance().run(number_of_strips, [&](size_t aStrip)
+    {
+        size_t first_row = aStrip * strip_height;
+        size_t last_row = std::min(first_row + strip_height, aHeight);
+
+        // The input rows of the strip, padded with the closest pixels
+        size_t number_of_rows = last_row - first_row + window - 1;
+        PixelBuffer<uint8_t> rows(number_of_rows * padded_width);
+        for (size_t i = 0; i < number_of_rows; ++i)
+        {
+            const uint8_t* p_input_row = anInput +
+                clampIndex(ptrdiff_t(first_row + i) - ptrdiff_t(aRadius), aHeight) * aWidth;
+            uint8_t* p_row = &rows[i * padded_width];
+
+            std::fill(p_row, p_row + aRadius, p_input_row[0]);
+            std::copy(p_input_row, p_input_row + aWidth, p_row + aRadius);
+            std::fill(p_row + aRadius + aWidth, p_row + padded_width, p_input_row[aWidth - 1]);
+        }
+
+        PixelBuffer<uint8_t> values(number_of_values * network_block_width, 0);
+        for (size_t row = first_row; row < last_row; ++row)
+        {
+            for (size_t first_col = 0; first_col < aWidth; first_col += network_block_width)
+            {
+                size_t block_width = std::min(network_block_width, aWidth - first_col);
+
+                // The k-th values of the windows
+                for (size_t l = 0; l < window; ++l)
+                {
+                    const uint8_t* p_row = &rows[(row - first_row + l) * padded_width + first_col];
+                    for (size_t k = 0; k < window; ++k)
+                    {
+                        std::copy(p_row + k, p_row + k + block_width,
+                                  &values[(l * window + k) * network_block_width]);
+                    }
+                }
+
+                // Apply the sorting network to all the windows, by vectors of
+                // bytes (the compiler cannot tell that the rows of values do
+                // not overlap: they are copied to local arrays)
+                for (size_t i = 0; i < network.size(); ++i)
+                {
+                    uint8_t* p_a = &values[network[i].first * network_block_width];
+                    uint8_t* p_b = &values[network[i].second * network_block_width];
+                    for (size_t x = 0; x < block_width; x += network_vector_width)
+                    {
+                        uint8_t a[network_vector_width], b[network_vector_width];
+                        uint8_t minimum[network_vector_width], maximum[network_vector_width];
+                        std::memcpy(a, p_a + x, network_vector_width);
+                        std::memcpy(b, p_b + x, network_vector_width);
+                        for (size_t j = 0; j < network_vector_width; ++j)
+                        {
+                            minimum[j] = std::min(a[j], b[j]);
+                            maximum[j] = std::max(a[j], b[j]);
+                        }
+                        std::memcpy(p_a + x, minimum, network_vector_width);
+                        std::memcpy(p_b + x, maximum, network_vector_width);
+                    }
+                }
+
+                const uint8_t* p_median = &values[number_of_values / 2 * network_block_width];
+                std::copy(p_median, p_median + block_width, anOutput + row * aWidth + first_col);
+            }
+        }
+    });
+}
+
+
+//------------------------------------------------------------------------------
+/// Median filter for r > 2, in constant time per pixel (Perreault and Hebert):
+/// histograms of the columns, and histogram of the window, with two levels.
+/// Each strip of rows starts with the histograms of its first row.
+//------------------------------------------------------------------------------
+void medianHistogramFilter(const uint8_t* anInput, size_t aWidth, size_t aHeight,
+                           unsigned int aRadius, uint8_t* anOutput)
+{
+    const ptrdiff_t radius = aRadius;
+    const ptrdiff_t window = 2 * radius + 1;
+
+    // Index of the median in the sorted values of a window
+    const size_t rank = size_t(window) * size_t(window) / 2;
+
+    // The initialisation of the histograms costs 2r + 1 rows: the strips are
+    // taller than that, and a few per thread
+    size_t number_of_threads = ThreadPool::getInstance().getNumberOfThreads();
+    size_t strip_height = std::max<size_t>(window,
+        (aHeight + 4 * number_of_threads - 1) / (4 * number_of_threads));
+    size_t number_of_strips = (aHeight + strip_height - 1) / strip_height;
+
+    ThreadPool::getInstance().run(number_of_strips, [&](size_t aStrip)
+    {
+        size_t first_row = aStrip * strip_height;
+        size_t last_row = std::min(first_row + strip_height, aHeight);
+
+        // The histograms of the columns, over 2r + 1 rows
+        PixelBuffer<uint16_t> fine_columns(aWidth * fine_bins, 0);
+        PixelBuffer<uint16_t> coarse_columns(aWidth * coarse_bins, 0);
+
+        // Add a row to the histograms of the columns, or remove it
+        auto addRow = [&](const uint8_t* aRow)
+        {
+            for (size_t col = 0; col < aWidth; ++col)
+            {
+                ++fine_columns[col * fine_bins + aRow[col]];
+                ++coarse_columns[col * coarse_bins + (aRow[col] >> 4)];
+            }
+        };
+
+        auto removeRow = [&](const uint8_t* aRow)
+        {
+            for (size_t col = 0; col < aWidth; ++col)
+            {
+                --fine_columns[col * fine_bins + aRow[col]];
+                --coarse_columns[col * coarse_bins + (aRow[col] >> 4)];
+            }
+        };
+
+        for (ptrdiff_t l = -radius; l <= radius; ++l)
+        {
+            addRow(anInput + clampIndex(ptrdiff_t(first_row) + l, aHeight) * aWidth);
+        }
+
+        // The histogram of the window. The fine bins of a coarse bin are up
+        // to date for the pixel updated[bin].
+        uint32_t coarse[coarse_bins];
+        uint32_t fine[coarse_bins][fine_bins / coarse_bins];
+        ptrdiff_t updated[coarse_bins];
+
+        for (size_t row = first_row; row < last_row; ++row)
+        {
+            // Move the histograms of the columns down
+            if (row > first_row)
+            {
+                removeRow(anInput + clampIndex(ptrdiff_t(row) - radius - 1, aHeight) * aWidth);
+                addRow(anInput + clampIndex(ptrdiff_t(row) + radius, aHeight) * aWidth);
+            }
+
+            // The coarse bins of the window of the first pixel
+            std::fill(coarse, coarse + coarse_bins, 0);
+            for (ptrdiff_t k = -radius; k <= radius; ++k)
+            {
+                const uint16_t* p_column = &coarse_columns[clampIndex(k, aWidth) * coarse_bins];
+                for (size_t bin = 0; bin < coarse_bins; ++bin) coarse[bin] += p_column[bin];
+            }
+
+            // No fine bin is up to date
+            std::fill(updated, updated + coarse_bins, -window);
+
+            uint8_t* p_output_row = anOutput + row * aWidth;
+            for (ptrdiff_t col = 0; col < ptrdiff_t(aWidth); ++col)
+            {
+                // Move the coarse bins of the window right
+                if (col)
+                {
+                    const uint16_t* p_in = &coarse_columns[clampIndex(col + radius, aWidth) * coarse_bins];
+                    const uint16_t* p_out = &coarse_columns[clampIndex(col - radius - 1, aWidth) * coarse_bins];
+                    for (size_t bin = 0; bin < coarse_bins; ++bin) coarse[bin] += p_in[bin] - p_out[bin];
+                }
+
+                // The coarse bin of the median
+                size_t count = 0;
+                size_t bin = 0;
+                while (count + coarse[bin] <= rank) count += coarse[bin++];
+
+                // Update its fine bins: from scratch if the window has moved
+                // by 2r + 1 columns or more, or column by column
+                uint32_t* p_fine = fine[bin];
+                const size_t offset = bin * (fine_bins / coarse_bins);
+                if (col - updated[bin] >= window)
+                {
+                    std::fill(p_fine, p_fine + fine_bins / coarse_bins, 0);
+                    for (ptrdiff_t k = col - radius; k <= col + radius; ++k)
+                    {
+                        const uint16_t* p_column = &fine_columns[clampIndex(k, aWidth) * fine_bins + offset];
+                        for (size_t i = 0; i < fine_bins / coarse_bins; ++i) p_fine[i] += p_column[i];
+                    }
+                }
+                else
+                {
+                    for (ptrdiff_t k = updated[bin] + 1; k <= col; ++k)
+                    {
+                        const uint16_t* p_in = &fine_columns[clampIndex(k + radius, aWidth) * fine_bins + offset];
+                        const uint16_t* p_out = &fine_columns[clampIndex(k - radius - 1, aWidth) * fine_bins + offset];
+                        for (size_t i = 0; i < fine_bins / coarse_bins; ++i) p_fine[i] += p_in[i] - p_out[i];
+                    }
+                }
+                updated[bin] = col;
+
+                // The median in the fine bins
+                size_t i = 0;
+                while (count + p_fine[i] <= rank) count += p_fine[i++];
+
+                p_output_row[col] = uint8_t(offset + i);
+            }
+        }
+    });
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------
+void medianFilter(const uint8_t* anInput, size_t aWidth, size_t aHeight,
+                  unsigned int aRadius, uint8_t* anOutput)
+//-----------------------------------------------------------------------
+{
+    // The histograms of the columns would overflow
+    checkRadius(__FUNCTION__, __LINE__, aRadius);
+
+    if (!aWidth || !aHeight) return;
+
+    if (!aRadius)
+    {
+        std::copy(anInput, anInput + aWidth * aHeight, anOutput);
+    }
+    else if (aRadius <= 2)
+    {
+        medianNetworkFilter(anInput, aWidth, aHeight, aRadius, anOutput);
+    }
+    else
+    {
+        medianHistogramFilter(anInput, aWidth, aHeight, aRadius, anOutput);
+    }
+}
+
+
+//-------------------------------------------------------------------
+void medianFilter(const float* anInput, size_t aWidth, size_t aHeight,
+                  unsigned int aRadius, float* anOutput)
+//-------------------------------------------------------------------
+{
+    checkRadius(__FUNCTION__, __LINE__, aRadius);
+
+    if (!aWidth || !aHeight) return;
+
+    const ptrdiff_t radius = aRadius;
+    const size_t window = 2 * aRadius + 1;
+
+    // The rows are independent: they are computed in parallel
+    ThreadPool::getInstance().run(aHeight, [&](size_t aRow)
+    {
+        std::vector<float> values(window * window);
+        std::vector<const float*> p_input_rows(window);
+        for (size_t j = 0; j < window; ++j)
+        {
+            p_input_rows[j] = anInput + clampIndex(ptrdiff_t(aRow + j) - radius, aHeight) * aWidth;
+        }
+
+        float* p_output_row = anOutput + aRow * aWidth;
+        for (size_t col = 0; col < aWidth; ++col)
+        {
+            // Gather the window, then select its median
+            size_t count = 0;
+            for (size_t j = 0; j < window; ++j)
+            {
+                for (ptrdiff_t i = ptrdiff_t(col) - radius; i <= ptrdiff_t(col) + radius; ++i)
+                {
+                    values[count++] = p_input_rows[j][clampIndex(i, aWidth)];
+                }
+            }
+
+            std::nth_element(values.begin(), values.begin() + count / 2, values.end());
+            p_output_row[col] = values[count / 2];
+        }
+    });
+}
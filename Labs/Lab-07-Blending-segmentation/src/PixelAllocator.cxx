@@ -0,0 +1,268 @@
+#include <cstdlib>      // posix_memalign, free
+#include <new>          // std::bad_alloc
+
+#ifdef _WIN32
+#include <malloc.h>     // _aligned_malloc, _aligned_free
+#endif
+
+#include <atomic>
+
+#include "PixelAllocator.h"
+
+
+namespace
+{
+
+// The allocator of the current thread, set by the innermost ScopedPixelAllocator
+thread_local const std::shared_ptr<PixelAllocator>* p_current_allocator = 0;
+
+// Protect the default allocator
+std::mutex default_allocator_mutex;
+
+// Incremented when the default allocator changes
+std::atomic<size_t> default_allocator_version(0);
+
+// The copy of the default allocator of the current thread, and its version
+thread_local std::shared_ptr<PixelAllocator> thread_default_allocator;
+thread_local size_t thread_default_allocator_version = size_t(-1);
+
+
+//------------------------------------------------------------------------------
+/// Accessor on the default allocator (protected by default_allocator_mutex)
+//------------------------------------------------------------------------------
+std::shared_ptr<PixelAllocator>& getDefaultPixelAllocator()
+{
+    static std::shared_ptr<PixelAllocator> allocator(std::make_shared<BufferPool>());
+    return allocator;
+}
+
+
+//------------------------------------------------------------------------------
+/// Allocate an aligned block from the heap
+//------------------------------------------------------------------------------
+void* allocateAligned(size_t aSize)
+{
+#ifdef _WIN32
+    void* p_block = _aligned_malloc(aSize, PIXEL_ALIGNMENT);
+#else
+    void* p_block = 0;
+    if (posix_memalign(&p_block, PIXEL_ALIGNMENT, aSize)) p_block = 0;
+#endif
+
+    if (!p_block) throw std::bad_alloc();
+    return p_block;
+}
+
+
+//------------------------------------------------------------------------------
+/// Release a block allocated by allocateAligned()
+//------------------------------------------------------------------------------
+void deallocateAligned(void* aBlock)
+{
+#ifdef _WIN32
+    _aligned_free(aBlock);
+#else
+    free(aBlock);
+#endif
+}
+
+} // namespace
+
+
+//-------------------------------
+PixelAllocator::~PixelAllocator()
+//-------------------------------
+{}
+
+
+//--------------------------------------------
+void* AlignedAllocator::allocate(size_t aSize)
+//--------------------------------------------
+{
+    return allocateAligned(aSize);
+}
+
+
+//-----------------------------------------------------
+void AlignedAllocator::deallocate(void* aBlock, size_t)
+//-----------------------------------------------------
+{
+    deallocateAligned(aBlock);
+}
+
+
+//------------------------------------------------
+BufferPool::BufferPool(size_t aMaximumCachedSize):
+//------------------------------------------------
+    m_cached_size(0),
+    m_maximum_cached_size(aMaximumCachedSize)
+//------------------------------------------------
+{}
+
+
+//-----------------------
+BufferPool::~BufferPool()
+//-----------------------
+{
+    release();
+}
+
+
+//--------------------------------------
+void* BufferPool::allocate(size_t aSize)
+//--------------------------------------
+{
+    size_t size_class = getSizeClass(aSize);
+
+    // Reuse a released block of the same class if any
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::map<size_t, std::vector<void*> >::iterator free_list = m_free_lists.find(size_class);
+        if (free_list != m_free_lists.end() && free_list->second.size())
+        {
+            void* p_block = free_list->second.back();
+            free_list->second.pop_back();
+            m_cached_size -= size_class;
+            return p_block;
+        }
+    }
+
+    return allocateAligned(size_class);
+}
+
+
+//-----------------------------------------------------
+void BufferPool::deallocate(void* aBlock, size_t aSize)
+//-----------------------------------------------------
+{
+    size_t size_class = getSizeClass(aSize);
+
+    // Keep the block if there is room in the cache
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_cached_size + size_class <= m_maximum_cached_size)
+        {
+            m_free_lists[size_class].push_back(aBlock);
+            m_cached_size += size_class;
+            return;
+        }
+    }
+
+    deallocateAligned(aBlock);
+}
+
+
+//------------------------
+void BufferPool::release()
+//------------------------
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (std::map<size_t, std::vector<void*> >::iterator free_list = m_free_lists.begin();
+        free_list != m_free_lists.end();
+        ++free_list)
+    {
+        for (size_t i = 0; i < free_list->second.size(); ++i)
+        {
+            deallocateAligned(free_list->second[i]);
+        }
+    }
+
+    m_free_lists.clear();
+    m_cached_size = 0;
+}
+
+
+//-------------------------------------------------
+void BufferPool::setMaximumCachedSize(size_t aSize)
+//-------------------------------------------------
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_maximum_cached_size = aSize;
+
+    // Release the largest blocks first until the cache fits
+    while (m_cached_size > m_maximum_cached_size)
+    {
+        std::map<size_t, std::vector<void*> >::iterator free_list = --m_free_lists.end();
+        while (free_list->second.size() && m_cached_size > m_maximum_cached_size)
+        {
+            deallocateAligned(free_list->second.back());
+            free_list->second.pop_back();
+            m_cached_size -= free_list->first;
+        }
+        if (free_list->second.empty()) m_free_lists.erase(free_list);
+    }
+}
+
+
+//--------------------------------------
+size_t BufferPool::getCachedSize() const
+//--------------------------------------
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_cached_size;
+}
+
+
+//-------------------------------------------
+size_t BufferPool::getSizeClass(size_t aSize)
+//-------------------------------------------
+{
+    size_t size = aSize > PIXEL_ALIGNMENT ? aSize : PIXEL_ALIGNMENT;
+
+    // The largest power of two that is not greater than the size
+    size_t power_of_two = 1;
+    while (power_of_two <= size / 2) power_of_two *= 2;
+
+    // Four classes between two powers of two
+    size_t step = power_of_two / 4;
+    return (size + step - 1) / step * step;
+}
+
+
+//--------------------------------------------------------
+const std::shared_ptr<PixelAllocator>& getPixelAllocator()
+//--------------------------------------------------------
+{
+    if (p_current_allocator) return *p_current_allocator;
+
+    // The default allocator has changed since the last copy
+    if (thread_default_allocator_version != default_allocator_version.load(std::memory_order_acquire))
+    {
+        std::lock_guard<std::mutex> lock(default_allocator_mutex);
+        thread_default_allocator = getDefaultPixelAllocator();
+        thread_default_allocator_version = default_allocator_version;
+    }
+
+    return thread_default_allocator;
+}
+
+
+//-------------------------------------------------------------------------------
+void setDefaultPixelAllocator(const std::shared_ptr<PixelAllocator>& anAllocator)
+//-------------------------------------------------------------------------------
+{
+    std::lock_guard<std::mutex> lock(default_allocator_mutex);
+    getDefaultPixelAllocator() = anAllocator;
+    ++default_allocator_version;
+}
+
+
+//---------------------------------------------------------------------------------------------
+ScopedPixelAllocator::ScopedPixelAllocator(const std::shared_ptr<PixelAllocator>& anAllocator):
+//---------------------------------------------------------------------------------------------
+    m_allocator(anAllocator),
+    m_p_previous_allocator(p_current_allocator)
+//---------------------------------------------------------------------------------------------
+{
+    p_current_allocator = &m_allocator;
+}
+
+
+//-------------------------------------------
+ScopedPixelAllocator::~ScopedPixelAllocator()
+//-------------------------------------------
+{
+    p_current_allocator = m_p_previous_allocator;
+}
@@ -0,0 +1,171 @@
+#include <cmath>
+
+#if defined(HAS_X86_KERNELS) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "PixelKernelsImpl.h"
+
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+/// Plain floats, used when no SIMD instruction set is available
+//------------------------------------------------------------------------------
+struct ScalarTraits
+{
+    typedef float type;
+    enum { width = 1 };
+
+    static type load(const float* p) { return *p; }
+    static void store(float* p, type a) { *p = a; }
+    static type set(float a) { return a; }
+    static type add(type a, type b) { return a + b; }
+    static type subtract(type a, type b) { return a - b; }
+    static type multiply(type a, type b) { return a * b; }
+    static type divide(type a, type b) { return a / b; }
+    static type minimum(type a, type b) { return a < b ? a : b; }
+    static type maximum(type a, type b) { return a > b ? a : b; }
+    static type absoluteValue(type a) { return std::fabs(a); }
+    static type squareRoot(type a) { return std::sqrt(a); }
+
+    static type load(const uint8_t* p) { return *p; }
+    static type load(const uint16_t* p) { return *p; }
+    static void store(uint8_t* p, type a) { *p = uint8_t(std::nearbyint(a)); }
+    static void store(uint16_t* p, type a) { *p = uint16_t(std::nearbyint(a)); }
+};
+
+
+//------------------------------------------------------------------------------
+/// Query the CPU (and the OS for the AVX registers) using CPUID
+//------------------------------------------------------------------------------
+SIMDLevel detectSIMDLevel()
+{
+#if defined(HAS_X86_KERNELS) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int number_of_ids = info[0];
+
+    __cpuid(info, 1);
+    bool has_sse2 = (info[3] & (1 << 26)) != 0;
+    bool has_osxsave = (info[2] & (1 << 27)) != 0;
+    bool has_avx = (info[2] & (1 << 28)) != 0;
+
+    bool has_avx2 = false;
+    bool has_avx512 = false;
+    if (has_osxsave && has_avx && number_of_ids >= 7)
+    {
+        unsigned long long xcr0 = _xgetbv(0);
+
+        __cpuidex(info, 7, 0);
+        has_avx2 = (xcr0 & 0x06) == 0x06 && (info[1] & (1 << 5)) != 0;
+        has_avx512 = (xcr0 & 0xe6) == 0xe6 && (info[1] & (1 << 16)) != 0;
+    }
+
+    if (has_avx512) return SIMD_AVX512;
+    if (has_avx2) return SIMD_AVX2;
+    if (has_sse2) return SIMD_SSE2;
+#elif defined(HAS_X86_KERNELS) && defined(__GNUC__)
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f")) return SIMD_AVX512;
+    if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+    if (__builtin_cpu_supports("sse2")) return SIMD_SSE2;
+#endif
+
+    return SIMD_SCALAR;
+}
+
+
+//------------------------------------------------------------------------------
+/// The kernels of each instruction set, created once
+//------------------------------------------------------------------------------
+struct PixelKernelsTable
+{
+    PixelKernelsTable():
+        m_supported_level(detectSIMDLevel())
+    {
+        m_kernels[SIMD_SCALAR] = createPixelKernels<ScalarTraits, ScalarTraits>("Scalar", SIMD_SCALAR);
+
+#ifdef HAS_X86_KERNELS
+        m_kernels[SIMD_SSE2] = createSSE2PixelKernels();
+        m_kernels[SIMD_AVX2] = createAVX2PixelKernels();
+        m_kernels[SIMD_AVX512] = createAVX512PixelKernels();
+#endif
+    }
+
+    SIMDLevel m_supported_level;
+    PixelKernels m_kernels[SIMD_AVX512 + 1];
+};
+
+
+const PixelKernelsTable& getPixelKernelsTable()
+{
+    // Thread-safe initialisation (C++11)
+    static const PixelKernelsTable table;
+    return table;
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------------
+void mergeStatistics(PixelStatistics& aStatistics, const PixelStatistics& anOtherSet)
+//-----------------------------------------------------------------------------------
+{
+    // Nothing to merge
+    if (!anOtherSet.count) return;
+
+    // The first set is empty
+    if (!aStatistics.count)
+    {
+        aStatistics = anOtherSet;
+        return;
+    }
+
+    double count_a = double(aStatistics.count);
+    double count_b = double(anOtherSet.count);
+    double count = count_a + count_b;
+    double delta = anOtherSet.mean - aStatistics.mean;
+
+    if (aStatistics.min > anOtherSet.min) aStatistics.min = anOtherSet.min;
+    if (aStatistics.max < anOtherSet.max) aStatistics.max = anOtherSet.max;
+
+    aStatistics.mean += delta * count_b / count;
+    aStatistics.sum_of_squares += anOtherSet.sum_of_squares + delta * delta * count_a * count_b / count;
+    aStatistics.count += anOtherSet.count;
+}
+
+
+//-------------------------------
+SIMDLevel getSupportedSIMDLevel()
+//-------------------------------
+{
+    return getPixelKernelsTable().m_supported_level;
+}
+
+
+//-----------------------------------
+const PixelKernels& getPixelKernels()
+//-----------------------------------
+{
+    const PixelKernelsTable& table = getPixelKernelsTable();
+    return table.m_kernels[table.m_supported_level];
+}
+
+
+//---------------------------------------------------
+const PixelKernels* getPixelKernels(SIMDLevel aLevel)
+//---------------------------------------------------
+{
+    const PixelKernelsTable& table = getPixelKernelsTable();
+
+    // The instruction set is not supported by the CPU
+    if (aLevel > table.m_supported_level)
+    {
+        return 0;
+    }
+
+    return &table.m_kernels[aLevel];
+}
@@ -0,0 +1,65 @@
+// This file must be compiled with AVX2 enabled (e.g. -mavx2)
+#include <immintrin.h>
+
+#include "PixelKernelsImpl.h"
+
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+/// 8 floats in an AVX register
+//------------------------------------------------------------------------------
+struct AVX2Traits
+{
+    typedef __m256 type;
+    enum { width = 8 };
+
+    static type load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, type a) { _mm256_storeu_ps(p, a); }
+    static type set(float a) { return _mm256_set1_ps(a); }
+    static type add(type a, type b) { return _mm256_add_ps(a, b); }
+    static type subtract(type a, type b) { return _mm256_sub_ps(a, b); }
+    static type multiply(type a, type b) { return _mm256_mul_ps(a, b); }
+    static type divide(type a, type b) { return _mm256_div_ps(a, b); }
+    static type minimum(type a, type b) { return _mm256_min_ps(a, b); }
+    static type maximum(type a, type b) { return _mm256_max_ps(a, b); }
+    static type absoluteValue(type a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+    static type squareRoot(type a) { return _mm256_sqrt_ps(a); }
+
+    static type load(const uint8_t* p)
+    {
+        __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+        return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+    }
+
+    static type load(const uint16_t* p)
+    {
+        __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(words));
+    }
+
+    static void store(uint8_t* p, type a)
+    {
+        __m256i integers = _mm256_cvtps_epi32(a);
+        __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(integers), _mm256_extracti128_si256(integers, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packus_epi16(words, words));
+    }
+
+    static void store(uint16_t* p, type a)
+    {
+        __m256i integers = _mm256_cvtps_epi32(a);
+        __m128i words = _mm_packus_epi32(_mm256_castsi256_si128(integers), _mm256_extracti128_si256(integers, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), words);
+    }
+};
+
+} // namespace
+
+
+//-----------------------------------
+PixelKernels createAVX2PixelKernels()
+//-----------------------------------
+{
+    return createPixelKernels<AVX2Traits, SSEScalarTraits>("AVX2", SIMD_AVX2);
+}
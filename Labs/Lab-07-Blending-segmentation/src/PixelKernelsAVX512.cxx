@@ -0,0 +1,61 @@
+// This file must be compiled with AVX-512F enabled (e.g. -mavx512f)
+#include <immintrin.h>
+
+#include "PixelKernelsImpl.h"
+
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+/// 16 floats in an AVX-512 register
+//------------------------------------------------------------------------------
+struct AVX512Traits
+{
+    typedef __m512 type;
+    enum { width = 16 };
+
+    static type load(const float* p) { return _mm512_loadu_ps(p); }
+    static void store(float* p, type a) { _mm512_storeu_ps(p, a); }
+    static type set(float a) { return _mm512_set1_ps(a); }
+    static type add(type a, type b) { return _mm512_add_ps(a, b); }
+    static type subtract(type a, type b) { return _mm512_sub_ps(a, b); }
+    static type multiply(type a, type b) { return _mm512_mul_ps(a, b); }
+    static type divide(type a, type b) { return _mm512_div_ps(a, b); }
+    static type minimum(type a, type b) { return _mm512_min_ps(a, b); }
+    static type maximum(type a, type b) { return _mm512_max_ps(a, b); }
+    static type absoluteValue(type a) { return _mm512_abs_ps(a); }
+    static type squareRoot(type a) { return _mm512_sqrt_ps(a); }
+
+    static type load(const uint8_t* p)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        return _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(bytes));
+    }
+
+    static type load(const uint16_t* p)
+    {
+        __m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        return _mm512_cvtepi32_ps(_mm512_cvtepu16_epi32(words));
+    }
+
+    static void store(uint8_t* p, type a)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm512_cvtusepi32_epi8(_mm512_cvtps_epi32(a)));
+    }
+
+    static void store(uint16_t* p, type a)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm512_cvtusepi32_epi16(_mm512_cvtps_epi32(a)));
+    }
+};
+
+} // namespace
+
+
+//-------------------------------------
+PixelKernels createAVX512PixelKernels()
+//-------------------------------------
+{
+    return createPixelKernels<AVX512Traits, SSEScalarTraits>("AVX-512", SIMD_AVX512);
+}
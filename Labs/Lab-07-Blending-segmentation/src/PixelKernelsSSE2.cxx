@@ -0,0 +1,73 @@
+// This file must be compiled with SSE2 enabled (e.g. -msse2)
+#include <emmintrin.h>
+#include <cstring>      // std::memcpy
+
+#include "PixelKernelsImpl.h"
+
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+/// 4 floats in a SSE register
+//------------------------------------------------------------------------------
+struct SSE2Traits
+{
+    typedef __m128 type;
+    enum { width = 4 };
+
+    static type load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, type a) { _mm_storeu_ps(p, a); }
+    static type set(float a) { return _mm_set1_ps(a); }
+    static type add(type a, type b) { return _mm_add_ps(a, b); }
+    static type subtract(type a, type b) { return _mm_sub_ps(a, b); }
+    static type multiply(type a, type b) { return _mm_mul_ps(a, b); }
+    static type divide(type a, type b) { return _mm_div_ps(a, b); }
+    static type minimum(type a, type b) { return _mm_min_ps(a, b); }
+    static type maximum(type a, type b) { return _mm_max_ps(a, b); }
+    static type absoluteValue(type a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+    static type squareRoot(type a) { return _mm_sqrt_ps(a); }
+
+    static type load(const uint8_t* p)
+    {
+        int bytes;
+        std::memcpy(&bytes, p, 4);
+        __m128i zero = _mm_setzero_si128();
+        __m128i words = _mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero);
+        return _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+    }
+
+    static type load(const uint16_t* p)
+    {
+        __m128i words = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+        return _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, _mm_setzero_si128()));
+    }
+
+    static void store(uint8_t* p, type a)
+    {
+        __m128i integers = _mm_cvtps_epi32(a);
+        __m128i words = _mm_packs_epi32(integers, integers);
+        int bytes = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+        std::memcpy(p, &bytes, 4);
+    }
+
+    // There is no unsigned saturation from 32 to 16 bits in SSE2: shift the
+    // values to the signed range, and back
+    static void store(uint16_t* p, type a)
+    {
+        __m128i integers = _mm_sub_epi32(_mm_cvtps_epi32(a), _mm_set1_epi32(32768));
+        __m128i words = _mm_packs_epi32(integers, integers);
+        words = _mm_xor_si128(words, _mm_set1_epi16(-32768));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(p), words);
+    }
+};
+
+} // namespace
+
+
+//-----------------------------------
+PixelKernels createSSE2PixelKernels()
+//-----------------------------------
+{
+    return createPixelKernels<SSE2Traits, SSEScalarTraits>("SSE2", SIMD_SSE2);
+}
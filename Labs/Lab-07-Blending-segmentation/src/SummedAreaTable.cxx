@@ -0,0 +1,341 @@
+#include <sstream>
+#include <stdexcept>    // std::out_of_range, std::logic_error
+#include <algorithm>    // std::min, std::max, std::fill_n
+
+#include "SummedAreaTable.h"
+#include "ThreadPool.h"
+
+
+namespace
+{
+
+// The number of columns of a block of the vertical pass (a few cache lines)
+const size_t column_block_width = 64;
+
+
+//------------------------------------------------------------------------------
+/// Throw an exception with a nice error message
+//------------------------------------------------------------------------------
+template<typename ExceptionT>
+void throwError(const char* aFunction, int aLine, const std::string& aMessage)
+{
+    // Format a nice error message
+    std::stringstream error_message;
+    error_message << "ERROR:" << std::endl;
+    error_message << "\tin File:" << __FILE__ << std::endl;
+    error_message << "\tin Function:" << aFunction << std::endl;
+    error_message << "\tat Line:" << aLine << std::endl;
+    error_message << "\tMESSAGE: " << aMessage << std::endl;
+
+    // Throw an exception
+    throw ExceptionT(error_message.str());
+}
+
+
+//------------------------------------------------------------------------------
+/// A range of rows (or columns) of the image, used a number of times
+//------------------------------------------------------------------------------
+struct Span
+{
+    size_t first;   //< The first index
+    size_t last;    //< The index after the last one
+    size_t count;   //< The number of times it is used
+};
+
+
+//------------------------------------------------------------------------------
+/// Split a range of coordinates into the spans of the image that it uses: the
+/// first index (for the coordinates before the image), the indices inside the
+/// image, and the last index (for the coordinates after the image). Only the
+/// inside span is kept with BORDER_ZERO.
+//------------------------------------------------------------------------------
+size_t getSpans(ptrdiff_t aStart, size_t aLength, size_t aSize, BorderMode aBorderMode, Span* aSpans)
+{
+    ptrdiff_t end = aStart + ptrdiff_t(aLength);
+    ptrdiff_t size = aSize;
+    size_t number_of_spans = 0;
+
+    ptrdiff_t before = std::min(end, ptrdiff_t(0)) - aStart;
+    if (aBorderMode == BORDER_EXTEND && before > 0)
+    {
+        Span span = {0, 1, size_t(before)};
+        aSpans[number_of_spans++] = span;
+    }
+
+    ptrdiff_t first = std::max(aStart, ptrdiff_t(0));
+    ptrdiff_t last = std::min(end, size);
+    if (first < last)
+    {
+        Span span = {size_t(first), size_t(last), 1};
+        aSpans[number_of_spans++] = span;
+    }
+
+    ptrdiff_t after = end - std::max(aStart, size);
+    if (aBorderMode == BORDER_EXTEND && after > 0)
+    {
+        Span span = {aSize - 1, aSize, size_t(after)};
+        aSpans[number_of_spans++] = span;
+    }
+
+    return number_of_spans;
+}
+
+
+//------------------------------------------------------------------------------
+/// Build the table of an image: sums of the rows in parallel, then sums of the
+/// columns in parallel (by blocks of columns). The first row and the first
+/// column of the table are zeros.
+//------------------------------------------------------------------------------
+void buildTable(const float* aPixels, size_t aWidth, size_t aHeight, bool aSquaresFlag, double* aTable)
+{
+    size_t table_width = aWidth + 1;
+
+    std::fill_n(aTable, table_width, 0.0);
+
+    ThreadPool::getInstance().run(aHeight, [&](size_t aRow)
+    {
+        const float* p_input = aPixels + aRow * aWidth;
+        double* p_output = aTable + (aRow + 1) * table_width;
+
+        double sum = 0.0;
+        p_output[0] = 0.0;
+        for (size_t col = 0; col < aWidth; ++col)
+        {
+            double pixel = p_input[col];
+            sum += aSquaresFlag ? pixel * pixel : pixel;
+            p_output[col + 1] = sum;
+        }
+    });
+
+    size_t number_of_blocks = (table_width + column_block_width - 1) / column_block_width;
+    ThreadPool::getInstance().run(number_of_blocks, [&](size_t aBlock)
+    {
+        size_t first_col = aBlock * column_block_width;
+        size_t last_col = std::min(first_col + column_block_width, table_width);
+
+        for (size_t row = 1; row <= aHeight; ++row)
+        {
+            const double* p_previous = aTable + (row - 1) * table_width;
+            double* p_current = aTable + row * table_width;
+            for (size_t col = first_col; col < last_col; ++col)
+            {
+                p_current[col] += p_previous[col];
+            }
+        }
+    });
+}
+
+} // namespace
+
+
+//---------------------------------
+SummedAreaTable::SummedAreaTable():
+//---------------------------------
+    m_width(0),
+    m_height(0)
+//---------------------------------
+{}
+
+
+//------------------------------------------------------------------------
+SummedAreaTable::SummedAreaTable(const Image& anImage, bool aSquaresFlag):
+//------------------------------------------------------------------------
+    m_width(0),
+    m_height(0)
+//------------------------------------------------------------------------
+{
+    create(anImage, aSquaresFlag);
+}
+
+
+//-------------------------------------------------------------------
+void SummedAreaTable::create(const Image& anImage, bool aSquaresFlag)
+//-------------------------------------------------------------------
+{
+    m_width = anImage.getWidth();
+    m_height = anImage.getHeight();
+
+    size_t table_size = (m_width + 1) * (m_height + 1);
+    m_sums.resize(table_size);
+    m_squares.resize(aSquaresFlag ? table_size : 0);
+
+    buildTable(anImage.getPixelPointer(), m_width, m_height, false, &m_sums[0]);
+
+    if (aSquaresFlag)
+    {
+        buildTable(anImage.getPixelPointer(), m_width, m_height, true, &m_squares[0]);
+    }
+}
+
+
+//--------------------------------------
+size_t SummedAreaTable::getWidth() const
+//--------------------------------------
+{
+    return m_width;
+}
+
+
+//---------------------------------------
+size_t SummedAreaTable::getHeight() const
+//---------------------------------------
+{
+    return m_height;
+}
+
+
+//------------------------------------------------------------
+double SummedAreaTable::getSum(ptrdiff_t aCol, ptrdiff_t aRow,
+                               size_t aWidth, size_t aHeight,
+                               BorderMode aBorderMode) const
+//------------------------------------------------------------
+{
+    return getSum(m_sums, aCol, aRow, aWidth, aHeight, aBorderMode);
+}
+
+
+//---------------------------------------------------------------------
+double SummedAreaTable::getSumOfSquares(ptrdiff_t aCol, ptrdiff_t aRow,
+                                        size_t aWidth, size_t aHeight,
+                                        BorderMode aBorderMode) const
+//---------------------------------------------------------------------
+{
+    if (m_squares.empty() && m_width && m_height)
+    {
+        throwError<std::logic_error>(__FUNCTION__, __LINE__, "The sums of the squared pixels have not been computed.");
+    }
+
+    return getSum(m_squares, aCol, aRow, aWidth, aHeight, aBorderMode);
+}
+
+
+//----------------------------------------------------------------------------------
+Image SummedAreaTable::boxFilter(unsigned int aRadius, BorderMode aBorderMode) const
+//----------------------------------------------------------------------------------
+{
+    return filter(aRadius, aBorderMode, false);
+}
+
+
+//--------------------------------------------------------------------------------------
+Image SummedAreaTable::localVariance(unsigned int aRadius, BorderMode aBorderMode) const
+//--------------------------------------------------------------------------------------
+{
+    if (m_squares.empty() && m_width && m_height)
+    {
+        throwError<std::logic_error>(__FUNCTION__, __LINE__, "The sums of the squared pixels have not been computed.");
+    }
+
+    return filter(aRadius, aBorderMode, true);
+}
+
+
+//---------------------------------------------------------------
+double SummedAreaTable::getSum(const PixelBuffer<double>& aTable,
+                               ptrdiff_t aCol, ptrdiff_t aRow,
+                               size_t aWidth, size_t aHeight,
+                               BorderMode aBorderMode) const
+//---------------------------------------------------------------
+{
+    if (aBorderMode == BORDER_CROP &&
+        (aCol < 0 || aRow < 0 ||
+         size_t(aCol) + aWidth > m_width || size_t(aRow) + aHeight > m_height))
+    {
+        throwError<std::out_of_range>(__FUNCTION__, __LINE__, "The rectangle is not inside the image.");
+    }
+
+    if (!aWidth || !aHeight || !m_width || !m_height) return 0.0;
+
+    // Each pair of spans (rows and columns) is a rectangle of the image,
+    // used a number of times
+    Span col_spans[3];
+    Span row_spans[3];
+    size_t number_of_col_spans = getSpans(aCol, aWidth, m_width, aBorderMode, col_spans);
+    size_t number_of_row_spans = getSpans(aRow, aHeight, m_height, aBorderMode, row_spans);
+
+    size_t table_width = m_width + 1;
+    double sum = 0.0;
+    for (size_t j = 0; j < number_of_row_spans; ++j)
+    {
+        const double* p_top = &aTable[row_spans[j].first * table_width];
+        const double* p_bottom = &aTable[row_spans[j].last * table_width];
+
+        for (size_t i = 0; i < number_of_col_spans; ++i)
+        {
+            size_t left = col_spans[i].first;
+            size_t right = col_spans[i].last;
+
+            sum += double(row_spans[j].count * col_spans[i].count) *
+                (p_bottom[right] - p_bottom[left] - p_top[right] + p_top[left]);
+        }
+    }
+
+    return sum;
+}
+
+
+//---------------------------------------------------------------------------------------------------
+Image SummedAreaTable::filter(unsigned int aRadius, BorderMode aBorderMode, bool aVarianceFlag) const
+//---------------------------------------------------------------------------------------------------
+{
+    size_t window = 2 * size_t(aRadius) + 1;
+    double number_of_pixels = double(window) * double(window);
+
+    size_t output_width;
+    size_t output_height;
+    getConvolutionSize(m_width, m_height, window, window, aBorderMode, output_width, output_height);
+
+    Image output(0.0f, output_width, output_height);
+    if (!output_width || !output_height) return output;
+
+    float* p_output = output.getPixelPointer();
+    ptrdiff_t offset = aBorderMode == BORDER_CROP ? 0 : aRadius;
+    size_t table_width = m_width + 1;
+
+    ThreadPool::getInstance().run(output_height, [&](size_t aRow)
+    {
+        ptrdiff_t row = ptrdiff_t(aRow) - offset;
+        bool inside_rows = row >= 0 && size_t(row) + window <= m_height;
+
+        for (size_t col = 0; col < output_width; ++col)
+        {
+            ptrdiff_t first_col = ptrdiff_t(col) - offset;
+            double sum;
+            double sum_of_squares = 0.0;
+
+            // Four look-ups inside the image, the spans near the border
+            if (inside_rows && first_col >= 0 && size_t(first_col) + window <= m_width)
+            {
+                size_t top = row * table_width + first_col;
+                size_t bottom = top + window * table_width;
+
+                sum = m_sums[bottom + window] - m_sums[bottom] - m_sums[top + window] + m_sums[top];
+                if (aVarianceFlag)
+                {
+                    sum_of_squares = m_squares[bottom + window] - m_squares[bottom] - m_squares[top + window] + m_squares[top];
+                }
+            }
+            else
+            {
+                sum = getSum(m_sums, first_col, row, window, window, aBorderMode);
+                if (aVarianceFlag)
+                {
+                    sum_of_squares = getSum(m_squares, first_col, row, window, window, aBorderMode);
+                }
+            }
+
+            double mean = sum / number_of_pixels;
+            if (aVarianceFlag)
+            {
+                // The rounding errors can give tiny negative values
+                p_output[aRow * output_width + col] = float(std::max(0.0, sum_of_squares / number_of_pixels - mean * mean));
+            }
+            else
+            {
+                p_output[aRow * output_width + col] = float(mean);
+            }
+        }
+    });
+
+    return output;
+}
@@ -0,0 +1,349 @@
+#include <stdexcept>    // std::logic_error
+
+#include "ThreadPool.h"
+
+
+namespace
+{
+
+// The default number of pixels of a tile (128 KB, i.e. in the L2 cache)
+const size_t default_tile_size = 1 << 15;
+
+// True in the worker threads, and in the caller while it runs tasks: a job
+// submitted from a task is run by the current thread
+thread_local bool is_running_tasks = false;
+
+
+//------------------------------------------------------------------------------
+/// Set is_running_tasks for the lifetime of the object, even if a task throws
+//------------------------------------------------------------------------------
+struct RunningTasksScope
+{
+    RunningTasksScope() { is_running_tasks = true; }
+    ~RunningTasksScope() { is_running_tasks = false; }
+};
+
+} // namespace
+
+
+//-----------------------------------
+ThreadPool& ThreadPool::getInstance()
+//-----------------------------------
+{
+    // Thread-safe initialisation (C++11)
+    static ThreadPool pool;
+    return pool;
+}
+
+
+//-----------------------
+ThreadPool::ThreadPool():
+//-----------------------
+    m_p_task(0),
+    m_job_id(0),
+    m_busy_workers(0),
+    m_stop(false),
+    m_remaining_tasks(0),
+    m_number_of_threads(0),
+    m_tile_size(default_tile_size)
+//-----------------------
+{
+    startThreads(std::thread::hardware_concurrency());
+}
+
+
+//-----------------------
+ThreadPool::~ThreadPool()
+//-----------------------
+{
+    stopThreads();
+}
+
+
+//----------------------------------------------------------
+void ThreadPool::setNumberOfThreads(size_t aNumberOfThreads)
+//----------------------------------------------------------
+{
+    // The job of the task would never end
+    if (is_running_tasks)
+    {
+        throw std::logic_error("ThreadPool::setNumberOfThreads cannot be called from a task");
+    }
+
+    // Wait for the job in progress
+    std::lock_guard<std::mutex> job_lock(m_job_mutex);
+
+    stopThreads();
+    startThreads(aNumberOfThreads ? aNumberOfThreads : std::thread::hardware_concurrency());
+}
+
+
+//-------------------------------------------
+size_t ThreadPool::getNumberOfThreads() const
+//-------------------------------------------
+{
+    return m_number_of_threads;
+}
+
+
+//--------------------------------------------------
+void ThreadPool::setTileSize(size_t aNumberOfPixels)
+//--------------------------------------------------
+{
+    m_tile_size = aNumberOfPixels ? aNumberOfPixels : default_tile_size;
+}
+
+
+//------------------------------------
+size_t ThreadPool::getTileSize() const
+//------------------------------------
+{
+    return m_tile_size;
+}
+
+
+//------------------------------------------------------------
+void ThreadPool::run(size_t aNumberOfTasks, const Task& aTask)
+//------------------------------------------------------------
+{
+    // Nothing to share between threads
+    if (aNumberOfTasks < 2 || is_running_tasks)
+    {
+        for (size_t i = 0; i < aNumberOfTasks; ++i)
+        {
+            aTask(i);
+        }
+        return;
+    }
+
+    // The threads cannot be changed until the end of the job
+    std::lock_guard<std::mutex> job_lock(m_job_mutex);
+
+    if (m_threads.empty())
+    {
+        RunningTasksScope scope;
+        for (size_t i = 0; i < aNumberOfTasks; ++i)
+        {
+            aTask(i);
+        }
+        return;
+    }
+
+    // Give a contiguous range of tasks to each thread
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_p_task = &aTask;
+        m_allocator = getPixelAllocator();
+        m_exception = std::exception_ptr();
+        m_remaining_tasks = aNumberOfTasks;
+
+        size_t number_of_queues = m_queues.size();
+        for (size_t i = 0; i < number_of_queues; ++i)
+        {
+            std::lock_guard<std::mutex> queue_lock(m_queues[i]->m_mutex);
+            m_queues[i]->m_first_task = aNumberOfTasks * i / number_of_queues;
+            m_queues[i]->m_last_task = aNumberOfTasks * (i + 1) / number_of_queues;
+        }
+
+        ++m_job_id;
+    }
+    m_start.notify_all();
+
+    // Work too
+    {
+        RunningTasksScope scope;
+        runTasks(0);
+    }
+
+    // Wait for the workers
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_remaining_tasks == 0 && m_busy_workers == 0; });
+    m_p_task = 0;
+    m_allocator.reset();
+
+    if (m_exception)
+    {
+        std::exception_ptr exception = m_exception;
+        m_exception = std::exception_ptr();
+        std::rethrow_exception(exception);
+    }
+}
+
+
+//------------------------------------------------------------------------
+void ThreadPool::runOnTiles(size_t aNumberOfPixels, const TileTask& aTask)
+//------------------------------------------------------------------------
+{
+    size_t tile_size = m_tile_size;
+    size_t number_of_tiles = (aNumberOfPixels + tile_size - 1) / tile_size;
+
+    run(number_of_tiles, [&](size_t aTile)
+    {
+        size_t first_pixel = aTile * tile_size;
+        size_t number_of_pixels = aNumberOfPixels - first_pixel < tile_size ?
+            aNumberOfPixels - first_pixel : tile_size;
+
+        aTask(first_pixel, number_of_pixels);
+    });
+}
+
+
+//----------------------------------------------------
+void ThreadPool::startThreads(size_t aNumberOfThreads)
+//----------------------------------------------------
+{
+    if (!aNumberOfThreads) aNumberOfThreads = 1;
+    m_number_of_threads = aNumberOfThreads;
+
+    m_stop = false;
+    m_queues.clear();
+    for (size_t i = 0; i < aNumberOfThreads; ++i)
+    {
+        m_queues.push_back(std::unique_ptr<TaskQueue>(new TaskQueue));
+        m_queues.back()->m_first_task = 0;
+        m_queues.back()->m_last_task = 0;
+    }
+
+    for (size_t i = 1; i < aNumberOfThreads; ++i)
+    {
+        m_threads.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+    }
+}
+
+
+//----------------------------
+void ThreadPool::stopThreads()
+//----------------------------
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_start.notify_all();
+
+    for (size_t i = 0; i < m_threads.size(); ++i)
+    {
+        m_threads[i].join();
+    }
+    m_threads.clear();
+}
+
+
+//-------------------------------------------
+void ThreadPool::workerLoop(size_t aThreadID)
+//-------------------------------------------
+{
+    is_running_tasks = true;
+    size_t job_id = 0;
+
+    while (true)
+    {
+        // Wait for a new job
+        std::shared_ptr<PixelAllocator> allocator;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [&]() { return m_stop || m_job_id != job_id; });
+
+            if (m_stop) return;
+
+            job_id = m_job_id;
+            allocator = m_allocator;
+            ++m_busy_workers;
+        }
+
+        // The buffers of the tasks come from the allocator of the caller (the
+        // job may already be over, without any task left)
+        {
+            ScopedPixelAllocator scope(allocator ? allocator : getPixelAllocator());
+            runTasks(aThreadID);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_busy_workers;
+        }
+        m_done.notify_all();
+    }
+}
+
+
+//-----------------------------------------
+void ThreadPool::runTasks(size_t aThreadID)
+//-----------------------------------------
+{
+    size_t task;
+    while (popTask(aThreadID, task) || stealTasks(aThreadID, task))
+    {
+        // m_p_task was set before the queues were filled, under their mutex
+        try
+        {
+            (*m_p_task)(task);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_exception) m_exception = std::current_exception();
+        }
+
+        // The last task is done
+        if (--m_remaining_tasks == 0)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done.notify_all();
+        }
+    }
+}
+
+
+//-------------------------------------------------------
+bool ThreadPool::popTask(size_t aThreadID, size_t& aTask)
+//-------------------------------------------------------
+{
+    TaskQueue& queue = *m_queues[aThreadID];
+    std::lock_guard<std::mutex> lock(queue.m_mutex);
+
+    if (queue.m_first_task == queue.m_last_task) return false;
+
+    aTask = queue.m_first_task++;
+    return true;
+}
+
+
+//----------------------------------------------------------
+bool ThreadPool::stealTasks(size_t aThreadID, size_t& aTask)
+//----------------------------------------------------------
+{
+    size_t number_of_queues = m_queues.size();
+    for (size_t i = 1; i < number_of_queues; ++i)
+    {
+        size_t first_task = 0;
+        size_t last_task = 0;
+
+        // Take the second half of the tasks of the victim
+        {
+            TaskQueue& victim = *m_queues[(aThreadID + i) % number_of_queues];
+            std::lock_guard<std::mutex> lock(victim.m_mutex);
+
+            size_t number_of_tasks = victim.m_last_task - victim.m_first_task;
+            if (!number_of_tasks) continue;
+
+            first_task = victim.m_last_task - (number_of_tasks + 1) / 2;
+            last_task = victim.m_last_task;
+            victim.m_last_task = first_task;
+        }
+
+        // Run the first one, keep the others. Only this thread adds tasks to
+        // its own queue, which is empty.
+        aTask = first_task;
+        {
+            TaskQueue& queue = *m_queues[aThreadID];
+            std::lock_guard<std::mutex> lock(queue.m_mutex);
+            queue.m_first_task = first_task + 1;
+            queue.m_last_task = last_task;
+        }
+        return true;
+    }
+
+    return false;
+}
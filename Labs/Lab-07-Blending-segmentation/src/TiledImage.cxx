@@ -0,0 +1,446 @@
+#include <sstream>
+#include <stdexcept>    // std::runtime_error, std::invalid_argument
+#include <cstring>      // std::memcpy
+#include <cstdint>      // uint16_t, uintptr_t, SIZE_MAX
+#include <algorithm>    // std::min, std::max, std::fill_n
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>      // open
+#include <unistd.h>     // close, ftruncate, sysconf
+#include <sys/mman.h>   // mmap, munmap, msync, madvise
+#include <sys/stat.h>   // fstat
+#endif
+
+#include "TiledImage.h"
+#include "ImageIO.h"
+
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+/// Throw an exception with a nice error message
+//------------------------------------------------------------------------------
+template<typename ExceptionT>
+void throwError(const char* aFunction, int aLine, const std::string& aMessage)
+{
+    // Format a nice error message
+    std::stringstream error_message;
+    error_message << "ERROR:" << std::endl;
+    error_message << "\tin File:" << __FILE__ << std::endl;
+    error_message << "\tin Function:" << aFunction << std::endl;
+    error_message << "\tat Line:" << aLine << std::endl;
+    error_message << "\tMESSAGE: " << aMessage << std::endl;
+
+    // Throw an exception
+    throw ExceptionT(error_message.str());
+}
+
+
+//------------------------------------------------------------------------------
+/// The index of the pixel of the image that is the closest to a coordinate
+//------------------------------------------------------------------------------
+size_t clampCoordinate(ptrdiff_t aCoordinate, size_t aSize)
+{
+    return aCoordinate < 0 ? 0 : std::min(size_t(aCoordinate), aSize - 1);
+}
+
+} // namespace
+
+
+//---------------------------------------------------------------------------------------------
+TiledImage::TiledImage(const char* aFilename, size_t aWidth, size_t aHeight, size_t aTileSize):
+//---------------------------------------------------------------------------------------------
+    m_p_data(0),
+    m_size(0),
+    m_p_pixels(0),
+    m_width(aWidth),
+    m_height(aHeight),
+    m_tile_size(std::max(aTileSize, size_t(1)))
+//---------------------------------------------------------------------------------------------
+{
+    if (!aWidth || !aHeight)
+    {
+        throwError<std::invalid_argument>(__FUNCTION__, __LINE__, "The image is empty.");
+    }
+
+    if (aWidth > (SIZE_MAX - RAW_HEADER_SIZE) / sizeof(float) / aHeight)
+    {
+        throwError<std::invalid_argument>(__FUNCTION__, __LINE__, "The image is too large.");
+    }
+
+    map(aFilename, RAW_HEADER_SIZE + aWidth * aHeight * sizeof(float));
+    writeRawHeader(m_p_data, SAMPLE_FLOAT, aWidth, aHeight);
+}
+
+
+//--------------------------------------------------------------
+TiledImage::TiledImage(const char* aFilename, size_t aTileSize):
+//--------------------------------------------------------------
+    m_p_data(0),
+    m_size(0),
+    m_p_pixels(0),
+    m_width(0),
+    m_height(0),
+    m_tile_size(std::max(aTileSize, size_t(1)))
+//--------------------------------------------------------------
+{
+    // Only the raw files of floats store the pixels as they are in memory
+    if (readFileFormat(aFilename) != FORMAT_RAW)
+    {
+        throwError<std::runtime_error>(__FUNCTION__, __LINE__, std::string("Not a raw file: ") + aFilename);
+    }
+
+    {
+        ImageFileReader reader(aFilename);
+        if (reader.getSampleType() != SAMPLE_FLOAT)
+        {
+            throwError<std::runtime_error>(__FUNCTION__, __LINE__, std::string("The pixels are not floats: ") + aFilename);
+        }
+
+        m_width = reader.getWidth();
+        m_height = reader.getHeight();
+    }
+
+    if (!m_width || !m_height)
+    {
+        throwError<std::invalid_argument>(__FUNCTION__, __LINE__, "The image is empty.");
+    }
+
+    map(aFilename, 0);
+}
+
+
+//-----------------------
+TiledImage::~TiledImage()
+//-----------------------
+{
+    if (m_p_data)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(m_p_data);
+#else
+        munmap(m_p_data, m_size);
+#endif
+    }
+}
+
+
+//---------------------------------
+size_t TiledImage::getWidth() const
+//---------------------------------
+{
+    return m_width;
+}
+
+
+//----------------------------------
+size_t TiledImage::getHeight() const
+//----------------------------------
+{
+    return m_height;
+}
+
+
+//------------------------------------
+size_t TiledImage::getTileSize() const
+//------------------------------------
+{
+    return m_tile_size;
+}
+
+
+//-------------------------------------------------------------
+Image TiledImage::readRegion(ptrdiff_t aColumn, ptrdiff_t aRow,
+                             size_t aWidth, size_t aHeight,
+                             BorderMode aBorderMode) const
+//-------------------------------------------------------------
+{
+    bool inside = aColumn >= 0 && aRow >= 0 &&
+        size_t(aColumn) + aWidth <= m_width && size_t(aRow) + aHeight <= m_height;
+
+    if (aBorderMode == BORDER_CROP && !inside)
+    {
+        throwError<std::invalid_argument>(__FUNCTION__, __LINE__, "The region is not inside the image.");
+    }
+
+    Image region(0.0f, aWidth, aHeight);
+    float* p_output = region.getPixelPointer();
+
+    // The columns of the region that are in the image
+    ptrdiff_t first_column = std::max(aColumn, ptrdiff_t(0));
+    ptrdiff_t last_column = std::min(aColumn + ptrdiff_t(aWidth), ptrdiff_t(m_width));
+    size_t left = size_t(std::min(first_column - aColumn, ptrdiff_t(aWidth)));
+    size_t middle = last_column > first_column ? size_t(last_column - first_column) : 0;
+
+    for (size_t i = 0; i < aHeight; ++i, p_output += aWidth)
+    {
+        ptrdiff_t row = aRow + ptrdiff_t(i);
+        bool outside_row = row < 0 || row >= ptrdiff_t(m_height);
+
+        // Padded with zeros
+        if (aBorderMode == BORDER_ZERO && outside_row) continue;
+
+        const float* p_input = m_p_pixels + clampCoordinate(row, m_height) * m_width;
+        if (middle)
+        {
+            std::memcpy(p_output + left, p_input + first_column, middle * sizeof(float));
+        }
+
+        // The closest pixels of the row
+        if (aBorderMode == BORDER_EXTEND)
+        {
+            std::fill_n(p_output, left, p_input[clampCoordinate(aColumn, m_width)]);
+            std::fill_n(p_output + left + middle, aWidth - left - middle, p_input[m_width - 1]);
+        }
+    }
+
+    return region;
+}
+
+
+//-----------------------------------------------------------------------------
+void TiledImage::writeRegion(const Image& anImage, size_t aColumn, size_t aRow)
+//-----------------------------------------------------------------------------
+{
+    if (aColumn + anImage.getWidth() > m_width || aRow + anImage.getHeight() > m_height)
+    {
+        throwError<std::invalid_argument>(__FUNCTION__, __LINE__, "The region is not inside the image.");
+    }
+
+    const float* p_input = anImage.getPixelPointer();
+    for (size_t i = 0; i < anImage.getHeight(); ++i)
+    {
+        std::memcpy(m_p_pixels + (aRow + i) * m_width + aColumn,
+                    p_input + i * anImage.getWidth(),
+                    anImage.getWidth() * sizeof(float));
+    }
+}
+
+
+//----------------------------------------------------------------------------------------------------
+void TiledImage::transform(TiledImage& anOutput, const TileOperation& anOperation, size_t aHalo) const
+//----------------------------------------------------------------------------------------------------
+{
+    if (anOutput.m_width != m_width || anOutput.m_height != m_height)
+    {
+        throwError<std::invalid_argument>(__FUNCTION__, __LINE__, "The images do not have the same size.");
+    }
+
+    // The tiles around would read the output
+    if (&anOutput == this && aHalo)
+    {
+        throwError<std::invalid_argument>(__FUNCTION__, __LINE__, "An image with a halo can't be processed in place.");
+    }
+
+    processTiles(anOutput, [&](size_t aColumn, size_t aRow, size_t aWidth, size_t aHeight)
+    {
+        Image tile = anOperation(readRegion(ptrdiff_t(aColumn) - ptrdiff_t(aHalo),
+                                            ptrdiff_t(aRow) - ptrdiff_t(aHalo),
+                                            aWidth + 2 * aHalo, aHeight + 2 * aHalo));
+
+        if (tile.getWidth() != aWidth + 2 * aHalo || tile.getHeight() != aHeight + 2 * aHalo)
+        {
+            throwError<std::invalid_argument>(__FUNCTION__, __LINE__, "The operation changed the size of the tile.");
+        }
+
+        // Remove the halo
+        if (!aHalo) return tile;
+
+        Image output(0.0f, aWidth, aHeight);
+        for (size_t i = 0; i < aHeight; ++i)
+        {
+            std::memcpy(output.getPixelPointer() + i * aWidth,
+                        tile.getPixelPointer() + (i + aHalo) * tile.getWidth() + aHalo,
+                        aWidth * sizeof(float));
+        }
+        return output;
+    },
+    aHalo);
+}
+
+
+//------------------------------------------------------
+void TiledImage::conv2d(TiledImage& anOutput,
+                        const Image& aKernel,
+                        BorderMode aBorderMode,
+                        ConvolutionMethod aMethod) const
+//------------------------------------------------------
+{
+    if (!aKernel.getWidth() || !aKernel.getHeight())
+    {
+        throwError<std::invalid_argument>(__FUNCTION__, __LINE__, "The convolution kernel is empty.");
+    }
+
+    size_t width;
+    size_t height;
+    getConvolutionSize(m_width, m_height, aKernel.getWidth(), aKernel.getHeight(), aBorderMode, width, height);
+    if (anOutput.m_width != width || anOutput.m_height != height)
+    {
+        throwError<std::invalid_argument>(__FUNCTION__, __LINE__, "The output image does not have the size of the convolution.");
+    }
+
+    if (&anOutput == this)
+    {
+        throwError<std::invalid_argument>(__FUNCTION__, __LINE__, "A convolution can't be computed in place.");
+    }
+
+    // The output pixel (x, y) needs the input pixels from (x - W_h / 2, y - H_h / 2)
+    // to (x - W_h / 2 + W_h - 1, y - H_h / 2 + H_h - 1), or from (x, y) when
+    // the border is cropped. Each tile is convolved with its halo, and the
+    // border of the halo is cropped.
+    ptrdiff_t offset_x = aBorderMode == BORDER_CROP ? 0 : -ptrdiff_t(aKernel.getWidth() / 2);
+    ptrdiff_t offset_y = aBorderMode == BORDER_CROP ? 0 : -ptrdiff_t(aKernel.getHeight() / 2);
+
+    processTiles(anOutput, [&](size_t aColumn, size_t aRow, size_t aWidth, size_t aHeight)
+    {
+        Image region = readRegion(ptrdiff_t(aColumn) + offset_x, ptrdiff_t(aRow) + offset_y,
+                                  aWidth + aKernel.getWidth() - 1, aHeight + aKernel.getHeight() - 1,
+                                  aBorderMode);
+
+        return region.conv2d(aKernel, BORDER_CROP, aMethod);
+    },
+    aKernel.getHeight());
+}
+
+
+//-------------------------------------------------------
+void TiledImage::map(const char* aFilename, size_t aSize)
+//-------------------------------------------------------
+{
+    // The pixels are stored little-endian
+    uint16_t value = 1;
+    if (*reinterpret_cast<unsigned char*>(&value) != 1)
+    {
+        throwError<std::runtime_error>(__FUNCTION__, __LINE__, "The tiled images need a little-endian machine.");
+    }
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(aFilename, GENERIC_READ | GENERIC_WRITE, 0, NULL,
+                              aSize ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throwError<std::runtime_error>(__FUNCTION__, __LINE__, std::string("Can't open ") + aFilename);
+    }
+
+    LARGE_INTEGER size;
+    size.QuadPart = aSize;
+    if (!aSize) GetFileSizeEx(file, &size);
+    m_size = size_t(size.QuadPart);
+
+    // The mapping sets the size of a new file, and the view keeps the mapping
+    // alive once the handles are closed
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, size.HighPart, size.LowPart, NULL);
+    if (mapping)
+    {
+        m_p_data = static_cast<unsigned char*>(MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0));
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+#else
+    int file = aSize ? open(aFilename, O_RDWR | O_CREAT | O_TRUNC, 0644) : open(aFilename, O_RDWR);
+    if (file < 0)
+    {
+        throwError<std::runtime_error>(__FUNCTION__, __LINE__, std::string("Can't open ") + aFilename);
+    }
+
+    // A new file is sparse: the disk is only used by the pages that are written
+    struct stat status;
+    if (aSize)
+    {
+        if (ftruncate(file, off_t(aSize)) == 0) m_size = aSize;
+    }
+    else if (fstat(file, &status) == 0)
+    {
+        m_size = size_t(status.st_size);
+    }
+
+    // The mapping remains valid once the file is closed
+    if (m_size)
+    {
+        void* p_data = mmap(0, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+        if (p_data != MAP_FAILED) m_p_data = static_cast<unsigned char*>(p_data);
+    }
+    close(file);
+#endif
+
+    // The number of pixels is checked without computing the size of the pixels,
+    // which may not fit in size_t
+    if (m_p_data && (m_size < RAW_HEADER_SIZE ||
+        (m_height && m_width > (m_size - RAW_HEADER_SIZE) / sizeof(float) / m_height)))
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(m_p_data);
+#else
+        munmap(m_p_data, m_size);
+#endif
+        m_p_data = 0;
+    }
+
+    if (!m_p_data)
+    {
+        throwError<std::runtime_error>(__FUNCTION__, __LINE__, std::string("Can't map ") + aFilename);
+    }
+
+    m_p_pixels = reinterpret_cast<float*>(m_p_data + RAW_HEADER_SIZE);
+}
+
+
+//------------------------------------------------------------------------
+void TiledImage::releaseRows(size_t aFirstRow, size_t aNumberOfRows) const
+//------------------------------------------------------------------------
+{
+#ifndef _WIN32
+    // Only the pages that are entirely in the rows
+    uintptr_t page_size = uintptr_t(sysconf(_SC_PAGESIZE));
+    uintptr_t first = reinterpret_cast<uintptr_t>(m_p_pixels + aFirstRow * m_width);
+    uintptr_t last = reinterpret_cast<uintptr_t>(m_p_pixels + (aFirstRow + aNumberOfRows) * m_width);
+    first = (first + page_size - 1) / page_size * page_size;
+    last = last / page_size * page_size;
+
+    if (first < last)
+    {
+        msync(reinterpret_cast<void*>(first), last - first, MS_ASYNC);
+        madvise(reinterpret_cast<void*>(first), last - first, MADV_DONTNEED);
+    }
+#else
+    // The system trims the working set of the process when needed
+    (void)aFirstRow;
+    (void)aNumberOfRows;
+#endif
+}
+
+
+//-----------------------------------------------------------------------------------------------------
+void TiledImage::processTiles(TiledImage& anOutput,
+                              const std::function<Image(size_t, size_t, size_t, size_t)>& aProcessTile,
+                              size_t aHalo) const
+//-----------------------------------------------------------------------------------------------------
+{
+    size_t released_rows = 0;
+    for (size_t row = 0; row < anOutput.m_height; row += m_tile_size)
+    {
+        size_t height = std::min(m_tile_size, anOutput.m_height - row);
+
+        // The tiles of the band. Each tile uses all the threads of the pool.
+        for (size_t column = 0; column < anOutput.m_width; column += m_tile_size)
+        {
+            size_t width = std::min(m_tile_size, anOutput.m_width - column);
+            Image tile = aProcessTile(column, row, width, height);
+            anOutput.writeRegion(tile, column, row);
+        }
+
+        // The output band is done, and the input rows above the halo of the
+        // next band are not needed anymore
+        if (&anOutput != this) anOutput.releaseRows(row, height);
+
+        size_t needed_row = std::min(row + height > aHalo ? row + height - aHalo : 0, m_height);
+        if (needed_row > released_rows)
+        {
+            releaseRows(released_rows, needed_row - released_rows);
+            released_rows = needed_row;
+        }
+    }
+}
@@ -0,0 +1,118 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <cstdio>       // std::remove
+#include <stdexcept>    // std::runtime_error
+
+#include "Image.h"
+#include "ImageBatchLoader.h"
+#include "gtest/gtest.h"
+
+
+using namespace std;
+
+// Write test images of different sizes, alternately in JPEG and raw files
+vector<string> createFiles(size_t aNumberOfFiles)
+{
+    vector<string> filenames;
+    for (size_t i = 0; i < aNumberOfFiles; ++i)
+    {
+        stringstream filename;
+        filename << "test-batch-loader-" << i << (i % 2 ? ".raw" : ".jpg");
+        filenames.push_back(filename.str());
+
+        Image image(float(i), 20 + i, 10 + i);
+        image.save(filenames.back());
+    }
+    return filenames;
+}
+
+// Delete the test files
+void removeFiles(const vector<string>& aFilenames)
+{
+    for (size_t i = 0; i < aFilenames.size(); ++i)
+    {
+        std::remove(aFilenames[i].c_str());
+    }
+}
+
+// The images come in the order of the list, whatever the settings
+TEST(BatchLoader, Order)
+{
+    vector<string> filenames = createFiles(25);
+
+    const size_t numbers_of_threads[] = {1, 3, 8};
+    const size_t queue_sizes[] = {0, 1, 5};
+    for (size_t i = 0; i < 3; ++i)
+    {
+        for (size_t j = 0; j < 3; ++j)
+        {
+            ImageBatchLoader loader(filenames, numbers_of_threads[i], queue_sizes[j]);
+            ASSERT_EQ(loader.getNumberOfImages(), 25);
+            ASSERT_EQ(loader.getNumberOfThreads(), numbers_of_threads[i]);
+            ASSERT_GE(loader.getQueueSize(), loader.getNumberOfThreads());
+
+            Image image;
+            string filename;
+            for (size_t k = 0; k < 25; ++k)
+            {
+                ASSERT_TRUE(loader.getNextImage(image, &filename));
+                ASSERT_EQ(filename, filenames[k]);
+                ASSERT_EQ(image.getWidth(), 20 + k);
+                ASSERT_EQ(image.getHeight(), 10 + k);
+                ASSERT_NEAR(image(0, 0), float(k), 1.0f);
+            }
+
+            // The end of the list
+            ASSERT_FALSE(loader.getNextImage(image));
+            ASSERT_FALSE(loader.getNextImage(image));
+        }
+    }
+
+    removeFiles(filenames);
+}
+
+// A file that can't be loaded throws when its turn comes
+TEST(BatchLoader, Errors)
+{
+    vector<string> filenames = createFiles(5);
+    filenames[2] = "does-not-exist.jpg";
+
+    ImageBatchLoader loader(filenames, 2, 2);
+    Image image;
+    ASSERT_TRUE(loader.getNextImage(image));
+    ASSERT_TRUE(loader.getNextImage(image));
+    ASSERT_THROW(loader.getNextImage(image), std::runtime_error);
+    ASSERT_TRUE(loader.getNextImage(image));
+    ASSERT_EQ(image.getWidth(), 23);
+    ASSERT_TRUE(loader.getNextImage(image));
+    ASSERT_FALSE(loader.getNextImage(image));
+
+    removeFiles(filenames);
+}
+
+// The loader can be destroyed at any time
+TEST(BatchLoader, Stop)
+{
+    vector<string> filenames = createFiles(10);
+
+    {
+        ImageBatchLoader loader(filenames, 4, 4);
+    }
+
+    {
+        ImageBatchLoader loader(filenames, 4, 4, 0.5f);
+        Image image;
+        ASSERT_TRUE(loader.getNextImage(image));
+        ASSERT_EQ(image.getWidth(), 10);
+        ASSERT_EQ(image.getHeight(), 5);
+    }
+
+    // Nothing to load
+    ImageBatchLoader empty((vector<string>()));
+    Image image;
+    ASSERT_FALSE(empty.getNextImage(image));
+
+    removeFiles(filenames);
+}
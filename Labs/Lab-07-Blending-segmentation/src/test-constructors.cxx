@@ -89,3 +89,52 @@ TEST(TestContructors, CopyConstructor)
     }
 }
 
+
+// Test the accessors without bounds check
+TEST(TestContructors, UncheckedAccessors)
+{
+    vector<float> p_cxx_array = {1, 2, 3, 4, 5, 6, 7, 8};
+    Image test_image(p_cxx_array, 4, 2);
+
+    // The checked accessor throws an error
+    EXPECT_THROW(test_image(4, 0), std::out_of_range);
+    EXPECT_THROW(test_image(0, 2), std::out_of_range);
+
+    // Read the pixels row by row
+    size_t k = 0;
+    size_t number_of_rows = 0;
+    for (PixelRow<const float> row: test_image.getRows())
+    {
+        ASSERT_EQ(row.size(), 4);
+        for (float pixel: row)
+        {
+            ASSERT_EQ(pixel, p_cxx_array[k]);
+            ASSERT_EQ(pixel, test_image.atUnchecked(k % 4, k / 4));
+            ++k;
+        }
+        ++number_of_rows;
+    }
+    ASSERT_EQ(number_of_rows, 2);
+    ASSERT_EQ(test_image.getRow(1)[2], 7);
+
+    // Modify the pixels
+    ASSERT_EQ(test_image.getMaxValue(), 8);
+    {
+        PixelWriter writer(test_image);
+        for (PixelRow<float> row: writer.getRows())
+        {
+            for (float& pixel: row)
+            {
+                pixel *= 2;
+            }
+        }
+
+        // Statistics computed while the pixels are modified
+        ASSERT_EQ(test_image.getMaxValue(), 16);
+        writer.atUnchecked(3, 1) = 20;
+    }
+
+    // The statistics are updated once the writer is destroyed
+    ASSERT_EQ(test_image.getMaxValue(), 20);
+    ASSERT_EQ(test_image(3, 1), 20);
+}
@@ -0,0 +1,476 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "Image.h"
+#include "FFT.h"
+#include "MedianFilter.h"
+#include "SummedAreaTable.h"
+#include "gtest/gtest.h"
+
+
+using namespace std;
+
+// Create a test image with a non-trivial content. 37 columns, so that the
+// tails of the vector loops are used too.
+Image createTestImage(size_t aWidth = 37, size_t aHeight = 23)
+{
+    Image image(0.0f, aWidth, aHeight);
+    for (size_t row = 0; row < aHeight; ++row)
+    {
+        for (size_t col = 0; col < aWidth; ++col)
+        {
+            image(col, row) = std::sin(col * 0.7f) * 50.0f + row * 3.0f - col;
+        }
+    }
+    return image;
+}
+
+// The four nested loops of Lab 8, used as a reference
+Image naiveConvolution(const Image& anImage, const Image& aKernel, BorderMode aBorderMode)
+{
+    long w = anImage.getWidth();
+    long h = anImage.getHeight();
+    long kw = aKernel.getWidth();
+    long kh = aKernel.getHeight();
+
+    long offset_x = aBorderMode == BORDER_CROP ? 0 : kw / 2;
+    long offset_y = aBorderMode == BORDER_CROP ? 0 : kh / 2;
+    long output_width = aBorderMode == BORDER_CROP ? w - kw + 1 : w;
+    long output_height = aBorderMode == BORDER_CROP ? h - kh + 1 : h;
+
+    Image output(0.0f, output_width, output_height);
+    for (long y = 0; y < output_height; ++y)
+    {
+        for (long x = 0; x < output_width; ++x)
+        {
+            double accumulator = 0;
+            for (long l = 0; l < kh; ++l)
+            {
+                for (long k = 0; k < kw; ++k)
+                {
+                    long i = x - offset_x + k;
+                    long j = y - offset_y + l;
+                    float pixel;
+
+                    if (i >= 0 && i < w && j >= 0 && j < h)
+                        pixel = anImage(i, j);
+                    else if (aBorderMode == BORDER_ZERO)
+                        pixel = 0;
+                    else
+                        pixel = anImage(std::min(std::max(i, 0L), w - 1), std::min(std::max(j, 0L), h - 1));
+
+                    accumulator += pixel * aKernel(k, l);
+                }
+            }
+            output(x, y) = accumulator;
+        }
+    }
+    return output;
+}
+
+// The rounding errors depend on the order of the operations: the tolerance is
+// relative to the magnitude of the terms that are summed
+float getTolerance(Image anImage, const Image& aKernel)
+{
+    float sum = 0;
+    for (size_t i = 0; i < aKernel.getWidth() * aKernel.getHeight(); ++i)
+    {
+        sum += std::fabs(aKernel.getPixelPointer()[i]);
+    }
+    return 1e-6f * sum * std::max(std::fabs(anImage.getMinValue()), std::fabs(anImage.getMaxValue()));
+}
+
+void compareImages(const Image& anExpected, const Image& anActual, float aTolerance = 1e-5f)
+{
+    ASSERT_EQ(anExpected.getWidth(), anActual.getWidth());
+    ASSERT_EQ(anExpected.getHeight(), anActual.getHeight());
+
+    for (size_t row = 0; row < anExpected.getHeight(); ++row)
+    {
+        for (size_t col = 0; col < anExpected.getWidth(); ++col)
+        {
+            ASSERT_NEAR(anExpected(col, row), anActual(col, row), aTolerance);
+        }
+    }
+}
+
+// Separable kernels
+TEST(Filters, SeparableKernels)
+{
+    vector<float> row, column;
+
+    // Gaussian
+    float gaussian[] = {1, 2, 1, 2, 4, 2, 1, 2, 1};
+    ASSERT_TRUE(separateKernel(gaussian, 3, 3, row, column));
+    for (size_t l = 0; l < 3; ++l)
+        for (size_t k = 0; k < 3; ++k)
+            ASSERT_FLOAT_EQ(gaussian[l * 3 + k], column[l] * row[k]);
+
+    // Sobel, not symmetrical
+    float sobel[] = {1, 0, -1, 2, 0, -2, 1, 0, -1};
+    ASSERT_TRUE(separateKernel(sobel, 3, 3, row, column));
+    for (size_t l = 0; l < 3; ++l)
+        for (size_t k = 0; k < 3; ++k)
+            ASSERT_FLOAT_EQ(sobel[l * 3 + k], column[l] * row[k]);
+
+    // Laplacian
+    float laplacian[] = {1, 1, 1, 1, -8, 1, 1, 1, 1};
+    ASSERT_FALSE(separateKernel(laplacian, 3, 3, row, column));
+
+    // Null kernel
+    float null_kernel[] = {0, 0, 0, 0};
+    ASSERT_FALSE(separateKernel(null_kernel, 2, 2, row, column));
+}
+
+// The convolution must match the four nested loops of Lab 8
+TEST(Filters, Convolution)
+{
+    Image image = createTestImage();
+
+    vector<Image> kernels;
+    kernels.push_back(Image({1, 2, 1, 2, 4, 2, 1, 2, 1}, 3, 3));                    // Separable
+    kernels.push_back(Image({1, 1, 1, 1, -8, 1, 1, 1, 1}, 3, 3));                   // Not separable
+    kernels.push_back(Image({1, 2, 3, 4, 5, 6, 7, 8}, 4, 2));                       // Even size
+    kernels.push_back(Image({1, -2, 3, 4, 5}, 5, 1));                               // 1D
+    kernels.push_back(Image({1, 4, 6, 4, 1}, 1, 5));                                // 1D
+    kernels.push_back(Image(0.5f, 7, 9));                                           // Large
+
+    // Separable, 5x5
+    float binomial[] = {1, 4, 6, 4, 1};
+    float derivative[] = {1, 2, 0, -2, -1};
+    Image outer_product(0.0f, 5, 5);
+    for (size_t l = 0; l < 5; ++l)
+        for (size_t k = 0; k < 5; ++k)
+            outer_product(k, l) = binomial[l] * derivative[k];
+    kernels.push_back(outer_product);
+
+    BorderMode border_modes[] = {BORDER_EXTEND, BORDER_ZERO, BORDER_CROP};
+
+    for (size_t i = 0; i < kernels.size(); ++i)
+    {
+        for (size_t j = 0; j < 3; ++j)
+        {
+            compareImages(naiveConvolution(image, kernels[i], border_modes[j]),
+                image.conv2d(kernels[i], border_modes[j]),
+                getTolerance(image, kernels[i]));
+        }
+    }
+
+    // Extend by default
+    compareImages(naiveConvolution(image, kernels[0], BORDER_EXTEND), image.conv2d(kernels[0]), getTolerance(image, kernels[0]));
+
+    // Large image, processed in several strips
+    Image large_image = createTestImage(1500, 60);
+    compareImages(naiveConvolution(large_image, kernels[0], BORDER_ZERO), large_image.conv2d(kernels[0], BORDER_ZERO), getTolerance(large_image, kernels[0]));
+    compareImages(naiveConvolution(large_image, kernels[1], BORDER_EXTEND), large_image.conv2d(kernels[1]), getTolerance(large_image, kernels[1]));
+
+    // The kernel is larger than the image
+    Image cropped = Image(1.0f, 3, 3).conv2d(kernels[5], BORDER_CROP);
+    ASSERT_EQ(cropped.getWidth(), 0);
+    ASSERT_EQ(cropped.getHeight(), 0);
+    compareImages(naiveConvolution(Image(1.0f, 3, 3), kernels[5], BORDER_EXTEND), Image(1.0f, 3, 3).conv2d(kernels[5]));
+
+    // Empty kernel
+    ASSERT_THROW(image.conv2d(Image()), std::invalid_argument);
+}
+
+// The FFT must match the discrete Fourier transform
+TEST(Filters, FourierTransform)
+{
+    size_t sizes[] = {1, 2, 3, 4, 5, 6, 8, 9, 10, 12, 15, 16, 25, 30, 32, 60, 64, 100, 120};
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(size_t); ++i)
+    {
+        size_t n = sizes[i];
+        vector<FFT::Complex> input(n), expected(n), actual(n), inverse(n);
+        for (size_t k = 0; k < n; ++k)
+        {
+            input[k] = FFT::Complex(std::cos(k * 1.3) * 10.0 + k, std::sin(k * 0.4) - 2.0);
+        }
+
+        // Naive DFT
+        for (size_t k = 0; k < n; ++k)
+        {
+            for (size_t j = 0; j < n; ++j)
+            {
+                double phase = -2.0 * M_PI * double(j * k % n) / n;
+                expected[k] += input[j] * FFT::Complex(std::cos(phase), std::sin(phase));
+            }
+        }
+
+        FFT(n).transform(&input[0], &actual[0]);
+        for (size_t k = 0; k < n; ++k)
+        {
+            ASSERT_NEAR(expected[k].real(), actual[k].real(), 1e-9 * n);
+            ASSERT_NEAR(expected[k].imag(), actual[k].imag(), 1e-9 * n);
+        }
+
+        // The inverse transform is not normalised
+        FFT(n, true).transform(&actual[0], &inverse[0]);
+        for (size_t k = 0; k < n; ++k)
+        {
+            ASSERT_NEAR(input[k].real() * n, inverse[k].real(), 1e-9 * n * n);
+            ASSERT_NEAR(input[k].imag() * n, inverse[k].imag(), 1e-9 * n * n);
+        }
+
+        // Real transform: half the spectrum of the complex transform
+        if (n % 2 == 0)
+        {
+            vector<double> real_input(n), real_inverse(n);
+            vector<FFT::Complex> complex_input(n), spectrum(n / 2 + 1);
+            for (size_t k = 0; k < n; ++k)
+            {
+                real_input[k] = input[k].real();
+                complex_input[k] = real_input[k];
+            }
+
+            FFT(n).transform(&complex_input[0], &expected[0]);
+            RealFFT transform(n);
+            transform.forward(&real_input[0], &spectrum[0]);
+            for (size_t k = 0; k <= n / 2; ++k)
+            {
+                ASSERT_NEAR(expected[k].real(), spectrum[k].real(), 1e-9 * n);
+                ASSERT_NEAR(expected[k].imag(), spectrum[k].imag(), 1e-9 * n);
+            }
+
+            transform.inverse(&spectrum[0], &real_inverse[0]);
+            for (size_t k = 0; k < n; ++k)
+            {
+                ASSERT_NEAR(real_input[k] * n, real_inverse[k], 1e-9 * n * n);
+            }
+        }
+    }
+
+    // Sizes
+    ASSERT_EQ(FFT::getFastSize(7), 8);
+    ASSERT_EQ(FFT::getFastSize(11), 12);
+    ASSERT_EQ(FFT::getFastSize(15, true), 16);
+    ASSERT_EQ(FFT::getFastSize(29, true), 30);
+    ASSERT_THROW(FFT(7), std::invalid_argument);
+    ASSERT_THROW(RealFFT(15), std::invalid_argument);
+}
+
+// All the methods must match the four nested loops of Lab 8
+TEST(Filters, ConvolutionMethods)
+{
+    Image image = createTestImage(67, 41);
+
+    vector<Image> kernels;
+    kernels.push_back(Image({1, 2, 1, 2, 4, 2, 1, 2, 1}, 3, 3));
+    kernels.push_back(Image({1, 2, 3, 4, 5, 6, 7, 8}, 4, 2));
+    kernels.push_back(Image({1, -2, 3, 4, 5}, 5, 1));
+
+    Image large_kernel(0.0f, 17, 13);
+    for (size_t l = 0; l < 13; ++l)
+        for (size_t k = 0; k < 17; ++k)
+            large_kernel(k, l) = float((k * 3 + l * 5) % 7) - 3.0f;
+    kernels.push_back(large_kernel);
+
+    BorderMode border_modes[] = {BORDER_EXTEND, BORDER_ZERO, BORDER_CROP};
+    ConvolutionMethod methods[] = {CONVOLUTION_SPATIAL, CONVOLUTION_SEPARABLE, CONVOLUTION_FFT};
+
+    for (size_t i = 0; i < kernels.size(); ++i)
+    {
+        for (size_t j = 0; j < 3; ++j)
+        {
+            Image expected = naiveConvolution(image, kernels[i], border_modes[j]);
+            for (size_t m = 0; m < 3; ++m)
+            {
+                compareImages(expected,
+                    image.conv2d(kernels[i], border_modes[j], methods[m]),
+                    getTolerance(image, kernels[i]));
+            }
+        }
+    }
+
+    // The cost model
+    ASSERT_EQ(selectConvolutionMethod(1024, 1024, 3, 3, false), CONVOLUTION_SPATIAL);
+    ASSERT_EQ(selectConvolutionMethod(1024, 1024, 5, 5, true), CONVOLUTION_SEPARABLE);
+    ASSERT_EQ(selectConvolutionMethod(1024, 1024, 63, 63, false), CONVOLUTION_FFT);
+    ASSERT_EQ(selectConvolutionMethod(1024, 1024, 63, 63, true), CONVOLUTION_SEPARABLE);
+}
+
+// The filters of Labs 8 and 9
+TEST(Filters, Filters)
+{
+    Image constant(5.0f, 16, 8);
+
+    // The filters are normalised
+    compareImages(constant, constant.gaussianFilter());
+    compareImages(constant, constant.meanFilter());
+    compareImages(constant, constant.averageFilter());
+    compareImages(constant, constant.boxFilter());
+
+    // No edge
+    compareImages(Image(0.0f, 16, 8), constant.laplacianFilter());
+    compareImages(Image(0.0f, 16, 8), constant.gradientMagnitude());
+
+    // No detail
+    compareImages(constant, constant.sharpen(4.0));
+
+    // Vertical edge
+    Image edge(0.0f, 16, 8);
+    for (size_t row = 0; row < 8; ++row)
+        for (size_t col = 8; col < 16; ++col)
+            edge(col, row) = 1.0f;
+
+    Image magnitude = edge.gradientMagnitude();
+    ASSERT_FLOAT_EQ(magnitude(7, 4), 4.0f);
+    ASSERT_FLOAT_EQ(magnitude(8, 4), 4.0f);
+    ASSERT_FLOAT_EQ(magnitude(3, 4), 0.0f);
+    ASSERT_FLOAT_EQ(magnitude(12, 4), 0.0f);
+
+    // The dynamic range is preserved
+    Image sharp = edge.sharpen(4.0);
+    ASSERT_FLOAT_EQ(sharp.getMinValue(), 0.0f);
+    ASSERT_FLOAT_EQ(sharp.getMaxValue(), 1.0f);
+}
+
+
+// Box filters and local variances of any radius
+TEST(Filters, SummedAreaTable)
+{
+    Image image = createTestImage();
+    SummedAreaTable table(image, true);
+    ASSERT_EQ(table.getWidth(), image.getWidth());
+    ASSERT_EQ(table.getHeight(), image.getHeight());
+
+    BorderMode border_modes[] = {BORDER_EXTEND, BORDER_ZERO, BORDER_CROP};
+    for (unsigned int radius = 0; radius <= 9; radius += 3)
+    {
+        size_t window = 2 * radius + 1;
+        Image kernel(1.0f / (window * window), window, window);
+
+        for (size_t i = 0; i < 3; ++i)
+        {
+            // The convolution with the normalised box kernel
+            Image expected_means = naiveConvolution(image, kernel, border_modes[i]);
+            compareImages(expected_means, table.boxFilter(radius, border_modes[i]), getTolerance(image, kernel));
+
+            // E[f^2] - E[f]^2
+            Image squares = image * image;
+            Image expected_variances = naiveConvolution(squares, kernel, border_modes[i]) - expected_means * expected_means;
+            compareImages(expected_variances.clamp(0.0f, expected_variances.getMaxValue()),
+                table.localVariance(radius, border_modes[i]), 1e-6f * squares.getMaxValue());
+        }
+    }
+
+    // Windows larger than the image
+    Image large_kernel(1.0f / (61 * 61), 61, 61);
+    compareImages(naiveConvolution(image, large_kernel, BORDER_EXTEND), table.boxFilter(30), getTolerance(image, large_kernel));
+    ASSERT_EQ(table.boxFilter(30, BORDER_CROP).getWidth(), 0);
+
+    // A window larger than the image, around a corner
+    double sum = 0.0;
+    for (long row = -5; row < 40; ++row)
+        for (long col = -8; col < 3; ++col)
+            sum += image(std::max(col, 0L), std::min(std::max(row, 0L), long(image.getHeight()) - 1));
+    ASSERT_NEAR(table.getSum(-8, -5, 11, 45), sum, 1e-9 * image.getWidth() * image.getHeight() * 255);
+
+    ASSERT_NEAR(table.getSum(-8, -5, 11, 45, BORDER_ZERO), SummedAreaTable(image).getSum(0, 0, 3, 23, BORDER_CROP), 1e-6);
+    ASSERT_DOUBLE_EQ(table.getSum(40, 0, 5, 5, BORDER_ZERO), 0.0);
+    ASSERT_THROW(table.getSum(-1, 0, 5, 5, BORDER_CROP), std::out_of_range);
+    ASSERT_THROW(SummedAreaTable(image).localVariance(1), std::logic_error);
+
+    // The mean filter of the image is the same as the convolution
+    Image kernel(1.0f / 49.0f, 7, 7);
+    compareImages(image.conv2d(kernel), image.meanFilter(3), getTolerance(image, kernel));
+}
+
+
+vector<uint8_t> naiveMedian(const vector<uint8_t>& anImage, long aWidth, long aHeight, long aRadius)
+{
+    vector<uint8_t> output(anImage.size());
+    vector<uint8_t> window;
+    for (long y = 0; y < aHeight; ++y)
+    {
+        for (long x = 0; x < aWidth; ++x)
+        {
+            window.clear();
+            for (long j = y - aRadius; j <= y + aRadius; ++j)
+            {
+                for (long i = x - aRadius; i <= x + aRadius; ++i)
+                {
+                    window.push_back(anImage[std::min(std::max(j, 0L), aHeight - 1) * aWidth +
+                                             std::min(std::max(i, 0L), aWidth - 1)]);
+                }
+            }
+            std::sort(window.begin(), window.end());
+            output[y * aWidth + x] = window[window.size() / 2];
+        }
+    }
+    return output;
+}
+
+// Sorting networks (r <= 2) and histograms (r > 2)
+TEST(Filters, Median)
+{
+    size_t sizes[][2] = {{37, 23}, {300, 70}, {5, 3}, {1, 9}};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        size_t width = sizes[s][0];
+        size_t height = sizes[s][1];
+
+        // Noise with a few uniform regions (ties)
+        vector<uint8_t> image(width * height);
+        unsigned int seed = 1;
+        for (size_t i = 0; i < image.size(); ++i)
+        {
+            seed = seed * 1103515245 + 12345;
+            image[i] = (i / 7) % 5 ? uint8_t(seed >> 16) : 128;
+        }
+
+        for (unsigned int radius = 0; radius <= 6; ++radius)
+        {
+            vector<uint8_t> expected = naiveMedian(image, width, height, radius);
+            vector<uint8_t> actual(image.size());
+            medianFilter(&image[0], width, height, radius, &actual[0]);
+            ASSERT_EQ(expected, actual) << width << "x" << height << ", r = " << radius;
+        }
+    }
+
+    ASSERT_THROW(medianFilter((const uint8_t*)0, 0, 0, MAX_MEDIAN_RADIUS + 1, (uint8_t*)0), std::out_of_range);
+
+    // Salt and pepper noise is removed, and the pixels are not rounded
+    Image constant(5.2f, 16, 8);
+    Image noisy(constant);
+    noisy(3, 3) = 255.0f;
+    noisy(10, 5) = -20.0f;
+    compareImages(constant, noisy.medianFilter());
+    compareImages(constant, noisy.medianFilter(4));
+
+    // The 8-bit images, and the float images of integers in [0, 255], use the
+    // filter above
+    size_t width = 37;
+    size_t height = 23;
+    vector<uint8_t> bytes(width * height);
+    for (size_t i = 0; i < bytes.size(); ++i) bytes[i] = uint8_t((i * 7919) % 251);
+    for (unsigned int radius = 1; radius <= 4; radius += 3)
+    {
+        vector<uint8_t> expected = naiveMedian(bytes, width, height, radius);
+        ImageU8 median = ImageU8(bytes, width, height).medianFilter(radius);
+        ASSERT_EQ(expected, vector<uint8_t>(median.getPixelPointer(), median.getPixelPointer() + bytes.size()));
+        compareImages(Image(median), Image(ImageU8(bytes, width, height)).medianFilter(radius));
+    }
+
+    // The floats in [0, 1] keep their precision: the median of each window is
+    // one of its values
+    Image unit(0.0f, width, height);
+    for (size_t i = 0; i < bytes.size(); ++i) unit.getPixelPointer()[i] = bytes[i] / 250.0f;
+    for (unsigned int radius = 0; radius <= 3; ++radius)
+    {
+        vector<uint8_t> expected = naiveMedian(bytes, width, height, radius);
+        Image median = unit.medianFilter(radius);
+        ASSERT_GT(median.getMaxValue(), 0.0f);
+        for (size_t row = 0; row < height; ++row)
+        {
+            for (size_t col = 0; col < width; ++col)
+            {
+                ASSERT_EQ(median(col, row), expected[row * width + col] / 250.0f);
+            }
+        }
+    }
+    ASSERT_THROW(unit.medianFilter(MAX_MEDIAN_RADIUS + 1), std::out_of_range);
+}
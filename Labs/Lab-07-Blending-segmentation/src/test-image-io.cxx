@@ -0,0 +1,427 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdio>       // std::remove, std::fopen
+#include <stdexcept>    // std::runtime_error
+#include <algorithm>    // std::equal, std::min, std::max
+#include <string>
+#include <utility>      // std::move
+
+#include "Image.h"
+#include "ImageIO.h"
+#include "gtest/gtest.h"
+
+
+using namespace std;
+
+// Create a test image with a non-trivial content
+Image createTestImage(size_t aWidth = 97, size_t aHeight = 61)
+{
+    Image image(0.0f, aWidth, aHeight);
+    for (size_t row = 0; row < aHeight; ++row)
+    {
+        for (size_t col = 0; col < aWidth; ++col)
+        {
+            image(col, row) = 128.0f + std::sin(col * 0.3f) * 60.0f + row * 0.5f - col * 0.5f;
+        }
+    }
+    return image;
+}
+
+// Write some bytes in a file
+void writeFile(const char* aFilename, const vector<unsigned char>& aData)
+{
+    FILE* p_file = std::fopen(aFilename, "wb");
+    ASSERT_TRUE(p_file != NULL);
+    if (aData.size()) std::fwrite(&aData[0], 1, aData.size(), p_file);
+    std::fclose(p_file);
+}
+
+// Test the memory-mapped files
+TEST(ImageIO, MappedFile)
+{
+    vector<unsigned char> data;
+    for (size_t i = 0; i < 10000; ++i) data.push_back(i * 7);
+    writeFile("test-image-io.bin", data);
+
+    {
+        MappedFile file("test-image-io.bin");
+        ASSERT_EQ(file.getSize(), data.size());
+        ASSERT_TRUE(std::equal(data.begin(), data.end(), file.getData()));
+
+        // The mapping is moved, not copied
+        const unsigned char* p_data = file.getData();
+        MappedFile moved(std::move(file));
+        ASSERT_EQ(moved.getData(), p_data);
+        ASSERT_EQ(moved.getSize(), data.size());
+        ASSERT_TRUE(file.getData() == NULL);
+        ASSERT_EQ(file.getSize(), 0);
+    }
+
+    // The format of a mapped file, from its first bytes
+    data[0] = 'P';
+    data[1] = '5';
+    writeFile("test-image-io.bin", data);
+    {
+        MappedFile file("test-image-io.bin");
+        ASSERT_EQ(readFileFormat(file, "test-image-io.bin"), FORMAT_PGM);
+    }
+
+    // Empty file
+    writeFile("test-image-io.bin", vector<unsigned char>());
+    {
+        MappedFile file("test-image-io.bin");
+        ASSERT_EQ(file.getSize(), 0);
+        ASSERT_TRUE(file.getData() == NULL);
+    }
+
+    std::remove("test-image-io.bin");
+
+    ASSERT_THROW(MappedFile("does-not-exist.bin"), std::runtime_error);
+}
+
+// Decode a file scanline by scanline
+TEST(ImageIO, Decoder)
+{
+    Image image = createTestImage();
+    image.saveJPEG("test-image-io.jpg");
+
+    // The file is stored in greyscale
+    JPEGDecoder decoder("test-image-io.jpg");
+    ASSERT_EQ(decoder.getWidth(), image.getWidth());
+    ASSERT_EQ(decoder.getHeight(), image.getHeight());
+    ASSERT_EQ(decoder.getNumberOfComponents(), 1);
+
+    // The image is made of the rows
+    Image loaded("test-image-io.jpg");
+    vector<unsigned char> scanline(decoder.getWidth());
+    for (size_t row = 0; row < decoder.getHeight(); ++row)
+    {
+        decoder.readScanline(&scanline[0]);
+        for (size_t col = 0; col < decoder.getWidth(); ++col)
+        {
+            ASSERT_EQ(loaded(col, row), scanline[col]);
+        }
+    }
+
+    // Everything was decoded
+    ASSERT_THROW(decoder.readScanline(&scanline[0]), std::runtime_error);
+
+    // Lossy compression
+    for (size_t i = 0; i < image.getWidth() * image.getHeight(); ++i)
+    {
+        ASSERT_NEAR(loaded.getPixelPointer()[i], image.getPixelPointer()[i], 12.0);
+    }
+
+    // Loading again in the same image: the pixels are decoded in a new
+    // buffer, which replaces the old one
+    Image reloaded = loaded;
+    reloaded.load("test-image-io.jpg");
+    ASSERT_EQ(reloaded.getWidth(), loaded.getWidth());
+    ASSERT_EQ(reloaded.getHeight(), loaded.getHeight());
+    ASSERT_TRUE(std::equal(loaded.getPixelPointer(),
+                           loaded.getPixelPointer() + loaded.getWidth() * loaded.getHeight(),
+                           reloaded.getPixelPointer()));
+
+    std::remove("test-image-io.jpg");
+}
+
+// The luminance of grey RGB pixels is their value
+TEST(ImageIO, Luminance)
+{
+    const unsigned char rgb[] = {0, 0, 0,  255, 255, 255,  100, 100, 100,  255, 0, 0,  0, 255, 0,  0, 0, 255};
+    float luminance[6];
+    computeLuminance(rgb, luminance, 6);
+    ASSERT_EQ(luminance[0], 0.0f);
+    ASSERT_EQ(luminance[1], 255.0f);
+    ASSERT_EQ(luminance[2], 100.0f);
+    ASSERT_NEAR(luminance[3], 0.2126f * 255.0f, 0.001f);
+    ASSERT_NEAR(luminance[4], 0.7152f * 255.0f, 0.001f);
+    ASSERT_NEAR(luminance[5], 0.0722f * 255.0f, 0.001f);
+}
+
+// The quality and the optimisation of the Huffman tables
+TEST(ImageIO, EncoderSettings)
+{
+    Image image = createTestImage(256, 256);
+
+    // Same image, different sizes
+    image.saveJPEG("test-image-io-50.jpg", 50);
+    image.saveJPEG("test-image-io-95.jpg", 95);
+    image.saveJPEG("test-image-io-opt.jpg", 95, true);
+    size_t size_50 = MappedFile("test-image-io-50.jpg").getSize();
+    size_t size_95 = MappedFile("test-image-io-95.jpg").getSize();
+    size_t size_optimised = MappedFile("test-image-io-opt.jpg").getSize();
+    ASSERT_LT(size_50, size_95);
+    ASSERT_LT(size_optimised, size_95);
+
+    // The optimisation is lossless
+    Image standard("test-image-io-95.jpg");
+    Image optimised("test-image-io-opt.jpg");
+    for (size_t i = 0; i < image.getWidth() * image.getHeight(); ++i)
+    {
+        ASSERT_EQ(optimised.getPixelPointer()[i], standard.getPixelPointer()[i]);
+        float pixel = std::min(std::max(image.getPixelPointer()[i], 0.0f), 255.0f);
+        ASSERT_NEAR(standard.getPixelPointer()[i], pixel, 4.0);
+    }
+
+    // The pixels are saturated
+    Image extremes(0.0f, 16, 16);
+    for (size_t i = 0; i < 256; ++i) extremes.getPixelPointer()[i] = i % 2 ? 1000.0f : -1000.0f;
+    extremes.saveJPEG("test-image-io-50.jpg", 100);
+    ImageU8 bytes("test-image-io-50.jpg");
+    ASSERT_NEAR(bytes(0, 0), 0, 8);
+    ASSERT_NEAR(bytes(1, 0), 255, 8);
+
+    ASSERT_THROW(image.saveJPEG("test-image-io-50.jpg", 0), std::runtime_error);
+    ASSERT_THROW(image.saveJPEG("test-image-io-50.jpg", 101), std::runtime_error);
+
+    // libjpeg rejects the empty images: no file is left behind
+    std::remove("test-image-io-50.jpg");
+    ASSERT_THROW(Image().saveJPEG("test-image-io-50.jpg"), std::runtime_error);
+    ASSERT_THROW(ImageU8().saveJPEG("test-image-io-50.jpg"), std::runtime_error);
+    ASSERT_TRUE(std::fopen("test-image-io-50.jpg", "rb") == NULL);
+
+    std::remove("test-image-io-50.jpg");
+    std::remove("test-image-io-95.jpg");
+    std::remove("test-image-io-opt.jpg");
+}
+
+// The errors of libjpeg are exceptions
+TEST(ImageIO, Errors)
+{
+    ASSERT_THROW(Image("does-not-exist.jpg"), std::runtime_error);
+    ASSERT_THROW(ImageU8("does-not-exist.jpg"), std::runtime_error);
+
+    // Not a JPEG file
+    writeFile("test-image-io.jpg", vector<unsigned char>(1000, 42));
+    ASSERT_THROW(Image("test-image-io.jpg"), std::runtime_error);
+
+    // Empty file
+    writeFile("test-image-io.jpg", vector<unsigned char>());
+    ASSERT_THROW(Image("test-image-io.jpg"), std::runtime_error);
+
+    // A truncated file is decoded up to where it ends
+    createTestImage().saveJPEG("test-image-io.jpg");
+    vector<unsigned char> data;
+    {
+        MappedFile file("test-image-io.jpg");
+        data.assign(file.getData(), file.getData() + file.getSize() * 2 / 3);
+    }
+    writeFile("test-image-io.jpg", data);
+
+    Image truncated("test-image-io.jpg");
+    ASSERT_EQ(truncated.getWidth(), 97);
+    ASSERT_EQ(truncated.getHeight(), 61);
+
+    // A second frame header after the pixels: the error is found after the
+    // last row, and the image that was loaded before is unchanged
+    createTestImage().saveJPEG("test-image-io.jpg");
+    {
+        MappedFile file("test-image-io.jpg");
+        data.assign(file.getData(), file.getData() + file.getSize());
+    }
+    vector<unsigned char>::iterator frame_header = data.begin();
+    while (frame_header[0] != 0xFF || frame_header[1] != 0xC0) ++frame_header;
+    size_t frame_header_size = 2 + frame_header[2] * 256 + frame_header[3];
+    vector<unsigned char> frame(frame_header, frame_header + frame_header_size);
+    data.insert(data.end() - 2, frame.begin(), frame.end());
+    writeFile("test-image-io.jpg", data);
+
+    Image image = createTestImage(20, 10);
+    ImageU8 bytes(image);
+    ASSERT_THROW(image.load("test-image-io.jpg"), std::runtime_error);
+    ASSERT_THROW(bytes.load("test-image-io.jpg"), std::runtime_error);
+    ASSERT_EQ(image.getWidth(), 20);
+    ASSERT_EQ(image.getHeight(), 10);
+    ASSERT_EQ(bytes.getWidth(), 20);
+    ASSERT_EQ(bytes.getHeight(), 10);
+    ASSERT_EQ(image(19, 9), createTestImage(20, 10)(19, 9));
+    ASSERT_EQ(bytes(19, 9), ImageU8(createTestImage(20, 10))(19, 9));
+
+    std::remove("test-image-io.jpg");
+}
+
+// Decode at a reduced resolution
+TEST(ImageIO, ScaledDecoding)
+{
+    Image image = createTestImage(203, 117);
+    image.saveJPEG("test-image-io.jpg");
+    Image full("test-image-io.jpg");
+
+    // The smallest scale (1, 1/2, 1/4 or 1/8) that is large enough
+    const float scale_hints[] = {1.0f, 0.9f, 0.5f, 0.3f, 0.25f, 0.2f, 0.125f, 0.01f, 0.0f};
+    const size_t scales[] = {1, 1, 2, 2, 4, 4, 8, 8, 8};
+    for (size_t i = 0; i < 9; ++i)
+    {
+        Image scaled;
+        scaled.load("test-image-io.jpg", scale_hints[i]);
+        ASSERT_EQ(scaled.getWidth(), (203 + scales[i] - 1) / scales[i]);
+        ASSERT_EQ(scaled.getHeight(), (117 + scales[i] - 1) / scales[i]);
+
+        // A pixel is about the average of a block of the full image
+        for (size_t row = 0; row < 117 / scales[i]; ++row)
+        {
+            for (size_t col = 0; col < 203 / scales[i]; ++col)
+            {
+                float average = 0.0f;
+                for (size_t j = 0; j < scales[i]; ++j)
+                {
+                    for (size_t k = 0; k < scales[i]; ++k)
+                    {
+                        average += full(col * scales[i] + k, row * scales[i] + j);
+                    }
+                }
+                average /= scales[i] * scales[i];
+                ASSERT_NEAR(scaled(col, row), average, 8.0f);
+            }
+        }
+    }
+
+    // The other pixel types
+    ImageU8 bytes;
+    bytes.load(std::string("test-image-io.jpg"), 0.25f);
+    ASSERT_EQ(bytes.getWidth(), 51);
+    ASSERT_EQ(bytes.getHeight(), 30);
+
+    std::remove("test-image-io.jpg");
+}
+
+// Save and load an image, and check that nothing was lost
+template<typename PixelT>
+void checkRoundTrip(const BasicImage<PixelT>& anImage, const char* aFilename)
+{
+    anImage.save(aFilename);
+    BasicImage<PixelT> loaded(aFilename);
+    ASSERT_EQ(loaded.getWidth(), anImage.getWidth());
+    ASSERT_EQ(loaded.getHeight(), anImage.getHeight());
+    for (size_t i = 0; i < anImage.getWidth() * anImage.getHeight(); ++i)
+    {
+        ASSERT_EQ(float(loaded.getPixelPointer()[i]), float(anImage.getPixelPointer()[i]));
+    }
+    std::remove(aFilename);
+}
+
+// The uncompressed formats store the pixels without any loss
+TEST(ImageIO, UncompressedFormats)
+{
+    // Several tiles in both directions, and partial tiles at the borders
+    Image image = createTestImage(600, 300);
+    image(0, 0) = -1.5f;
+    image(599, 299) = 1.0e6f;
+
+    checkRoundTrip(image, "test-image-io.raw");
+    checkRoundTrip(image, "test-image-io.pfm");
+    checkRoundTrip(image, "test-image-io.tif");
+    checkRoundTrip(createTestImage(31, 7), "test-image-io.TIFF");
+
+    ImageU8 bytes(image);
+    checkRoundTrip(bytes, "test-image-io.raw");
+    checkRoundTrip(bytes, "test-image-io.pgm");
+    checkRoundTrip(bytes, "test-image-io.tif");
+
+    ImageU16 words(Image(image * 100.0f));
+    checkRoundTrip(words, "test-image-io.raw");
+    checkRoundTrip(words, "test-image-io.pgm");
+    checkRoundTrip(words, "test-image-io.tif");
+
+    ImageHalf halves(image);
+    checkRoundTrip(halves, "test-image-io.raw");
+    checkRoundTrip(halves, "test-image-io.pfm");
+    checkRoundTrip(halves, "test-image-io.tif");
+
+    // The samples are converted when the types are different
+    words.save("test-image-io.pgm");
+    Image converted("test-image-io.pgm");
+    ASSERT_EQ(converted(10, 20), float(words(10, 20)));
+    std::remove("test-image-io.pgm");
+
+    // PGM files do not store floats
+    ASSERT_THROW(image.save("test-image-io.pgm"), std::runtime_error);
+    ASSERT_THROW(image.save("test-image-io.bmp"), std::runtime_error);
+    std::remove("test-image-io.pgm");
+}
+
+// Files written by other programs
+TEST(ImageIO, ForeignFiles)
+{
+    // PGM with comments in the header
+    std::string header("P5\n# A comment\n3 2\n# Another one\n255\n");
+    vector<unsigned char> data(header.begin(), header.end());
+    for (unsigned char i = 1; i <= 6; ++i) data.push_back(i * 10);
+    writeFile("test-image-io.pgm", data);
+
+    ASSERT_EQ(readFileFormat("test-image-io.pgm"), FORMAT_PGM);
+    ImageU8 grey("test-image-io.pgm");
+    ASSERT_EQ(grey.getWidth(), 3);
+    ASSERT_EQ(grey.getHeight(), 2);
+    ASSERT_EQ(grey(0, 0), 10);
+    ASSERT_EQ(grey(2, 1), 60);
+
+    // Truncated file
+    data.pop_back();
+    writeFile("test-image-io.pgm", data);
+    ASSERT_THROW(ImageU8("test-image-io.pgm"), std::runtime_error);
+    std::remove("test-image-io.pgm");
+
+    // Big-endian TIFF with 16-bit samples in two strips of 2 rows
+    const unsigned char tiff[] =
+    {
+        'M', 'M', 0, 42, 0, 0, 0, 8,
+        0, 6,
+        1, 0,  0, 3,  0, 0, 0, 1,  0, 3, 0, 0,     // ImageWidth: 3
+        1, 1,  0, 3,  0, 0, 0, 1,  0, 3, 0, 0,     // ImageLength: 3
+        1, 2,  0, 3,  0, 0, 0, 1,  0, 16, 0, 0,    // BitsPerSample: 16
+        1, 3,  0, 3,  0, 0, 0, 1,  0, 1, 0, 0,     // Compression: none
+        1, 17, 0, 3,  0, 0, 0, 2,  0, 86, 0, 98,   // StripOffsets: 86, 98
+        1, 22, 0, 3,  0, 0, 0, 1,  0, 2, 0, 0,     // RowsPerStrip: 2
+        0, 0, 0, 0,
+        0, 1, 0, 2, 0, 3,  1, 0, 2, 0, 3, 0,       // The first strip (offset 86)
+        255, 255, 0, 0, 0, 7                       // The second strip (offset 98)
+    };
+    writeFile("test-image-io.tif", vector<unsigned char>(tiff, tiff + sizeof(tiff)));
+
+    ASSERT_EQ(readFileFormat("test-image-io.tif"), FORMAT_TIFF);
+    ImageFileReader reader("test-image-io.tif");
+    ASSERT_EQ(reader.getSampleType(), SAMPLE_UINT16);
+
+    ImageU16 words("test-image-io.tif");
+    ASSERT_EQ(words.getWidth(), 3);
+    ASSERT_EQ(words.getHeight(), 3);
+    ASSERT_EQ(words(0, 0), 1);
+    ASSERT_EQ(words(2, 0), 3);
+    ASSERT_EQ(words(0, 1), 256);
+    ASSERT_EQ(words(1, 1), 512);
+    ASSERT_EQ(words(0, 2), 65535);
+    ASSERT_EQ(words(2, 2), 7);
+    std::remove("test-image-io.tif");
+
+    // Sizes that overflow size_t: 2^32 x 2^32 floats in a raw file, and in a
+    // PGM file
+    vector<unsigned char> raw(RAW_HEADER_SIZE);
+    writeRawHeader(&raw[0], SAMPLE_FLOAT, size_t(1) << 32, size_t(1) << 32);
+    raw.resize(64, 0);
+    writeFile("test-image-io.raw", raw);
+    ASSERT_THROW(ImageFileReader("test-image-io.raw"), std::runtime_error);
+    ASSERT_THROW(Image("test-image-io.raw"), std::runtime_error);
+    std::remove("test-image-io.raw");
+
+    header = "P5\n4294967296 4294967296\n65535\n";
+    data.assign(header.begin(), header.end());
+    data.resize(64, 0);
+    writeFile("test-image-io.pgm", data);
+    ASSERT_THROW(ImageU16("test-image-io.pgm"), std::runtime_error);
+    std::remove("test-image-io.pgm");
+
+    // TIFF file that ends before the offset of its first directory
+    const unsigned char short_tiff[] = {'I', 'I', 42, 0, 8};
+    writeFile("test-image-io.tif", vector<unsigned char>(short_tiff, short_tiff + sizeof(short_tiff)));
+    ASSERT_THROW(ImageFileReader("test-image-io.tif"), std::runtime_error);
+    std::remove("test-image-io.tif");
+
+    // The extensions
+    ASSERT_EQ(getFileFormat("a.JPG"), FORMAT_JPEG);
+    ASSERT_EQ(getFileFormat("a.b.pfm"), FORMAT_PFM);
+    ASSERT_EQ(getFileFormat("a.tiff"), FORMAT_TIFF);
+    ASSERT_THROW(getFileFormat("a"), std::runtime_error);
+}
@@ -0,0 +1,240 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "Image.h"
+#include "PixelKernels.h"
+#include "gtest/gtest.h"
+
+
+using namespace std;
+
+// Create test data with negative, null and positive values.
+// 37 pixels, so that the tails of the vector loops are used too.
+vector<float> createTestData()
+{
+    vector<float> data;
+    for (int i = 0; i < 37; ++i)
+    {
+        data.push_back((i - 18) * 1.5f);
+    }
+    return data;
+}
+
+// All the instruction sets must give exactly the same results as plain C++
+TEST(Kernels, AllInstructionSets)
+{
+    vector<float> input = createTestData();
+    vector<float> other(input.rbegin(), input.rend());
+    for (size_t i = 0; i < other.size(); ++i) other[i] += 100.0f;
+
+    const PixelKernels* p_reference = getPixelKernels(SIMD_SCALAR);
+    ASSERT_TRUE(p_reference != NULL);
+
+    for (int level = SIMD_SCALAR; level <= SIMD_AVX512; ++level)
+    {
+        const PixelKernels* p_kernels = getPixelKernels(SIMDLevel(level));
+
+        // Not supported by the CPU
+        if (!p_kernels) continue;
+
+        cout << "Testing " << p_kernels->name << endl;
+        size_t n = input.size();
+        vector<float> expected(n), actual(n);
+
+        PixelKernels::ScalarKernel scalar_kernels[][2] = {
+            {p_reference->addScalar,      p_kernels->addScalar},
+            {p_reference->subtractScalar, p_kernels->subtractScalar},
+            {p_reference->multiplyScalar, p_kernels->multiplyScalar},
+            {p_reference->divideScalar,   p_kernels->divideScalar},
+            {p_reference->scalarSubtract, p_kernels->scalarSubtract},
+            {p_reference->scalarDivide,   p_kernels->scalarDivide}
+        };
+        for (size_t k = 0; k < 6; ++k)
+        {
+            scalar_kernels[k][0](&input[0], 3.0f, &expected[0], n);
+            scalar_kernels[k][1](&input[0], 3.0f, &actual[0], n);
+            ASSERT_EQ(expected, actual);
+        }
+
+        // The multiply-add accumulates in the output
+        expected = other;
+        actual = other;
+        p_reference->multiplyAdd(&input[0], 3.0f, &expected[0], n);
+        p_kernels->multiplyAdd(&input[0], 3.0f, &actual[0], n);
+        ASSERT_EQ(expected, actual);
+
+        PixelKernels::BinaryKernel binary_kernels[][2] = {
+            {p_reference->add,      p_kernels->add},
+            {p_reference->subtract, p_kernels->subtract},
+            {p_reference->multiply, p_kernels->multiply},
+            {p_reference->divide,   p_kernels->divide}
+        };
+        for (size_t k = 0; k < 4; ++k)
+        {
+            binary_kernels[k][0](&input[0], &other[0], &expected[0], n);
+            binary_kernels[k][1](&input[0], &other[0], &actual[0], n);
+            ASSERT_EQ(expected, actual);
+        }
+
+        PixelKernels::UnaryKernel unary_kernels[][2] = {
+            {p_reference->absoluteValue, p_kernels->absoluteValue},
+            {p_reference->square,        p_kernels->square},
+            {p_reference->squareRoot,    p_kernels->squareRoot}
+        };
+        for (size_t k = 0; k < 3; ++k)
+        {
+            unary_kernels[k][0](&other[0], &expected[0], n);
+            unary_kernels[k][1](&other[0], &actual[0], n);
+            ASSERT_EQ(expected, actual);
+        }
+
+        p_reference->clamp(&input[0], -5.0f, 7.0f, &expected[0], n);
+        p_kernels->clamp(&input[0], -5.0f, 7.0f, &actual[0], n);
+        ASSERT_EQ(expected, actual);
+
+        // In place
+        actual = input;
+        p_kernels->multiplyScalar(&actual[0], 2.0f, &actual[0], n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            ASSERT_EQ(actual[i], input[i] * 2.0f);
+        }
+    }
+}
+
+// The conversions must saturate and round to the nearest integer (ties to
+// even) with all the instruction sets
+TEST(Kernels, Conversions)
+{
+    // 37 values, so that the tails of the vector loops are used too
+    const float values[] = {
+        -1e9f, -300.0f, -0.5f, -0.0f, 0.0f, 0.4f, 0.5f, 1.5f, 2.5f, 3.49f,
+        3.5f, 127.5f, 128.5f, 200.0f, 254.5f, 255.0f, 255.4f, 255.5f, 256.0f, 1000.0f,
+        1000.5f, 1001.5f, 32767.5f, 32768.0f, 65534.5f, 65535.0f, 65535.5f, 65536.0f, 1e9f, -7.0f,
+        12.25f, 99.75f, 300.0f, 40000.0f, 0.0f, 0.0f, 0.0f
+    };
+    vector<float> input(values, values + 37);
+    input[34] = std::numeric_limits<float>::quiet_NaN();
+    input[35] = std::numeric_limits<float>::infinity();
+    input[36] = -std::numeric_limits<float>::infinity();
+    size_t n = input.size();
+
+    // The expected values, computed with plain C++
+    vector<uint8_t> expected_bytes(n);
+    vector<uint16_t> expected_words(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        float value = input[i] == input[i] ? input[i] : 0.0f;
+        expected_bytes[i] = uint8_t(nearbyint(max(0.0f, min(255.0f, value))));
+        expected_words[i] = uint16_t(nearbyint(max(0.0f, min(65535.0f, value))));
+    }
+
+    ASSERT_EQ(expected_bytes[6], 0);
+    ASSERT_EQ(expected_bytes[8], 2);
+    ASSERT_EQ(expected_bytes[14], 254);
+    ASSERT_EQ(expected_bytes[18], 255);
+    ASSERT_EQ(expected_words[0], 0);
+    ASSERT_EQ(expected_words[24], 65534);
+    ASSERT_EQ(expected_words[28], 65535);
+
+    for (int level = SIMD_SCALAR; level <= SIMD_AVX512; ++level)
+    {
+        const PixelKernels* p_kernels = getPixelKernels(SIMDLevel(level));
+        if (!p_kernels) continue;
+
+        vector<uint8_t> bytes(n);
+        vector<uint16_t> words(n);
+        p_kernels->convertToUInt8(&input[0], &bytes[0], n);
+        p_kernels->convertToUInt16(&input[0], &words[0], n);
+        ASSERT_EQ(bytes, expected_bytes);
+        ASSERT_EQ(words, expected_words);
+
+        // Back to float
+        vector<float> from_bytes(n), from_words(n);
+        p_kernels->convertFromUInt8(&bytes[0], &from_bytes[0], n);
+        p_kernels->convertFromUInt16(&words[0], &from_words[0], n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            ASSERT_EQ(from_bytes[i], float(bytes[i]));
+            ASSERT_EQ(from_words[i], float(words[i]));
+        }
+    }
+}
+
+// Test the point operators of the Image class
+TEST(Kernels, PointOperators)
+{
+    vector<float> data = createTestData();
+    Image input_image(data, data.size(), 1);
+
+    Image abs_image = input_image.absoluteValue();
+    Image square_image = input_image.square();
+    Image sqrt_image = abs_image.squareRoot();
+    Image clamp_image = input_image.clamp(-5, 7);
+    Image negative_image = 255 - input_image;
+
+    ASSERT_EQ(abs_image.getWidth(), input_image.getWidth());
+    ASSERT_EQ(abs_image.getHeight(), input_image.getHeight());
+
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        ASSERT_NEAR(abs_image(i, 0), fabs(data[i]), 1e-6);
+        ASSERT_NEAR(square_image(i, 0), data[i] * data[i], 1e-6);
+        ASSERT_NEAR(sqrt_image(i, 0), sqrt(fabs(data[i])), 1e-6);
+        ASSERT_NEAR(clamp_image(i, 0), max(-5.0f, min(7.0f, data[i])), 1e-6);
+        ASSERT_NEAR(negative_image(i, 0), 255 - data[i], 1e-6);
+    }
+
+    ASSERT_NEAR(clamp_image.getMinValue(), -5, 1e-6);
+    ASSERT_NEAR(clamp_image.getMaxValue(), 7, 1e-6);
+}
+
+// Test the statistics of an image
+TEST(Kernels, Statistics)
+{
+    // A large image with a large offset: the naive algorithm with a float
+    // accumulator is not accurate enough here. 1000 x 1003 pixels, so that
+    // several threads and chunks are used, and the last chunk is incomplete.
+    size_t width = 1000;
+    size_t height = 1003;
+    vector<float> data(width * height);
+    double sum = 0;
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = 10000.0f + float(i % 7);
+        sum += data[i];
+    }
+    double mean = sum / data.size();
+
+    double sum_of_squares = 0;
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        sum_of_squares += (data[i] - mean) * (data[i] - mean);
+    }
+    double stddev = sqrt(sum_of_squares / data.size());
+
+    Image image(data, width, height);
+    ASSERT_NEAR(image.getMinValue(), 10000, 1e-6);
+    ASSERT_NEAR(image.getMaxValue(), 10006, 1e-6);
+    ASSERT_NEAR(image.getAverageValue(), mean, 1e-3);
+    ASSERT_NEAR(image.getStandardDeviation(), stddev, 1e-4);
+
+    // All the instruction sets must agree
+    for (int level = SIMD_SCALAR; level <= SIMD_AVX512; ++level)
+    {
+        const PixelKernels* p_kernels = getPixelKernels(SIMDLevel(level));
+        if (!p_kernels) continue;
+
+        // 37 pixels, so that the tails of the vector loops are used too.
+        vector<float> small_data = createTestData();
+        PixelStatistics statistics = p_kernels->statistics(&small_data[0], small_data.size());
+        ASSERT_EQ(statistics.count, small_data.size());
+        ASSERT_NEAR(statistics.min, -27, 1e-6);
+        ASSERT_NEAR(statistics.max, 27, 1e-6);
+        ASSERT_NEAR(statistics.mean, 0, 1e-6);
+        ASSERT_NEAR(statistics.sum_of_squares, 2.25 * 2 * 18 * 19 * 37 / 6, 1e-3);
+    }
+}
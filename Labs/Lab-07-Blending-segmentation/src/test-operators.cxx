@@ -31,3 +31,105 @@ TEST(Operators, FloatImageOperators)
     }
 }
 
+
+// Test the move constructor and the move assignment operator
+TEST(Operators, MoveSemantics)
+{
+    Image input_image({0, 1, 2, 3, 4, 5, 6 , 7}, 4, 2);
+    const float* p_data = input_image.getPixelPointer();
+
+    // The pixel data is taken over, not copied
+    Image moved_image(std::move(input_image));
+    ASSERT_EQ(moved_image.getWidth(), 4);
+    ASSERT_EQ(moved_image.getHeight(), 2);
+    EXPECT_TRUE(moved_image.getPixelPointer() == p_data);
+
+    // The moved image is empty
+    ASSERT_EQ(input_image.getWidth(), 0);
+    ASSERT_EQ(input_image.getHeight(), 0);
+    EXPECT_TRUE(input_image.getPixelPointer() == NULL);
+
+    Image assigned_image;
+    assigned_image = std::move(moved_image);
+    EXPECT_TRUE(assigned_image.getPixelPointer() == p_data);
+    EXPECT_TRUE(moved_image.getPixelPointer() == NULL);
+
+    // A chain of operators reuses the buffer of the temporary
+    Image chained_image = (std::move(assigned_image) - 1) / 2;
+    EXPECT_TRUE(chained_image.getPixelPointer() == p_data);
+
+    size_t k = 0;
+    for (size_t j = 0; j < chained_image.getHeight(); ++j)
+    {
+        for (size_t i = 0; i < chained_image.getWidth(); ++i, ++k)
+        {
+            ASSERT_NEAR(chained_image(i, j), (k - 1.0) / 2.0, 1e-6);
+        }
+    }
+}
+
+// Test the in-place operators
+TEST(Operators, InPlaceOperators)
+{
+    Image input_image({0, 1, 2, 3, 4, 5, 6 , 7}, 4, 2);
+    const float* p_data = input_image.getPixelPointer();
+
+    // The statistics must be updated after each operator
+    ASSERT_NEAR(input_image.getMaxValue(), 7, 1e-6);
+
+    input_image += 1;
+    ASSERT_NEAR(input_image.getMaxValue(), 8, 1e-6);
+
+    input_image *= 4;
+    ASSERT_NEAR(input_image.getMaxValue(), 32, 1e-6);
+
+    input_image -= 2;
+    ASSERT_NEAR(input_image.getMaxValue(), 30, 1e-6);
+
+    input_image /= 2;
+    ASSERT_NEAR(input_image.getMinValue(), 1, 1e-6);
+    ASSERT_NEAR(input_image.getMaxValue(), 15, 1e-6);
+
+    // No reallocation
+    EXPECT_TRUE(input_image.getPixelPointer() == p_data);
+
+    // The normalisation is from 0 to 1
+    Image normalised_image = input_image.normalise();
+    ASSERT_NEAR(normalised_image.getMinValue(), 0, 1e-6);
+    ASSERT_NEAR(normalised_image.getMaxValue(), 1, 1e-6);
+}
+
+// Test the pixel-wise expressions between images
+TEST(Operators, ImageExpressions)
+{
+    Image image1({0, 1, 2, 3, 4, 5, 6 , 7}, 4, 2);
+    Image image2(1.0, 4, 2);
+    float alpha = 0.25;
+
+    // Blending of two images
+    Image blend = alpha * image1 + (1.0 - alpha) * image2;
+    ASSERT_EQ(blend.getWidth(), image1.getWidth());
+    ASSERT_EQ(blend.getHeight(), image1.getHeight());
+
+    // Assignment in place
+    const float* p_data = blend.getPixelPointer();
+    blend = blend - image2 + 1;
+    EXPECT_TRUE(blend.getPixelPointer() == p_data);
+
+    size_t k = 0;
+    for (size_t j = 0; j < blend.getHeight(); ++j)
+    {
+        for (size_t i = 0; i < blend.getWidth(); ++i, ++k)
+        {
+            ASSERT_NEAR(blend(i, j), alpha * k + (1.0 - alpha), 1e-6);
+        }
+    }
+
+    // The statistics must be computed on the new pixel values
+    ASSERT_NEAR(blend.getMinValue(), 1.0 - alpha, 1e-6);
+    ASSERT_NEAR(blend.getMaxValue(), alpha * 7 + (1.0 - alpha), 1e-6);
+
+    // The images must have the same size
+    Image image3(1.0, 2, 4);
+    EXPECT_THROW(Image(image1 + image3), std::invalid_argument);
+}
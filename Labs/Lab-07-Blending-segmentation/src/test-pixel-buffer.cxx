@@ -0,0 +1,227 @@
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <cstdint>      // uintptr_t
+#include <atomic>
+#include <thread>
+
+#include "Image.h"
+#include "PixelBuffer.h"
+#include "ThreadPool.h"
+#include "gtest/gtest.h"
+
+
+using namespace std;
+
+// True if a pointer is aligned on PIXEL_ALIGNMENT bytes
+bool isAligned(const void* aPointer)
+{
+    return reinterpret_cast<uintptr_t>(aPointer) % PIXEL_ALIGNMENT == 0;
+}
+
+// Allocator that counts its allocations
+class CountingAllocator: public AlignedAllocator
+{
+public:
+    CountingAllocator(): m_allocations(0), m_deallocations(0) {}
+
+    virtual void* allocate(size_t aSize)
+    {
+        ++m_allocations;
+        return AlignedAllocator::allocate(aSize);
+    }
+
+    virtual void deallocate(void* aBlock, size_t aSize)
+    {
+        ++m_deallocations;
+        AlignedAllocator::deallocate(aBlock, aSize);
+    }
+
+    atomic<size_t> m_allocations;
+    atomic<size_t> m_deallocations;
+};
+
+// Test the buffer operations
+TEST(PixelBuffer, Buffer)
+{
+    PixelBuffer<float> empty;
+    ASSERT_EQ(empty.size(), 0);
+    ASSERT_TRUE(empty.data() == NULL);
+
+    PixelBuffer<float> constant(1000, 3.0f);
+    ASSERT_EQ(constant.size(), 1000);
+    ASSERT_TRUE(isAligned(constant.data()));
+    for (size_t i = 0; i < constant.size(); ++i) ASSERT_EQ(constant[i], 3.0f);
+
+    // Copy
+    PixelBuffer<float> copy(constant);
+    ASSERT_EQ(copy.size(), 1000);
+    ASSERT_TRUE(copy.data() != constant.data());
+    ASSERT_EQ(copy[999], 3.0f);
+
+    // The memory is reused by the assignment of a buffer of the same size
+    const float* p_data = copy.data();
+    constant[0] = 5.0f;
+    copy = constant;
+    ASSERT_EQ(copy.data(), p_data);
+    ASSERT_EQ(copy[0], 5.0f);
+
+    // Move
+    PixelBuffer<float> moved(std::move(copy));
+    ASSERT_EQ(moved.data(), p_data);
+    ASSERT_EQ(copy.size(), 0);
+    ASSERT_TRUE(copy.data() == NULL);
+
+    // Resize: the pixels are kept
+    moved.resize(10);
+    ASSERT_EQ(moved.size(), 10);
+    ASSERT_EQ(moved[0], 5.0f);
+    ASSERT_EQ(moved[9], 3.0f);
+    moved.clear();
+    ASSERT_EQ(moved.size(), 0);
+
+    // Other pixel types
+    PixelBuffer<uint8_t> bytes(3, 7);
+    ASSERT_TRUE(isAligned(bytes.data()));
+    ASSERT_EQ(bytes[2], 7);
+}
+
+// Test the size classes of the pools
+TEST(PixelBuffer, SizeClasses)
+{
+    ASSERT_EQ(BufferPool::getSizeClass(1), PIXEL_ALIGNMENT);
+    ASSERT_EQ(BufferPool::getSizeClass(64), 64);
+    ASSERT_EQ(BufferPool::getSizeClass(1024), 1024);
+    ASSERT_EQ(BufferPool::getSizeClass(1025), 1280);
+    ASSERT_EQ(BufferPool::getSizeClass(1500), 1536);
+    ASSERT_EQ(BufferPool::getSizeClass(1900), 2048);
+
+    // Less than 25% of waste
+    for (size_t size = 64; size < 100000; size += 37)
+    {
+        size_t size_class = BufferPool::getSizeClass(size);
+        ASSERT_GE(size_class, size);
+        ASSERT_LT(size_class, size + size / 4 + 16);
+        ASSERT_EQ(BufferPool::getSizeClass(size_class), size_class);
+    }
+}
+
+// The pools recycle the released blocks
+TEST(PixelBuffer, Pool)
+{
+    BufferPool pool(1 << 20);
+
+    void* p_block = pool.allocate(1000);
+    ASSERT_TRUE(isAligned(p_block));
+    pool.deallocate(p_block, 1000);
+    ASSERT_EQ(pool.getCachedSize(), 1024);
+
+    // Same size class
+    ASSERT_EQ(pool.allocate(1010), p_block);
+    ASSERT_EQ(pool.getCachedSize(), 0);
+    pool.deallocate(p_block, 1010);
+
+    // The blocks that do not fit in the cache are released
+    void* p_large_block = pool.allocate(2 << 20);
+    pool.deallocate(p_large_block, 2 << 20);
+    ASSERT_EQ(pool.getCachedSize(), 1024);
+
+    pool.setMaximumCachedSize(0);
+    ASSERT_EQ(pool.getCachedSize(), 0);
+}
+
+// The images use aligned buffers from the current allocator
+TEST(PixelBuffer, Images)
+{
+    shared_ptr<CountingAllocator> allocator(make_shared<CountingAllocator>());
+
+    {
+        ScopedPixelAllocator scope(allocator);
+
+        Image image(1.0f, 101, 37);
+        ASSERT_TRUE(isAligned(image.getPixelPointer()));
+        ASSERT_EQ(allocator->m_allocations, 1);
+
+        // An expression only allocates its result
+        Image result = (image + 1.0f) * 2.0f;
+        ASSERT_EQ(result(100, 36), 4.0f);
+        ASSERT_EQ(allocator->m_allocations, 2);
+
+        ImageU8 bytes(result);
+        ASSERT_TRUE(isAligned(bytes.getPixelPointer()));
+        ASSERT_EQ(allocator->m_allocations, 3);
+    }
+
+    ASSERT_EQ(allocator->m_deallocations, 3);
+
+    // Back to the default allocator
+    Image image(1.0f, 101, 37);
+    ASSERT_EQ(allocator->m_allocations, 3);
+
+    // A chain of operations recycles its temporaries
+    shared_ptr<BufferPool> arena(make_shared<BufferPool>());
+    {
+        ScopedPixelAllocator scope(arena);
+        Image result = image;
+        result = result.absoluteValue();
+        result = result.squareRoot();
+        result = result.absoluteValue();
+    }
+    ASSERT_EQ(arena->getCachedSize(), BufferPool::getSizeClass(101 * 37 * sizeof(float)) * 2);
+}
+
+// The tasks of the thread pool allocate their buffers from the allocator of
+// the caller, not from the default allocator
+TEST(PixelBuffer, AllocatorOfTasks)
+{
+    ThreadPool& pool = ThreadPool::getInstance();
+    pool.setNumberOfThreads(4);
+
+    // Small tiles: the convolution is computed by 75 strips of 8 rows, each
+    // with its own buffer
+    pool.setTileSize(4000);
+
+    Image image(0.0f, 1000, 600);
+    for (size_t row = 0; row < image.getHeight(); ++row)
+    {
+        for (size_t col = 0; col < image.getWidth(); ++col)
+        {
+            image(col, row) = float((col * 7 + row * 13) % 256);
+        }
+    }
+
+    Image kernel(1.0f, 5, 5);
+    kernel(1, 3) = 2.0f;
+
+    shared_ptr<CountingAllocator> heap(make_shared<CountingAllocator>());
+    shared_ptr<CountingAllocator> arena(make_shared<CountingAllocator>());
+    setDefaultPixelAllocator(heap);
+    {
+        ScopedPixelAllocator scope(arena);
+        Image result = image.conv2d(kernel, BORDER_EXTEND, CONVOLUTION_SPATIAL);
+        ASSERT_EQ(result.getWidth(), image.getWidth());
+    }
+
+    // The result and the buffers of the strips
+    ASSERT_GE(arena->m_allocations, 1 + 75);
+    ASSERT_EQ(arena->m_deallocations, arena->m_allocations);
+    ASSERT_EQ(heap->m_allocations, 0);
+
+    // Each task waits for the other ones: the four threads run one each
+    {
+        ScopedPixelAllocator scope(arena);
+        atomic<int> started(0);
+        pool.run(4, [&](size_t)
+        {
+            ++started;
+            while (started < 4) this_thread::yield();
+            PixelBuffer<float> buffer(100);
+        });
+    }
+    ASSERT_GE(arena->m_allocations, 1 + 75 + 4);
+    ASSERT_EQ(heap->m_allocations, 0);
+
+    setDefaultPixelAllocator(make_shared<BufferPool>());
+    pool.setTileSize(0);
+    pool.setNumberOfThreads(0);
+}
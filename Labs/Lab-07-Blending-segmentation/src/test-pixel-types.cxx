@@ -0,0 +1,186 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <cstdio>       // std::remove
+
+#include "Image.h"
+#include "gtest/gtest.h"
+
+
+using namespace std;
+
+// Create a test image with a non-trivial content, and values beyond [0, 255]
+Image createTestImage(size_t aWidth = 97, size_t aHeight = 61)
+{
+    Image image(0.0f, aWidth, aHeight);
+    for (size_t row = 0; row < aHeight; ++row)
+    {
+        for (size_t col = 0; col < aWidth; ++col)
+        {
+            image(col, row) = std::sin(col * 0.7f) * 200.0f + row * 3.0f - col + 0.25f;
+        }
+    }
+    return image;
+}
+
+// Test the constructors and the accessors of the compact images
+TEST(PixelTypes, Constructors)
+{
+    ImageU8 empty;
+    ASSERT_EQ(empty.getWidth(), 0);
+    ASSERT_EQ(empty.getHeight(), 0);
+    ASSERT_TRUE(empty.getPixelPointer() == NULL);
+
+    ImageU8 constant(uint8_t(7), 5, 3);
+    ASSERT_EQ(constant.getWidth(), 5);
+    ASSERT_EQ(constant.getHeight(), 3);
+    ASSERT_EQ(constant(4, 2), 7);
+    ASSERT_EQ(constant.getAverageValue(), 7);
+    ASSERT_THROW(constant(5, 0), std::out_of_range);
+
+    vector<uint16_t> data;
+    for (uint16_t i = 0; i < 12; ++i) data.push_back(i * 1000);
+    ImageU16 words(data, 4, 3);
+    ASSERT_EQ(words(3, 2), 11000);
+    ASSERT_EQ(words.getRow(1)[2], 6000);
+    ASSERT_EQ(words.getMinValue(), 0);
+    ASSERT_EQ(words.getMaxValue(), 11000);
+
+    // The statistics are updated when a pixel is modified
+    words(0, 0) = 60000;
+    ASSERT_EQ(words.getMaxValue(), 60000);
+
+    // Move
+    ImageU16 moved(std::move(words));
+    ASSERT_EQ(moved.getWidth(), 4);
+    ASSERT_EQ(words.getWidth(), 0);
+    ASSERT_TRUE(words.getPixelPointer() == NULL);
+}
+
+// The conversions to integers are rounded and saturated
+TEST(PixelTypes, Conversions)
+{
+    const float values[] = {-10.0f, 0.0f, 0.5f, 1.5f, 100.4f, 254.5f, 255.0f, 300.0f, 70000.0f};
+    Image image(values, 9, 1);
+
+    ImageU8 bytes(image);
+    const uint8_t expected_bytes[] = {0, 0, 0, 2, 100, 254, 255, 255, 255};
+    for (size_t i = 0; i < 9; ++i) ASSERT_EQ(bytes(i, 0), expected_bytes[i]);
+
+    ImageU16 words(image);
+    const uint16_t expected_words[] = {0, 0, 0, 2, 100, 254, 255, 300, 65535};
+    for (size_t i = 0; i < 9; ++i) ASSERT_EQ(words(i, 0), expected_words[i]);
+
+    // Between integer types
+    ImageU8 bytes_from_words(words);
+    for (size_t i = 0; i < 9; ++i) ASSERT_EQ(bytes_from_words(i, 0), expected_bytes[i]);
+
+    ImageU16 words_from_bytes(bytes);
+    for (size_t i = 0; i < 9; ++i) ASSERT_EQ(words_from_bytes(i, 0), expected_bytes[i]);
+
+    // The conversions to float are exact
+    Image back(bytes);
+    for (size_t i = 0; i < 9; ++i) ASSERT_EQ(back(i, 0), expected_bytes[i]);
+}
+
+// Test the half-precision numbers
+TEST(PixelTypes, Half)
+{
+    // Exact values
+    const float exact_values[] = {0.0f, 1.0f, -2.0f, 0.5f, 1024.0f, 65504.0f, 6.103515625e-05f, 5.9604644775390625e-08f};
+    for (size_t i = 0; i < 8; ++i)
+    {
+        ASSERT_EQ(float(Half(exact_values[i])), exact_values[i]);
+    }
+
+    // Known binary representations
+    ASSERT_EQ(Half(1.0f).getBits(), 0x3c00);
+    ASSERT_EQ(Half(-2.0f).getBits(), 0xc000);
+    ASSERT_EQ(Half(-0.0f).getBits(), 0x8000);
+    ASSERT_EQ(Half(65504.0f).getBits(), 0x7bff);
+
+    // Rounding to the nearest, ties to even: 1 + 2^-11 is halfway between 1
+    // and 1 + 2^-10
+    ASSERT_EQ(Half(1.0f + 1.0f / 2048.0f).getBits(), 0x3c00);
+    ASSERT_EQ(Half(1.0f + 3.0f / 2048.0f).getBits(), 0x3c02);
+    ASSERT_EQ(Half(1.0f + 1.0f / 2048.0f + 1.0f / 65536.0f).getBits(), 0x3c01);
+
+    // Saturation, infinities and NaN
+    ASSERT_EQ(Half(1e6f).getBits(), 0x7bff);
+    ASSERT_EQ(Half(-1e6f).getBits(), 0xfbff);
+    ASSERT_EQ(Half(std::numeric_limits<float>::infinity()).getBits(), 0x7c00);
+    float nan = float(Half(std::numeric_limits<float>::quiet_NaN()));
+    ASSERT_TRUE(nan != nan);
+
+    // Subnormals
+    ASSERT_EQ(Half(5.9604644775390625e-08f).getBits(), 0x0001);
+    ASSERT_EQ(Half(2.0f * 5.9604644775390625e-08f).getBits(), 0x0002);
+    ASSERT_EQ(Half(1e-9f).getBits(), 0x0000);
+
+    // All the halves are converted back to themselves
+    for (uint32_t bits = 0; bits < 0x7c00; ++bits)
+    {
+        uint16_t half_bits = uint16_t(bits);
+        Half half = Half::fromBits(half_bits);
+        ASSERT_EQ(half.getBits(), half_bits);
+        ASSERT_EQ(Half(float(half)).getBits(), half_bits);
+    }
+
+    // Half images
+    Image image = createTestImage();
+    ImageHalf halves(image);
+    Image back(halves);
+    for (size_t i = 0; i < image.getWidth() * image.getHeight(); ++i)
+    {
+        float expected = image.getPixelPointer()[i];
+        ASSERT_NEAR(back.getPixelPointer()[i], expected, std::fabs(expected) / 1024.0f);
+    }
+}
+
+// The statistics of a compact image are the ones of its conversion to float
+TEST(PixelTypes, Statistics)
+{
+    // Several chunks, the last one incomplete
+    Image image = createTestImage(1000, 203);
+
+    ImageU8 bytes(image);
+    Image float_bytes(bytes);
+    ASSERT_EQ(bytes.getMinValue(), float_bytes.getMinValue());
+    ASSERT_EQ(bytes.getMaxValue(), float_bytes.getMaxValue());
+    ASSERT_EQ(bytes.getAverageValue(), float_bytes.getAverageValue());
+    ASSERT_EQ(bytes.getStandardDeviation(), float_bytes.getStandardDeviation());
+
+    ImageHalf halves(image);
+    Image float_halves(halves);
+    ASSERT_EQ(halves.getAverageValue(), float_halves.getAverageValue());
+    ASSERT_EQ(halves.getStandardDeviation(), float_halves.getStandardDeviation());
+}
+
+// An 8-bit image loaded from a JPEG file is the rounded luminance
+TEST(PixelTypes, JPEG)
+{
+    Image image = createTestImage();
+    image.saveJPEG("test-pixel-types.jpg");
+
+    Image float_image("test-pixel-types.jpg");
+    ImageU8 bytes("test-pixel-types.jpg");
+    ImageU16 words("test-pixel-types.jpg");
+    ASSERT_EQ(bytes.getWidth(), image.getWidth());
+    ASSERT_EQ(bytes.getHeight(), image.getHeight());
+
+    ImageU8 expected(float_image);
+    for (size_t i = 0; i < image.getWidth() * image.getHeight(); ++i)
+    {
+        ASSERT_EQ(bytes.getPixelPointer()[i], expected.getPixelPointer()[i]);
+        ASSERT_EQ(words.getPixelPointer()[i], expected.getPixelPointer()[i]);
+    }
+
+    // Save and load again
+    bytes.saveJPEG("test-pixel-types.jpg");
+    ImageU8 reloaded("test-pixel-types.jpg");
+    ASSERT_EQ(reloaded.getWidth(), bytes.getWidth());
+    ASSERT_NEAR(reloaded.getAverageValue(), bytes.getAverageValue(), 1.0);
+
+    std::remove("test-pixel-types.jpg");
+}
@@ -0,0 +1,235 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+#include "Image.h"
+#include "ThreadPool.h"
+#include "gtest/gtest.h"
+
+
+using namespace std;
+
+// Create a test image with a non-trivial content. 97 columns, so that the
+// tiles do not start at the beginning of a row.
+Image createTestImage(size_t aWidth = 97, size_t aHeight = 61)
+{
+    Image image(0.0f, aWidth, aHeight);
+    for (size_t row = 0; row < aHeight; ++row)
+    {
+        for (size_t col = 0; col < aWidth; ++col)
+        {
+            image(col, row) = std::sin(col * 0.7f) * 50.0f + row * 3.0f - col;
+        }
+    }
+    return image;
+}
+
+// Run all the multithreaded operations of the Image class
+vector<vector<float> > runImageOperations()
+{
+    Image image = createTestImage();
+
+    Image kernel(1.0f, 15, 11);
+    kernel(3, 4) = 5.0f;
+
+    vector<Image> results;
+    results.push_back(image * 2.0f + image.absoluteValue() / 3.0f - 1.0f);
+    results.push_back(image.square().squareRoot());
+    results.push_back(image.clamp(-10.0f, 20.0f));
+
+    Image compound = image;
+    compound += 2.0f;
+    compound *= 0.5f;
+    results.push_back(compound);
+
+    results.push_back(image.conv2d(kernel, BORDER_EXTEND, CONVOLUTION_SPATIAL));
+    results.push_back(image.conv2d(kernel, BORDER_ZERO, CONVOLUTION_FFT));
+    results.push_back(image.gaussianFilter());
+    results.push_back(image.gradientMagnitude());
+    results.push_back(image.sharpen(0.5));
+
+    vector<vector<float> > pixels;
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        pixels.push_back(vector<float>(results[i].getPixelPointer(),
+            results[i].getPixelPointer() + results[i].getWidth() * results[i].getHeight()));
+    }
+
+    pixels.push_back(vector<float>());
+    pixels.back().push_back(image.getMinValue());
+    pixels.back().push_back(image.getMaxValue());
+    pixels.back().push_back(image.getAverageValue());
+    pixels.back().push_back(image.getStandardDeviation());
+
+    return pixels;
+}
+
+// Every task is run exactly once, whatever the number of threads
+TEST(ThreadPool, AllTasksRun)
+{
+    ThreadPool& pool = ThreadPool::getInstance();
+
+    for (size_t number_of_threads = 1; number_of_threads <= 8; ++number_of_threads)
+    {
+        pool.setNumberOfThreads(number_of_threads);
+        ASSERT_EQ(pool.getNumberOfThreads(), number_of_threads);
+
+        for (size_t number_of_tasks = 0; number_of_tasks < 200; number_of_tasks += 13)
+        {
+            vector<atomic<int> > counters(number_of_tasks);
+            for (size_t i = 0; i < number_of_tasks; ++i) counters[i] = 0;
+
+            pool.run(number_of_tasks, [&](size_t aTask) { ++counters[aTask]; });
+
+            for (size_t i = 0; i < number_of_tasks; ++i)
+            {
+                ASSERT_EQ(counters[i], 1);
+            }
+        }
+    }
+
+    pool.setNumberOfThreads(0);
+}
+
+// The tiles cover all the pixels once
+TEST(ThreadPool, Tiles)
+{
+    ThreadPool& pool = ThreadPool::getInstance();
+    pool.setNumberOfThreads(4);
+    pool.setTileSize(100);
+    ASSERT_EQ(pool.getTileSize(), 100);
+
+    vector<atomic<int> > counters(1234);
+    for (size_t i = 0; i < counters.size(); ++i) counters[i] = 0;
+
+    pool.runOnTiles(counters.size(), [&](size_t aFirstPixel, size_t aNumberOfPixels)
+    {
+        ASSERT_LE(aNumberOfPixels, 100);
+        for (size_t i = aFirstPixel; i < aFirstPixel + aNumberOfPixels; ++i) ++counters[i];
+    });
+
+    for (size_t i = 0; i < counters.size(); ++i)
+    {
+        ASSERT_EQ(counters[i], 1);
+    }
+
+    // Back to the default
+    pool.setTileSize(0);
+    ASSERT_EQ(pool.getTileSize(), 1 << 15);
+    pool.setNumberOfThreads(0);
+}
+
+// A job submitted from a task is run by the thread of the task
+TEST(ThreadPool, NestedJobs)
+{
+    ThreadPool& pool = ThreadPool::getInstance();
+    pool.setNumberOfThreads(4);
+
+    vector<atomic<int> > counters(10 * 10);
+    for (size_t i = 0; i < counters.size(); ++i) counters[i] = 0;
+
+    pool.run(10, [&](size_t aTask)
+    {
+        pool.run(10, [&](size_t anInnerTask) { ++counters[aTask * 10 + anInnerTask]; });
+    });
+
+    for (size_t i = 0; i < counters.size(); ++i)
+    {
+        ASSERT_EQ(counters[i], 1);
+    }
+
+    pool.setNumberOfThreads(0);
+}
+
+// The exceptions thrown by the tasks are thrown again by run
+TEST(ThreadPool, Exceptions)
+{
+    ThreadPool& pool = ThreadPool::getInstance();
+    pool.setNumberOfThreads(4);
+
+    atomic<int> counter(0);
+    ASSERT_THROW(pool.run(100, [&](size_t aTask)
+    {
+        ++counter;
+        if (aTask == 42) throw std::runtime_error("task 42");
+    }), std::runtime_error);
+
+    // All the tasks were run anyway, and the pool can still be used
+    ASSERT_EQ(counter, 100);
+
+    counter = 0;
+    pool.run(100, [&](size_t) { ++counter; });
+    ASSERT_EQ(counter, 100);
+
+    pool.setNumberOfThreads(0);
+}
+
+// The number of threads and the size of the tiles can be changed by a thread
+// while another one runs jobs: the job in progress ends first
+TEST(ThreadPool, ConcurrentReconfiguration)
+{
+    ThreadPool& pool = ThreadPool::getInstance();
+    pool.setNumberOfThreads(4);
+
+    atomic<bool> done(false);
+    thread other_thread([&]()
+    {
+        for (size_t i = 0; i < 50; ++i)
+        {
+            pool.setNumberOfThreads(1 + i % 5);
+            pool.setTileSize(100 + i);
+        }
+        done = true;
+    });
+
+    size_t number_of_jobs = 0;
+    while (!done || number_of_jobs < 50)
+    {
+        vector<atomic<int> > counters(97);
+        for (size_t i = 0; i < counters.size(); ++i) counters[i] = 0;
+
+        pool.run(counters.size(), [&](size_t aTask) { ++counters[aTask]; });
+
+        for (size_t i = 0; i < counters.size(); ++i)
+        {
+            ASSERT_EQ(counters[i], 1);
+        }
+        ++number_of_jobs;
+    }
+    other_thread.join();
+
+    // Not from a task: the job would never end
+    ASSERT_THROW(pool.run(10, [&](size_t) { pool.setNumberOfThreads(2); }), std::logic_error);
+
+    pool.setNumberOfThreads(0);
+    pool.setTileSize(0);
+}
+
+// The results do not depend on the number of threads or on the size of the
+// tiles: they must be exactly the same
+TEST(ThreadPool, DeterministicResults)
+{
+    ThreadPool& pool = ThreadPool::getInstance();
+
+    pool.setNumberOfThreads(1);
+    pool.setTileSize(0);
+    vector<vector<float> > expected = runImageOperations();
+
+    const size_t number_of_threads[] = {1, 2, 4, 7};
+    const size_t tile_sizes[] = {0, 1000, 333};
+    for (size_t i = 0; i < 4; ++i)
+    {
+        for (size_t j = 0; j < 3; ++j)
+        {
+            pool.setNumberOfThreads(number_of_threads[i]);
+            pool.setTileSize(tile_sizes[j]);
+            ASSERT_EQ(runImageOperations(), expected);
+        }
+    }
+
+    pool.setNumberOfThreads(0);
+    pool.setTileSize(0);
+}
@@ -0,0 +1,196 @@
+#include <iostream>
+#include <cmath>
+#include <cstdio>       // std::remove, std::fopen
+#include <vector>
+#include <stdexcept>    // std::runtime_error, std::invalid_argument
+
+#include "Image.h"
+#include "TiledImage.h"
+#include "ImageIO.h"
+#include "gtest/gtest.h"
+
+
+using namespace std;
+
+// Create a test image with a non-trivial content
+Image createTestImage(size_t aWidth, size_t aHeight)
+{
+    Image image(0.0f, aWidth, aHeight);
+    for (size_t row = 0; row < aHeight; ++row)
+    {
+        for (size_t col = 0; col < aWidth; ++col)
+        {
+            image(col, row) = std::sin(col * 0.1f) * 50.0f + std::cos(row * 0.07f) * 30.0f + (col * row) % 17;
+        }
+    }
+    return image;
+}
+
+// Copy an image in a new tiled image
+void createTiledImage(const Image& anImage, const char* aFilename, size_t aTileSize)
+{
+    TiledImage tiled(aFilename, anImage.getWidth(), anImage.getHeight(), aTileSize);
+    tiled.writeRegion(anImage, 0, 0);
+}
+
+// Check that two images are the same
+void checkImages(const Image& anImage, const Image& aReference, float aTolerance)
+{
+    ASSERT_EQ(anImage.getWidth(), aReference.getWidth());
+    ASSERT_EQ(anImage.getHeight(), aReference.getHeight());
+    for (size_t row = 0; row < aReference.getHeight(); ++row)
+    {
+        for (size_t col = 0; col < aReference.getWidth(); ++col)
+        {
+            ASSERT_NEAR(anImage(col, row), aReference(col, row), aTolerance);
+        }
+    }
+}
+
+// Read and write regions of the file
+TEST(TiledImage, Regions)
+{
+    Image image = createTestImage(150, 70);
+    createTiledImage(image, "test-tiled-image.raw", 32);
+
+    // The file is a raw image
+    checkImages(Image("test-tiled-image.raw"), image, 0.0f);
+
+    TiledImage tiled("test-tiled-image.raw", 32);
+    ASSERT_EQ(tiled.getWidth(), 150);
+    ASSERT_EQ(tiled.getHeight(), 70);
+    ASSERT_EQ(tiled.getTileSize(), 32);
+
+    // Inside
+    Image region = tiled.readRegion(10, 20, 30, 5, BORDER_CROP);
+    ASSERT_EQ(region(0, 0), image(10, 20));
+    ASSERT_EQ(region(29, 4), image(39, 24));
+
+    // Beyond the edges
+    region = tiled.readRegion(-3, -2, 160, 75);
+    ASSERT_EQ(region(0, 0), image(0, 0));
+    ASSERT_EQ(region(5, 1), image(2, 0));
+    ASSERT_EQ(region(159, 74), image(149, 69));
+
+    region = tiled.readRegion(-3, -2, 160, 75, BORDER_ZERO);
+    ASSERT_EQ(region(0, 0), 0.0f);
+    ASSERT_EQ(region(5, 1), 0.0f);
+    ASSERT_EQ(region(5, 2), image(2, 0));
+    ASSERT_EQ(region(153, 71), 0.0f);
+
+    region = tiled.readRegion(200, 5, 3, 2);
+    ASSERT_EQ(region(2, 1), image(149, 6));
+
+    ASSERT_THROW(tiled.readRegion(-1, 0, 10, 10, BORDER_CROP), std::invalid_argument);
+    ASSERT_THROW(tiled.writeRegion(region, 148, 0), std::invalid_argument);
+
+    // Write and read back
+    tiled.writeRegion(Image(7.0f, 3, 2), 147, 68);
+    ASSERT_EQ(tiled.readRegion(149, 69, 1, 1)(0, 0), 7.0f);
+
+    std::remove("test-tiled-image.raw");
+}
+
+// The operations by tiles give the same result as on the whole image
+TEST(TiledImage, Operations)
+{
+    Image image = createTestImage(201, 133);
+    createTiledImage(image, "test-tiled-image.raw", 64);
+
+    TiledImage input("test-tiled-image.raw", 64);
+    TiledImage output("test-tiled-image-out.raw", 201, 133, 64);
+
+    // Point operators
+    input.transform(output, [](const Image& aTile) { return Image(aTile * 2.0f + 1.0f).clamp(0.0f, 80.0f); });
+    checkImages(output.readRegion(0, 0, 201, 133), Image(image * 2.0f + 1.0f).clamp(0.0f, 80.0f), 0.0f);
+
+    // A filter, with its halo
+    input.transform(output, [](const Image& aTile) { return aTile.gaussianFilter(); }, 1);
+    checkImages(output.readRegion(0, 0, 201, 133), image.gaussianFilter(), 1.0e-4f);
+
+    // In place
+    output.transform(output, [](const Image& aTile) { return Image(aTile - 1.0f); });
+    checkImages(output.readRegion(0, 0, 201, 133), image.gaussianFilter() - 1.0f, 1.0e-4f);
+    ASSERT_THROW(output.transform(output, [](const Image& aTile) { return aTile; }, 1), std::invalid_argument);
+
+    // The operation must keep the size of the tiles
+    ASSERT_THROW(input.transform(output, [](const Image& aTile) { return aTile.conv2d(Image(1.0f, 3, 3), BORDER_CROP); }),
+                 std::invalid_argument);
+
+    std::remove("test-tiled-image.raw");
+    std::remove("test-tiled-image-out.raw");
+}
+
+// Convolutions with odd and even kernels, and all the border modes
+TEST(TiledImage, Convolution)
+{
+    Image image = createTestImage(173, 91);
+    createTiledImage(image, "test-tiled-image.raw", 40);
+    TiledImage input("test-tiled-image.raw", 40);
+
+    Image kernels[] = {createTestImage(5, 5) / 1000.0f, createTestImage(4, 3) / 1000.0f, createTestImage(1, 7) / 1000.0f};
+    BorderMode border_modes[] = {BORDER_EXTEND, BORDER_ZERO, BORDER_CROP};
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        for (size_t j = 0; j < 3; ++j)
+        {
+            Image reference = image.conv2d(kernels[i], border_modes[j], CONVOLUTION_SPATIAL);
+            TiledImage output("test-tiled-image-out.raw", reference.getWidth(), reference.getHeight(), 40);
+            input.conv2d(output, kernels[i], border_modes[j], CONVOLUTION_SPATIAL);
+            checkImages(output.readRegion(0, 0, reference.getWidth(), reference.getHeight()), reference, 1.0e-3f);
+        }
+    }
+
+    // The size of the output
+    TiledImage output("test-tiled-image-out.raw", 173, 91, 40);
+    ASSERT_THROW(input.conv2d(output, kernels[0], BORDER_CROP), std::invalid_argument);
+    ASSERT_THROW(input.conv2d(input, kernels[0]), std::invalid_argument);
+
+    std::remove("test-tiled-image.raw");
+    std::remove("test-tiled-image-out.raw");
+}
+
+// Only the raw files of floats can be opened
+TEST(TiledImage, Errors)
+{
+    ImageU8(Image(createTestImage(10, 10))).save("test-tiled-image.raw");
+    ASSERT_THROW(TiledImage("test-tiled-image.raw"), std::runtime_error);
+
+    createTestImage(10, 10).save("test-tiled-image.pfm");
+    ASSERT_THROW(TiledImage("test-tiled-image.pfm"), std::runtime_error);
+
+    ASSERT_THROW(TiledImage("does-not-exist.raw"), std::runtime_error);
+    ASSERT_THROW(TiledImage("test-tiled-image.raw", 0, 10), std::invalid_argument);
+
+    // The size of the file would overflow size_t
+    ASSERT_THROW(TiledImage("test-tiled-image.raw", size_t(1) << 32, size_t(1) << 32), std::invalid_argument);
+
+    // A header of 2^32 x 2^32 floats in a small file
+    {
+        TiledImage small("test-tiled-image.raw", 4, 4);
+    }
+    {
+        vector<unsigned char> header(RAW_HEADER_SIZE);
+        writeRawHeader(&header[0], SAMPLE_FLOAT, size_t(1) << 32, size_t(1) << 32);
+        FILE* p_file = std::fopen("test-tiled-image.raw", "r+b");
+        ASSERT_TRUE(p_file != NULL);
+        std::fwrite(&header[0], 1, header.size(), p_file);
+        std::fclose(p_file);
+    }
+    ASSERT_THROW(TiledImage("test-tiled-image.raw"), std::runtime_error);
+
+    // A valid file of 0 x 7 floats
+    {
+        vector<unsigned char> header(RAW_HEADER_SIZE);
+        writeRawHeader(&header[0], SAMPLE_FLOAT, 0, 7);
+        FILE* p_file = std::fopen("test-tiled-image.raw", "wb");
+        ASSERT_TRUE(p_file != NULL);
+        std::fwrite(&header[0], 1, header.size(), p_file);
+        std::fclose(p_file);
+    }
+    ASSERT_THROW(TiledImage("test-tiled-image.raw"), std::invalid_argument);
+
+    std::remove("test-tiled-image.raw");
+    std::remove("test-tiled-image.pfm");
+}
@@ -74,10 +74,29 @@ int main(int argc, char** argv)
             radius = atoi(argv[3]);
         }
     
-        // Write your own code here
-
+        // Load the image
+        cv::Mat input = cv::imread(argv[1], cv::IMREAD_UNCHANGED);
+        if (input.empty())
+        {
+            std::string error_message = "Cannot read ";
+            error_message += argv[1];
+            throw error_message;
+        }
 
+        // Mean over a (2r + 1) x (2r + 1) window. cv::blur keeps running sums
+        // of the columns and of the rows: the cost per pixel does not grow
+        // with the radius. The border is extended, as in Image::meanFilter.
+        cv::Mat output;
+        cv::blur(input, output, cv::Size(2 * radius + 1, 2 * radius + 1),
+                 cv::Point(-1, -1), cv::BORDER_REPLICATE);
 
+        // Save the result
+        if (!cv::imwrite(argv[2], output))
+        {
+            std::string error_message = "Cannot write ";
+            error_message += argv[2];
+            throw error_message;
+        }
     }
     // An error occured
     catch (const std::exception& error)
@@ -74,10 +74,52 @@ int main(int argc, char** argv)
             radius = atoi(argv[3]);
         }
     
-        // Write your own code here
+        // Load the image, at its own depth
+        cv::Mat input = cv::imread(argv[1], cv::IMREAD_UNCHANGED);
+        if (input.empty())
+        {
+            std::string error_message = "Cannot read ";
+            error_message += argv[1];
+            throw error_message;
+        }
 
+        // cv::medianBlur supports 16-bit and float images for 3x3 and 5x5
+        // windows only. Otherwise, the image is converted to 8 bits, with its
+        // dynamic range scaled (not saturated) to [0, 255]: 16-bit pixels are
+        // divided by 257, and float pixels are expected in [0, 1].
+        bool is_supported = input.depth() == CV_8U ||
+            (radius <= 2 && (input.depth() == CV_16U || input.depth() == CV_32F));
 
+        if (!is_supported)
+        {
+            double scale = 1.0;
+            double offset = 0.0;
+            switch (input.depth())
+            {
+            case CV_8S:  offset = 128.0; break;
+            case CV_16U: scale = 255.0 / 65535.0; break;
+            case CV_16S: scale = 255.0 / 65535.0; offset = 127.5; break;
+            case CV_32S: scale = 255.0 / 4294967295.0; offset = 127.5; break;
+            default:     scale = 255.0; break; // CV_32F and CV_64F
+            }
+
+            input.convertTo(input, CV_8U, scale, offset);
+        }
 
+        // Median filter over a (2r + 1) x (2r + 1) window. For 8-bit images,
+        // OpenCV uses sorting networks for 3x3 and 5x5 windows, and the
+        // constant-time histograms of Perreault and Hebert for larger ones:
+        // the cost per pixel does not grow with the radius.
+        cv::Mat output;
+        cv::medianBlur(input, output, 2 * radius + 1);
+
+        // Save the result
+        if (!cv::imwrite(argv[2], output))
+        {
+            std::string error_message = "Cannot write ";
+            error_message += argv[2];
+            throw error_message;
+        }
     }
     // An error occured
     catch (const std::exception& error)
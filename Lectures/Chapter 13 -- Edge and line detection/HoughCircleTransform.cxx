@@ -0,0 +1,456 @@
+/*
+
+ Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+ http://www.fpvidal.net/
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ 3. Neither the name of the Bangor University nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+/**
+ ********************************************************************************
+ *
+ *   @file       HoughCircleTransform.cxx
+ *
+ *   @brief      Hough transform for circles: the edge pixels vote along their
+ *               gradient direction for the centres, then the radius of each
+ *               centre is found with a histogram.
+ *
+ *   @version    1.0
+ *
+ *   @date       06/02/2020
+ *
+ *   @author     Dr Franck P. Vidal
+ *
+ *   @section    License
+ *               BSD 3-Clause License.
+ *
+ *               For details on use and redistribution please refer
+ *               to http://opensource.org/licenses/BSD-3-Clause
+ *
+ *   @section    Copyright
+ *               (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+ *               http://www.fpvidal.net/, Feb 2020 2020, version 1.0,
+ *               BSD 3-Clause License
+ *
+ ********************************************************************************
+ */
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+
+// Header for sqrt, floor, ceil and fabs
+#include <cmath>
+
+// C++ exceptions
+#include <stdexcept>
+
+// Header for min, max, stable_sort and lower_bound
+#include <algorithm>
+
+#include "HoughCircleTransform.h"
+
+
+//******************************************************************************
+//  Name spaces
+//******************************************************************************
+
+using namespace cv;
+using namespace std;
+
+
+//******************************************************************************
+//  Constants
+//******************************************************************************
+
+// A thread has its own accumulator if it has at least this number of votes per
+// cell of the accumulator to add
+const size_t min_votes_per_cell = 4;
+
+// The radius of the neighbourhood of the local maxima of the centre
+// accumulator (in pixels)
+const int centre_peak_radius = 2;
+
+// An edge pixel is counted in the radius histogram of a centre if the angle
+// between its gradient and the direction of the centre is below 25 degrees
+const float min_alignment = 0.9f;
+
+
+//******************************************************************************
+//  Function declarations
+//******************************************************************************
+
+// The value of a pixel of a gradient image (CV_16S or CV_32F)
+float getGradient(const Mat& aGradient, int aRow, int aColumn);
+
+
+//-------------------------------------------------------------------------
+HoughCircleTransform::HoughCircleTransform(int aMinRadius, int aMaxRadius):
+//-------------------------------------------------------------------------
+    m_min_radius(aMinRadius),
+    m_max_radius(aMaxRadius),
+    m_width(0),
+    m_height(0)
+//-------------------------------------------------------------------------
+{
+    if (aMinRadius < 1 || aMaxRadius < aMinRadius)
+    {
+        throw invalid_argument("The radii must be at least 1, and the smallest radius cannot be larger than the largest one");
+    }
+}
+
+
+//----------------------------------------------------------
+void HoughCircleTransform::setImages(const Mat& anEdgeImage,
+                                     const Mat& aGradientX,
+                                     const Mat& aGradientY)
+//----------------------------------------------------------
+{
+    if (anEdgeImage.type() != CV_8U)
+    {
+        throw invalid_argument("The edge image must be a greyscale image (CV_8U)");
+    }
+
+    if ((aGradientX.type() != CV_16S && aGradientX.type() != CV_32F) ||
+        aGradientY.type() != aGradientX.type())
+    {
+        throw invalid_argument("The gradient images must be both CV_16S or both CV_32F images");
+    }
+
+    if (aGradientX.size() != anEdgeImage.size() || aGradientY.size() != anEdgeImage.size())
+    {
+        throw invalid_argument("The edge image and the gradient images must have the same size");
+    }
+
+    m_width = anEdgeImage.cols;
+    m_height = anEdgeImage.rows;
+
+    // The coordinates of the edge pixels and the directions of their
+    // gradients, in compact lists, row by row (and by column in a row)
+    m_x.clear();
+    m_y.clear();
+    m_dx.clear();
+    m_dy.clear();
+    m_row_starts.assign(1, 0);
+    for (int j = 0; j < anEdgeImage.rows; ++j)
+    {
+        const unsigned char* p_row = anEdgeImage.ptr<unsigned char>(j);
+        for (int i = 0; i < anEdgeImage.cols; ++i)
+        {
+            if (p_row[i])
+            {
+                float gx = getGradient(aGradientX, j, i);
+                float gy = getGradient(aGradientY, j, i);
+                float magnitude = sqrt(gx * gx + gy * gy);
+
+                // No direction to vote along
+                if (magnitude > 0)
+                {
+                    m_x.push_back(float(i));
+                    m_y.push_back(float(j));
+                    m_dx.push_back(gx / magnitude);
+                    m_dy.push_back(gy / magnitude);
+                }
+            }
+        }
+
+        m_row_starts.push_back(m_x.size());
+    }
+}
+
+
+//--------------------------------------------
+int HoughCircleTransform::getMinRadius() const
+//--------------------------------------------
+{
+    return m_min_radius;
+}
+
+
+//--------------------------------------------
+int HoughCircleTransform::getMaxRadius() const
+//--------------------------------------------
+{
+    return m_max_radius;
+}
+
+
+//--------------------------------------------------------
+size_t HoughCircleTransform::getNumberOfEdgePixels() const
+//--------------------------------------------------------
+{
+    return m_x.size();
+}
+
+
+//------------------------------------
+Mat HoughCircleTransform::vote() const
+//------------------------------------
+{
+    const size_t number_of_cells = size_t(m_width) * m_height;
+
+    // Each thread votes for a chunk of pixels in its own accumulator (see
+    // HoughTransform::vote)
+    size_t number_of_votes = m_x.size() * 2 * (m_max_radius - m_min_radius + 1);
+    size_t number_of_chunks = max(size_t(1), min(size_t(getNumThreads()),
+        number_of_votes / (min_votes_per_cell * max(number_of_cells, size_t(1)))));
+    size_t chunk_size = (m_x.size() + number_of_chunks - 1) / number_of_chunks;
+
+    vector<Mat> votes(number_of_chunks);
+    parallel_for_(Range(0, int(number_of_chunks)), [&](const Range& aRange)
+    {
+        for (int chunk = aRange.start; chunk < aRange.end; ++chunk)
+        {
+            votes[chunk] = Mat(m_height, m_width, CV_32S, Scalar(0));
+
+            size_t first_pixel = chunk * chunk_size;
+            size_t last_pixel = min(first_pixel + chunk_size, m_x.size());
+            vote(first_pixel, last_pixel, votes[chunk].ptr<int>(0));
+        }
+    });
+
+    // Sum the accumulators of the chunks into the first one, by rows
+    parallel_for_(Range(0, m_height), [&](const Range& aRange)
+    {
+        for (int j = aRange.start; j < aRange.end; ++j)
+        {
+            int* p_sum = votes[0].ptr<int>(j);
+            for (size_t chunk = 1; chunk < number_of_chunks; ++chunk)
+            {
+                const int* p_votes = votes[chunk].ptr<int>(j);
+                for (int i = 0; i < m_width; ++i)
+                {
+                    p_sum[i] += p_votes[i];
+                }
+            }
+        }
+    });
+
+    return votes[0];
+}
+
+
+//------------------------------------------------------------------------------
+vector<HoughCircle> HoughCircleTransform::findCircles(const Mat& anAccumulator,
+                                                      int aMinCentreVotes,
+                                                      double aMinCoverage,
+                                                      double aMinDistance) const
+//------------------------------------------------------------------------------
+{
+    if (anAccumulator.type() != CV_32S)
+    {
+        throw invalid_argument("The accumulator must be a CV_32S image");
+    }
+
+    if (anAccumulator.cols != m_width || anAccumulator.rows != m_height)
+    {
+        throw invalid_argument("The accumulator must have the size of the images");
+    }
+
+    // The candidate centres: the local maxima of the accumulator (a plateau
+    // gives a single centre, see HoughTransform::findPeaks)
+    vector<HoughCircle> candidates;
+    for (int j = 0; j < anAccumulator.rows; ++j)
+    {
+        const int* p_row = anAccumulator.ptr<int>(j);
+        for (int i = 0; i < anAccumulator.cols; ++i)
+        {
+            int votes = p_row[i];
+            if (votes < aMinCentreVotes || votes < 1) continue;
+
+            bool is_peak = true;
+            for (int l = max(0, j - centre_peak_radius); is_peak && l <= min(anAccumulator.rows - 1, j + centre_peak_radius); ++l)
+            {
+                const int* p_neighbours = anAccumulator.ptr<int>(l);
+                for (int k = max(0, i - centre_peak_radius); k <= min(anAccumulator.cols - 1, i + centre_peak_radius); ++k)
+                {
+                    bool before = l < j || (l == j && k < i);
+                    if (p_neighbours[k] > votes || (before && p_neighbours[k] == votes))
+                    {
+                        is_peak = false;
+                        break;
+                    }
+                }
+            }
+
+            if (is_peak)
+            {
+                HoughCircle candidate = {Point(i, j), 0, votes};
+                candidates.push_back(candidate);
+            }
+        }
+    }
+
+    // The strongest centres first (the order of the circles with the same
+    // number of edge pixels)
+    stable_sort(candidates.begin(), candidates.end(), [](const HoughCircle& a, const HoughCircle& b)
+    {
+        return a.votes > b.votes;
+    });
+
+    // The radius of each candidate, in parallel: the bin of the histogram
+    // with the most edge pixels, counting the two neighbour bins too (the
+    // distances of the pixels of a digital circle are spread over them)
+    parallel_for_(Range(0, int(candidates.size())), [&](const Range& aRange)
+    {
+        vector<int> histogram;
+        for (int n = aRange.start; n < aRange.end; ++n)
+        {
+            getRadiusHistogram(candidates[n].centre, histogram);
+
+            int best_count = -1;
+            for (int radius = m_min_radius; radius <= m_max_radius; ++radius)
+            {
+                size_t bin = radius - m_min_radius + 1;
+                int count = histogram[bin - 1] + histogram[bin] + histogram[bin + 1];
+                if (count > best_count)
+                {
+                    best_count = count;
+                    candidates[n].radius = radius;
+                }
+            }
+            candidates[n].votes = best_count;
+        }
+    });
+
+    // The circles with the most edge pixels first
+    stable_sort(candidates.begin(), candidates.end(), [](const HoughCircle& a, const HoughCircle& b)
+    {
+        return a.votes > b.votes;
+    });
+
+    // Keep the circles that are complete enough, and that are not too close
+    // to a stronger one
+    vector<HoughCircle> circles;
+    for (size_t n = 0; n < candidates.size(); ++n)
+    {
+        const HoughCircle& candidate = candidates[n];
+        if (candidate.votes < aMinCoverage * 2.0 * M_PI * candidate.radius) continue;
+
+        bool too_close = false;
+        for (size_t k = 0; !too_close && k < circles.size(); ++k)
+        {
+            double dx = candidate.centre.x - circles[k].centre.x;
+            double dy = candidate.centre.y - circles[k].centre.y;
+            too_close = dx * dx + dy * dy < aMinDistance * aMinDistance;
+        }
+
+        if (!too_close)
+        {
+            circles.push_back(candidate);
+        }
+    }
+
+    return circles;
+}
+
+
+//---------------------------------------------------------------------------------------
+void HoughCircleTransform::vote(size_t aFirstPixel, size_t aLastPixel, int* aVotes) const
+//---------------------------------------------------------------------------------------
+{
+    for (size_t n = aFirstPixel; n < aLastPixel; ++n)
+    {
+        const float x = m_x[n] + 0.5f;
+        const float y = m_y[n] + 0.5f;
+        const float dx = m_dx[n];
+        const float dy = m_dy[n];
+
+        // Along the gradient, then against it
+        for (int sign = -1; sign <= 1; sign += 2)
+        {
+            for (int radius = m_min_radius; radius <= m_max_radius; ++radius)
+            {
+                // The nearest pixel (x and y include the 0.5 of the rounding)
+                int i = int(floor(x + sign * radius * dx));
+                int j = int(floor(y + sign * radius * dy));
+
+                // The next centres are further away from the image
+                if (i < 0 || i >= m_width || j < 0 || j >= m_height) break;
+
+                ++aVotes[size_t(j) * m_width + i];
+            }
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------
+void HoughCircleTransform::getRadiusHistogram(const Point& aCentre,
+                                              vector<int>& aHistogram) const
+//--------------------------------------------------------------------------
+{
+    // One bin per radius, and one more on each side
+    aHistogram.assign(m_max_radius - m_min_radius + 3, 0);
+
+    const float min_distance = m_min_radius - 1.5f;
+    const float max_distance = m_max_radius + 1.5f;
+
+    // The edge pixels are sorted by row, then by column: only visit the box
+    // around the centre
+    const int half_size = int(ceil(max_distance));
+    const int first_row = max(0, aCentre.y - half_size);
+    const int last_row = min(m_height - 1, aCentre.y + half_size);
+    const float min_x = float(aCentre.x - half_size);
+    const float max_x = float(aCentre.x + half_size);
+
+    for (int j = first_row; j <= last_row; ++j)
+    {
+        size_t n = lower_bound(m_x.begin() + m_row_starts[j], m_x.begin() + m_row_starts[j + 1], min_x) - m_x.begin();
+        for (; n < m_row_starts[j + 1] && m_x[n] <= max_x; ++n)
+        {
+            float vx = m_x[n] - aCentre.x;
+            float vy = m_y[n] - aCentre.y;
+            float distance = sqrt(vx * vx + vy * vy);
+
+            if (distance < min_distance || distance >= max_distance) continue;
+
+            // The gradient must point to the centre, or away from it
+            if (fabs(vx * m_dx[n] + vy * m_dy[n]) < min_alignment * distance) continue;
+
+            ++aHistogram[int(distance - min_distance)];
+        }
+    }
+}
+
+
+//------------------------------------------------------------
+float getGradient(const Mat& aGradient, int aRow, int aColumn)
+//------------------------------------------------------------
+{
+    if (aGradient.type() == CV_16S)
+    {
+        return aGradient.at<short>(aRow, aColumn);
+    }
+    else
+    {
+        return aGradient.at<float>(aRow, aColumn);
+    }
+}
@@ -0,0 +1,226 @@
+#ifndef __HoughCircleTransform_h
+#define __HoughCircleTransform_h
+
+/*
+
+ Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+ http://www.fpvidal.net/
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ 3. Neither the name of the Bangor University nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+/**
+ ********************************************************************************
+ *
+ *   @file       HoughCircleTransform.h
+ *
+ *   @brief      Hough transform for circles: the edge pixels vote along their
+ *               gradient direction for the centres, then the radius of each
+ *               centre is found with a histogram.
+ *
+ *   @version    1.0
+ *
+ *   @date       06/02/2020
+ *
+ *   @author     Dr Franck P. Vidal
+ *
+ *   @section    License
+ *               BSD 3-Clause License.
+ *
+ *               For details on use and redistribution please refer
+ *               to http://opensource.org/licenses/BSD-3-Clause
+ *
+ *   @section    Copyright
+ *               (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+ *               http://www.fpvidal.net/, Feb 2020 2020, version 1.0,
+ *               BSD 3-Clause License
+ *
+ ********************************************************************************
+ */
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+
+// C++ vectors
+#include <vector>
+
+// Headers for OpenCV
+#include <opencv2/core/core.hpp>
+
+
+//------------------------------------------------------------------------------
+/// A circle found by the Hough transform
+//------------------------------------------------------------------------------
+struct HoughCircle
+{
+    cv::Point centre;   //< The centre, in pixels
+    int radius;         //< The radius, in pixels
+    int votes;          //< The number of edge pixels on the circle
+};
+
+
+//------------------------------------------------------------------------------
+/// Hough transform for circles, in two stages (the "gradient" Hough transform).
+///
+/// The gradient of an edge pixel on a circle points to the centre (or away
+/// from it). Each edge pixel only votes for the centres along its gradient
+/// direction, at the distances from the smallest to the largest radius, in
+/// a 2D accumulator of the size of the image. The local maxima of this
+/// accumulator are the candidate centres. For each of them, the distances of
+/// the edge pixels whose gradient points to it are counted in a histogram of
+/// the radii, and its highest bin gives the radius of the circle.
+///
+/// The memory is O(image), instead of O(image x radii) for a 3D accumulator
+/// of (x, y, r), and the number of votes is O(edge pixels x radii) instead of
+/// O(edge pixels x radii x angles).
+//------------------------------------------------------------------------------
+class HoughCircleTransform
+{
+public:
+    //--------------------------------------------------------------------------
+    /// Constructor
+    /**
+     * @param aMinRadius: the smallest radius (in pixels)
+     * @param aMaxRadius: the largest radius (in pixels)
+     */
+    //--------------------------------------------------------------------------
+    HoughCircleTransform(int aMinRadius, int aMaxRadius);
+
+
+    //--------------------------------------------------------------------------
+    /// Collect the edge pixels and the direction of their gradient
+    /**
+     * @param anEdgeImage: the edge image (CV_8U), e.g. from cv::Canny
+     * @param aGradientX: the horizontal derivative (CV_16S or CV_32F), e.g.
+     * from cv::Sobel
+     * @param aGradientY: the vertical derivative (same type and size)
+     */
+    //--------------------------------------------------------------------------
+    void setImages(const cv::Mat& anEdgeImage,
+                   const cv::Mat& aGradientX,
+                   const cv::Mat& aGradientY);
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the smallest radius
+    /**
+     * @return the smallest radius (in pixels)
+     */
+    //--------------------------------------------------------------------------
+    int getMinRadius() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the largest radius
+    /**
+     * @return the largest radius (in pixels)
+     */
+    //--------------------------------------------------------------------------
+    int getMaxRadius() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the number of edge pixels
+    /**
+     * @return the number of edge pixels with a gradient
+     */
+    //--------------------------------------------------------------------------
+    size_t getNumberOfEdgePixels() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Each edge pixel votes for the centres along its gradient direction, on
+    /// both sides (dark circles on a bright background and vice versa)
+    /**
+     * @return the accumulator of the centres (CV_32S, size of the image)
+     */
+    //--------------------------------------------------------------------------
+    cv::Mat vote() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Find the circles: the local maxima of the centre accumulator, and the
+    /// radius of each of them. A circle close to one with more edge pixels is
+    /// discarded.
+    /**
+     * @param anAccumulator: the accumulator of the centres (see vote)
+     * @param aMinCentreVotes: the smallest number of votes of a centre
+     * @param aMinCoverage: the smallest fraction of the circumference of a
+     * circle that must be made of edge pixels (between 0 and 1)
+     * @param aMinDistance: the smallest distance between two centres (in
+     * pixels)
+     * @return the circles, by decreasing number of edge pixels (votes)
+     */
+    //--------------------------------------------------------------------------
+    std::vector<HoughCircle> findCircles(const cv::Mat& anAccumulator,
+                                         int aMinCentreVotes,
+                                         double aMinCoverage = 0.5,
+                                         double aMinDistance = 0.0) const;
+
+
+private:
+    //--------------------------------------------------------------------------
+    /// Votes of a range of edge pixels
+    /**
+     * @param aFirstPixel: the first edge pixel
+     * @param aLastPixel: the edge pixel after the last one
+     * @param aVotes: the accumulator (added to)
+     */
+    //--------------------------------------------------------------------------
+    void vote(size_t aFirstPixel, size_t aLastPixel, int* aVotes) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Histogram of the distances of the edge pixels whose gradient points to
+    /// a centre. Only the rows and the columns within the largest radius of the
+    /// centre are visited.
+    /**
+     * @param aCentre: the centre
+     * @param aHistogram: the counts, one bin per radius (overwritten)
+     */
+    //--------------------------------------------------------------------------
+    void getRadiusHistogram(const cv::Point& aCentre,
+                            std::vector<int>& aHistogram) const;
+
+
+    int m_min_radius;                 //< The smallest radius
+    int m_max_radius;                 //< The largest radius
+    int m_width;                      //< The number of columns of the images
+    int m_height;                     //< The number of rows of the images
+    std::vector<float> m_x;           //< The columns of the edge pixels
+    std::vector<float> m_y;           //< The rows of the edge pixels
+    std::vector<float> m_dx;          //< The x components of the unit gradients
+    std::vector<float> m_dy;          //< The y components of the unit gradients
+    std::vector<size_t> m_row_starts; //< The first edge pixel of each row (and the end)
+};
+
+
+#endif // __HoughCircleTransform_h
@@ -0,0 +1,517 @@
+/*
+
+ Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+ http://www.fpvidal.net/
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ 3. Neither the name of the Bangor University nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+/**
+ ********************************************************************************
+ *
+ *   @file       HoughTransform.cxx
+ *
+ *   @brief      Hough transform for lines: lookup tables of the angles, list
+ *               of the edge pixels, and voting across all the angles at once.
+ *
+ *   @version    1.0
+ *
+ *   @date       06/02/2020
+ *
+ *   @author     Dr Franck P. Vidal
+ *
+ *   @section    License
+ *               BSD 3-Clause License.
+ *
+ *               For details on use and redistribution please refer
+ *               to http://opensource.org/licenses/BSD-3-Clause
+ *
+ *   @section    Copyright
+ *               (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+ *               http://www.fpvidal.net/, Feb 2020 2020, version 1.0,
+ *               BSD 3-Clause License
+ *
+ ********************************************************************************
+ */
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+
+// Header for sqrt, cos, sin, floor, fabs and hypot
+#include <cmath>
+
+// C++ exceptions
+#include <stdexcept>
+
+// Header for min, max, stable_sort and shuffle
+#include <algorithm>
+
+// Header for iota
+#include <numeric>
+
+// Header for the random order of the pixels (mt19937)
+#include <random>
+
+#include "HoughTransform.h"
+
+
+//******************************************************************************
+//  Name spaces
+//******************************************************************************
+
+using namespace cv;
+using namespace std;
+
+
+//******************************************************************************
+//  Constants
+//******************************************************************************
+
+// The number of edge pixels that vote together: their votes for an angle are
+// close to each other in the accumulator
+const size_t pixel_block_size = 256;
+
+// A thread has its own accumulator if it has at least this number of votes per
+// cell of the accumulator to add
+const size_t min_votes_per_cell = 4;
+
+// The states of the pixels in the progressive probabilistic Hough transform
+const unsigned char pixel_none = 0;     // Not an edge, or removed
+const unsigned char pixel_edge = 1;     // An edge pixel that has not voted
+const unsigned char pixel_voted = 2;    // An edge pixel that has voted
+
+
+//--------------------------------------------------
+HoughTransform::HoughTransform(int aNumberOfAngles):
+//--------------------------------------------------
+    m_number_of_angles(aNumberOfAngles),
+    m_width(0),
+    m_height(0),
+    m_distance_offset(0)
+//--------------------------------------------------
+{
+    // Checked before the tables are sized: a negative size would not throw
+    // std::invalid_argument
+    if (aNumberOfAngles < 1)
+    {
+        throw invalid_argument("The number of angles must be at least 1");
+    }
+
+    // The lookup tables, computed once
+    m_cos.resize(m_number_of_angles);
+    m_sin.resize(m_number_of_angles);
+    for (int theta = 0; theta < m_number_of_angles; ++theta)
+    {
+        m_cos[theta] = cos(getAngle(theta));
+        m_sin[theta] = sin(getAngle(theta));
+    }
+}
+
+
+//-------------------------------------------------------
+void HoughTransform::setEdgeImage(const Mat& anEdgeImage)
+//-------------------------------------------------------
+{
+    if (anEdgeImage.type() != CV_8U)
+    {
+        throw invalid_argument("The edge image must be a greyscale image (CV_8U)");
+    }
+
+    m_width = anEdgeImage.cols;
+    m_height = anEdgeImage.rows;
+
+    // The distances go from -D to D
+    double diagonal = sqrt(double(anEdgeImage.cols) * anEdgeImage.cols + double(anEdgeImage.rows) * anEdgeImage.rows);
+    m_distance_offset = int(ceil(diagonal));
+
+    // The coordinates of the edge pixels, in a compact list
+    m_x.clear();
+    m_y.clear();
+    for (int j = 0; j < anEdgeImage.rows; ++j)
+    {
+        const unsigned char* p_row = anEdgeImage.ptr<unsigned char>(j);
+        for (int i = 0; i < anEdgeImage.cols; ++i)
+        {
+            if (p_row[i])
+            {
+                m_x.push_back(float(i));
+                m_y.push_back(float(j));
+            }
+        }
+    }
+}
+
+
+//-------------------------------------------
+int HoughTransform::getNumberOfAngles() const
+//-------------------------------------------
+{
+    return m_number_of_angles;
+}
+
+
+//----------------------------------------------
+int HoughTransform::getNumberOfDistances() const
+//----------------------------------------------
+{
+    return 2 * m_distance_offset + 1;
+}
+
+
+//--------------------------------------------------
+size_t HoughTransform::getNumberOfEdgePixels() const
+//--------------------------------------------------
+{
+    return m_x.size();
+}
+
+
+//------------------------------------------------
+double HoughTransform::getAngle(int aColumn) const
+//------------------------------------------------
+{
+    return aColumn * M_PI / m_number_of_angles;
+}
+
+
+//------------------------------------------------
+double HoughTransform::getDistance(int aRow) const
+//------------------------------------------------
+{
+    return aRow - m_distance_offset;
+}
+
+
+//------------------------------
+Mat HoughTransform::vote() const
+//------------------------------
+{
+    const int number_of_angles = m_number_of_angles;
+    const int number_of_distances = getNumberOfDistances();
+    const size_t number_of_cells = size_t(number_of_angles) * number_of_distances;
+
+    // Each thread votes for a chunk of pixels in its own accumulator. There
+    // are fewer chunks for small sets of pixels, so that the merge does not
+    // cost more than the votes.
+    size_t number_of_votes = m_x.size() * number_of_angles;
+    size_t number_of_chunks = max(size_t(1), min(size_t(getNumThreads()),
+        number_of_votes / (min_votes_per_cell * number_of_cells)));
+    size_t chunk_size = (m_x.size() + number_of_chunks - 1) / number_of_chunks;
+
+    // The votes are counted with one row per angle, so that the votes of
+    // neighbour pixels for an angle are in the same cache lines
+    vector<Mat> votes(number_of_chunks);
+    parallel_for_(Range(0, int(number_of_chunks)), [&](const Range& aRange)
+    {
+        for (int chunk = aRange.start; chunk < aRange.end; ++chunk)
+        {
+            votes[chunk] = Mat(number_of_angles, number_of_distances, CV_32S, Scalar(0));
+
+            size_t first_pixel = chunk * chunk_size;
+            size_t last_pixel = min(first_pixel + chunk_size, m_x.size());
+            vote(first_pixel, last_pixel, votes[chunk].ptr<int>(0));
+        }
+    });
+
+    // Sum the accumulators of the chunks into the first one, by rows (the
+    // sums are vectorised by the compiler)
+    parallel_for_(Range(0, number_of_angles), [&](const Range& aRange)
+    {
+        for (int theta = aRange.start; theta < aRange.end; ++theta)
+        {
+            int* p_sum = votes[0].ptr<int>(theta);
+            for (size_t chunk = 1; chunk < number_of_chunks; ++chunk)
+            {
+                const int* p_votes = votes[chunk].ptr<int>(theta);
+                for (int i = 0; i < number_of_distances; ++i)
+                {
+                    p_sum[i] += p_votes[i];
+                }
+            }
+        }
+    });
+
+    // One column per angle
+    Mat accumulator;
+    transpose(votes[0], accumulator);
+
+    return accumulator;
+}
+
+
+//-------------------------------------------------------------------
+vector<HoughLine> HoughTransform::findPeaks(const Mat& anAccumulator,
+                                            int aMinVotes,
+                                            int aRadius) const
+//-------------------------------------------------------------------
+{
+    if (anAccumulator.type() != CV_32S)
+    {
+        throw invalid_argument("The accumulator must be a CV_32S image");
+    }
+
+    vector<HoughLine> lines;
+    for (int j = 0; j < anAccumulator.rows; ++j)
+    {
+        const int* p_row = anAccumulator.ptr<int>(j);
+        for (int i = 0; i < anAccumulator.cols; ++i)
+        {
+            int votes = p_row[i];
+            if (votes < aMinVotes || votes < 1) continue;
+
+            // Compare with the neighbourhood, stop at the first larger cell
+            bool is_peak = true;
+            for (int l = max(0, j - aRadius); is_peak && l <= min(anAccumulator.rows - 1, j + aRadius); ++l)
+            {
+                const int* p_neighbours = anAccumulator.ptr<int>(l);
+                for (int k = max(0, i - aRadius); k <= min(anAccumulator.cols - 1, i + aRadius); ++k)
+                {
+                    bool before = l < j || (l == j && k < i);
+                    if (p_neighbours[k] > votes || (before && p_neighbours[k] == votes))
+                    {
+                        is_peak = false;
+                        break;
+                    }
+                }
+            }
+
+            if (is_peak)
+            {
+                HoughLine line = {getAngle(i), getDistance(j), votes};
+                lines.push_back(line);
+            }
+        }
+    }
+
+    // The strongest lines first
+    stable_sort(lines.begin(), lines.end(), [](const HoughLine& a, const HoughLine& b)
+    {
+        return a.votes > b.votes;
+    });
+
+    return lines;
+}
+
+
+//-----------------------------------------------------------------------------
+vector<HoughSegment> HoughTransform::findSegments(int aThreshold,
+                                                  int aMinLength,
+                                                  int aMaxGap,
+                                                  unsigned int aSeed) const
+//-----------------------------------------------------------------------------
+{
+    if (aThreshold < 1)
+    {
+        throw invalid_argument("The threshold must be at least 1");
+    }
+
+    const int number_of_angles = m_number_of_angles;
+    const int number_of_distances = getNumberOfDistances();
+    const float* p_cos = &m_cos[0];
+    const float* p_sin = &m_sin[0];
+    const float offset = m_distance_offset + 0.5f;
+
+    // The accumulator, with one row per angle (see vote)
+    Mat accumulator(number_of_angles, number_of_distances, CV_32S, Scalar(0));
+    vector<int> distances(number_of_angles);
+
+    // Add (+1) or remove (-1) the votes of a pixel, and return the strongest
+    // line through it
+    auto votePixel = [&](int x, int y, int aVote, int& aBestAngle) -> int
+    {
+        for (int theta = 0; theta < number_of_angles; ++theta)
+        {
+            distances[theta] = int(x * p_cos[theta] + y * p_sin[theta] + offset);
+        }
+
+        int best_votes = 0;
+        for (int theta = 0; theta < number_of_angles; ++theta)
+        {
+            int& votes = accumulator.ptr<int>(theta)[distances[theta]];
+            votes += aVote;
+            if (votes > best_votes)
+            {
+                best_votes = votes;
+                aBestAngle = theta;
+            }
+        }
+
+        return best_votes;
+    };
+
+    // The state of each pixel of the edge image
+    Mat state(m_height, m_width, CV_8U, Scalar(pixel_none));
+    for (size_t i = 0; i < m_x.size(); ++i)
+    {
+        state.at<unsigned char>(int(m_y[i]), int(m_x[i])) = pixel_edge;
+    }
+
+    // The pixels vote in a random order
+    vector<size_t> order(m_x.size());
+    iota(order.begin(), order.end(), size_t(0));
+    shuffle(order.begin(), order.end(), mt19937(aSeed));
+
+    vector<HoughSegment> segments;
+    for (size_t n = 0; n < order.size(); ++n)
+    {
+        int x = int(m_x[order[n]]);
+        int y = int(m_y[order[n]]);
+
+        // The pixel has been removed with a segment
+        unsigned char& pixel_state = state.at<unsigned char>(y, x);
+        if (pixel_state != pixel_edge) continue;
+        pixel_state = pixel_voted;
+
+        int theta = 0;
+        int votes = votePixel(x, y, 1, theta);
+        if (votes < aThreshold) continue;
+
+        // The direction of the line is (-sin(theta), cos(theta)): one pixel
+        // per step along its main axis
+        float dx = -p_sin[theta];
+        float dy = p_cos[theta];
+        float step_x;
+        float step_y;
+        if (fabs(dx) > fabs(dy))
+        {
+            step_x = dx > 0 ? 1.0f : -1.0f;
+            step_y = dy / fabs(dx);
+        }
+        else
+        {
+            step_x = dx / fabs(dy);
+            step_y = dy > 0 ? 1.0f : -1.0f;
+        }
+
+        // Follow the line in both directions, until the gap is too large
+        Point line_end[2] = {Point(x, y), Point(x, y)};
+        int number_of_steps[2] = {0, 0};
+        for (int k = 0; k < 2; ++k)
+        {
+            float sign = k ? -1.0f : 1.0f;
+            int gap = 0;
+            for (int step = 1; ; ++step)
+            {
+                int i = int(floor(x + sign * step * step_x + 0.5f));
+                int j = int(floor(y + sign * step * step_y + 0.5f));
+                if (i < 0 || i >= m_width || j < 0 || j >= m_height) break;
+
+                if (state.at<unsigned char>(j, i) != pixel_none)
+                {
+                    gap = 0;
+                    line_end[k] = Point(i, j);
+                    number_of_steps[k] = step;
+                }
+                else if (++gap > aMaxGap)
+                {
+                    break;
+                }
+            }
+        }
+
+        double length = hypot(double(line_end[1].x - line_end[0].x), double(line_end[1].y - line_end[0].y));
+        bool good_segment = length >= aMinLength;
+
+        // Remove the pixels of the segment. As in OpenCV, they are removed
+        // even if the segment is too short, but they keep their votes.
+        for (int k = 0; k < 2; ++k)
+        {
+            float sign = k ? -1.0f : 1.0f;
+            for (int step = k; step <= number_of_steps[k]; ++step)
+            {
+                int i = int(floor(x + sign * step * step_x + 0.5f));
+                int j = int(floor(y + sign * step * step_y + 0.5f));
+
+                unsigned char& segment_state = state.at<unsigned char>(j, i);
+                if (good_segment && segment_state == pixel_voted)
+                {
+                    int unused_angle = 0;
+                    votePixel(i, j, -1, unused_angle);
+                }
+                segment_state = pixel_none;
+            }
+        }
+
+        if (good_segment)
+        {
+            HoughSegment segment = {line_end[1], line_end[0], votes};
+            segments.push_back(segment);
+        }
+    }
+
+    return segments;
+}
+
+
+//---------------------------------------------------------------------------------
+void HoughTransform::vote(size_t aFirstPixel, size_t aLastPixel, int* aVotes) const
+//---------------------------------------------------------------------------------
+{
+    const int number_of_angles = m_number_of_angles;
+    const int number_of_distances = getNumberOfDistances();
+
+    // The rows of the accumulator of a block of pixels, for all the angles
+    vector<int> distances(pixel_block_size * number_of_angles);
+    const float* p_cos = &m_cos[0];
+    const float* p_sin = &m_sin[0];
+
+    // r + offset + 0.5 is positive: the conversion to int rounds it to the
+    // nearest row
+    const float offset = m_distance_offset + 0.5f;
+
+    for (size_t first_pixel = aFirstPixel; first_pixel < aLastPixel; first_pixel += pixel_block_size)
+    {
+        size_t number_of_pixels = min(pixel_block_size, aLastPixel - first_pixel);
+
+        // All the angles at once for each pixel (vectorised by the compiler)
+        for (size_t i = 0; i < number_of_pixels; ++i)
+        {
+            const float x = m_x[first_pixel + i];
+            const float y = m_y[first_pixel + i];
+            int* p_distances = &distances[i * number_of_angles];
+
+            for (int theta = 0; theta < number_of_angles; ++theta)
+            {
+                p_distances[theta] = int(x * p_cos[theta] + y * p_sin[theta] + offset);
+            }
+        }
+
+        // The votes, angle by angle
+        for (int theta = 0; theta < number_of_angles; ++theta)
+        {
+            int* p_row = aVotes + size_t(theta) * number_of_distances;
+            for (size_t i = 0; i < number_of_pixels; ++i)
+            {
+                ++p_row[distances[i * number_of_angles + theta]];
+            }
+        }
+    }
+}
@@ -0,0 +1,255 @@
+#ifndef __HoughTransform_h
+#define __HoughTransform_h
+
+/*
+
+ Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+ http://www.fpvidal.net/
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ 3. Neither the name of the Bangor University nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+/**
+ ********************************************************************************
+ *
+ *   @file       HoughTransform.h
+ *
+ *   @brief      Hough transform for lines: lookup tables of the angles, list
+ *               of the edge pixels, and voting across all the angles at once.
+ *
+ *   @version    1.0
+ *
+ *   @date       06/02/2020
+ *
+ *   @author     Dr Franck P. Vidal
+ *
+ *   @section    License
+ *               BSD 3-Clause License.
+ *
+ *               For details on use and redistribution please refer
+ *               to http://opensource.org/licenses/BSD-3-Clause
+ *
+ *   @section    Copyright
+ *               (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+ *               http://www.fpvidal.net/, Feb 2020 2020, version 1.0,
+ *               BSD 3-Clause License
+ *
+ ********************************************************************************
+ */
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+
+// C++ vectors
+#include <vector>
+
+// Headers for OpenCV
+#include <opencv2/core/core.hpp>
+
+
+//------------------------------------------------------------------------------
+/// A line found by the Hough transform: x cos(theta) + y sin(theta) = r
+//------------------------------------------------------------------------------
+struct HoughLine
+{
+    double theta;   //< The angle, in radians
+    double r;       //< The distance to the origin, in pixels
+    int votes;      //< The number of votes
+};
+
+
+//------------------------------------------------------------------------------
+/// A line segment found by the progressive probabilistic Hough transform
+//------------------------------------------------------------------------------
+struct HoughSegment
+{
+    cv::Point start;    //< The first end of the segment
+    cv::Point end;      //< The other end of the segment
+    int votes;          //< The number of votes of its line when it was found
+};
+
+
+//------------------------------------------------------------------------------
+/// Hough transform for lines: x cos(theta) + y sin(theta) = r.
+///
+/// The accumulator has one column per angle (theta from 0 to 180 degrees,
+/// excluded) and one row per distance r (in pixels, from -D to D, where D is
+/// the length of the diagonal of the image). cos(theta) and sin(theta) are
+/// computed once, in tables. The coordinates of the edge pixels are collected
+/// once in a compact list, then each of them votes for all the angles at once:
+/// the distances of the 180 angles are computed as a vector (SIMD), then the
+/// votes are added to the accumulator.
+///
+/// The counters are 32-bit integers (long lines in large images have more than
+/// 255 votes). The edge pixels are split into chunks that vote in parallel,
+/// each in the private accumulator of its thread, and the accumulators are
+/// summed at the end.
+//------------------------------------------------------------------------------
+class HoughTransform
+{
+public:
+    //--------------------------------------------------------------------------
+    /// Constructor
+    /**
+     * @param aNumberOfAngles: the number of columns of the accumulator
+     */
+    //--------------------------------------------------------------------------
+    explicit HoughTransform(int aNumberOfAngles = 180);
+
+
+    //--------------------------------------------------------------------------
+    /// Collect the pixels of an edge image (the non-zero pixels)
+    /**
+     * @param anEdgeImage: the edge image (CV_8U), e.g. from cv::Canny
+     */
+    //--------------------------------------------------------------------------
+    void setEdgeImage(const cv::Mat& anEdgeImage);
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the number of angles
+    /**
+     * @return the number of columns of the accumulator
+     */
+    //--------------------------------------------------------------------------
+    int getNumberOfAngles() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the number of distances
+    /**
+     * @return the number of rows of the accumulator
+     */
+    //--------------------------------------------------------------------------
+    int getNumberOfDistances() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the number of edge pixels
+    /**
+     * @return the number of edge pixels
+     */
+    //--------------------------------------------------------------------------
+    size_t getNumberOfEdgePixels() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the angle of a column of the accumulator
+    /**
+     * @param aColumn: the column
+     * @return theta, in radians
+     */
+    //--------------------------------------------------------------------------
+    double getAngle(int aColumn) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Accessor on the distance of a row of the accumulator
+    /**
+     * @param aRow: the row
+     * @return r, in pixels
+     */
+    //--------------------------------------------------------------------------
+    double getDistance(int aRow) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Each edge pixel votes for all the lines that go through it
+    /**
+     * @return the accumulator (CV_32S)
+     */
+    //--------------------------------------------------------------------------
+    cv::Mat vote() const;
+
+
+    //--------------------------------------------------------------------------
+    /// Non-maximum suppression: find the local maxima of the accumulator. A
+    /// cell is kept if it has more votes than the cells before it in its
+    /// neighbourhood, and at least as many as the cells after it (a plateau
+    /// gives a single line).
+    /**
+     * @param anAccumulator: the accumulator (see vote)
+     * @param aMinVotes: the smallest number of votes of a line
+     * @param aRadius: the radius of the neighbourhood (in cells)
+     * @return the lines, by decreasing number of votes
+     */
+    //--------------------------------------------------------------------------
+    std::vector<HoughLine> findPeaks(const cv::Mat& anAccumulator,
+                                     int aMinVotes = 1,
+                                     int aRadius = 2) const;
+
+
+    //--------------------------------------------------------------------------
+    /// Progressive probabilistic Hough transform (Matas et al., 2000): the
+    /// edge pixels vote one at a time, in a random order. As soon as a line
+    /// through the pixel that has just voted reaches the threshold, the
+    /// segment is followed along the line in the edge image, and its pixels
+    /// are removed: those that have voted take their votes back, and the
+    /// others will not vote. Most of the pixels of long lines never vote.
+    /**
+     * @param aThreshold: the number of votes that triggers the search of a
+     * segment
+     * @param aMinLength: the smallest length of a segment (in pixels)
+     * @param aMaxGap: the largest number of missing pixels in a segment
+     * @param aSeed: the seed of the random order of the pixels
+     * @return the segments, in the order they were found
+     */
+    //--------------------------------------------------------------------------
+    std::vector<HoughSegment> findSegments(int aThreshold,
+                                           int aMinLength,
+                                           int aMaxGap,
+                                           unsigned int aSeed = 0) const;
+
+
+private:
+    //--------------------------------------------------------------------------
+    /// Votes of a range of edge pixels
+    /**
+     * @param aFirstPixel: the first edge pixel
+     * @param aLastPixel: the edge pixel after the last one
+     * @param aVotes: the accumulator, with one row per angle (added to)
+     */
+    //--------------------------------------------------------------------------
+    void vote(size_t aFirstPixel, size_t aLastPixel, int* aVotes) const;
+
+
+    int m_number_of_angles;         //< The number of columns of the accumulator
+    int m_width;                    //< The number of columns of the edge image
+    int m_height;                   //< The number of rows of the edge image
+    int m_distance_offset;          //< The row of r = 0 (the length of the diagonal)
+    std::vector<float> m_cos;       //< cos(theta) of each column
+    std::vector<float> m_sin;       //< sin(theta) of each column
+    std::vector<float> m_x;         //< The columns of the edge pixels
+    std::vector<float> m_y;         //< The rows of the edge pixels
+};
+
+
+#endif // __HoughTransform_h
@@ -0,0 +1,348 @@
+/*
+
+ Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+ http://www.fpvidal.net/
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ 3. Neither the name of the Bangor University nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+/**
+ ********************************************************************************
+ *
+ *   @file       hough_circles.cxx
+ *
+ *   @brief      Demo program to show how to detect circles with the Hough
+ *               transform, using the directions of the gradients.
+ *
+ *   @version    1.0
+ *
+ *   @date       06/02/2020
+ *
+ *   @author     Dr Franck P. Vidal
+ *
+ *   @section    License
+ *               BSD 3-Clause License.
+ *
+ *               For details on use and redistribution please refer
+ *               to http://opensource.org/licenses/BSD-3-Clause
+ *
+ *   @section    Copyright
+ *               (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+ *               http://www.fpvidal.net/, Feb 2020 2020, version 1.0,
+ *               BSD 3-Clause License
+ *
+ ********************************************************************************
+ */
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+
+// Header for cout and cerr (display some text in the console)
+#include <iostream>
+
+// C++ strings
+#include <string>
+
+// C++ exceptions
+#include <exception>
+
+// Header for atoi
+#include <cstdlib>
+
+// Headers for OpenCV
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/opencv.hpp>
+#include "opencv2/imgproc/imgproc.hpp"
+
+#include "HoughCircleTransform.h"
+
+
+//******************************************************************************
+//  Name spaces
+//******************************************************************************
+
+using namespace cv;
+using namespace std;
+
+
+//******************************************************************************
+//  Function declarations
+//******************************************************************************
+
+// The stages of the processing, in the order of their dependencies: each stage
+// uses the results of the previous one
+enum Stage
+{
+    STAGE_GRADIENTS = 0,    // The luminance image is blurred, and its gradients
+    STAGE_EDGES,            // Canny (the Canny threshold)
+    STAGE_ACCUMULATOR,      // The votes for the centres
+    STAGE_CIRCLES,          // The circles (the coverage threshold)
+    STAGE_DONE              // Everything is up to date
+};
+
+// A stage and all the stages after it have to be computed again
+void invalidate(Stage aStage);
+
+// Compute the stages that are not up to date
+void update();
+
+// Callback function for the Canny threshold trackbar
+void cannyThresholdCallback(int, void*);
+
+// Callback function for the coverage trackbar
+void coverageCallback(int, void*);
+
+Mat drawCircles(const Mat& anImage,
+                const vector<HoughCircle>& aCircleSet,
+                int aLineWidth = 1,
+                const Scalar& aLineColour = Scalar(0, 0, 255));
+
+
+//******************************************************************************
+//  Global variables
+//******************************************************************************
+
+int g_canny_low_threshold = 60;
+int g_coverage = 50;    // In percents of the circumference
+const int g_max_low_threshold = 100;
+const int g_max_coverage = 100;
+const int g_ratio = 3;
+const int g_kernel_size = 3;
+
+// The votes of a centre must be at least this number of times the smallest
+// radius
+const int g_min_centre_votes_per_radius = 2;
+
+Mat g_input_RGB_image;
+Mat g_input_luminance_image;
+Mat g_blurred_image;
+Mat g_gradient_x;
+Mat g_gradient_y;
+Mat g_edge_image;
+Mat g_accumulator_image;
+vector<HoughCircle> g_circle_set;
+HoughCircleTransform* g_p_hough_transform = 0;
+
+// The first stage that is not up to date
+Stage g_first_invalid_stage = STAGE_GRADIENTS;
+
+
+//-----------------------------
+int main(int argc, char** argv)
+//-----------------------------
+{
+    try
+    {
+        // Check the command line arguments: image [min_radius max_radius]
+        if (argc != 2 && argc != 4)
+        {
+            throw "Invalid command line arguments, usage: hough_circles image [min_radius max_radius]";
+        }
+
+        int min_radius = 10;
+        int max_radius = 100;
+        if (argc == 4)
+        {
+            min_radius = atoi(argv[2]);
+            max_radius = atoi(argv[3]);
+        }
+
+        HoughCircleTransform hough_transform(min_radius, max_radius);
+        g_p_hough_transform = &hough_transform;
+
+        // Read the image
+        g_input_RGB_image = imread(argv[1], CV_LOAD_IMAGE_COLOR);
+
+        // Check for invalid input
+        if (!g_input_RGB_image.data)
+        {
+            throw "Could not open or find the image";
+        }
+
+        // Create windows
+        namedWindow("input RGB image", CV_WINDOW_AUTOSIZE);
+        namedWindow("edge image", CV_WINDOW_AUTOSIZE);
+        namedWindow("accumulator image", CV_WINDOW_AUTOSIZE);
+        namedWindow("image with circles", CV_WINDOW_AUTOSIZE);
+
+        // Create a slider in edge image
+        createTrackbar("Min Canny Threshold:",
+                       "edge image",
+                       &g_canny_low_threshold,
+                       g_max_low_threshold,
+                       cannyThresholdCallback);
+
+        // Create a slider in the image with circles
+        createTrackbar("Min coverage (%):",
+                       "image with circles",
+                       &g_coverage,
+                       g_max_coverage,
+                       coverageCallback);
+
+        // The image is not a greyscale image, convert it
+        cvtColor(g_input_RGB_image, g_input_luminance_image, CV_RGB2GRAY);
+
+        // Show our image
+        imshow ("input RGB image", g_input_RGB_image);
+
+        // Run all the stages once
+        update();
+
+        // Event loop
+        char key = 0;
+        while(key != 'q' && key != 27)
+        {
+            key = cv::waitKey(0);
+        }
+    }
+    // There was an error
+    catch (const std::exception& error)
+    {
+        std::cerr << "ERROR:\t" << error.what() << std::endl;
+        return 1;
+    }
+    catch (const std::string& error)
+    {
+        std::cerr << "ERROR:\t" << error << std::endl;
+        return 1;
+    }
+    catch (const char* error)
+    {
+        std::cerr << "ERROR:\t" << error << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+
+//---------------------------
+void invalidate(Stage aStage)
+//---------------------------
+{
+    g_first_invalid_stage = min(g_first_invalid_stage, aStage);
+}
+
+
+//-----------
+void update()
+//-----------
+{
+    // The gradients only depend on the input image, they are computed once
+    // for Canny and for the votes
+    if (g_first_invalid_stage <= STAGE_GRADIENTS)
+    {
+        blur(g_input_luminance_image, g_blurred_image, Size(3,3));
+        Sobel(g_blurred_image, g_gradient_x, CV_16S, 1, 0, g_kernel_size);
+        Sobel(g_blurred_image, g_gradient_y, CV_16S, 0, 1, g_kernel_size);
+    }
+
+    // The edges depend on the Canny threshold
+    if (g_first_invalid_stage <= STAGE_EDGES)
+    {
+        Canny(g_gradient_x,
+              g_gradient_y,
+              g_edge_image,
+              g_canny_low_threshold,
+              g_canny_low_threshold * g_ratio);
+
+        imshow("edge image", g_edge_image);
+    }
+
+    // The centres depend on the edges
+    if (g_first_invalid_stage <= STAGE_ACCUMULATOR)
+    {
+        g_p_hough_transform->setImages(g_edge_image, g_gradient_x, g_gradient_y);
+        g_accumulator_image = g_p_hough_transform->vote();
+
+        Mat normalised_accumulator;
+        normalize(g_accumulator_image, normalised_accumulator, 0, 255, NORM_MINMAX, CV_8U);
+        imshow("accumulator image", normalised_accumulator);
+    }
+
+    // The circles depend on the coverage threshold
+    if (g_first_invalid_stage <= STAGE_CIRCLES)
+    {
+        int min_radius = g_p_hough_transform->getMinRadius();
+
+        g_circle_set = g_p_hough_transform->findCircles(g_accumulator_image,
+                                                        g_min_centre_votes_per_radius * min_radius,
+                                                        double(g_coverage) / g_max_coverage,
+                                                        min_radius);
+
+        Mat image_with_circles = drawCircles(g_input_RGB_image, g_circle_set, 2);
+        imshow("image with circles", image_with_circles);
+    }
+
+    g_first_invalid_stage = STAGE_DONE;
+}
+
+
+//-------------------------------------
+void cannyThresholdCallback(int, void*)
+//-------------------------------------
+{
+    invalidate(STAGE_EDGES);
+    update();
+}
+
+
+//-------------------------------
+void coverageCallback(int, void*)
+//-------------------------------
+{
+    invalidate(STAGE_CIRCLES);
+    update();
+}
+
+
+//----------------------------------------------------
+Mat drawCircles(const Mat& anImage,
+                const vector<HoughCircle>& aCircleSet,
+                int aLineWidth,
+                const Scalar& aLineColour)
+//----------------------------------------------------
+{
+    // Copy the input image into the output image
+    Mat output = anImage.clone();
+
+    // Draw the circles and their centres
+    for (vector<HoughCircle>::const_iterator circle_ite = aCircleSet.begin();
+         circle_ite != aCircleSet.end();
+         ++circle_ite)
+    {
+        circle(output, circle_ite->centre, circle_ite->radius, aLineColour, aLineWidth);
+        circle(output, circle_ite->centre, 1, aLineColour, aLineWidth);
+    }
+
+    return output;
+}
@@ -79,6 +79,8 @@
 #include <opencv2/opencv.hpp>
 #include "opencv2/imgproc/imgproc.hpp"
 
+#include "HoughTransform.h"
+
 
 //******************************************************************************
 //  Name spaces
@@ -92,20 +94,44 @@ using namespace std;
 //  Function declarations
 //******************************************************************************
 
-double deg2rad(double anAngleInDegrees);
+// The stages of the processing, in the order of their dependencies: each stage
+// uses the results of the previous one
+enum Stage
+{
+    STAGE_BLUR = 0,     // The luminance image is blurred
+    STAGE_EDGES,        // Canny (the Canny threshold)
+    STAGE_ACCUMULATOR,  // The Hough transform of the edges
+    STAGE_PEAKS,        // The local maxima of the accumulator
+    STAGE_LINES,        // The lines (or segments) above the Hough threshold
+    STAGE_DONE          // Everything is up to date
+};
+
+// A stage and all the stages after it have to be computed again
+void invalidate(Stage aStage);
+
+// Compute the stages that are not up to date
+void update();
 
-// Callback function for the threshold trackbar
-void thresholdCallback(int, void*);
+// Callback function for the Canny threshold trackbar
+void cannyThresholdCallback(int, void*);
 
-Mat houghTransform(const Mat& anInputImage,
-                   int aCannyThreshold);
+// Callback function for the Hough threshold trackbar
+void houghThresholdCallback(int, void*);
+
+Mat detectEdges(const Mat& aBlurredImage,
+                int aCannyThreshold);
 
 Mat drawLines(const Mat& anImage,
-              const Mat& anAccumulator,
+              const vector<HoughLine>& aLineSet,
               double aHoughThreshold,
               int aLineWidth = 1,
               const Scalar& aLineColour = Scalar(0, 0, 255));
 
+Mat drawSegments(const Mat& anImage,
+                 const vector<HoughSegment>& aSegmentSet,
+                 int aLineWidth = 1,
+                 const Scalar& aLineColour = Scalar(0, 0, 255));
+
 
 //******************************************************************************
 //  Global variables
@@ -117,9 +143,25 @@ const int g_max_low_threshold = 100;
 const int g_ratio = 3;
 const int g_kernel_size = 3;
 
+// The progressive probabilistic Hough transform (-p on the command line): the
+// Hough threshold is a number of votes, and the segments are drawn
+bool g_probabilistic_mode = false;
+const int g_min_segment_length = 30;
+const int g_max_segment_gap = 5;
+
 Mat g_input_RGB_image;
 Mat g_input_luminance_image;
+Mat g_blurred_image;
+Mat g_edge_image;
 Mat g_accumulator_image;
+double g_min_votes = 0;
+double g_max_votes = 0;
+vector<HoughLine> g_line_set;
+vector<HoughSegment> g_segment_set;
+HoughTransform g_hough_transform;
+
+// The first stage that is not up to date
+Stage g_first_invalid_stage = STAGE_BLUR;
 
 
 //-----------------------------
@@ -128,14 +170,18 @@ int main(int argc, char** argv)
 {
     try
     {
-        // Check the number of command line arguments
-        if (argc != 2)
+        // Check the command line arguments: [-p] image
+        if (argc == 3 && string(argv[1]) == "-p")
         {
-            throw "Invalid number of command line arguments";
+            g_probabilistic_mode = true;
+        }
+        else if (argc != 2)
+        {
+            throw "Invalid command line arguments, usage: hough_transform [-p] image";
         }
 
         // Read the image
-        g_input_RGB_image = imread(argv[1], CV_LOAD_IMAGE_COLOR);
+        g_input_RGB_image = imread(argv[argc - 1], CV_LOAD_IMAGE_COLOR);
 
         // Check for invalid input
         if (!g_input_RGB_image.data)
@@ -147,7 +193,10 @@ int main(int argc, char** argv)
         namedWindow("input RGB image", CV_WINDOW_AUTOSIZE);
         namedWindow("input luminance image", CV_WINDOW_AUTOSIZE);
         namedWindow("edge image", CV_WINDOW_AUTOSIZE);
-        namedWindow("accumulator image", CV_WINDOW_AUTOSIZE);
+        if (!g_probabilistic_mode)
+        {
+            namedWindow("accumulator image", CV_WINDOW_AUTOSIZE);
+        }
         namedWindow("image with lines", CV_WINDOW_AUTOSIZE);
 
         // Create a slider in edge image
@@ -155,14 +204,14 @@ int main(int argc, char** argv)
                        "edge image",
                        &g_canny_low_threshold,
                        g_max_low_threshold,
-                       thresholdCallback);
+                       cannyThresholdCallback);
 
         // Create a slider in edge image
         createTrackbar("Min Hough Threshold:",
                        "image with lines",
                        &g_hough_low_threshold,
                        g_max_low_threshold,
-                       thresholdCallback);
+                       houghThresholdCallback);
 
         // The image is not a greyscale image, convert it
         cvtColor(g_input_RGB_image, g_input_luminance_image, CV_RGB2GRAY);
@@ -171,8 +220,8 @@ int main(int argc, char** argv)
         imshow ("input RGB image", g_input_RGB_image);
         imshow ("input luminance image", g_input_luminance_image);
 
-        // Run the Hough transform at least once
-        thresholdCallback(0, 0);
+        // Run all the stages once
+        update();
 
         // Event loop
         char key = 0;
@@ -202,139 +251,180 @@ int main(int argc, char** argv)
 }
 
 
-//--------------------------------------------
-inline double deg2rad(double anAngleInDegrees)
-//--------------------------------------------
+//---------------------------
+void invalidate(Stage aStage)
+//---------------------------
 {
-    return anAngleInDegrees * M_PI / 180.0;
+    g_first_invalid_stage = min(g_first_invalid_stage, aStage);
 }
 
 
-//--------------------------------
-void thresholdCallback(int, void*)
-//--------------------------------
+//-----------
+void update()
+//-----------
 {
-    g_accumulator_image = houghTransform(g_input_luminance_image, g_canny_low_threshold);
+    // The blurred image only depends on the input image
+    if (g_first_invalid_stage <= STAGE_BLUR)
+    {
+        blur(g_input_luminance_image, g_blurred_image, Size(3,3));
+    }
+
+    // The edges depend on the Canny threshold
+    if (g_first_invalid_stage <= STAGE_EDGES)
+    {
+        g_edge_image = detectEdges(g_blurred_image, g_canny_low_threshold);
+        imshow("edge image", g_edge_image);
+    }
+
+    // The accumulator depends on the edges (the probabilistic transform
+    // only needs the edge pixels, it votes for each segment)
+    if (g_first_invalid_stage <= STAGE_ACCUMULATOR)
+    {
+        g_hough_transform.setEdgeImage(g_edge_image);
+    }
+
+    if (g_first_invalid_stage <= STAGE_ACCUMULATOR && !g_probabilistic_mode)
+    {
+        g_accumulator_image = g_hough_transform.vote();
+
+        Mat normalised_accumulator;
+        normalize(g_accumulator_image, normalised_accumulator, 0, 255, NORM_MINMAX, CV_8U);
+        imshow("accumulator image", normalised_accumulator);
+
+        // Get tne min and max in the accumulator
+        cv::minMaxLoc(g_accumulator_image, &g_min_votes, &g_max_votes, 0, 0);
+    }
+
+    // The local maxima of the accumulator, whatever their number of votes
+    if (g_first_invalid_stage <= STAGE_PEAKS && !g_probabilistic_mode)
+    {
+        g_line_set = g_hough_transform.findPeaks(g_accumulator_image);
+    }
 
-    Mat normalised_accumulator;
-    normalize(g_accumulator_image, normalised_accumulator, 0, 255, NORM_MINMAX);
-    imshow("accumulator image", normalised_accumulator);
+    // The segments depend on the edges and on the Hough threshold
+    if (g_first_invalid_stage <= STAGE_LINES && g_probabilistic_mode)
+    {
+        g_segment_set = g_hough_transform.findSegments(max(1, g_hough_low_threshold),
+                                                       g_min_segment_length,
+                                                       g_max_segment_gap);
+
+        Mat image_with_lines = drawSegments(g_input_RGB_image, g_segment_set, 4);
+        imshow("image with lines", image_with_lines);
+    }
 
-    // Linear interpolation
-    // Get tne min and max in the accumulator
-    double min_value, max_value;
-    cv::minMaxLoc(g_accumulator_image, &min_value, &max_value, 0, 0);
-    double hough_threshold = min_value + (max_value - min_value) * (double(g_hough_low_threshold) / g_max_low_threshold);
+    // The lines depend on the Hough threshold only
+    if (g_first_invalid_stage <= STAGE_LINES && !g_probabilistic_mode)
+    {
+        // Linear interpolation
+        double hough_threshold = g_min_votes + (g_max_votes - g_min_votes) * (double(g_hough_low_threshold) / g_max_low_threshold);
 
-    Mat image_with_lines = drawLines(g_input_RGB_image, g_accumulator_image, hough_threshold, 4);
-    imshow("image with lines", image_with_lines);
+        Mat image_with_lines = drawLines(g_input_RGB_image, g_line_set, hough_threshold, 4);
+        imshow("image with lines", image_with_lines);
+    }
+
+    g_first_invalid_stage = STAGE_DONE;
+}
+
+
+//-------------------------------------
+void cannyThresholdCallback(int, void*)
+//-------------------------------------
+{
+    invalidate(STAGE_EDGES);
+    update();
 }
 
 
-//-----------------------------------------
-Mat houghTransform(const Mat& anInputImage,
-                   int aCannyThreshold)
-//-----------------------------------------
+//-------------------------------------
+void houghThresholdCallback(int, void*)
+//-------------------------------------
 {
-    Mat blurred_image;
-    blur( g_input_luminance_image, blurred_image, Size(3,3) );
+    invalidate(STAGE_LINES);
+    update();
+}
+
 
+//---------------------------------------
+Mat detectEdges(const Mat& aBlurredImage,
+                int aCannyThreshold)
+//---------------------------------------
+{
     Mat edge_image;
-    Canny(blurred_image,
+    Canny(aBlurredImage,
           edge_image,
           aCannyThreshold,
           aCannyThreshold * g_ratio,
           g_kernel_size);
 
-    imshow("edge image", edge_image);
+    return edge_image;
+}
 
-    int width  = 180;
-    double diagonal = sqrt(edge_image.cols * edge_image.cols + edge_image.rows * edge_image.rows);
-    int height = floor(2.0 * diagonal);
-    double half_height = height / 2.0;
-    Mat accumulator(height, width, CV_8U, Scalar(0));
 
-    // Process all the pixels of the edge image
-    for (int j = 0; j < edge_image.rows; ++j)
+//----------------------------------------------
+Mat drawLines(const Mat& anImage,
+              const vector<HoughLine>& aLineSet,
+              double aHoughThreshold,
+              int aLineWidth,
+              const Scalar& aLineColour)
+//----------------------------------------------
+{
+    // Copy the input image into the output image
+    Mat output = anImage.clone();
+
+    // Process the lines, from the strongest one, until the threshold
+    for (vector<HoughLine>::const_iterator line_ite = aLineSet.begin();
+         line_ite != aLineSet.end() && line_ite->votes > aHoughThreshold;
+         ++line_ite)
     {
-        for (int i = 0; i < edge_image.cols; ++i)
+        // The two corners of the image
+        Point pt1(               0, 0);
+        Point pt2(anImage.cols - 1, anImage.rows - 1);
+
+        // Get theta in radian, and r
+        double theta = line_ite->theta;
+        double r = line_ite->r;
+
+        // How to retrieve the line from theta and r:
+        //      x = (r - y * sin(theta)) / cos(theta);
+        //      y = (r - x * cos(theta)) / sin(theta);
+
+        // The line is not vertical: sin(theta) != 0
+        if (theta != 0)
+        {
+            pt1.y = (r - pt1.x * cos(theta)) / sin(theta);
+            pt2.y = (r - pt2.x * cos(theta)) / sin(theta);
+        }
+        // Vertical line: sin(theta) == 0 && cos(theta) != 0
+        else
         {
-            // The pixel is on an edge
-            if (edge_image.at<unsigned char>(i, j) > 0)
-            {
-                // Process all the angles
-                for (int theta = 0; theta <= 180; ++theta)
-                {
-                    double angle = deg2rad(theta);
-                    double r = i * cos(angle) + j * sin(angle);
-
-                    int v = floor(r + half_height);
-                    //cout << theta << " " << v << " " << accumulator.cols << "x" << accumulator.rows << endl;
-                    accumulator.at<unsigned char>(v, theta) += 1;
-                }
-            }
+            pt1.x = (r - pt1.y * sin(theta)) / cos(theta);
+            pt2.x = (r - pt2.y * sin(theta)) / cos(theta);
         }
+
+        // Draw the line
+        line(output, pt1, pt2, aLineColour, aLineWidth);
     }
 
-    return accumulator;
+    return output;
 }
 
 
-//--------------------------------------
-Mat drawLines(const Mat& anImage,
-              const Mat& anAccumulator,
-              double aHoughThreshold,
-              int aLineWidth,
-              const Scalar& aLineColour)
-//--------------------------------------
+//------------------------------------------------------
+Mat drawSegments(const Mat& anImage,
+                 const vector<HoughSegment>& aSegmentSet,
+                 int aLineWidth,
+                 const Scalar& aLineColour)
+//------------------------------------------------------
 {
     // Copy the input image into the output image
     Mat output = anImage.clone();
 
-    // Process all the pixels of the accumulator image
-    for (int j = 0; j < anAccumulator.rows; ++j)
+    // Draw the segments
+    for (vector<HoughSegment>::const_iterator segment_ite = aSegmentSet.begin();
+         segment_ite != aSegmentSet.end();
+         ++segment_ite)
     {
-        for (int i = 0; i < anAccumulator.cols; ++i)
-        {
-            // The pixel value in the accumulator is greater than the threshold
-            // Display the corresponding line
-            if (anAccumulator.at<unsigned char>(j, i) > aHoughThreshold)
-            {
-                // The pixel location
-                Point location(i, j);
-
-                // The two corners of the image
-                Point pt1(               0, 0);
-                Point pt2(anImage.cols - 1, anImage.rows - 1);
-
-                // Get theta in radian
-                double theta = deg2rad(location.x);
-
-                // Get r
-                double r = location.y;
-                r -= anAccumulator.rows / 2.0;
-
-                // How to retrieve the line from theta and r:
-                //      x = (r - y * sin(theta)) / cos(theta);
-                //      y = (r - x * cos(theta)) / sin(theta);
-
-                // sin(theta) != 0
-                if (location.x != 0 && location.x != 180)
-                {
-                    pt1.x = (r - pt1.y * cos(theta)) / sin(theta);
-                    pt2.x = (r - pt2.y * cos(theta)) / sin(theta);
-                }
-                // sin(theta) == 0 && cos(theta) != 0
-                else
-                {
-                    pt1.y = (r - pt1.x * sin(theta)) / cos(theta);
-                    pt2.y = (r - pt2.x * sin(theta)) / cos(theta);
-                }
-
-                // Draw the line
-                line(output, pt1, pt2, aLineColour, aLineWidth);
-            }
-        }
+        line(output, segment_ite->start, segment_ite->end, aLineColour, aLineWidth);
     }
 
     return output;